@@ -28,6 +28,8 @@
 #include "gui/pbcSettings.h"
 #include "pbcController.h"
 #include "models/pbcPlaybook.h"
+#include "models/pbcPlaybookCompaction.h"
+#include "models/pbcPlaybookMerge.h"
 #include "dialogs/pbcExportPdfDialog.h"
 #include "dialogs/pbcDeleteDialog.h"
 #include "dialogs/pbcNewPlaybookDialog.h"
@@ -36,16 +38,32 @@
 #include "dialogs/pbcSavePlayAsDialog.h"
 #include "dialogs/pbcSetPasswordDialog.h"
 #include "util/pbcDeclarations.h"
+#include <QApplication>
 #include <QMessageBox>
 #include <QInputDialog>
 #include <QDebug>
 #include "util/pbcStorage.h"
+#include "util/pbcBookletExport.h"
 #include "util/pbcExceptions.h"
+#include "util/pbcImageExport.h"
+#include "util/pbcKeyDerivation.h"
+#include "util/pbcMultiLayoutExportJob.h"
+#include "util/pbcPDFExportJob.h"
 #include <QFileDialog>
 #include <QStringList>
 #include <QPushButton>
 #include <QCheckBox>
 #include <QDialogButtonBox>
+#include <QLabel>
+#include <QListWidget>
+#include <QDir>
+#include <QStandardPaths>
+#include <QStatusBar>
+#include <QDateTime>
+#include <QEventLoop>
+#include <QProgressDialog>
+#include <algorithm>
+#include <chrono>
 #include <string>
 #include <vector>
 #include <list>
@@ -64,7 +82,11 @@
  */
 MainDialog::MainDialog(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::MainDialog){
+    ui(new Ui::MainDialog),
+    _updateChecker(NULL),
+    _updateCheckAction(NULL),
+    _diagnosticsDock(NULL),
+    _saveFailurePending(false) {
     ui->setupUi(this);
     ui->graphicsView->setRenderHint(QPainter::Antialiasing);
     ui->graphicsView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
@@ -82,6 +104,32 @@ MainDialog::MainDialog(QWidget *parent) :
     ui->actionImport_playbook->setShortcut(QKeySequence("Ctrl+Alt+I"));
     ui->actionPDF_Export->setShortcut(QKeySequence("Ctrl+Alt+W"));
 
+    ui->actionUndo->setShortcut(QKeySequence::Undo);
+    ui->actionRedo->setShortcut(QKeySequence::Redo);
+    // the actions must be up to date before the menu is opened, otherwise the shortcuts would not work
+    PBCController::getInstance()->getPlaybook()->history().setListener([this]() {
+        updateUndoActions();
+    });
+    // queued, because the automatic saves happen in the middle of changes to the playbook
+    PBCStorage::getInstance()->setSaveFailureListener([this](const std::string& message) {
+        if (_saveFailurePending == false) {
+            _saveFailurePending = true;
+            QMetaObject::invokeMethod(this, [this, message]() { reportFailedSave(message); }, Qt::QueuedConnection);
+        }
+    });
+
+    // hidden from the menus, only reachable by its shortcut
+    QAction* diagnosticsAction = new QAction("Diagnostics", this);
+    diagnosticsAction->setShortcut(QKeySequence("Ctrl+Alt+D"));
+    addAction(diagnosticsAction);
+    connect(diagnosticsAction, &QAction::triggered, this, &MainDialog::toggleDiagnosticsDock);
+
+    _updateCheckAction = new QAction("Check for Updates at Startup", this);
+    _updateCheckAction->setCheckable(true);
+    _updateCheckAction->setChecked(getUpdateCheckSetting() == "enabled");
+    ui->menuHelp->addAction(_updateCheckAction);
+    connect(_updateCheckAction, &QAction::toggled, this, &MainDialog::setUpdateCheckEnabled);
+
     _currentPlay = _currentlySelectedPlays.begin();
 
     _playView = new PBCPlayView(NULL, this);
@@ -91,6 +139,7 @@ MainDialog::MainDialog(QWidget *parent) :
     this->setMinimumHeight(PBCConfig::getInstance()->minHeight());
 
     updateTitle(false);
+    updateUndoActions();
 }
 
 void MainDialog::keyReleaseEvent(QKeyEvent *event) {
@@ -111,6 +160,7 @@ void MainDialog::keyReleaseEvent(QKeyEvent *event) {
  */
 void MainDialog::show(QString playbookPath) {
     QMainWindow::showMaximized();
+    checkForUpdates();
 
     if (!playbookPath.isNull()) {
         loadPlaybook(playbookPath);
@@ -132,6 +182,102 @@ void MainDialog::show(QString playbookPath) {
     }
 }
 
+/**
+ * @brief Starts checking for a new release of Playbook Creator in the
+ * background, if the user has agreed to it. The user is asked once, the
+ * answer can be changed in the help menu. The result is shown by
+ * showUpdateNotice() as soon as it is available.
+ */
+void MainDialog::checkForUpdates() {
+    if (getUpdateCheckSetting().isEmpty()) {
+        QMessageBox::StandardButton answer = QMessageBox::question(
+                    this,
+                    "PBC Update Checker",
+                    "Do you want to look for updates and news at every start?\n"
+                    "Recommended only, if you have stable internet connection. "
+                    "You can change this later in the help menu.",
+                    QMessageBox::Yes | QMessageBox::No);
+        // keeps the help menu in sync with the stored answer
+        _updateCheckAction->setChecked(answer == QMessageBox::Yes);
+        setUpdateCheckEnabled(answer == QMessageBox::Yes);
+    }
+    if (getUpdateCheckSetting() != "enabled") {
+        return;
+    }
+
+    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(cacheDir);
+    QString cacheFile = QDir(cacheDir).filePath("update_check.cache");
+
+    _updateChecker = new PBCUpdateChecker(PBCVersion::getVersionString(),
+                                          PBCUpdateChecker::releaseFetcher(PBC_VERSION_MAJOR,
+                                                                           PBC_VERSION_MINOR,
+                                                                           PBC_VERSION_PATCH),
+                                          cacheFile.toStdString());
+    _updateChecker->start([this](const PBCReleaseInfo& info) {
+        // the checker calls back from its own thread
+        QMetaObject::invokeMethod(this, [this, info]() {
+            showUpdateNotice(info);
+        }, Qt::QueuedConnection);
+    });
+}
+
+/**
+ * @brief Stores whether checkForUpdates() may contact the release server
+ * @param enabled true if updates should be looked for at startup
+ */
+void MainDialog::setUpdateCheckEnabled(bool enabled) {
+    setUpdateCheckSetting(enabled ? "enabled" : "disabled");
+}
+
+/**
+ * @brief Shows the result of the update check without blocking the user
+ * @param info The result of the update check
+ */
+void MainDialog::showUpdateNotice(const PBCReleaseInfo &info) {
+    switch (info.status) {
+        case PBCReleaseInfo::UPDATE_AVAILABLE:
+            {
+                QString latestVersion = QString("v%1.%2.%3").arg(info.major).arg(info.minor).arg(info.patch);
+                QString msg = "A new version of PlaybookCreator is available!"
+                              "<br><br>Description of release " + latestVersion + ":<br>" +
+                              QString::fromStdString(info.description).toHtmlEscaped() +
+                              "<br><br>Please visit <a href='https://github.com/obraunsdorf/playbook-creator/releases'>https://github.com/obraunsdorf/playbook-creator/releases</a> "  // NOLINT
+                              "to update to the current version!";
+                QMessageBox* notice = new QMessageBox(this);
+                notice->setAttribute(Qt::WA_DeleteOnClose);
+                notice->setWindowModality(Qt::NonModal);
+                notice->setWindowTitle("PBC Update Checker");
+                notice->setTextFormat(Qt::RichText);
+                notice->setText(msg);
+                notice->show();
+                statusBar()->showMessage("Playbook Creator " + latestVersion + " is available");
+            }
+            break;
+        case PBCReleaseInfo::UP_TO_DATE:
+            statusBar()->showMessage("Playbook Creator is up to date", 5000);
+            break;
+        case PBCReleaseInfo::CHECK_FAILED:
+        case PBCReleaseInfo::TIMED_OUT:
+            statusBar()->showMessage("Could not check for updates (maybe bad internet connection?). "
+                                     "Please visit https://github.com/obraunsdorf/playbook-creator/releases "
+                                     "to see if a new version of PBC has been released", 15000);
+            break;
+    }
+}
+
+/**
+ * @brief Shows or hides the dock with the performance metrics. The dock is
+ * created when it is shown for the first time.
+ */
+void MainDialog::toggleDiagnosticsDock() {
+    if (_diagnosticsDock == NULL) {
+        _diagnosticsDock = new PBCDiagnosticsDock(this);
+        addDockWidget(Qt::BottomDockWidgetArea, _diagnosticsDock);
+    }
+    _diagnosticsDock->setVisible(!_diagnosticsDock->isVisible());
+}
+
 /**
  * @brief adds / deletes an "*" to / from the window title depending on
  * saved / modified state of the current playbook
@@ -150,6 +296,18 @@ void MainDialog::updateTitle(bool saved) {
     this->setWindowTitle(QString::fromStdString(windowTitle));
 }
 
+/**
+ * @brief Tells the user that the playbook could not be saved. The playbook
+ * stays in memory and the file keeps its previous version.
+ * @param message The reason
+ */
+void MainDialog::reportFailedSave(const std::string& message) {
+    _saveFailurePending = false;
+    updateTitle(false);
+    QMessageBox::warning(this, "Save Playbook",
+                         QString::fromStdString(message + "\n\nPlease save the playbook to another location."));
+}
+
 /**
  * @brief Enables all menu actions.
  *
@@ -465,8 +623,13 @@ void MainDialog::savePlaybookAs() {
         int returnCode = pwDialog.exec();
         if (returnCode == QDialog::Accepted) {
             QString password = pwDialog.getPassword();
-            PBCStorage::getInstance()->savePlaybook(password.toStdString(),
-                                                    fileName.toStdString());
+            try {
+                PBCStorage::getInstance()->savePlaybook(password.toStdString(),
+                                                        fileName.toStdString());
+            } catch (const PBCSaveException& e) {
+                QMessageBox::warning(this, "Save Playbook", QString::fromStdString(e.what()));
+                return;
+            }
             updateTitle(true);
             return;
         }
@@ -475,44 +638,120 @@ void MainDialog::savePlaybookAs() {
 }
 
 /**
- * @brief Loads a playbook from a given filename
+ * @brief Maps the progress of a phase of a PBCLoadJob to the progress of the
+ * whole job (in percent). The key derivation and the deserialization take
+ * most of the time.
  */
-void MainDialog::loadPlaybook(QString fileName) {
-    unsigned int decryptionFailureCount = 0;
-    while (true) {
+static int loadProgress(PBCLoadJob::Phase phase, double progress) {
+    switch (phase) {
+        case PBCLoadJob::READING:
+            return static_cast<int>(10 * progress);
+        case PBCLoadJob::DERIVING_KEY:
+            return 10 + static_cast<int>(40 * progress);
+        case PBCLoadJob::DECRYPTING:
+            return 50 + static_cast<int>(10 * progress);
+        case PBCLoadJob::DESERIALIZING:
+            return 60 + static_cast<int>(40 * progress);
+    }
+    return 0;
+}
+
+static QString loadPhaseText(PBCLoadJob::Phase phase) {
+    switch (phase) {
+        case PBCLoadJob::READING:
+            return "Reading the playbook file...";
+        case PBCLoadJob::DERIVING_KEY:
+            return "Deriving the key from the password...";
+        case PBCLoadJob::DECRYPTING:
+            return "Decrypting the playbook...";
+        case PBCLoadJob::DESERIALIZING:
+            return "Loading plays, formations and routes...";
+    }
+    return "";
+}
+
+/**
+ * @brief Asks for the password and runs a load job in the background while a
+ * progress dialog is shown. If the password is wrong, it is asked again and
+ * the job is restarted (without reading the file again).
+ * @param job The job
+ * @param title The title of the dialogs
+ * @return true if the playbook has been loaded, false if the user has
+ * cancelled or the password has been wrong too often
+ * @throws PBCStorageException if the playbook cannot be loaded for another
+ * reason, e.g. PBCDeprecatedVersionException
+ */
+bool MainDialog::runLoadJob(PBCLoadJob &job, const QString &title) {
+    for (unsigned int decryptionFailureCount = 0;
+         decryptionFailureCount < PASSWORD_MAX_RETRYS;
+         ++decryptionFailureCount) {
         bool ok;
-        std::string msg;
-        if (decryptionFailureCount == 0) {
-            msg = "Enter decryption password";
-        } else {
-            msg = "Error on decryption. Maybe wrong password. Try again!";
+        QString msg = decryptionFailureCount == 0 ?
+                    "Enter decryption password" :
+                    "Error on decryption. Maybe wrong password. Try again!";
+        QString password = QInputDialog::getText(this, title, msg, QLineEdit::Password, "", &ok);
+        if (ok == false) {
+            return false;
         }
-        QString password = QInputDialog::getText(this, "Open Playbook",
-                                                 QString::fromStdString(msg),
-                                                 QLineEdit::Password, "", &ok);
-        if (ok == true) {
-            try {
-                PBCStorage::getInstance()->loadActivePlaybook(password.toStdString(),
-                                                              fileName.toStdString());
-            } catch (PBCDecryptionException &e) {
-                if (decryptionFailureCount < PASSWORD_MAX_RETRYS - 1) {
-                    decryptionFailureCount++;
-                    continue;
-                } else {
-                    throw e;
-                }
-            } catch (PBCDeprecatedVersionException& e) {
-                QMessageBox::critical(this,
-                        "Open Playbook",
-                        "Cannot load playbook because it's created by a newer version of Playbook-Creator. "
-                        "Please download the latest version of Playbook-Creator!");
-            }
-            _playView->resetPlay();
-            resetForNewPlaybook();
-            updateTitle(true);
-            break;
+
+        QProgressDialog progressDialog(loadPhaseText(PBCLoadJob::READING), "Cancel", 0, 100, this);
+        progressDialog.setWindowTitle(title);
+        progressDialog.setWindowModality(Qt::WindowModal);
+        progressDialog.setMinimumDuration(300);
+        QEventLoop loop;
+        connect(&progressDialog, &QProgressDialog::canceled, [&job]() { job.cancel(); });
+        QProgressDialog* dialog = &progressDialog;
+        QEventLoop* eventLoop = &loop;
+        job.start(password.toStdString(),
+                  [dialog](PBCLoadJob::Phase phase, double progress) {
+                      QMetaObject::invokeMethod(dialog, [dialog, phase, progress]() {
+                          dialog->setLabelText(loadPhaseText(phase));
+                          dialog->setValue(loadProgress(phase, progress));
+                      }, Qt::QueuedConnection);
+                  },
+                  [eventLoop]() {
+                      QMetaObject::invokeMethod(eventLoop, "quit", Qt::QueuedConnection);
+                  });
+        loop.exec();
+        job.wait();
+
+        if (job.status() == PBCLoadJob::SUCCEEDED) {
+            return true;
+        } else if (job.status() == PBCLoadJob::CANCELLED) {
+            return false;
+        }
+        try {
+            job.rethrow();
+        } catch (PBCDecryptionException &e) {
+            continue;
+        }
+    }
+    QMessageBox::critical(this, title, "Could not decrypt the playbook.");
+    return false;
+}
+
+/**
+ * @brief Loads a playbook from a given filename. The playbook is loaded in the
+ * background and replaces the active playbook only if it has been loaded
+ * completely.
+ */
+void MainDialog::loadPlaybook(QString fileName) {
+    PBCLoadJob job(fileName.toStdString());
+    try {
+        if (runLoadJob(job, "Open Playbook") == false) {
+            return;
         }
+    } catch (PBCDeprecatedVersionException& e) {
+        QMessageBox::critical(this,
+                "Open Playbook",
+                "Cannot load playbook because it's created by a newer version of Playbook-Creator. "
+                "Please download the latest version of Playbook-Creator!");
+        return;
     }
+    PBCStorage::getInstance()->activatePlaybook(job);
+    _playView->resetPlay();
+    resetForNewPlaybook();
+    updateTitle(true);
 }
 
 /**
@@ -545,84 +784,429 @@ void MainDialog::importPlaybook() {
         pbcAssert(files.size() == 1);
         QString fileName = files.first();
 
-        unsigned int decryptionFailureCount = 0;
-        while (true) {
-            bool ok;
-            std::string msg;
-            if (decryptionFailureCount == 0) {
-                msg = "Enter decryption password";
-            } else {
-                msg = "Error on decryption. Maybe wrong password. Try again!";
+        PBCLoadJob job(fileName.toStdString());
+        try {
+            if (runLoadJob(job, "Import Playbook") == false) {
+                return;
             }
-            QString password = QInputDialog::getText(this, "Import Playbook",
-                                                     QString::fromStdString(msg),
-                                                     QLineEdit::Password, "", &ok);
-            if (ok == true) {
-                QDialog* importDialog = new QDialog(this);
-                importDialog->setWindowTitle("Choose what to import");
-                QLayout* layout = new QVBoxLayout;
-                QLineEdit* prefixLine = new QLineEdit;
-                prefixLine->setPlaceholderText("prefix");
-                QCheckBox* playCB = new QCheckBox("Import Plays");
-                playCB->setChecked(true);
-                QCheckBox* categoryCB = new QCheckBox("Import Categories");
-                categoryCB->setChecked(true);
-                QCheckBox* formationCB = new QCheckBox("Import Formations");
-                formationCB->setChecked(true);
-                QCheckBox* routeCB = new QCheckBox("Import Routes");
-                routeCB->setChecked(false);
-                layout->addWidget(playCB);
-                layout->addWidget(categoryCB);
-                layout->addWidget(formationCB);
-                layout->addWidget(routeCB);
-                layout->addWidget(prefixLine);
-                QPushButton* okButton = new QPushButton("Import now!");
-                layout->addWidget(okButton);
-                importDialog->setLayout(layout);
-                connect(okButton, &QPushButton::clicked, importDialog, &QDialog::accept);
-                if (importDialog->exec() == QDialog::Accepted) {
-                    bool import_plays = playCB->isChecked();
-                    bool import_categories = categoryCB->isChecked();
-                    bool import_formations = formationCB->isChecked();
-                    bool import_routes = routeCB->isChecked();
-                    std::string prefix = prefixLine->text().toStdString();
-                    try {
-                        PBCStorage::getInstance()->importPlaybook(
-                                password.toStdString(),
-                                fileName.toStdString(),
-                                import_plays,
-                                import_categories,
-                                import_routes,
-                                import_formations,
-                                prefix);
-                        QMessageBox::information(this,
-                                                 "Import Playbook",
-                                                 "Import successful. Your playbook has been saved automatically!");
-                    }  catch (PBCImportException& e) {
-                        QString msg = e.what();
-                        msg.append("\n\nYou should rename or delete it and try to import again.");
-                        QMessageBox::critical(this, "Import Playbook", msg);
-                    } catch (PBCDecryptionException &e) {
-                        if (decryptionFailureCount < PASSWORD_MAX_RETRYS - 1) {
-                            decryptionFailureCount++;
-                            continue;
-                        } else {
-                            throw e;
-                        }
-                    } catch (PBCDeprecatedVersionException& e) {
-                        QMessageBox::critical(this,
-                                              "Import Playbook",
-                                              "Cannot load playbook because it's created by a newer version of Playbook-Creator. "
-                                              "Please download the latest version of Playbook-Creator!");
-                    }
-                }
-                break;
+        } catch (PBCDeprecatedVersionException& e) {
+            QMessageBox::critical(this,
+                                  "Import Playbook",
+                                  "Cannot load playbook because it's created by a newer version of Playbook-Creator. "
+                                  "Please download the latest version of Playbook-Creator!");
+            return;
+        }
+
+        QDialog* importDialog = new QDialog(this);
+        importDialog->setWindowTitle("Choose what to import");
+        QLayout* layout = new QVBoxLayout;
+        QLineEdit* prefixLine = new QLineEdit;
+        prefixLine->setPlaceholderText("prefix");
+        QCheckBox* playCB = new QCheckBox("Import Plays");
+        playCB->setChecked(true);
+        QCheckBox* categoryCB = new QCheckBox("Import Categories");
+        categoryCB->setChecked(true);
+        QCheckBox* formationCB = new QCheckBox("Import Formations");
+        formationCB->setChecked(true);
+        QCheckBox* routeCB = new QCheckBox("Import Routes");
+        routeCB->setChecked(false);
+        QCheckBox* duplicateCB = new QCheckBox("Skip identical items");
+        duplicateCB->setChecked(true);
+        layout->addWidget(playCB);
+        layout->addWidget(categoryCB);
+        layout->addWidget(formationCB);
+        layout->addWidget(routeCB);
+        layout->addWidget(duplicateCB);
+        layout->addWidget(prefixLine);
+        QPushButton* okButton = new QPushButton("Import now!");
+        layout->addWidget(okButton);
+        importDialog->setLayout(layout);
+        connect(okButton, &QPushButton::clicked, importDialog, &QDialog::accept);
+        if (importDialog->exec() == QDialog::Accepted) {
+            bool import_plays = playCB->isChecked();
+            bool import_categories = categoryCB->isChecked();
+            bool import_formations = formationCB->isChecked();
+            bool import_routes = routeCB->isChecked();
+            bool skip_duplicates = duplicateCB->isChecked();
+            std::string prefix = prefixLine->text().toStdString();
+            try {
+                PBCStorage::getInstance()->importPlaybook(
+                        job.playbook(),
+                        import_plays,
+                        import_categories,
+                        import_routes,
+                        import_formations,
+                        prefix,
+                        "",
+                        skip_duplicates);
+                QMessageBox::information(this,
+                                         "Import Playbook",
+                                         "Import successful. Your playbook has been saved automatically!");
+            }  catch (PBCImportException& e) {
+                QString msg = e.what();
+                msg.append("\n\nYou should rename or delete it and try to import again.");
+                QMessageBox::critical(this, "Import Playbook", msg);
             }
         }
     }
 }
 
 
+/**
+ * @brief Asks for a playbook file and its password and loads the playbook
+ * without replacing the active playbook
+ * @param title The title of the dialogs
+ * @return The loaded playbook or NULL if the user cancelled
+ */
+PBCPlaybookSP MainDialog::openPlaybookForMerge(const QString& title) {
+    QString fileName = QFileDialog::getOpenFileName(this, title, getLastPlaybookLocation(""),
+                                                    "PBC Files (*.pbc);;All Files (*.*)");
+    if (fileName.isEmpty()) {
+        return PBCPlaybookSP();
+    }
+    PBCLoadJob job(fileName.toStdString());
+    if (runLoadJob(job, title) == false) {
+        return PBCPlaybookSP();
+    }
+    return job.playbook();
+}
+
+/**
+ * @brief Merges the changes of another copy of the active playbook into a new
+ * playbook file.
+ *
+ * The user chooses the common ancestor of both copies and the other copy. The
+ * active playbook is not changed.
+ */
+void MainDialog::mergePlaybook() {
+    try {
+        PBCPlaybookSP base = openPlaybookForMerge("Merge Playbook: Common Ancestor");
+        if (base == NULL) {
+            return;
+        }
+        PBCPlaybookSP theirs = openPlaybookForMerge("Merge Playbook: Other Playbook");
+        if (theirs == NULL) {
+            return;
+        }
+        PBCMergeResult result = PBCPlaybookMerge::merge(
+                    *base, *PBCController::getInstance()->getPlaybook(), *theirs);
+
+        if (!result.conflicts.empty()) {
+            static const char* typeNames[] = {"Playbook", "Formation", "Route", "Category", "Play"};
+            QString msg = QString("%1 conflict(s). Your version has been kept for:\n").arg(result.conflicts.size());
+            for (const PBCMergeConflict& conflict : result.conflicts) {
+                msg.append(QString("\n%1 '%2'").arg(typeNames[conflict.type],
+                                                    QString::fromStdString(conflict.name)));
+            }
+            if (QMessageBox::warning(this, "Merge Playbook", msg, QMessageBox::Ok | QMessageBox::Cancel)
+                    != QMessageBox::Ok) {
+                return;
+            }
+        }
+
+        QString fileName = QFileDialog::getSaveFileName(
+                    this, "Save Merged Playbook",
+                    getLastPlaybookLocation(QString::fromStdString(result.playbook->name() + "_merged.pbc")),
+                    "PBC Files (*.pbc);;All Files (*.*)");
+        if (fileName.isEmpty()) {
+            return;
+        }
+        if (!fileName.endsWith(".pbc")) {
+            fileName.append(".pbc");
+        }
+        PBCSetPasswordDialog pwDialog;
+        if (pwDialog.exec() == QDialog::Accepted) {
+            PBCStorage::getInstance()->writePlaybookToFile(pwDialog.getPassword().toStdString(),
+                                                           fileName.toStdString(),
+                                                           result.playbook);
+            QMessageBox::information(this, "Merge Playbook", "The merged playbook has been saved.");
+        }
+    } catch (PBCImportException& e) {
+        QMessageBox::critical(this, "Merge Playbook", e.what());
+    } catch (PBCDeprecatedVersionException& e) {
+        QMessageBox::critical(this,
+                              "Merge Playbook",
+                              "Cannot load playbook because it's created by a newer version of Playbook-Creator. "
+                              "Please download the latest version of Playbook-Creator!");
+    } catch (PBCStorageException& e) {
+        QMessageBox::critical(this, "Merge Playbook", e.what());
+    }
+}
+
+/**
+ * @brief Parses a comma-separated list of play names, category names and
+ * search terms into a selection
+ */
+static PBCPlaySelection parsePlaySelection(PBCPlaybookSP playbook, const QString& input) {
+    PBCPlaySelection selection;
+    for (const QString& item : input.split(",", QString::SkipEmptyParts)) {
+        const std::string name = item.trimmed().toStdString();
+        if (name.empty()) {
+            continue;
+        } else if (playbook->hasPlay(name)) {
+            selection.plays.insert(name);
+        } else if (playbook->playsInCategory(name).empty() == false) {
+            selection.categories.insert(name);
+        } else {
+            selection.terms.push_back(name);
+        }
+    }
+    return selection;
+}
+
+/**
+ * @brief Exports a part of the playbook (e.g. for one position group) to a new
+ * playbook file.
+ *
+ * The user enters category names, play names and search terms. The new file
+ * contains the matching plays with their formations, routes and categories.
+ */
+void MainDialog::exportSubPlaybook() {
+    PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+    bool ok;
+    QString input = QInputDialog::getText(this, "Export Sub-Playbook",
+                                          "Categories, plays or search terms (separated by commas)",
+                                          QLineEdit::Normal, "", &ok);
+    if (ok == false) {
+        return;
+    }
+    PBCPlaySelection selection = parsePlaySelection(playbook, input);
+    if (selection.empty()) {
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(
+                this, "Export Sub-Playbook",
+                getLastPlaybookLocation(QString::fromStdString(playbook->name() + "_part.pbc")),
+                "PBC Files (*.pbc);;All Files (*.*)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    if (!fileName.endsWith(".pbc")) {
+        fileName.append(".pbc");
+    }
+    PBCSetPasswordDialog pwDialog;
+    if (pwDialog.exec() != QDialog::Accepted) {
+        return;
+    }
+    try {
+        PBCPlaybookSP exported = PBCStorage::getInstance()->exportPlaybook(pwDialog.getPassword().toStdString(),
+                                                                           fileName.toStdString(),
+                                                                           selection);
+        QMessageBox::information(this, "Export Sub-Playbook",
+                                 QString("%1 plays, %2 formations and %3 routes have been exported.").arg(
+                                     QString::number(exported->plays().size()),
+                                     QString::number(exported->formations().size()),
+                                     QString::number(exported->routes().size())));
+    } catch (PBCStorageException& e) {
+        QMessageBox::critical(this, "Export Sub-Playbook", e.what());
+    }
+}
+
+/**
+ * @brief Changes the password of one or more playbook files.
+ *
+ * The files are re-encrypted without being opened, so the active playbook is
+ * not changed. If the active playbook file is among them, it is saved with
+ * the new password from now on.
+ */
+void MainDialog::changePassword() {
+    QStringList fileNames = QFileDialog::getOpenFileNames(this, "Change Password", getLastPlaybookLocation(""),
+                                                          "PBC Files (*.pbc);;All Files (*.*)");
+    if (fileNames.isEmpty()) {
+        return;
+    }
+    bool ok;
+    QString oldPassword = QInputDialog::getText(this, "Change Password", "Enter the current password",
+                                                QLineEdit::Password, "", &ok);
+    if (ok == false) {
+        return;
+    }
+    PBCSetPasswordDialog pwDialog;
+    if (pwDialog.exec() != QDialog::Accepted) {
+        return;
+    }
+
+    std::vector<std::string> files;
+    for (const QString& fileName : fileNames) {
+        files.push_back(fileName.toStdString());
+    }
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    std::vector<std::pair<std::string, std::string>> failures =
+            PBCStorage::getInstance()->changePassword(oldPassword.toStdString(),
+                                                      pwDialog.getPassword().toStdString(),
+                                                      files);
+    QApplication::restoreOverrideCursor();
+
+    if (failures.empty()) {
+        QMessageBox::information(this, "Change Password",
+                                 QString("The password of %1 playbook(s) has been changed.").arg(files.size()));
+    } else {
+        QString msg = QString("The password of %1 playbook(s) could not be changed:\n").arg(failures.size());
+        for (const auto& failure : failures) {
+            msg.append(QString("\n%1: %2").arg(QString::fromStdString(failure.first),
+                                               QString::fromStdString(failure.second)));
+        }
+        QMessageBox::warning(this, "Change Password", msg);
+    }
+}
+
+/**
+ * @brief Chooses the key derivation for playbooks that are saved with a new
+ * password. Its parameters are calibrated, so that deriving a key takes the
+ * chosen time on this machine.
+ */
+void MainDialog::calibrateKeyDerivation() {
+    PBCKdfSettings current = PBCStorage::getInstance()->keyDerivation();
+    QStringList algorithms;
+    algorithms << PBCKdfSettings::ARGON2ID << PBCKdfSettings::PBKDF2;
+    bool ok;
+    QString algorithm = QInputDialog::getItem(this, "Key Derivation",
+                                              QString("Current: %1\n\nAlgorithm").arg(
+                                                      QString::fromStdString(current.toString())),
+                                              algorithms,
+                                              std::max(0, algorithms.indexOf(QString::fromStdString(current.algorithm))),
+                                              false, &ok);
+    if (ok == false) {
+        return;
+    }
+    int targetTime = QInputDialog::getInt(this, "Key Derivation",
+                                          "Time for deriving a key (in milliseconds)",
+                                          250, 50, 5000, 50, &ok);
+    if (ok == false) {
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    try {
+        PBCKdfSettings kdf = PBCStorage::getInstance()->calibrateKeyDerivation(
+                algorithm.toStdString(), std::chrono::milliseconds(targetTime));
+        std::chrono::microseconds time = PBCKeyDerivation::benchmark(kdf);
+        QApplication::restoreOverrideCursor();
+        QMessageBox::information(this, "Key Derivation",
+                                 QString("New passwords use %1 (%2 ms).\n"
+                                         "Existing playbooks keep their key derivation until "
+                                         "their password is changed.").arg(
+                                         QString::fromStdString(kdf.toString()),
+                                         QString::number(time.count() / 1000.0, 'f', 1)));
+    } catch (std::exception& e) {
+        QApplication::restoreOverrideCursor();
+        QMessageBox::warning(this, "Key Derivation", e.what());
+    }
+}
+
+/**
+ * @brief Replaces the active playbook by one of the snapshots that have been
+ * taken of its file (see PBCStorage::restoreActivePlaybook()).
+ */
+void MainDialog::restoreBackup() {
+    const std::string fileName = PBCStorage::getInstance()->currentPlaybookFileName();
+    std::vector<PBCBackupStore::Snapshot> snapshots;
+    if (fileName != "") {
+        snapshots = PBCStorage::getInstance()->backups(fileName);
+    }
+    if (snapshots.empty()) {
+        QMessageBox::information(this, "Restore Backup", "There are no backups of this playbook yet.");
+        return;
+    }
+    // the snapshots are identified by their id, because two of them can have the same label
+    QDialog dialog(this);
+    dialog.setWindowTitle("Restore Backup");
+    QLayout* layout = new QVBoxLayout;
+    layout->addWidget(new QLabel("The current state is backed up before it is replaced.\n\nBackup"));
+    QListWidget* list = new QListWidget;
+    for (const PBCBackupStore::Snapshot& snapshot : snapshots) {
+        QListWidgetItem* item = new QListWidgetItem(QString("%1 (%2 KiB)").arg(
+                QDateTime::fromSecsSinceEpoch(snapshot.time).toString("yyyy-MM-dd HH:mm:ss"),
+                QString::number(snapshot.size() / 1024)), list);
+        item->setData(Qt::UserRole, QString::fromStdString(snapshot.id));
+    }
+    list->setCurrentRow(0);
+    layout->addWidget(list);
+    QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    layout->addWidget(buttons);
+    dialog.setLayout(layout);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    connect(list, &QListWidget::itemDoubleClicked, &dialog, &QDialog::accept);
+    if (dialog.exec() != QDialog::Accepted || list->currentItem() == NULL) {
+        return;
+    }
+    const std::string snapshotId = list->currentItem()->data(Qt::UserRole).toString().toStdString();
+    bool ok;
+    QString password = QInputDialog::getText(this, "Restore Backup",
+                                             "Enter the password the playbook had at that time",
+                                             QLineEdit::Password, "", &ok);
+    if (ok == false) {
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    try {
+        PBCStorage::getInstance()->restoreActivePlaybook(password.toStdString(), snapshotId);
+        QApplication::restoreOverrideCursor();
+    } catch (std::exception& e) {
+        QApplication::restoreOverrideCursor();
+        QMessageBox::warning(this, "Restore Backup", e.what());
+        return;
+    }
+    _playView->resetPlay();
+    resetForNewPlaybook();
+    updateTitle(true);
+}
+
+/**
+ * @brief Removes the routes, formations, motions and category links that no
+ * play needs anymore.
+ *
+ * A dry run is shown first, so the user can see what would be removed and how
+ * much smaller and faster to load the playbook would become.
+ */
+void MainDialog::compactPlaybook() {
+    PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    PBCCompactionReport report = PBCPlaybookCompaction::compact(*playbook, false);
+    QApplication::restoreOverrideCursor();
+    if (report.empty()) {
+        QMessageBox::information(this, "Compact Playbook", "There is nothing to remove.");
+        return;
+    }
+
+    QStringList lines;
+    if (!report.routes.empty()) {
+        lines << QString("%1 unused routes").arg(report.routes.size());
+    }
+    if (!report.formations.empty()) {
+        lines << QString("%1 unused formations").arg(report.formations.size());
+    }
+    if (report.emptyMotions > 0) {
+        lines << QString("%1 empty motions").arg(report.emptyMotions);
+    }
+    if (!report.categoryLinks.empty()) {
+        lines << QString("%1 broken category links (%2 deleted plays)").arg(
+                QString::number(report.categoryLinks.size()),
+                QString::number(report.staleCategoryPlays));
+    }
+    QString text = QString("Compacting removes or repairs\n\n%1\n\n"
+                           "The playbook shrinks from %2 KiB to %3 KiB and loads in %4 ms instead of %5 ms.").arg(
+            lines.join("\n"),
+            QString::number(report.bytesBefore / 1024),
+            QString::number(report.bytesAfter / 1024),
+            QString::number(report.loadMicrosAfter / 1000.0, 'f', 1),
+            QString::number(report.loadMicrosBefore / 1000.0, 'f', 1));
+    QMessageBox::StandardButton answer = QMessageBox::question(this, "Compact Playbook", text,
+                                                               QMessageBox::Ok | QMessageBox::Cancel);
+    if (answer != QMessageBox::Ok) {
+        return;
+    }
+    try {
+        PBCPlaybookCompaction::compact(*playbook, true);
+    } catch (PBCAutoSaveException &e) {
+        // the playbook has not been saved to a file yet, so it will be saved compacted
+    }
+    ui->statusbar->showMessage("Playbook compacted", 2000);
+}
+
 /**
  * @brief Exports the playbook to a PDF file.
  *
@@ -650,21 +1234,348 @@ void MainDialog::exportAsPDF() {
             pbcAssert(files.size() == 1);
             QString fileName = files.first();
 
-            PBCStorage::getInstance()->exportAsPDF(fileName.toStdString(),
-                                                   playListSP,
-                                                   returnStruct->paperWidth,
-                                                   returnStruct->paperHeight,
-                                                   returnStruct->columns,
-                                                   returnStruct->rows,
-                                                   returnStruct->marginLeft,
-                                                   returnStruct->marginRight,
-                                                   returnStruct->marginTop,
-                                                   returnStruct->marginBottom);
+            PBCPDFLayout layout{returnStruct->paperWidth,
+                                returnStruct->paperHeight,
+                                returnStruct->columns,
+                                returnStruct->rows,
+                                returnStruct->marginLeft,
+                                returnStruct->marginRight,
+                                returnStruct->marginTop,
+                                returnStruct->marginBottom};
+            try {
+                PBCPDFExportJob job(fileName.toStdString(), *playListSP, layout);
+                // the modal progress dialog processes the events whenever its
+                // value is set, so the window stays responsive between the pages
+                QProgressDialog progressDialog("Exporting plays...", "Cancel", 0, job.pages(), this);
+                progressDialog.setWindowTitle("Export Playbook As PDF");
+                progressDialog.setWindowModality(Qt::WindowModal);
+                progressDialog.setMinimumDuration(300);
+                while (job.step() == false) {
+                    progressDialog.setLabelText(QString("Exporting page %1 of %2...")
+                                                .arg(job.pagesDone() + 1)
+                                                .arg(job.pages()));
+                    progressDialog.setValue(job.pagesDone());
+                    if (progressDialog.wasCanceled()) {
+                        job.cancel();
+                    }
+                }
+                progressDialog.setValue(job.pages());
+                if (job.finished()) {
+                    ui->statusbar->showMessage("Playbook exported", 2000);
+                }
+            } catch (PBCStorageException& e) {
+                QMessageBox::critical(this, "Export Playbook As PDF", e.what());
+            }
         }
     }
 }
 
 
+/**
+ * @brief Asks for the grid of a booklet, which is printed on A4 paper
+ * @return false if the user has cancelled
+ */
+static bool askBookletLayout(QWidget* parent, const QString& title, PBCPDFLayout& layout) {  // NOLINT
+    bool ok;
+    int columns = QInputDialog::getInt(parent, title, "Plays per row", 2, 1, 10, 1, &ok);
+    if (ok == false) {
+        return false;
+    }
+    int rows = QInputDialog::getInt(parent, title, "Rows per page", 3, 1, 10, 1, &ok);
+    if (ok == false) {
+        return false;
+    }
+    layout = PBCPDFLayout{210, 297, static_cast<unsigned int>(columns), static_cast<unsigned int>(rows), 0, 0, 0, 0};
+    return true;
+}
+
+static void showBookletReport(QWidget* parent, const QString& title, const PBCBookletReport& report) {
+    QString message = QString("%1 booklets built.").arg(report.written.size());
+    if (report.skipped.empty() == false) {
+        message += QString(" %1 unchanged booklets skipped.").arg(report.skipped.size());
+    }
+    if (report.failures.empty()) {
+        QMessageBox::information(parent, title, message);
+    } else {
+        message += "\n\nThe following booklets could not be built:";
+        for (const std::pair<std::string, std::string>& failure : report.failures) {
+            message += QString("\n%1: %2").arg(QString::fromStdString(failure.first),
+                                                QString::fromStdString(failure.second));
+        }
+        QMessageBox::warning(parent, title, message);
+    }
+}
+
+/**
+ * @brief Exports one PDF booklet per category into a directory.
+ *
+ * The booklets are printed on A4 paper. Exporting into the same directory
+ * again only rebuilds the booklets whose plays have changed (see
+ * PBCBookletExport).
+ */
+void MainDialog::exportBooklets() {
+    PBCPDFLayout layout;
+    if (askBookletLayout(this, "Export Category Booklets", layout) == false) {
+        return;
+    }
+    QString directory = QFileDialog::getExistingDirectory(this, "Export Category Booklets",
+                                                          getLastPlaybookLocation(""));
+    if (directory.isEmpty()) {
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    PBCBookletReport report;
+    try {
+        report = PBCBookletExport::exportBooklets(PBCController::getInstance()->getPlaybook(),
+                                                  directory.toStdString(),
+                                                  layout);
+    } catch (PBCStorageException& e) {
+        QApplication::restoreOverrideCursor();
+        QMessageBox::critical(this, "Export Category Booklets", e.what());
+        return;
+    }
+    QApplication::restoreOverrideCursor();
+    showBookletReport(this, "Export Category Booklets", report);
+}
+
+/**
+ * @brief Exports one PDF booklet per position into a directory, in which the
+ * assignment of the position is emphasized.
+ *
+ * The user enters category names, play names and search terms (or nothing
+ * for all plays) and the short names of the roles (or nothing for all
+ * roles).
+ */
+void MainDialog::exportRoleBooklets() {
+    PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+    const QString title = "Export Position Booklets";
+    bool ok;
+    QString input = QInputDialog::getText(this, title,
+                                          "Categories, plays or search terms (separated by commas, "
+                                          "empty for all plays)",
+                                          QLineEdit::Normal, "", &ok);
+    if (ok == false) {
+        return;
+    }
+    PBCPlaySelection selection = parsePlaySelection(playbook, input);
+    QString roleInput = QInputDialog::getText(this, title,
+                                              "Positions, e.g. \"QB, WRL\" (separated by commas, "
+                                              "empty for all positions)",
+                                              QLineEdit::Normal, "", &ok);
+    if (ok == false) {
+        return;
+    }
+    std::vector<std::string> roles;
+    for (const QString& role : roleInput.split(",", QString::SkipEmptyParts)) {
+        if (role.trimmed().isEmpty() == false) {
+            roles.push_back(role.trimmed().toStdString());
+        }
+    }
+    PBCPDFLayout layout;
+    if (askBookletLayout(this, title, layout) == false) {
+        return;
+    }
+    QString directory = QFileDialog::getExistingDirectory(this, title, getLastPlaybookLocation(""));
+    if (directory.isEmpty()) {
+        return;
+    }
+
+    std::vector<PBCPlaySP> plays;
+    for (const std::string& name : playbook->getPlayNames()) {
+        PBCPlaySP play = playbook->getPlay(name);
+        if (selection.empty() || selection.matches(*play)) {
+            plays.push_back(play);
+        }
+    }
+    if (plays.empty()) {
+        QMessageBox::information(this, title, "No plays match the selection.");
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    PBCBookletReport report;
+    try {
+        report = PBCBookletExport::exportRoleBooklets(plays, roles, directory.toStdString(), layout);
+    } catch (PBCStorageException& e) {
+        QApplication::restoreOverrideCursor();
+        QMessageBox::critical(this, title, e.what());
+        return;
+    }
+    QApplication::restoreOverrideCursor();
+    showBookletReport(this, title, report);
+}
+
+/**
+ * @brief Exports plays as PNG or SVG images or as PNG sprite sheets into a
+ * directory.
+ *
+ * The user enters category names, play names and search terms (or nothing
+ * for all plays). Exporting into the same directory again only rewrites the
+ * images of the plays that have changed (see PBCImageExport).
+ */
+void MainDialog::exportImages() {
+    PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+    bool ok;
+    QString input = QInputDialog::getText(this, "Export Images",
+                                          "Categories, plays or search terms (separated by commas, "
+                                          "empty for all plays)",
+                                          QLineEdit::Normal, "", &ok);
+    if (ok == false) {
+        return;
+    }
+    PBCPlaySelection selection = parsePlaySelection(playbook, input);
+
+    QStringList formats;
+    formats << "PNG images" << "SVG images" << "PNG sprite sheets";
+    QString format = QInputDialog::getItem(this, "Export Images", "Format", formats, 0, false, &ok);
+    if (ok == false) {
+        return;
+    }
+    PBCImageExportOptions options;
+    options.format = static_cast<PBCImageExportOptions::Format>(formats.indexOf(format));
+    if (options.format != PBCImageExportOptions::SVG) {
+        options.dpi = QInputDialog::getInt(this, "Export Images", "Resolution (dpi)",
+                                           options.dpi,
+                                           PBCImageExportOptions::MIN_DPI,
+                                           PBCImageExportOptions::MAX_DPI,
+                                           10, &ok);
+        if (ok == false) {
+            return;
+        }
+    }
+
+    QString directory = QFileDialog::getExistingDirectory(this, "Export Images", getLastPlaybookLocation(""));
+    if (directory.isEmpty()) {
+        return;
+    }
+
+    std::vector<std::string> playNames;
+    for (const std::string& name : playbook->getPlayNames()) {
+        if (selection.empty() || selection.matches(*playbook->getPlay(name))) {
+            playNames.push_back(name);
+        }
+    }
+    if (playNames.empty()) {
+        QMessageBox::information(this, "Export Images", "No plays match the selection.");
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    PBCImageExportReport report;
+    try {
+        report = PBCImageExport::exportPlays(playbook, playNames, directory.toStdString(), options);
+    } catch (PBCStorageException& e) {
+        QApplication::restoreOverrideCursor();
+        QMessageBox::critical(this, "Export Images", e.what());
+        return;
+    }
+    QApplication::restoreOverrideCursor();
+
+    QString message = QString("%1 images written, %2 unchanged images skipped.")
+            .arg(report.written.size())
+            .arg(report.skipped.size());
+    if (report.failures.empty()) {
+        QMessageBox::information(this, "Export Images", message);
+    } else {
+        message += "\n\nThe following images could not be written:";
+        for (const std::pair<std::string, std::string>& failure : report.failures) {
+            message += QString("\n%1: %2").arg(QString::fromStdString(failure.first),
+                                                QString::fromStdString(failure.second));
+        }
+        QMessageBox::warning(this, "Export Images", message);
+    }
+}
+
+
+/**
+ * @brief Exports plays to several PDF files with different layouts at once.
+ *
+ * The PBCExportPDFDialog asks for the plays and the first layout. Further
+ * layouts are entered as grids (e.g. "4x2"), optionally with their paper size
+ * (e.g. "3x1@100x50"); they share the margins of the first layout. Every
+ * play is rendered only once for all layouts (see PBCMultiLayoutExportJob).
+ */
+void MainDialog::exportLayouts() {
+    const QString title = "Export Playbook In Several Layouts";
+    PBCExportPDFDialog exportDialog;
+    exportDialog.setWindowModality(Qt::ApplicationModal);
+    boost::shared_ptr<PBCExportPDFDialog::ReturnStruct> returnStruct(new PBCExportPDFDialog::ReturnStruct());  //NOLINT
+    boost::shared_ptr<QStringList> playListSP = exportDialog.exec(returnStruct);
+    if (playListSP == NULL || playListSP->empty()) {
+        return;
+    }
+    PBCPDFLayout firstLayout{returnStruct->paperWidth,
+                             returnStruct->paperHeight,
+                             returnStruct->columns,
+                             returnStruct->rows,
+                             returnStruct->marginLeft,
+                             returnStruct->marginRight,
+                             returnStruct->marginTop,
+                             returnStruct->marginBottom};
+    bool ok;
+    QString input = QInputDialog::getText(this, title,
+                                          "Further layouts as columns x rows, optionally with the paper size "
+                                          "in mm (e.g. \"1x1, 4x2, 3x1@100x50\")",
+                                          QLineEdit::Normal, "", &ok);
+    if (ok == false) {
+        return;
+    }
+    std::vector<PBCPDFLayout> layouts = {firstLayout};
+    for (const QString& spec : input.split(",", QString::SkipEmptyParts)) {
+        PBCPDFLayout layout = firstLayout;
+        if (PBCMultiLayoutExportJob::parseLayout(spec.toStdString(), layout) == false) {
+            QMessageBox::warning(this, title, QString("'%1' is not a valid layout.").arg(spec.trimmed()));
+            return;
+        }
+        layouts.push_back(layout);
+    }
+
+    std::string stdFile = PBCController::getInstance()->getPlaybook()->name() + ".pdf";
+    QString fileName = QFileDialog::getSaveFileName(this, title,
+                                                    getLastPlaybookLocation(QString::fromStdString(stdFile)),
+                                                    "PDF Documents (*.pdf);;All Files (*.*)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    if (fileName.endsWith(".pdf")) {
+        fileName.chop(4);
+    }
+    std::vector<PBCPDFTarget> targets;
+    for (const PBCPDFLayout& layout : layouts) {
+        PBCPDFTarget target{PBCMultiLayoutExportJob::fileName(fileName.toStdString(), layout), layout};
+        if (std::none_of(targets.begin(), targets.end(), [&target](const PBCPDFTarget& other) {
+                return other.fileName == target.fileName;
+            })) {
+            targets.push_back(target);
+        }
+    }
+    std::vector<PBCPlaySP> plays;
+    for (const QString& name : *playListSP) {
+        plays.push_back(PBCController::getInstance()->getPlaybook()->getPlay(name.toStdString()));
+    }
+
+    try {
+        PBCMultiLayoutExportJob job(plays, targets);
+        QProgressDialog progressDialog("Exporting plays...", "Cancel", 0, job.steps(), this);
+        progressDialog.setWindowTitle(title);
+        progressDialog.setWindowModality(Qt::WindowModal);
+        progressDialog.setMinimumDuration(300);
+        while (job.step() == false) {
+            progressDialog.setValue(job.stepsDone());
+            if (progressDialog.wasCanceled()) {
+                job.cancel();
+            }
+        }
+        progressDialog.setValue(job.steps());
+        if (job.finished()) {
+            ui->statusbar->showMessage(QString("Playbook exported in %1 layouts").arg(targets.size()), 2000);
+        }
+    } catch (PBCStorageException& e) {
+        QMessageBox::critical(this, title, e.what());
+    }
+}
+
 /**
  * @brief Adds the current play to a category.
  *
@@ -761,6 +1672,9 @@ void MainDialog::deleteCategories() {
  * @brief The destructor
  */
 MainDialog::~MainDialog() {
+    PBCController::getInstance()->getPlaybook()->history().setListener(PBCUndoStack::Listener());
+    PBCStorage::getInstance()->setSaveFailureListener(std::function<void(const std::string&)>());
+    delete _updateChecker;
     delete ui;
 }
 
@@ -832,6 +1746,72 @@ void MainDialog::savePlayAs(std::string name, std::string codename) {
     _playView->showPlay(name);
 }
 
+/**
+ * @brief Undoes the most recent edit of the current playbook
+ */
+void MainDialog::undo() {
+    PBCUndoCommandSP command = PBCController::getInstance()->getPlaybook()->history().undo();
+    if (command == NULL) {
+        ui->statusbar->showMessage("Nothing to undo", 2000);
+        return;
+    }
+    showUndoneCommand(command);
+    ui->statusbar->showMessage(QString::fromStdString("Undo " + command->text()), 2000);
+}
+
+/**
+ * @brief Redoes the most recently undone edit of the current playbook
+ */
+void MainDialog::redo() {
+    PBCUndoCommandSP command = PBCController::getInstance()->getPlaybook()->history().redo();
+    if (command == NULL) {
+        ui->statusbar->showMessage("Nothing to redo", 2000);
+        return;
+    }
+    showUndoneCommand(command);
+    ui->statusbar->showMessage(QString::fromStdString("Redo " + command->text()), 2000);
+}
+
+/**
+ * @brief Saves the playbook after an undo / redo step and displays the
+ * affected play.
+ * @param command The command that has been undone or redone
+ */
+void MainDialog::showUndoneCommand(PBCUndoCommandSP command) {
+    try {
+        PBCStorage::getInstance()->automaticSavePlaybook();
+        updateTitle(true);
+    } catch (const PBCAutoSaveException& e) {
+        updateTitle(false);
+    }
+    PBCPlaySP play = command->affectedPlay();
+    if (play != NULL) {
+        _playView->restorePlay(play);
+    } else {
+        _playView->repaint();
+    }
+}
+
+/**
+ * @brief Shows the description of the next undo / redo step in the Edit menu
+ * and enables the actions (and thus their shortcuts) only if there is a step
+ */
+void MainDialog::updateUndoActions() {
+    const PBCUndoStack& history = PBCController::getInstance()->getPlaybook()->history();
+    QString undoText = "Undo";
+    if (history.canUndo()) {
+        undoText += QString::fromStdString(" " + history.undoText());
+    }
+    QString redoText = "Redo";
+    if (history.canRedo()) {
+        redoText += QString::fromStdString(" " + history.redoText());
+    }
+    ui->actionUndo->setText(undoText);
+    ui->actionRedo->setText(redoText);
+    ui->actionUndo->setEnabled(history.canUndo());
+    ui->actionRedo->setEnabled(history.canRedo());
+}
+
 void MainDialog::savePlayAsNamed() {
     std::string name = ui->playNameLineEdit->text().toStdString();
     std::string codename = ui->codeNameLineEdit->text().toStdString();
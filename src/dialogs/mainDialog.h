@@ -25,6 +25,10 @@
 #include <QMainWindow>
 
 #include "gui/pbcPlayView.h"
+#include "gui/pbcDiagnosticsDock.h"
+#include "util/pbcUndoStack.h"
+#include "util/pbcUpdateChecker.h"
+#include "util/pbcLoadJob.h"
 #include <string>
 
 namespace Ui {
@@ -39,6 +43,10 @@ class MainDialog : public QMainWindow {
     PBCPlayView* _playView;
     std::list<PBCPlaySP> _currentlySelectedPlays;
     std::list<PBCPlaySP>::const_iterator _currentPlay;
+    PBCUpdateChecker* _updateChecker;
+    QAction* _updateCheckAction;
+    PBCDiagnosticsDock* _diagnosticsDock;
+    bool _saveFailurePending;
 
     void resetForNewPlaybook();
     void updateTitle(bool saved);
@@ -46,6 +54,14 @@ class MainDialog : public QMainWindow {
     void resizeEvent(QResizeEvent* e);
     void wheelEvent(QWheelEvent *event);
     void savePlayAs(std::string name, std::string codename);
+    void showUndoneCommand(PBCUndoCommandSP command);
+    bool runLoadJob(PBCLoadJob& job, const QString& title);  // NOLINT
+    PBCPlaybookSP openPlaybookForMerge(const QString& title);
+    void checkForUpdates();
+    void setUpdateCheckEnabled(bool enabled);
+    void showUpdateNotice(const PBCReleaseInfo& info);
+    void toggleDiagnosticsDock();
+    void reportFailedSave(const std::string& message);
 
  public:
     explicit MainDialog(QWidget *parent = 0);
@@ -71,7 +87,17 @@ class MainDialog : public QMainWindow {
     void loadPlaybook(QString fileName);
     void openPlaybook();
     void importPlaybook();
+    void mergePlaybook();
+    void exportSubPlaybook();
+    void changePassword();
+    void calibrateKeyDerivation();
+    void restoreBackup();
+    void compactPlaybook();
     void exportAsPDF();
+    void exportLayouts();
+    void exportImages();
+    void exportBooklets();
+    void exportRoleBooklets();
     void showAboutDialog();
     void addPlayToCategory();
     void deleteRoutes();
@@ -83,6 +109,9 @@ class MainDialog : public QMainWindow {
     void changeActivePlayerRoute(int index);
     void changeActivePlayerName(QString name);
     void changeActivePlayerNr(int nr);
+    void undo();
+    void redo();
+    void updateUndoActions();
 };
 
 #endif  // MAINDIALOG_H
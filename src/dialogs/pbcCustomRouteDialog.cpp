@@ -23,12 +23,12 @@
 #include "ui_pbcCustomRouteDialog.h"
 #include "util/pbcConfig.h"
 #include "util/pbcExceptions.h"
+#include "util/pbcLog.h"
 #include "util/pbcStorage.h"
 #include "gui/pbcSettings.h"
 #include "pbcController.h"
 #include "models/pbcPlaybook.h"
 #include "dialogs/pbcSetPasswordDialog.h"
-#include <QDebug>
 #include <QMessageBox>
 #include <string>
 #include <QFileDialog>
@@ -53,8 +53,13 @@ void PBCCustomRouteDialog::savePlaybookOnRouteCreation() {
         int returnCode = pwDialog.exec();
         if (returnCode == QDialog::Accepted) {
             QString password = pwDialog.getPassword();
-            PBCStorage::getInstance()->savePlaybook(password.toStdString(),
-                                                    fileName.toStdString());
+            try {
+                PBCStorage::getInstance()->savePlaybook(password.toStdString(),
+                                                        fileName.toStdString());
+            } catch (const PBCSaveException& e) {
+                QMessageBox::warning(this, "Save Playbook", QString::fromStdString(e.what()));
+                return;
+            }
             setLastPlaybookLocation(QFileInfo(fileName));
         }
     }
@@ -69,7 +74,7 @@ PBCCustomRouteDialog::PBCCustomRouteDialog(QWidget *parent) :
     ui->graphicsView->setScene(_crv.get());
     ui->graphicsView->setFixedWidth(_crv->sceneRect().width() + 2);
     ui->graphicsView->setFixedHeight(_crv->sceneRect().height() + 2);
-    qDebug() << this->size();
+    PBC_LOG_DEBUG("gui", "custom route dialog size: " << width() << "x" << height());
 }
 
 PBCCustomRouteDialog::~PBCCustomRouteDialog() {
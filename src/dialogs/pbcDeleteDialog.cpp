@@ -23,13 +23,36 @@
 #include "ui_pbcDeleteDialog.h"
 #include "pbcController.h"
 #include "models/pbcPlaybook.h"
+#include "models/pbcPlay.h"
 #include "pbcController.h"
+#include "util/pbcPerf.h"
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Lists the plays that use an entry that is about to be deleted
+ * @param plays The plays
+ * @return The tooltip text or an empty string if no play uses the entry
+ */
+static QString usageToolTip(const std::set<PBCPlaySP>& plays) {
+    if (plays.empty()) {
+        return QString();
+    }
+    QStringList playNames;
+    for (const PBCPlaySP& play : plays) {
+        playNames.append(QString::fromStdString(play->name()));
+    }
+    playNames.sort();
+    return QString("Used in %1 play(s): %2").arg(plays.size()).arg(playNames.join(", "));
+}
 
 
 PBCDeleteDialog::PBCDeleteDialog(DELETE_ENUM delete_enum, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::PBCDeleteDialog),
     _nameList(new QStringList()){
+    PBC_PERF_SCOPE("dialog.populate.delete");
     ui->setupUi(this);
 
     std::vector<std::string> names;
@@ -51,10 +74,24 @@ PBCDeleteDialog::PBCDeleteDialog(DELETE_ENUM delete_enum, QWidget *parent) :
     }
 
 
+    PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
     for(const std::string& name : names) {
         QListWidgetItem* listItem =
                 new QListWidgetItem(QString::fromStdString(name),
                                     ui->nameListWidget);
+        switch (delete_enum) {
+            case DELETE_ENUM::DELETE_FORMATIONS:
+                listItem->setToolTip(usageToolTip(playbook->playsUsingFormation(name)));
+                break;
+            case DELETE_ENUM::DELETE_CATEGORIES:
+                listItem->setToolTip(usageToolTip(playbook->playsInCategory(name)));
+                break;
+            case DELETE_ENUM::DELETE_ROUTES:
+                listItem->setToolTip(usageToolTip(playbook->playsUsingRoute(name)));
+                break;
+            default:
+                break;
+        }
         ui->nameListWidget->addItem(listItem);
     }
     ui->nameListWidget->setSelectionMode(QAbstractItemView::ExtendedSelection);
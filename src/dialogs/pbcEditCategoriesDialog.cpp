@@ -25,6 +25,8 @@
 #include "models/pbcPlaybook.h"
 
 #include "models/pbcPlay.h"
+#include "models/pbcUndoCommands.h"
+#include "util/pbcPerf.h"
 #include <string>
 #include <QMessageBox>
 
@@ -55,6 +57,7 @@ void PBCEditCategoriesDialog::editCategories() {
 }
 
 void PBCEditCategoriesDialog::refreshList() {
+    PBC_PERF_SCOPE("dialog.populate.editCategories");
     ui->categoryListWidget->clear();
     std::list<PBCCategorySP> categories = PBCController::getInstance()->getPlaybook()->categories();  // NOLINT
     for (PBCCategorySP categorySP : categories) {
@@ -75,10 +78,13 @@ void PBCEditCategoriesDialog::refreshList() {
 }
 
 void PBCEditCategoriesDialog::updateCategoryAssignment() {
+    PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+    PBCPlaybookEditCommandSP command(new PBCPlaybookEditCommand(playbook.get(), "Edit Categories"));  // NOLINT
     for(int i = 0; i < ui->categoryListWidget->count(); i++) {
         QListWidgetItem* item = ui->categoryListWidget->item(i);
         std::string categoryName = item->text().toStdString();
-        PBCCategorySP category = PBCController::getInstance()->getPlaybook()->getCategory(categoryName);  // NOLINT
+        PBCCategorySP category = playbook->getCategory(categoryName);
+        bool linked = _playSP->categories().count(category) > 0;
         if (item->checkState() == Qt::Checked) {
             _playSP->addCategory(category);
             category->addPlay(_playSP);
@@ -87,6 +93,12 @@ void PBCEditCategoriesDialog::updateCategoryAssignment() {
             _playSP->removeCategory(category);
             category->removePlay(_playSP);
         }
+        if (linked != (item->checkState() == Qt::Checked)) {
+            command->categoryLinkChanged(_playSP, category, !linked);
+        }
+    }
+    if (!command->empty()) {
+        playbook->history().push(command);
     }
 }
 
@@ -94,9 +106,14 @@ void PBCEditCategoriesDialog::updateCategoryAssignment() {
 void PBCEditCategoriesDialog::createCategory() {
     std::string categoryName = ui->newCategoryEdit->text().toStdString();
     PBCCategorySP categorySP(new PBCCategory(categoryName));
+    PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+    PBCUndoMacroScope macro(playbook->history(), "New Category");
+    PBCPlaybookEditCommandSP command(new PBCPlaybookEditCommand(playbook.get(), "New Category"));  // NOLINT
     _playSP->addCategory(categorySP);
     categorySP->addPlay(_playSP);
-    bool successfull = PBCController::getInstance()->getPlaybook()->addCategory(categorySP, false);  // NOLINT
+    command->categoryLinkChanged(_playSP, categorySP, true);
+    playbook->history().push(command);
+    bool successfull = playbook->addCategory(categorySP, false);
     if(successfull) {
         updateCategoryAssignment();
         refreshList();
@@ -23,12 +23,14 @@
 #include "ui_pbcNewPlayDialog.h"
 #include "pbcController.h"
 #include "models/pbcPlaybook.h"
+#include "util/pbcPerf.h"
 #include <vector>
 #include <string>
 
 PBCNewPlayDialog::PBCNewPlayDialog(QWidget *parent) :
     QDialog(parent),
     ui(new Ui::PBCNewPlayDialog) {
+    PBC_PERF_SCOPE("dialog.populate.newPlay");
     ui->setupUi(this);
     QStringList formationList;
     std::vector<std::string> formationNames =
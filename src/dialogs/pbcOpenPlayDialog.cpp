@@ -26,6 +26,7 @@
 #include "models/pbcPlaybook.h"
 #include "models/pbcPlay.h"
 #include "util/pbcDeclarations.h"
+#include "util/pbcPerf.h"
 
 #include <list>
 #include <map>
@@ -107,6 +108,7 @@ void PBCOpenPlayDialog::filterCategory(QListWidgetItem *item) {
 }
 
 void PBCOpenPlayDialog::reset() {
+    PBC_PERF_SCOPE("dialog.populate.openPlay");
     ui->nameComboBox->clear();
     ui->codeNameComboBox->clear();
     ui->categoryListWidget->clear();
@@ -0,0 +1,179 @@
+/** @file pbcDiagnosticsDock.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcDiagnosticsDock.h"
+#include "util/pbcPerf.h"
+#include "util/pbcTrace.h"
+#include <QFile>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QStringList>
+#include <QVBoxLayout>
+#include <string>
+#include <vector>
+
+static QString formatValue(const PBCPerfSnapshot& metric, double value) {
+    if (metric.kind == PBCPerfSnapshot::COUNTER) {
+        return QString::number(value, 'f', 0);
+    }
+    return QString::number(value / 1000.0, 'f', 3);  // microseconds to milliseconds
+}
+
+/**
+ * @brief The constructor. The dock is hidden initially.
+ * @param parent The main window
+ */
+PBCDiagnosticsDock::PBCDiagnosticsDock(QWidget *parent) :
+    QDockWidget("Diagnostics", parent) {
+    setObjectName("diagnosticsDock");
+    QWidget* content = new QWidget(this);
+    QVBoxLayout* layout = new QVBoxLayout(content);
+
+    QHBoxLayout* buttonLayout = new QHBoxLayout();
+    _recordCheckBox = new QCheckBox("Record", content);
+    _recordCheckBox->setChecked(PBCPerf::enabled());
+    _traceCheckBox = new QCheckBox("Trace", content);
+    _traceCheckBox->setChecked(PBCTrace::enabled());
+    QPushButton* resetButton = new QPushButton("Reset", content);
+    QPushButton* saveButton = new QPushButton("Save as JSON...", content);
+    QPushButton* saveTraceButton = new QPushButton("Save Trace...", content);
+    buttonLayout->addWidget(_recordCheckBox);
+    buttonLayout->addWidget(_traceCheckBox);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(resetButton);
+    buttonLayout->addWidget(saveButton);
+    buttonLayout->addWidget(saveTraceButton);
+    layout->addLayout(buttonLayout);
+
+    _table = new QTableWidget(0, 7, content);
+    _table->setHorizontalHeaderLabels(QStringList()
+                                      << "Metric" << "Count" << "Total [ms]" << "Mean [ms]"
+                                      << "p50 [ms]" << "p95 [ms]" << "Max [ms]");
+    _table->verticalHeader()->hide();
+    _table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    _table->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    layout->addWidget(_table);
+    setWidget(content);
+
+    connect(_recordCheckBox, &QCheckBox::toggled, this, [](bool checked) {
+        PBCPerf::setEnabled(checked);
+    });
+    connect(_traceCheckBox, &QCheckBox::toggled, this, [](bool checked) {
+        if (checked) {
+            PBCTrace::setThreadName("GUI");
+        }
+        PBCTrace::setEnabled(checked);
+    });
+    connect(resetButton, &QPushButton::clicked, this, [this]() {
+        PBCPerf::reset();
+        PBCTrace::clear();
+        refresh();
+    });
+    connect(saveButton, &QPushButton::clicked, this, [this]() {
+        saveAsJson();
+    });
+    connect(saveTraceButton, &QPushButton::clicked, this, [this]() {
+        saveTrace();
+    });
+    connect(&_refreshTimer, &QTimer::timeout, this, [this]() {
+        refresh();
+    });
+    _refreshTimer.setInterval(1000);
+    hide();
+}
+
+/**
+ * @brief Shows the current values of all metrics that have been recorded
+ * at least once. For counters, the values are sums instead of durations.
+ */
+void PBCDiagnosticsDock::refresh() {
+    std::vector<PBCPerfSnapshot> metrics;
+    for (const PBCPerfSnapshot& metric : PBCPerf::snapshot()) {
+        if (metric.count > 0) {
+            metrics.push_back(metric);
+        }
+    }
+    _table->setRowCount(metrics.size());
+    for (unsigned int row = 0; row < metrics.size(); ++row) {
+        const PBCPerfSnapshot& metric = metrics[row];
+        QStringList values;
+        values << QString::fromStdString(metric.name)
+               << QString::number(metric.count)
+               << formatValue(metric, metric.sum)
+               << formatValue(metric, metric.mean())
+               << formatValue(metric, metric.percentile(0.5))
+               << formatValue(metric, metric.percentile(0.95))
+               << formatValue(metric, metric.max);
+        for (int column = 0; column < values.size(); ++column) {
+            QTableWidgetItem* item = new QTableWidgetItem(values[column]);
+            if (column > 0) {
+                item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            }
+            _table->setItem(row, column, item);
+        }
+    }
+}
+
+void PBCDiagnosticsDock::showEvent(QShowEvent *event) {
+    QDockWidget::showEvent(event);
+    refresh();
+    _refreshTimer.start();
+}
+
+void PBCDiagnosticsDock::hideEvent(QHideEvent *event) {
+    _refreshTimer.stop();
+    QDockWidget::hideEvent(event);
+}
+
+void PBCDiagnosticsDock::saveAsJson() {
+    QString fileName = QFileDialog::getSaveFileName(this,
+                                                    "Save diagnostics",
+                                                    "pbc-diagnostics.json",
+                                                    "JSON Files (*.json)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+        file.write(QByteArray::fromStdString(PBCPerf::toJson())) < 0) {
+        QMessageBox::warning(this, "Diagnostics", "Could not write " + fileName);
+    }
+}
+
+/**
+ * @brief Saves the recorded spans in the Chrome trace-event format, which can
+ * be opened in chrome://tracing or ui.perfetto.dev
+ */
+void PBCDiagnosticsDock::saveTrace() {
+    QString fileName = QFileDialog::getSaveFileName(this,
+                                                    "Save trace",
+                                                    "pbc-trace.json",
+                                                    "JSON Files (*.json)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    if (PBCTrace::writeJson(fileName.toStdString()) == false) {
+        QMessageBox::warning(this, "Diagnostics", "Could not write " + fileName);
+    }
+}
@@ -0,0 +1,54 @@
+/** @file pbcDiagnosticsDock.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCDIAGNOSTICSDOCK_H
+#define PBCDIAGNOSTICSDOCK_H
+
+#include <QDockWidget>
+#include <QCheckBox>
+#include <QTableWidget>
+#include <QTimer>
+
+/**
+ * @class PBCDiagnosticsDock
+ * @brief A dock which shows the performance metrics (see PBCPerf) while it is
+ * visible and can save them as JSON. It also records traces (see PBCTrace).
+ */
+class PBCDiagnosticsDock : public QDockWidget {
+ public:
+    explicit PBCDiagnosticsDock(QWidget *parent = 0);
+    void refresh();
+
+ protected:
+    void showEvent(QShowEvent *event);
+    void hideEvent(QHideEvent *event);
+
+ private:
+    QCheckBox* _recordCheckBox;
+    QCheckBox* _traceCheckBox;
+    QTableWidget* _table;
+    QTimer _refreshTimer;
+
+    void saveAsJson();
+    void saveTrace();
+};
+
+#endif  // PBCDIAGNOSTICSDOCK_H
@@ -0,0 +1,595 @@
+/** @file pbcPlayRenderer.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcPlayRenderer.h"
+#include "models/pbcPlayer.h"
+#include "models/pbcFormation.h"
+#include "models/pbcMotion.h"
+#include "models/pbcRoute.h"
+#include "models/pbcPath.h"
+#include "util/pbcConfig.h"
+#include "util/pbcDeclarations.h"
+#include "util/pbcExceptions.h"
+#include "util/pbcLog.h"
+#include "util/pbcPerf.h"
+#include <QFontInfo>
+#include <QFontMetrics>
+#include <QFontMetricsF>
+#include <QImage>
+#include <QPainter>
+#include <QPolygonF>
+#include <QTransform>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846
+#endif
+
+// the default color of QGraphicsDropShadowEffect, which PBCPlayerView uses
+static const QColor SHADOW_COLOR(63, 63, 63, 180);
+// the shadows are blurred images, which need no more resolution than that
+static const double MAX_SHADOW_SCALE = 2.0;
+// the margin of QGraphicsTextItem's document
+static const double TEXT_MARGIN = 4.0;
+
+/**
+ * @brief Copies the drawing parameters for the current canvas size from
+ * PBCConfig. Must be called on the GUI thread.
+ */
+PBCRenderStyle PBCRenderStyle::fromConfig() {
+    PBCConfig* config = PBCConfig::getInstance();
+    PBCRenderStyle style;
+    style.canvasWidth = config->canvasWidth();
+    style.canvasHeight = config->canvasHeight();
+    style.ydInPixel = config->ydInPixel();
+    style.losY = config->losY();
+    style.fiveYdY = config->fiveYdY();
+    style.tenYdY = config->tenYdY();
+    style.fifteenYdY = config->fifteenYdY();
+    style.losWidth = config->losWidth();
+    style.fiveYdWidth = config->fiveYdWidth();
+    style.losColor = config->losColor();
+    style.fiveYdColor = config->fiveYdColor();
+    style.printPlayName = config->printPlayName();
+    style.playNameSize = config->playNameSize();
+    style.playNameFont = config->playNameFont();
+    style.playNameColor = config->playNameColor();
+    style.playerWidth = config->playerWidth();
+    style.routeWidth = config->routeWidth();
+    style.playerShadow = config->playerShadow();
+    style.playerShadowRadius = config->playerShadowRadius();
+    style.playerShadowOffset = config->playerShadowOffset();
+    return style;
+}
+
+/**
+ * @brief Copies the drawing parameters for the given canvas size from
+ * PBCConfig. Must be called on the GUI thread.
+ * @param canvasWidth The width of the canvas (only the height is relevant,
+ * like in PBCConfig::setCanvasSize())
+ * @param canvasHeight The height of the canvas
+ */
+PBCRenderStyle PBCRenderStyle::fromConfig(unsigned int canvasWidth, unsigned int canvasHeight) {
+    PBCConfig* config = PBCConfig::getInstance();
+    const unsigned int oldWidth = config->canvasWidth();
+    const unsigned int oldHeight = config->canvasHeight();
+    config->setCanvasSize(canvasWidth, canvasHeight);
+    PBCRenderStyle style = fromConfig();
+    config->setCanvasSize(oldWidth, oldHeight);
+    return style;
+}
+
+static PBCHash colorHash(const PBCColor& color, PBCHash seed) {
+    seed = PBCContentHash::number(static_cast<uint64_t>(color.r()), seed);
+    seed = PBCContentHash::number(static_cast<uint64_t>(color.g()), seed);
+    return PBCContentHash::number(static_cast<uint64_t>(color.b()), seed);
+}
+
+/**
+ * @brief Hashes the drawing parameters, so that exported files can be
+ * rewritten if the look of the plays changes
+ */
+PBCHash PBCRenderStyle::contentHash() const {
+    PBCHash hash = PBCContentHash::EMPTY;
+    for (uint64_t value : {canvasWidth, canvasHeight, ydInPixel,
+                           losY, fiveYdY, tenYdY, fifteenYdY,
+                           losWidth, fiveYdWidth, playNameSize,
+                           playerWidth, routeWidth}) {
+        hash = PBCContentHash::number(value, hash);
+    }
+    hash = colorHash(losColor, hash);
+    hash = colorHash(fiveYdColor, hash);
+    hash = colorHash(playNameColor, hash);
+    hash = PBCContentHash::number(static_cast<uint64_t>(printPlayName), hash);
+    hash = PBCContentHash::string(playNameFont, hash);
+    hash = PBCContentHash::number(static_cast<uint64_t>(playerShadow), hash);
+    hash = PBCContentHash::number(playerShadowRadius, hash);
+    return PBCContentHash::number(playerShadowOffset, hash);
+}
+
+static PBCDPoint translatePos(const PBCRenderStyle& style, PBCDPoint pos, PBCDPoint center) {
+    return PBCDPoint(center.get<0>() + style.ydInPixel * pos.get<0>(),
+                     center.get<1>() - style.ydInPixel * pos.get<1>());
+}
+
+static QColor toQColor(const PBCColor& color) {
+    return QColor(color.r(), color.g(), color.b());
+}
+
+static void throwOutsideOfCanvas(double x, double y) {
+    std::ostringstream errMsg;
+    errMsg << "trying to draw a route outside of canvas (x = " << x << "; y = " << y << ")";
+    throw PBCRenderingException(errMsg.str());
+}
+
+/**
+ * @brief Computes the lines of a motion or a route like
+ * PBCPlayerView::joinPaths() (including the positions being truncated to
+ * whole pixels)
+ * @throws PBCRenderingException if a line ends outside of the canvas
+ */
+static void joinPaths(const PBCRenderStyle& style,
+                      const std::vector<PBCPathSP>& paths,
+                      PBCDPoint basePoint,
+                      const QColor& color,
+                      Qt::PenStyle penStyle,
+                      bool arrow,
+                      std::vector<PBCPlayGeometry::Stroke>& strokes) {
+    if (paths.empty()) {
+        return;
+    }
+    QBrush brush(color);
+    QPen pen(brush, style.routeWidth, penStyle, Qt::PenCapStyle::RoundCap, Qt::PenJoinStyle::RoundJoin);
+
+    double lastX = basePoint.get<0>();
+    double lastY = basePoint.get<1>();
+    int inOutFactor = -1;
+    if (basePoint.get<0>() < style.canvasWidth / 2) {
+        inOutFactor = 1;
+    }
+    for (const PBCPathSP& path : paths) {
+        PBCDPoint endPointYd(inOutFactor * path->endpoint().get<0>(),
+                             path->endpoint().get<1>());
+        PBCDPoint endPointPixel = translatePos(style, endPointYd, basePoint);
+        if (endPointPixel.get<0>() < 0 || endPointPixel.get<1>() < 0) {
+            throwOutsideOfCanvas(endPointPixel.get<0>(), endPointPixel.get<1>());
+        }
+        double endPointX = std::trunc(endPointPixel.get<0>());
+        double endPointY = std::trunc(endPointPixel.get<1>());
+
+        QPainterPath painterPath;
+        painterPath.moveTo(lastX, lastY);
+
+        if (arrow && path == paths.back()) {
+            // like PBCPlayerView, the direction of the arrow head uses the
+            // control point of a curve without translating it
+            if (path->bezierControlPoint().get<0>() != DUMMY_POINT.get<0>()) {
+                lastX = path->bezierControlPoint().get<0>();
+                lastY = path->bezierControlPoint().get<1>();
+            }
+            double angle = std::atan2(endPointY - lastY, -(endPointX - lastX));
+
+            double routeWidth = style.routeWidth;
+            double arrowSize = routeWidth * 2;
+            QPointF endPoint(endPointX, endPointY);
+            QPointF arrowP1 = endPoint + QPointF(sin(angle + M_PI / 3) * arrowSize,
+                                                 cos(angle + M_PI / 3) * arrowSize);
+            QPointF arrowP2 = endPoint + QPointF(sin(angle + M_PI - M_PI / 3) * arrowSize,
+                                                 cos(angle + M_PI - M_PI / 3) * arrowSize);
+            QPointF arrowPHalf = arrowP1 + (arrowP2 - arrowP1) / 2;
+
+            PBCPlayGeometry::Stroke arrowHead;
+            arrowHead.path.addPolygon(QPolygonF(QVector<QPointF>({endPoint, arrowP1, arrowP2})));
+            arrowHead.path.closeSubpath();
+            arrowHead.pen = QPen(brush, routeWidth / 4);
+            arrowHead.brush = brush;
+            strokes.push_back(arrowHead);
+
+            if (arrowPHalf.x() < 0 || arrowPHalf.y() < 0) {
+                throwOutsideOfCanvas(arrowPHalf.x(), arrowPHalf.y());
+            }
+            endPointX = std::trunc(arrowPHalf.x());
+            endPointY = std::trunc(arrowPHalf.y());
+        }
+
+        if (endPointX >= style.canvasWidth || endPointY >= style.canvasHeight) {
+            throwOutsideOfCanvas(endPointX, endPointY);
+        }
+
+        if (path->bezierControlPoint().get<0>() == DUMMY_POINT.get<0>()) {
+            painterPath.lineTo(endPointX, endPointY);
+        } else {
+            PBCDPoint controlPointYd(inOutFactor * path->bezierControlPoint().get<0>(),
+                                     path->bezierControlPoint().get<1>());
+            PBCDPoint controlPointPixel = translatePos(style, controlPointYd, basePoint);
+            painterPath.quadTo(QPointF(std::trunc(controlPointPixel.get<0>()), std::trunc(controlPointPixel.get<1>())),
+                               QPointF(endPointX, endPointY));
+        }
+
+        PBCPlayGeometry::Stroke line;
+        line.path = painterPath;
+        line.pen = pen;
+        strokes.push_back(line);
+        lastX = endPointX;
+        lastY = endPointY;
+    }
+}
+
+/**
+ * @brief Computes the geometry of a play
+ * @param play The play
+ * @param style The drawing parameters
+ * @return The geometry, which can be rendered any number of times
+ * @throws PBCRenderingException if a motion ends outside of the canvas.
+ * Routes that end outside of the canvas are left out (PBCPlayView removes
+ * them from the player).
+ */
+PBCPlayGeometry PBCPlayRenderer::layout(const PBCPlay &play, const PBCRenderStyle &style) {
+    PBC_PERF_SCOPE("render.layout");
+    PBCPlayGeometry geometry;
+    geometry.style = style;
+    for (const PBCPlayerSP& player : *(play.formation())) {
+        geometry.players.push_back(PBCPlayGeometry::Player());
+        layoutPlayer(*player, style, geometry.players.back());
+    }
+
+    if (style.printPlayName) {
+        geometry.name = play.codeName() != "" ?
+                        QString::fromStdString(play.codeName()) :
+                        QString::fromStdString(play.name());
+        // adjust the font size for the name to fit in one line (like PBCPlayView::paintPlayName())
+        const unsigned int margin = 5;
+        unsigned int textHeight = style.playNameSize;
+        QFont font(QString::fromStdString(style.playNameFont), textHeight, textHeight, true);
+        while (true) {
+            font.setPointSize(textHeight);
+            font.setWeight(textHeight);
+            QFontMetrics fm(font);
+            if (fm.width(geometry.name) < static_cast<int>(style.canvasWidth - 2 * margin) || textHeight <= 1) {
+                break;
+            }
+            textHeight = textHeight - 1;
+        }
+        // the name is drawn in canvas pixels, no matter the resolution of the paint device
+        font.setPixelSize(QFontInfo(font).pixelSize());
+        geometry.nameFont = font;
+        geometry.namePosition = QPointF(margin + TEXT_MARGIN,
+                                        style.canvasHeight - 2 * textHeight + TEXT_MARGIN + QFontMetricsF(font).ascent());
+        geometry.nameColor = toQColor(style.playNameColor);
+    }
+    return geometry;
+}
+
+void PBCPlayRenderer::layoutPlayer(const PBCPlayer &player,
+                                   const PBCRenderStyle &style,
+                                   PBCPlayGeometry::Player &result) {
+    const std::array<char, 4> shortName = player.role().shortName;
+    result.shortName = std::string(shortName.begin(), std::find(shortName.begin(), shortName.end(), '\0'));
+    PBCDPoint ballPos(style.canvasWidth / 2, style.losY);
+    PBCDPoint playerPos = translatePos(style, player.pos(), ballPos);
+    result.shape = QRectF(playerPos.get<0>() - style.playerWidth / 2,
+                          playerPos.get<1>(),
+                          style.playerWidth,
+                          style.playerWidth);
+    result.rectangular = player.role().fullName == "Center";
+    result.color = toQColor(player.color());
+    if (player.nr() > 0) {
+        result.number = QString::number(player.nr());
+        result.numberColor = toQColor(PBCColor::contrastColor(player.color()));
+        result.numberFont = QFont(QString::fromStdString(style.playNameFont));
+        result.numberFont.setPixelSize(style.playerWidth / 2);
+        result.numberFont.setBold(true);
+    }
+
+    if (player.motion() != NULL) {
+        joinPaths(style, player.motion()->paths(), playerPos, result.color, Qt::PenStyle::DashLine, false,
+                  result.strokes);
+    }
+
+    const size_t motionStrokes = result.strokes.size();
+    PBCDPoint base = playerPos;
+    if (player.motion() != NULL) {
+        int inOutFactor = playerPos.get<0>() < style.canvasWidth / 2 ? 1 : -1;
+        PBCDPoint correctMotionEndPoint(inOutFactor * player.motion()->motionEndPoint().get<0>(),
+                                        player.motion()->motionEndPoint().get<1>());
+        base = translatePos(style, correctMotionEndPoint, playerPos);
+    }
+    try {
+        for (const PBCRouteSP& route : player.optionRoutes()) {
+            joinPaths(style, route->paths(), base, result.color, Qt::PenStyle::DotLine, true, result.strokes);
+        }
+        if (player.alternativeRoute(2) != NULL) {
+            joinPaths(style, player.alternativeRoute(2)->paths(), base, QColor("fuchsia"), Qt::PenStyle::SolidLine,
+                      true, result.strokes);
+        }
+        if (player.alternativeRoute(1) != NULL) {
+            joinPaths(style, player.alternativeRoute(1)->paths(), base, QColor("orange"), Qt::PenStyle::SolidLine,
+                      true, result.strokes);
+        }
+        if (player.route() != NULL) {
+            joinPaths(style, player.route()->paths(), base, result.color, Qt::PenStyle::SolidLine, true,
+                      result.strokes);
+        }
+    } catch (const PBCRenderingException& e) {
+        PBC_LOG_WARNING("render", "leaving out the routes of " << player.role().fullName << ": " << e.what());
+        result.strokes.resize(motionStrokes);
+    }
+
+    result.bounds = result.shape;
+    for (const PBCPlayGeometry::Stroke& stroke : result.strokes) {
+        const double halfWidth = stroke.pen.widthF() / 2;
+        result.bounds |= stroke.path.boundingRect().adjusted(-halfWidth, -halfWidth, halfWidth, halfWidth);
+    }
+}
+
+/**
+ * @brief The bounding rectangle of the field's border, which is mapped to the
+ * target rectangle
+ */
+static QRectF sourceRect(const PBCRenderStyle& style) {
+    return QRectF(-0.5, -0.5, style.canvasWidth + 1, style.canvasHeight + 1);
+}
+
+/**
+ * @brief Paints a play into the target rectangle of a painter
+ *
+ * Like QGraphicsScene::render(), the bounding rectangle of the field's border
+ * is stretched to the target rectangle, and painting is clipped to it.
+ * @param painter The painter
+ * @param geometry The geometry of the play (see layout())
+ * @param target The target rectangle in the painter's coordinates
+ * @param emphasis The role whose assignment is emphasized (if any). The
+ * geometry is not changed, so one layout can be rendered for many roles.
+ */
+void PBCPlayRenderer::render(QPainter *painter,
+                             const PBCPlayGeometry &geometry,
+                             const QRectF &target,
+                             const PBCRenderEmphasis &emphasis) {
+    PBC_PERF_SCOPE("render.immediate");
+    const PBCRenderStyle& style = geometry.style;
+    QRectF source = sourceRect(style);
+    painter->save();
+    painter->setClipRect(target, Qt::IntersectClip);
+    painter->translate(target.topLeft());
+    painter->scale(target.width() / source.width(), target.height() / source.height());
+    painter->translate(-source.topLeft());
+
+    paintField(painter, style);
+    if (emphasis.role.empty()) {
+        for (const PBCPlayGeometry::Player& player : geometry.players) {
+            if (style.playerShadow) {
+                paintShadow(painter, player, style);
+            }
+            paintPlayer(painter, player);
+        }
+    } else {
+        // the faded players have no shadows, the emphasized ones are drawn on top
+        painter->setOpacity(emphasis.fadedOpacity);
+        for (const PBCPlayGeometry::Player& player : geometry.players) {
+            if (player.shortName != emphasis.role) {
+                paintPlayer(painter, player);
+            }
+        }
+        painter->setOpacity(1);
+        for (const PBCPlayGeometry::Player& player : geometry.players) {
+            if (player.shortName == emphasis.role) {
+                PBCPlayGeometry::Player bold = emphasized(player, emphasis.lineScale);
+                if (style.playerShadow) {
+                    paintShadow(painter, bold, style);
+                }
+                paintPlayer(painter, bold);
+            }
+        }
+    }
+    if (geometry.name.isEmpty() == false) {
+        painter->setFont(geometry.nameFont);
+        painter->setPen(geometry.nameColor);
+        painter->drawText(geometry.namePosition, geometry.name);
+    }
+    painter->restore();
+}
+
+/**
+ * @brief Computes the geometry of a play and paints it
+ * @see layout()
+ */
+void PBCPlayRenderer::render(QPainter *painter,
+                             const PBCPlay &play,
+                             const PBCRenderStyle &style,
+                             const QRectF &target) {
+    render(painter, layout(play, style), target);
+}
+
+/**
+ * @brief Records the painting of a play, so that it can be replayed into
+ * several targets (e.g. the same plays in several PDF layouts). The play is
+ * recorded at the size of its style, so drop shadows (which are images) should
+ * be recorded at about the size of the largest target.
+ * @param geometry The geometry of the play (see layout())
+ * @param emphasis The role whose assignment is emphasized (if any)
+ * @return The recording
+ */
+PBCPlayRecording PBCPlayRenderer::record(const PBCPlayGeometry &geometry, const PBCRenderEmphasis &emphasis) {
+    PBC_PERF_SCOPE("render.record");
+    PBCPlayRecording recording;
+    recording.style = geometry.style;
+    {
+        QPainter painter(&recording.picture);
+        render(&painter, geometry, sourceRect(geometry.style), emphasis);
+    }
+    return recording;
+}
+
+/**
+ * @brief Replays a recorded play into the target rectangle of a painter, like
+ * rendering its geometry
+ * @param painter The painter
+ * @param recording The recorded play (see record())
+ * @param target The target rectangle in the painter's coordinates
+ */
+void PBCPlayRenderer::render(QPainter *painter, const PBCPlayRecording &recording, const QRectF &target) {
+    PBC_PERF_SCOPE("render.replay");
+    QRectF source = sourceRect(recording.style);
+    painter->save();
+    painter->setClipRect(target, Qt::IntersectClip);
+    painter->translate(target.topLeft());
+    painter->scale(target.width() / source.width(), target.height() / source.height());
+    painter->translate(-source.topLeft());
+    painter->drawPicture(0, 0, recording.picture);
+    painter->restore();
+}
+
+void PBCPlayRenderer::paintField(QPainter *painter, const PBCRenderStyle &style) {
+    auto paintLine = [painter, &style](unsigned int yPos, unsigned int lineWidth, const PBCColor& color) {
+        QPen pen(toQColor(color));
+        pen.setWidth(lineWidth);
+        painter->setPen(pen);
+        painter->drawLine(QLineF(0 + lineWidth / 2, yPos, style.canvasWidth - lineWidth / 2, yPos));
+    };
+    paintLine(style.losY, style.losWidth, style.losColor);
+    paintLine(style.fiveYdY, style.fiveYdWidth, style.fiveYdColor);
+    paintLine(style.tenYdY, style.fiveYdWidth, style.fiveYdColor);
+    paintLine(style.fifteenYdY, style.fiveYdWidth, style.fiveYdColor);
+
+    painter->setPen(QPen());
+    painter->setBrush(Qt::NoBrush);
+    painter->drawRect(QRectF(0, 0, style.canvasWidth, style.canvasHeight));
+}
+
+void PBCPlayRenderer::paintPlayer(QPainter *painter, const PBCPlayGeometry::Player &player) {
+    for (const PBCPlayGeometry::Stroke& stroke : player.strokes) {
+        painter->setPen(stroke.pen);
+        painter->setBrush(stroke.brush);
+        painter->drawPath(stroke.path);
+    }
+    painter->setPen(QPen());
+    painter->setBrush(player.color);
+    if (player.rectangular) {
+        painter->drawRect(player.shape);
+    } else {
+        painter->drawEllipse(player.shape);
+    }
+    if (player.number.isEmpty() == false) {
+        painter->setFont(player.numberFont);
+        painter->setPen(player.numberColor);
+        painter->drawText(player.shape, Qt::AlignCenter, player.number);
+    }
+}
+
+/**
+ * @brief Copies a player with all lines widened by a factor. The copy shares
+ * the paths with the original.
+ */
+PBCPlayGeometry::Player PBCPlayRenderer::emphasized(const PBCPlayGeometry::Player &player, double lineScale) {
+    PBCPlayGeometry::Player result = player;
+    result.bounds = result.shape;
+    for (PBCPlayGeometry::Stroke& stroke : result.strokes) {
+        stroke.pen.setWidthF(stroke.pen.widthF() * lineScale);
+        const double halfWidth = stroke.pen.widthF() / 2;
+        result.bounds |= stroke.path.boundingRect().adjusted(-halfWidth, -halfWidth, halfWidth, halfWidth);
+    }
+    return result;
+}
+
+/**
+ * @brief Blurs a line of pixels with a box filter. The pixels outside of the
+ * image are transparent.
+ */
+static void boxBlur(QImage& image, int radius, bool horizontal) {
+    const int lines = horizontal ? image.height() : image.width();
+    const int length = horizontal ? image.width() : image.height();
+    const int window = 2 * radius + 1;
+    std::vector<QRgb> line(length);
+    for (int l = 0; l < lines; ++l) {
+        auto pixel = [&image, horizontal, l](int i) -> QRgb& {
+            return horizontal ?
+                   reinterpret_cast<QRgb*>(image.scanLine(l))[i] :
+                   reinterpret_cast<QRgb*>(image.scanLine(i))[l];
+        };
+        for (int i = 0; i < length; ++i) {
+            line[i] = pixel(i);
+        }
+        int sums[4] = {0, 0, 0, 0};
+        auto add = [&sums](QRgb rgb, int sign) {
+            sums[0] += sign * qRed(rgb);
+            sums[1] += sign * qGreen(rgb);
+            sums[2] += sign * qBlue(rgb);
+            sums[3] += sign * qAlpha(rgb);
+        };
+        for (int i = 0; i < std::min(radius, length); ++i) {
+            add(line[i], 1);
+        }
+        for (int i = 0; i < length; ++i) {
+            if (i + radius < length) {
+                add(line[i + radius], 1);
+            }
+            if (i - radius - 1 >= 0) {
+                add(line[i - radius - 1], -1);
+            }
+            pixel(i) = qRgba(sums[0] / window, sums[1] / window, sums[2] / window, sums[3] / window);
+        }
+    }
+}
+
+/**
+ * @brief Paints the drop shadow of a player like QGraphicsDropShadowEffect:
+ * the player is painted into an image in the shadow color, which is blurred
+ * and painted with an offset. Three box blurs approximate the gaussian blur.
+ */
+void PBCPlayRenderer::paintShadow(QPainter *painter,
+                                  const PBCPlayGeometry::Player &player,
+                                  const PBCRenderStyle &style) {
+    PBC_PERF_SCOPE("render.shadow");
+    const double radius = style.playerShadowRadius;
+    QRectF bounds = player.bounds.adjusted(-radius, -radius, radius, radius);
+    const QTransform transform = painter->deviceTransform();
+    const double scale = std::min(std::sqrt(transform.m11() * transform.m11() + transform.m12() * transform.m12()),
+                                  MAX_SHADOW_SCALE);
+    QSize size(std::ceil(bounds.width() * scale), std::ceil(bounds.height() * scale));
+    if (size.isEmpty()) {
+        return;
+    }
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    {
+        QPainter imagePainter(&image);
+        imagePainter.setRenderHint(QPainter::Antialiasing);
+        imagePainter.scale(scale, scale);
+        imagePainter.translate(-bounds.topLeft());
+        paintPlayer(&imagePainter, player);
+        imagePainter.resetTransform();
+        imagePainter.setCompositionMode(QPainter::CompositionMode_SourceIn);
+        imagePainter.fillRect(image.rect(), SHADOW_COLOR);
+    }
+    const int boxRadius = std::lround(radius * scale / 2);
+    if (boxRadius > 0) {
+        for (int pass = 0; pass < 3; ++pass) {
+            boxBlur(image, boxRadius, true);
+            boxBlur(image, boxRadius, false);
+        }
+    }
+    painter->drawImage(bounds.translated(style.playerShadowOffset, style.playerShadowOffset), image);
+}
@@ -0,0 +1,168 @@
+/** @file pbcPlayRenderer.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCPLAYRENDERER_H
+#define PBCPLAYRENDERER_H
+
+#include "models/pbcPlay.h"
+#include "models/pbcColor.h"
+#include "util/pbcContentHash.h"
+#include <QBrush>
+#include <QColor>
+#include <QFont>
+#include <QPainterPath>
+#include <QPen>
+#include <QPicture>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <string>
+#include <vector>
+
+class QPainter;
+
+/**
+ * @brief The drawing parameters of a play for one canvas size, copied from
+ * PBCConfig. The values are rounded like in PBCPlayView, so both renderers
+ * produce the same geometry.
+ */
+struct PBCRenderStyle {
+    unsigned int canvasWidth;
+    unsigned int canvasHeight;
+    unsigned int ydInPixel;  // truncated like in PBCPositionTranslator
+    unsigned int losY;
+    unsigned int fiveYdY;
+    unsigned int tenYdY;
+    unsigned int fifteenYdY;
+    unsigned int losWidth;
+    unsigned int fiveYdWidth;
+    PBCColor losColor;
+    PBCColor fiveYdColor;
+    bool printPlayName;
+    unsigned int playNameSize;
+    std::string playNameFont;
+    PBCColor playNameColor;
+    unsigned int playerWidth;
+    unsigned int routeWidth;
+    bool playerShadow;
+    double playerShadowRadius;
+    double playerShadowOffset;
+
+    static PBCRenderStyle fromConfig();
+    static PBCRenderStyle fromConfig(unsigned int canvasWidth, unsigned int canvasHeight);
+    PBCHash contentHash() const;
+};
+
+/**
+ * @brief The precomputed geometry of a play in canvas coordinates (pixels)
+ */
+struct PBCPlayGeometry {
+    /**
+     * @brief A line of a motion or a route, or the head of a route's arrow
+     */
+    struct Stroke {
+        QPainterPath path;
+        QPen pen;
+        QBrush brush;
+    };
+
+    struct Player {
+        std::string shortName;
+        QRectF shape;
+        bool rectangular;  // the center is drawn as a square
+        QColor color;
+        QString number;  // empty if the player has no number
+        QColor numberColor;
+        QFont numberFont;
+        std::vector<Stroke> strokes;  // motion and routes, in the order in which they are drawn
+        QRectF bounds;  // of the shape and the strokes
+    };
+
+    PBCRenderStyle style;
+    std::vector<Player> players;
+    QString name;  // empty if the name is not printed
+    QFont nameFont;
+    QPointF namePosition;  // the left end of the baseline
+    QColor nameColor;
+};
+
+/**
+ * @brief A play that has been painted into a QPicture (see
+ * PBCPlayRenderer::record()). The recording can be replayed into targets of
+ * any size without laying out and painting the play again.
+ *
+ * Replaying is not thread-safe (QPicture reads its commands through a shared
+ * buffer), so a recording must only be replayed by one thread at a time.
+ */
+struct PBCPlayRecording {
+    PBCRenderStyle style;  // the style of the recorded geometry
+    QPicture picture;
+};
+
+/**
+ * @brief Emphasizes the assignment of one role, e.g. in the booklet of a
+ * position: the players of the role are drawn on top with bold lines
+ * (including their option and alternative routes), all other players are
+ * faded.
+ */
+struct PBCRenderEmphasis {
+    std::string role;  // the short name of the emphasized role (see PBCRole), empty for none
+    double fadedOpacity = 0.3;  // the opacity of the other players
+    double lineScale = 2;  // the factor by which the lines of the emphasized players are widened
+};
+
+/**
+ * @class PBCPlayRenderer
+ * @brief Draws plays directly with a QPainter.
+ *
+ * PBCPlayView builds a QGraphicsScene with items for every player, route and
+ * text, which is needed to edit a play but is a lot of overhead for output
+ * that is never interactive (PDF tiles, thumbnails, image export). This
+ * renderer computes the geometry of a play once (layout()) and paints it
+ * into any paint device (render()). The result looks like a rendered
+ * PBCPlayView.
+ *
+ * The renderer is reentrant: it only reads the play and the PBCRenderStyle,
+ * so it can be used on worker threads as long as the play is not modified
+ * meanwhile. Only PBCRenderStyle::fromConfig() must be called on the GUI
+ * thread. A geometry may be rendered by several threads at the same time.
+ */
+class PBCPlayRenderer {
+ public:
+    static PBCPlayGeometry layout(const PBCPlay& play, const PBCRenderStyle& style);
+    static void render(QPainter* painter,
+                       const PBCPlayGeometry& geometry,
+                       const QRectF& target,
+                       const PBCRenderEmphasis& emphasis = PBCRenderEmphasis());
+    static void render(QPainter* painter, const PBCPlay& play, const PBCRenderStyle& style, const QRectF& target);
+    static void render(QPainter* painter, const PBCPlayRecording& recording, const QRectF& target);
+    static PBCPlayRecording record(const PBCPlayGeometry& geometry,
+                                   const PBCRenderEmphasis& emphasis = PBCRenderEmphasis());
+
+ private:
+    static void layoutPlayer(const PBCPlayer& player, const PBCRenderStyle& style, PBCPlayGeometry::Player& result);  // NOLINT
+    static void paintField(QPainter* painter, const PBCRenderStyle& style);
+    static void paintPlayer(QPainter* painter, const PBCPlayGeometry::Player& player);
+    static PBCPlayGeometry::Player emphasized(const PBCPlayGeometry::Player& player, double lineScale);
+    static void paintShadow(QPainter* painter, const PBCPlayGeometry::Player& player, const PBCRenderStyle& style);
+};
+
+#endif  // PBCPLAYRENDERER_H
@@ -26,6 +26,8 @@
 #include "models/pbcPlaybook.h"
 #include "util/pbcStorage.h"
 #include "util/pbcConfig.h"
+#include "util/pbcLog.h"
+#include "util/pbcPerf.h"
 #include "gui/pbcPlayerView.h"
 #include "gui/pbcSettings.h"
 #include "QGraphicsEllipseItem"
@@ -33,13 +35,13 @@
 #include "models/pbcPlaybook.h"
 #include "dialogs/pbcEditCategoriesDialog.h"
 #include "util/pbcPositionTranslator.h"
+#include "models/pbcUndoCommands.h"
 #include <QApplication>
 #include <QMessageBox>
 #include <QFileDialog>
 #include <QInputDialog>
 
 #include <string>
-#include <iostream>
 #include <dialogs/pbcSetPasswordDialog.h>
 
 /**
@@ -117,6 +119,7 @@ void PBCPlayView::paintPlayName() {
  * @brief Paints grid iron and the current play on it
  */
 void PBCPlayView::repaint() {
+    PBC_PERF_SCOPE("playView.repaint");
     this->clear();
     paintLine(PBCConfig::getInstance()->losY(),
               PBCConfig::getInstance()->canvasWidth(),
@@ -199,10 +202,14 @@ void PBCPlayView::renameAndSavePlay(const std::string& name,
     if (!_currentPlay)
         return;
 
-    PBCController::getInstance()->getPlaybook()->deletePlay(_currentPlay->name());
-    _currentPlay->setName(name);
-    _currentPlay->setCodeName(codeName);
-    PBCController::getInstance()->getPlaybook()->addPlay(_currentPlay, true);
+    PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+    {
+        PBCUndoMacroScope macro(playbook->history(), "Rename Play");
+        playbook->deletePlay(_currentPlay->name());
+        _currentPlay->setName(name);
+        _currentPlay->setCodeName(codeName);
+        playbook->addPlay(_currentPlay, true);
+    }
     showPlay(_currentPlay->name());
 }
 
@@ -211,19 +218,27 @@ void PBCPlayView::renameAndSavePlay(const std::string& name,
  * @brief Adds the current play to the playbook
  *
  * If a name is specified, the current play is saved with the given name and
- * code name. Otherwise it is saved with its original name.
+ * code name. Otherwise it is saved with its original name. If the play in the
+ * playbook has the same content as the current play, nothing is done.
  * @param name The new name of the play
  * @param codeName The new code name of the play
  */
 void PBCPlayView::savePlay(const std::string &name,
                            const std::string &codeName) {
-    // FIXME(obr): dirty hack to check if the play can be rendered (no PBCRenderingException occurs)
-    repaint();
-
     if(name != "") {
         _currentPlay->setName(name);
         _currentPlay->setCodeName(codeName);
     }
+
+    PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+    if (playbook->hasPlay(_currentPlay->name()) &&
+        playbook->getPlay(_currentPlay->name())->contentHash() == _currentPlay->contentHash()) {
+        return;  // unchanged
+    }
+
+    // FIXME(obr): dirty hack to check if the play can be rendered (no PBCRenderingException occurs)
+    repaint();
+
     PBCController::getInstance()->getPlaybook()->addPlay(_currentPlay, true);
     showPlay(_currentPlay->name());
 }
@@ -241,6 +256,22 @@ void PBCPlayView::showPlay(const std::string& name) {
     repaint();
 }
 
+/**
+ * @brief Displays a play that has been changed by an undo / redo step.
+ *
+ * Player edits are recorded on the working copy of a play, so the working
+ * copy itself is displayed again (instead of copying it from the playbook).
+ * @param playSP The play to display
+ */
+void PBCPlayView::restorePlay(PBCPlaySP playSP) {
+    pbcAssert(playSP != NULL);
+    _currentPlay = playSP;
+    _activePlayer.reset();
+    leaveRouteMotionEditMode();
+    setActivePlay(_currentPlay);
+    repaint();
+}
+
 /**
  * @brief saves the (maybe modified) formation of the
  * current play to the playbook.
@@ -271,7 +302,7 @@ void PBCPlayView::editCategories() {
 }
 
 void debug_point(PBCDPoint point, const std::string msg) {
-    std::cout << msg << " " << "x: " << point.get<0>() << " y: " << point.get<1>() << std::endl;
+    PBC_LOG_DEBUG("gui", msg << " " << "x: " << point.get<0>() << " y: " << point.get<1>());
 }
 
 
@@ -303,6 +334,7 @@ void PBCPlayView::enterRouteEditMode(PBCPlayerSP playerSP, RouteType routeType,
     _lastLine = NULL;
     _paths.clear();
     _routePlayer = playerSP;
+    _routePlayerBefore = *playerSP;
     _routeName = routeName;
     _routeCodeName = routeCodeName;
     _overwrite = overwrite;
@@ -335,6 +367,7 @@ void PBCPlayView::enterMotionEditMode(PBCPlayerSP playerSP) {
     _lastLine = NULL;
     _paths.clear();
     _routePlayer = playerSP;
+    _routePlayerBefore = *playerSP;
 
     std::vector<PBCPathSP> emptyRoutePaths;
     PBCMotionSP emptyMotion(new PBCMotion(emptyRoutePaths));
@@ -454,6 +487,7 @@ void PBCPlayView::mouseReleaseEvent(QGraphicsSceneMouseEvent *event) {
 void PBCPlayView::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event) {
     if (_routeEditMode == true) {
         pbcAssert(_routePlayer);
+        PBCUndoMacroScope macro(PBCController::getInstance()->getPlaybook()->history(), "Draw Route");  // NOLINT
         PBCRouteSP route(new PBCRoute(_routeName, _routeCodeName, _paths));
         if (_routeName != "") {
             try {
@@ -477,12 +511,14 @@ void PBCPlayView::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event) {
                 _routePlayer->setAlternativeRoute(2, route);
                 break;
         }
+        recordPlayerEdit("Draw Route", _routePlayer, _routePlayerBefore);
         leaveRouteMotionEditMode();
         repaint();
     } else if (_motionEditMode == true) {
         pbcAssert(_routePlayer);
         PBCMotionSP motion(new PBCMotion(_paths));
         _routePlayer->setMotion(motion);
+        recordPlayerEdit("Draw Motion", _routePlayer, _routePlayerBefore);
         leaveRouteMotionEditMode();
         repaint();
     } else {
@@ -508,8 +544,13 @@ void PBCPlayView::savePlaybookOnRouteCreation() {
         int returnCode = pwDialog.exec();
         if (returnCode == QDialog::Accepted) {
             QString password = pwDialog.getPassword();
-            PBCStorage::getInstance()->savePlaybook(password.toStdString(),
-                                                    fileName.toStdString());
+            try {
+                PBCStorage::getInstance()->savePlaybook(password.toStdString(),
+                                                        fileName.toStdString());
+            } catch (const PBCSaveException& e) {
+                QMessageBox::warning(NULL, "Save Playbook", QString::fromStdString(e.what()));
+                return;
+            }
             setLastPlaybookLocation(QFileInfo(fileName));
         }
     }
@@ -532,32 +573,63 @@ void PBCPlayView::setActivePlayer(PBCPlayerSP playerSP) {
 
 void PBCPlayView::setActivePlayerColor(PBCColor color) {
     if(_activePlayer != NULL) {
+        PBCColor oldColor = _activePlayer->color();
+        if (oldColor.r() == color.r() && oldColor.g() == color.g() && oldColor.b() == color.b()) {
+            return;  // the color wheel has only been updated for a newly selected player
+        }
+        PBCPlayer before = *_activePlayer;
         _activePlayer->setColor(color);
+        recordPlayerEdit("Change Player Color", _activePlayer, before);
         repaint();
     }
 }
 
 void PBCPlayView::setActivePlayerRoute(PBCRouteSP route) {
     if(_activePlayer != NULL) {
-       _activePlayer->setRoute(route);
-       repaint();
+        PBCPlayer before = *_activePlayer;
+        _activePlayer->setRoute(route);
+        recordPlayerEdit("Change Player Route", _activePlayer, before);
+        repaint();
     }
 }
 
 void PBCPlayView::setActivePlayerName(std::string name) {
-    if(_activePlayer != NULL) {
+    if(_activePlayer != NULL && _activePlayer->name() != name) {
+        PBCPlayer before = *_activePlayer;
         _activePlayer->setName(name);
+        recordPlayerEdit("Change Player Name", _activePlayer, before);
         repaint();
     }
 }
 
 void PBCPlayView::setActivePlayerNr(unsigned int nr) {
-    if(_activePlayer != NULL) {
+    if(_activePlayer != NULL && _activePlayer->nr() != nr) {
+        PBCPlayer before = *_activePlayer;
         _activePlayer->setNr(nr);
+        recordPlayerEdit("Change Player Number", _activePlayer, before);
         repaint();
     }
 }
 
+/**
+ * @brief Records an edit of a player of the current play in the playbook's
+ * undo history. Must be called after the player has been changed.
+ * @param text The description of the edit
+ * @param playerSP The changed player
+ * @param before A copy of the player before the edit
+ */
+void PBCPlayView::recordPlayerEdit(const std::string &text,
+                                   PBCPlayerSP playerSP,
+                                   const PBCPlayer &before) {
+    if (_currentPlay == NULL) {
+        return;
+    }
+    PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+    playbook->history().push(
+            PBCUndoCommandSP(new PBCPlayerEditCommand(text, _currentPlay, playerSP, before)));
+    playbook->updateUsages(_currentPlay);
+}
+
 void PBCPlayView::setPlayComment(const std::string &comment) {
     if(_currentPlay != NULL) {
         _currentPlay->setComment(comment);
@@ -43,6 +43,7 @@ class PBCPlayView : public PBCGridIronView {
                        const std::string& codeName,
                        const std::string& formationName = "");
     void showPlay(const std::string &name);
+    void restorePlay(PBCPlaySP playSP);
     void savePlay(const std::string& name = "",
                   const std::string& codeName = "");
     void renameAndSavePlay(const std::string& name = "",
@@ -72,6 +73,9 @@ class PBCPlayView : public PBCGridIronView {
     void setActivePlayerRoute(PBCRouteSP route);
     void setActivePlayerName(std::string name);
     void setActivePlayerNr(unsigned int nr);
+    void recordPlayerEdit(const std::string& text,
+                          PBCPlayerSP playerSP,
+                          const PBCPlayer& before);
 
 
  private:
@@ -82,6 +86,7 @@ class PBCPlayView : public PBCGridIronView {
     RouteType _routeType = RouteType::Route;
     bool _motionEditMode = false;
     PBCPlayerSP _routePlayer;
+    PBCPlayer _routePlayerBefore;
     std::string _routeName;
     std::string _routeCodeName;
     bool _overwrite;
@@ -28,9 +28,11 @@
 #include "QBrush"
 #include "QMenu"
 #include "util/pbcPositionTranslator.h"
+#include "util/pbcLog.h"
+#include "util/pbcPerf.h"
 #include "dialogs/pbcCustomRouteDialog.h"
 #include <utility>
-#include "QDebug"
+#include <string>
 #include <vector>
 #include <set>
 #include <QMessageBox>
@@ -38,7 +40,6 @@
 #include <QInputDialog>
 #include <QGraphicsPathItem>
 #include <QGraphicsDropShadowEffect>
-#include <iostream>
 
 #ifndef M_PI
     #define M_PI 3.14159265358979323846
@@ -67,6 +68,7 @@ PBCPlayerView::PBCPlayerView(PBCPlayerSP playerSP, PBCPlayView* playView) :
  * @brief Painting the player represented  by _playerSP
  */
 void PBCPlayerView::repaint() {
+    PBC_PERF_SCOPE("playerView.repaint");
     _originalPos = PBCPositionTranslator::getInstance()->translatePos(_playerSP->pos());  // NOLINT
     unsigned int playerWidth = PBCConfig::getInstance()->playerWidth();
     double playerPosX = _originalPos.get<0>() - playerWidth / 2;
@@ -142,6 +144,7 @@ void PBCPlayerView::joinPaths(const std::vector<PBCPathSP>& paths,
                               std::vector<QGraphicsItemSP>* graphicItems,
                               PBCDPoint basePoint,
                               RouteType mode) {
+    PBC_PERF_SCOPE("playerView.joinPaths");
     pbcAssert(graphicItems == &_routePaths || graphicItems == &_motionPaths);
     if (paths.empty()) {
         return;
@@ -293,10 +296,13 @@ void PBCPlayerView::paintRoutes() {
             __paintRoutes(_playerSP->route(), RouteType::Route);
         }
     } catch(const PBCRenderingException& e) {
+        PBCPlayer before = *_playerSP;
         _playerSP->resetOptionRoutes();
         _playerSP->resetRoute();
         _playerSP->resetAlternativeRoute(1);
         _playerSP->resetAlternativeRoute(2);
+        // keeps the usage index up to date and makes the reset undoable
+        _playView->recordPlayerEdit("Reset Routes", _playerSP, before);
         std::array<char, 4> sn = _playerSP->role().shortName;
         std::string playerShortName(sn.begin(), sn.end());
         QMessageBox::warning(NULL,
@@ -357,10 +363,10 @@ void PBCPlayerView::setPosition(double x, double y) {
 
 bool PBCPlayerView::isClickInShape(const QPointF& clickPos) {
     if (_playerShapeSP->contains(clickPos)) {
-        std::cout << "contained" << std::endl;
+        PBC_LOG_TRACE("gui.mouse", "click in shape of " << _playerSP->role().fullName);
         return true;
     } else {
-        std::cout << "not contained" << std::endl;
+        PBC_LOG_TRACE("gui.mouse", "click outside of shape of " << _playerSP->role().fullName);
         return false;
     }
 }
@@ -406,10 +412,18 @@ void PBCPlayerView::createNamedRoute(RouteType mode) {
         }
         bool overwriteRoute = false;
         if (routeAlreadyInPlaybook) {
+            std::string question = "There already exists a route named '" + rs.name + "'.";
+            size_t usageCount = PBCController::getInstance()->getPlaybook()->routeUsages(rs.name).size();
+            if (usageCount > 0) {
+                size_t playCount = PBCController::getInstance()->getPlaybook()->playsUsingRoute(rs.name).size();
+                question += " It is used by " + std::to_string(usageCount) + " player(s) in " +
+                            std::to_string(playCount) + " play(s), which will change as well.";
+            }
+            question += " Do you want to overwrite it?";
             QMessageBox::StandardButton button =
                     QMessageBox::question(NULL,
                                             "Create custom route",
-                                            QString::fromStdString("There already exists a route named '" + rs.name + "'. Do you want to overwrite it?"),  // NOLINT
+                                            QString::fromStdString(question),
                                             QMessageBox::Ok | QMessageBox::Cancel);
 
             if(button == QMessageBox::Ok) {
@@ -473,11 +487,13 @@ void PBCPlayerView::contextMenuEvent(QGraphicsSceneContextMenuEvent *event) {
     if (clicked == NULL) {
         return;
     }
+    PBCPlayer before = *_playerSP;
 
 
     for(const auto& kv : routeActionMap) {
         if(clicked == kv.first) {
             _playerSP->setRoute(kv.second);
+            _playView->recordPlayerEdit("Set Route", _playerSP, before);
             paintRoutes();
             return;
         }
@@ -485,6 +501,7 @@ void PBCPlayerView::contextMenuEvent(QGraphicsSceneContextMenuEvent *event) {
     for(const auto& kv : optionRoutesActionMap) {
         if(clicked == kv.first) {
             _playerSP->addOptionRoute(kv.second);
+            _playView->recordPlayerEdit("Add Option Route", _playerSP, before);
             paintRoutes();
             return;
         }
@@ -492,6 +509,7 @@ void PBCPlayerView::contextMenuEvent(QGraphicsSceneContextMenuEvent *event) {
     for(const auto& kv : alternativeRoute1ActionMap) {
         if(clicked == kv.first) {
             _playerSP->setAlternativeRoute(1, kv.second);
+            _playView->recordPlayerEdit("Set Alternative Route", _playerSP, before);
             paintRoutes();
             return;
         }
@@ -499,6 +517,7 @@ void PBCPlayerView::contextMenuEvent(QGraphicsSceneContextMenuEvent *event) {
     for(const auto& kv : alternativeRoute2ActionMap) {
         if(clicked == kv.first) {
             _playerSP->setAlternativeRoute(2, kv.second);
+            _playView->recordPlayerEdit("Set Alternative Route", _playerSP, before);
             paintRoutes();
             return;
         }
@@ -509,6 +528,7 @@ void PBCPlayerView::contextMenuEvent(QGraphicsSceneContextMenuEvent *event) {
         if (clickedMenu == routeMenu) {
             if (clicked->text() == ACTION_TEXT_RESET) {
                 _playerSP->resetRoute();
+                _playView->recordPlayerEdit("Reset Route", _playerSP, before);
                 paintRoutes();
             } else if (clicked->text() == ACTION_TEXT_NAMED_ROUTE) {
                 createNamedRoute(RouteType::Route);
@@ -516,9 +536,10 @@ void PBCPlayerView::contextMenuEvent(QGraphicsSceneContextMenuEvent *event) {
                 _playView->enterRouteEditMode(this->_playerSP, RouteType::Route);
             }
         } else if (clickedMenu == optionRoutesMenu) {
-            std::cout << "choose option menu" << std::endl;
+            PBC_LOG_DEBUG("gui", "choose option menu");
             if (clicked->text() == ACTION_TEXT_RESET) {
                 _playerSP->resetOptionRoutes();
+                _playView->recordPlayerEdit("Reset Option Routes", _playerSP, before);
                 paintRoutes();
             } else if (clicked->text() == ACTION_TEXT_NAMED_ROUTE) {
                 createNamedRoute(RouteType::OptionRoute);
@@ -528,6 +549,7 @@ void PBCPlayerView::contextMenuEvent(QGraphicsSceneContextMenuEvent *event) {
         } else if (clickedMenu == alternative1Menu) {
             if (clicked->text() == ACTION_TEXT_RESET) {
                 _playerSP->resetAlternativeRoute(1);
+                _playView->recordPlayerEdit("Reset Alternative Route", _playerSP, before);
                 paintRoutes();
             } else if (clicked->text() == ACTION_TEXT_NAMED_ROUTE) {
                 createNamedRoute(RouteType::Alternative1);
@@ -537,6 +559,7 @@ void PBCPlayerView::contextMenuEvent(QGraphicsSceneContextMenuEvent *event) {
         } else if (clickedMenu == alternative2Menu) {
             if (clicked->text() == ACTION_TEXT_RESET) {
                 _playerSP->resetAlternativeRoute(2);
+                _playView->recordPlayerEdit("Reset Alternative Route", _playerSP, before);
                 paintRoutes();
             } else if (clicked->text() == ACTION_TEXT_NAMED_ROUTE) {
                 createNamedRoute(RouteType::Alternative2);
@@ -554,6 +577,7 @@ void PBCPlayerView::contextMenuEvent(QGraphicsSceneContextMenuEvent *event) {
         this->_playerSP->setRoute(emptyRoute);
         PBCMotionSP emptyMotion(new PBCMotion());
         this->_playerSP->setMotion(emptyMotion);
+        _playView->recordPlayerEdit("Delete Motion", _playerSP, before);
         this->repaint();
     } else if(clicked == action_ApplyMotion) {} else if(clicked == action_SetColor) {
         QColor color = QColorDialog::getColor(Qt::black);
@@ -561,6 +585,7 @@ void PBCPlayerView::contextMenuEvent(QGraphicsSceneContextMenuEvent *event) {
             this->setColor(PBCColor(color.red(),
                                     color.green(),
                                     color.blue()));
+            _playView->recordPlayerEdit("Set Color", _playerSP, before);
         }
     } else if(clicked == action_SetPosition) {
         bool ok1, ok2;
@@ -582,6 +607,7 @@ void PBCPlayerView::contextMenuEvent(QGraphicsSceneContextMenuEvent *event) {
                                             &ok2);
         if(ok1 == true && ok2 == true) {
             this->setPosition(x, y);
+            _playView->recordPlayerEdit("Set Position", _playerSP, before);
         }
     }
 }
@@ -590,7 +616,7 @@ void PBCPlayerView::contextMenuEvent(QGraphicsSceneContextMenuEvent *event) {
 
 
 void PBCPlayerView::mousePressEvent(QGraphicsSceneMouseEvent *event) {
-    std::cout << "mouse press event on " << this->_playerSP->role().fullName << std::endl;
+    PBC_LOG_DEBUG("gui.mouse", "mouse press event on " << this->_playerSP->role().fullName);
     if (isClickInShape(event->pos())) {
         QGraphicsItemGroup::mousePressEvent(event);
     } else {
@@ -604,7 +630,7 @@ void PBCPlayerView::mousePressEvent(QGraphicsSceneMouseEvent *event) {
  * @param event event datastructure, includes position of context menu click
  */
 void PBCPlayerView::mouseReleaseEvent(QGraphicsSceneMouseEvent *event) {
-    std::cout << "mouse release event on " << this->_playerSP->role().fullName << std::endl;
+    PBC_LOG_DEBUG("gui.mouse", "mouse release event on " << this->_playerSP->role().fullName);
     QGraphicsItemGroup::mouseReleaseEvent(event);
     QPointF pixelDelta = this->pos();
     QPointF newPixelPos = QPointF(_originalPos.get<0>(),
@@ -612,16 +638,20 @@ void PBCPlayerView::mouseReleaseEvent(QGraphicsSceneMouseEvent *event) {
                           + pixelDelta;
 
     PBCDPoint newPos = PBCPositionTranslator::getInstance()->retranslatePos(PBCDPoint(newPixelPos.x(), newPixelPos.y()));  //NOLINT
-    std::cout << pixelDelta.x() << ", " << pixelDelta.y() << std::endl;
-    std::cout << newPos.get<0>() << ", " << newPos.get<1>() << std::endl;
-    std::cout << "----------------------------------" << std::endl;
-    _playerSP->setPos(newPos);
+    PBC_LOG_DEBUG("gui.mouse", "moved by " << pixelDelta.x() << ", " << pixelDelta.y()
+                  << " to " << newPos.get<0>() << ", " << newPos.get<1>());
+    PBCDPoint oldPos = _playerSP->pos();
+    if (oldPos.get<0>() != newPos.get<0>() || oldPos.get<1>() != newPos.get<1>()) {
+        PBCPlayer before = *_playerSP;
+        _playerSP->setPos(newPos);
+        _playView->recordPlayerEdit("Move Player", _playerSP, before);
+    }
     _playView->setActivePlayer(this->_playerSP);
 }
 
 
 void PBCPlayerView::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event) {
-    std::cout << "mouse double click event on " << this->_playerSP->role().fullName << std::endl;
+    PBC_LOG_DEBUG("gui.mouse", "mouse double click event on " << this->_playerSP->role().fullName);
     if (isClickInShape(event->pos())) {
         QGraphicsItemGroup::mouseDoubleClickEvent(event);
         _playView->enterRouteEditMode(this->_playerSP, RouteType::Route);
@@ -27,6 +27,8 @@
 #include <iostream>
 
 const QString LAST_PLAYBOOK_LOCATION_KEY = "lastPlaybookLocation";
+const QString KEY_DERIVATION_KEY = "keyDerivation";
+const QString UPDATE_CHECK_KEY = "updateCheck";
 const QString DEFAULT_PLAYBOOK_LOCATION = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
 
 void setLastPlaybookLocation(QFileInfo fileInfo) {
@@ -42,3 +44,23 @@ QString getLastPlaybookLocation(QString fileName) {
     return  QDir(lastPlaybookLocation).absoluteFilePath(fileName);
 
 }
+
+void setKeyDerivationSetting(QString keyDerivation) {
+    QSettings settings;
+    settings.setValue(KEY_DERIVATION_KEY, keyDerivation);
+}
+
+QString getKeyDerivationSetting() {
+    QSettings settings;
+    return settings.value(KEY_DERIVATION_KEY, "").toString();
+}
+
+void setUpdateCheckSetting(QString updateCheck) {
+    QSettings settings;
+    settings.setValue(UPDATE_CHECK_KEY, updateCheck);
+}
+
+QString getUpdateCheckSetting() {
+    QSettings settings;
+    return settings.value(UPDATE_CHECK_KEY, "").toString();
+}
@@ -26,6 +26,10 @@
 
 void setLastPlaybookLocation(QFileInfo fileInfo);
 QString getLastPlaybookLocation(QString fileName);
+void setKeyDerivationSetting(QString keyDerivation);
+QString getKeyDerivationSetting();
+void setUpdateCheckSetting(QString updateCheck);
+QString getUpdateCheckSetting();
 
 
 #endif // PBCSETTINGS_H
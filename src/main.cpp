@@ -20,14 +20,426 @@
     @brief This is the main file.
 */
 #include "dialogs/mainDialog.h"
+#include "gui/pbcPlayRenderer.h"
+#include "gui/pbcPlayView.h"
+#include "models/pbcPlaybook.h"
+#include "util/pbcConfig.h"
+#include "util/pbcBookletExport.h"
 #include "util/pbcExceptions.h"
+#include "util/pbcImageExport.h"
+#include "util/pbcKeyDerivation.h"
+#include "util/pbcLog.h"
+#include "util/pbcMultiLayoutExportJob.h"
+#include "util/pbcStartupProfiler.h"
+#include "util/pbcStorage.h"
+#include "util/pbcTrace.h"
+#include "pbcController.h"
 #include "pbcVersion.h"
-#include "../updater/pbc_updater_bindings.h"
 #include <botan/version.h>
 #include <boost/version.hpp>
 #include <QApplication>
 #include <QMessageBox>
+#include <QEvent>
+#include <QImage>
+#include <QPainter>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <functional>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Ends the startup profile as soon as the first frame of the
+ * application has been painted.
+ */
+class PBCFirstPaintObserver : public QObject {
+ public:
+    bool eventFilter(QObject *watched, QEvent *event) override {
+        if (event->type() == QEvent::Paint) {
+            qApp->removeEventFilter(this);
+            // queued, so that the painting of the frame is included
+            QMetaObject::invokeMethod(qApp, []() {
+                PBCStartupProfiler::phaseFinished("first paint");
+                PBCStartupProfiler::report(std::cout);
+            }, Qt::QueuedConnection);
+        }
+        return QObject::eventFilter(watched, event);
+    }
+};
+
+/**
+ * @brief Prints the metadata of playbook files without starting the GUI
+ * (playbook-creator --inspect FILE...). The password is read from the
+ * standard input.
+ * @param fileNames The playbook files
+ * @return 0 if all files could be read
+ */
+static int inspectPlaybooks(const std::vector<std::string>& fileNames) {
+    std::string password;
+    std::cerr << "Password: ";
+    std::getline(std::cin, password);
+    int result = 0;
+    for (const std::string& fileName : fileNames) {
+        try {
+            PBCPlaybookMetadata metadata = PBCStorage::getInstance()->readMetadata(password, fileName);
+            std::time_t lastModified = metadata.lastModified;
+            char lastModifiedString[32];
+            std::strftime(lastModifiedString, sizeof(lastModifiedString), "%Y-%m-%d %H:%M",
+                          std::localtime(&lastModified));
+            std::cout << fileName << ": \"" << metadata.name << "\", "
+                      << metadata.plays << " plays, "
+                      << metadata.categories << " categories, "
+                      << metadata.formations << " formations, "
+                      << metadata.routes << " routes, "
+                      << metadata.numberOfPlayers << " players, "
+                      << "version " << metadata.version << ", "
+                      << "last modified " << lastModifiedString << std::endl;
+        } catch (std::exception& e) {
+            std::cout << fileName << ": " << e.what() << std::endl;
+            result = 1;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Changes the password of playbook files without starting the GUI
+ * (playbook-creator --change-password FILE...). The current and the new
+ * password are read from the standard input.
+ * @param fileNames The playbook files
+ * @return 0 if the password of all files has been changed
+ */
+static int changePasswords(const std::vector<std::string>& fileNames) {
+    std::string oldPassword;
+    std::string newPassword;
+    std::cerr << "Current password: ";
+    std::getline(std::cin, oldPassword);
+    std::cerr << "New password: ";
+    std::getline(std::cin, newPassword);
+    std::vector<std::pair<std::string, std::string>> failures =
+            PBCStorage::getInstance()->changePassword(oldPassword, newPassword, fileNames);
+    for (const auto& failure : failures) {
+        std::cout << failure.first << ": " << failure.second << std::endl;
+    }
+    return failures.empty() ? 0 : 1;
+}
+
+/**
+ * @brief Measures the key derivation with different settings without
+ * starting the GUI (playbook-creator --benchmark-kdf ["SETTINGS"...]), e.g.
+ * "Argon2id 65536 3 1". Without settings, common settings and the settings
+ * for new keys (see PBCStorage::keyDerivation()) are measured.
+ * @param settings The key derivation settings
+ * @return 0 if all settings could be measured
+ */
+static int benchmarkKeyDerivation(const std::vector<std::string>& settings) {
+    std::vector<PBCKdfSettings> kdfs;
+    int result = 0;
+    try {
+        for (const std::string& setting : settings) {
+            kdfs.push_back(PBCKdfSettings::fromString(setting));
+        }
+        if (kdfs.empty()) {
+            kdfs = {PBCKdfSettings::legacy(),
+                    PBCKdfSettings{PBCKdfSettings::PBKDF2, {600000}},
+                    PBCKdfSettings{PBCKdfSettings::ARGON2ID, {19456, 2, 1}},
+                    PBCKdfSettings{PBCKdfSettings::ARGON2ID, {65536, 3, 1}},
+                    PBCStorage::getInstance()->keyDerivation()};
+        }
+    } catch (std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+    for (const PBCKdfSettings& kdf : kdfs) {
+        try {
+            std::chrono::microseconds time = PBCKeyDerivation::benchmark(kdf);
+            std::cout << kdf.toString() << ": " << time.count() / 1000.0 << " ms" << std::endl;
+        } catch (std::exception& e) {
+            std::cout << kdf.toString() << ": " << e.what() << std::endl;
+            result = 1;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Compares the time it takes to render the plays of a playbook through
+ * PBCPlayView (a graphics scene) and through PBCPlayRenderer without starting
+ * the GUI (playbook-creator --benchmark-render FILE [CANVAS_HEIGHT]). The
+ * password is read from the standard input.
+ * @param arguments The playbook file and optionally the canvas height
+ * @return 0 if all plays could be rendered
+ */
+static int benchmarkRendering(const std::vector<std::string>& arguments) {
+    if (arguments.empty()) {
+        std::cout << "usage: playbook-creator --benchmark-render FILE [CANVAS_HEIGHT]" << std::endl;
+        return 1;
+    }
+    std::string password;
+    std::cerr << "Password: ";
+    std::getline(std::cin, password);
+    PBCPlaybookSP playbook;
+    unsigned int canvasHeight = 800;
+    try {
+        playbook = PBCStorage::getInstance()->openPlaybook(password, arguments[0]);
+        if (arguments.size() > 1) {
+            canvasHeight = std::stoul(arguments[1]);
+        }
+    } catch (std::exception& e) {
+        std::cout << arguments[0] << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    PBCConfig::getInstance()->setCanvasSize(canvasHeight, canvasHeight);
+    PBCRenderStyle style = PBCRenderStyle::fromConfig();
+    QImage image(style.canvasWidth, style.canvasHeight, QImage::Format_ARGB32_Premultiplied);
+    const QRectF target(image.rect());
+    auto renderScene = [&image, &target](PBCPlaySP play) {
+        QPainter painter(&image);
+        PBCPlayView playView(play);
+        playView.render(&painter, target, QRectF(), Qt::IgnoreAspectRatio);
+    };
+    auto renderImmediate = [&image, &target, &style](PBCPlaySP play) {
+        QPainter painter(&image);
+        PBCPlayRenderer::render(&painter, *play, style, target);
+    };
+    auto measure = [](const std::function<void()>& render) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        render();
+        return std::chrono::steady_clock::now() - start;
+    };
+
+    std::chrono::steady_clock::duration sceneTime(0);
+    std::chrono::steady_clock::duration immediateTime(0);
+    unsigned int plays = 0;
+    int result = 0;
+    bool warm = false;
+    for (const std::string& name : playbook->getPlayNames()) {
+        PBCPlaySP play = playbook->getPlay(name);
+        try {
+            if (warm == false) {
+                // the first rendering loads the fonts and fills the caches of Qt
+                renderScene(play);
+                renderImmediate(play);
+                warm = true;
+            }
+            // alternated, so that neither renderer profits from the caches warmed up by the other one
+            if (plays % 2 == 0) {
+                sceneTime += measure([&]() { renderScene(play); });
+                immediateTime += measure([&]() { renderImmediate(play); });
+            } else {
+                immediateTime += measure([&]() { renderImmediate(play); });
+                sceneTime += measure([&]() { renderScene(play); });
+            }
+            ++plays;
+        } catch (std::exception& e) {
+            std::cout << name << ": " << e.what() << std::endl;
+            result = 1;
+        }
+    }
+    if (plays > 0) {
+        typedef std::chrono::duration<double, std::milli> Milliseconds;
+        std::cout << plays << " plays, " << style.canvasWidth << "x" << style.canvasHeight << " pixels" << std::endl
+                  << "scene: " << Milliseconds(sceneTime).count() / plays << " ms per play" << std::endl
+                  << "immediate: " << Milliseconds(immediateTime).count() / plays << " ms per play" << std::endl;
+    }
+    return result;
+}
+
+/**
+ * @brief Exports all plays of a playbook as images without starting the GUI
+ * (playbook-creator --export-images FILE DIRECTORY [png|svg|sprites] [DPI]).
+ * The password is read from the standard input.
+ * @param arguments The playbook file, the export directory and optionally the
+ * format and resolution
+ * @return 0 if all images could be written
+ */
+static int exportImages(const std::vector<std::string>& arguments) {
+    if (arguments.size() < 2) {
+        std::cout << "usage: playbook-creator --export-images FILE DIRECTORY [png|svg|sprites] [DPI]" << std::endl;
+        return 1;
+    }
+    PBCImageExportOptions options;
+    if (arguments.size() > 2) {
+        if (arguments[2] == "png") {
+            options.format = PBCImageExportOptions::PNG;
+        } else if (arguments[2] == "svg") {
+            options.format = PBCImageExportOptions::SVG;
+        } else if (arguments[2] == "sprites") {
+            options.format = PBCImageExportOptions::SPRITE_SHEET;
+        } else {
+            std::cout << "unknown format: " << arguments[2] << std::endl;
+            return 1;
+        }
+    }
+    std::string password;
+    std::cerr << "Password: ";
+    std::getline(std::cin, password);
+    PBCImageExportReport report;
+    try {
+        if (arguments.size() > 3) {
+            unsigned long dpi = std::stoul(arguments[3]);
+            // the same range as in the GUI, larger images would exhaust the memory
+            options.dpi = dpi < PBCImageExportOptions::MIN_DPI ? PBCImageExportOptions::MIN_DPI :
+                          dpi > PBCImageExportOptions::MAX_DPI ? PBCImageExportOptions::MAX_DPI :
+                          static_cast<unsigned int>(dpi);
+            if (options.dpi != dpi) {
+                std::cerr << "the resolution is limited to " << options.dpi << " dpi" << std::endl;
+            }
+        }
+        PBCPlaybookSP playbook = PBCStorage::getInstance()->openPlaybook(password, arguments[0]);
+        report = PBCImageExport::exportPlays(playbook, playbook->getPlayNames(), arguments[1], options);
+    } catch (std::exception& e) {
+        std::cout << arguments[0] << ": " << e.what() << std::endl;
+        return 1;
+    }
+    std::cout << report.written.size() << " images written, "
+              << report.skipped.size() << " unchanged images skipped" << std::endl;
+    for (const std::pair<std::string, std::string>& failure : report.failures) {
+        std::cout << failure.first << ": " << failure.second << std::endl;
+    }
+    return report.failures.empty() ? 0 : 1;
+}
+
+/**
+ * @brief Exports one PDF booklet per category of a playbook on A4 paper
+ * without starting the GUI
+ * (playbook-creator --export-booklets FILE DIRECTORY [COLUMNS ROWS]). Only
+ * the booklets whose plays have changed since the last export into the
+ * directory are rebuilt. The password is read from the standard input.
+ * @param arguments The playbook file, the export directory and optionally the
+ * number of plays per row and the number of rows per page
+ * @return 0 if all booklets could be built
+ */
+static int exportBooklets(const std::vector<std::string>& arguments) {
+    if (arguments.size() != 2 && arguments.size() != 4) {
+        std::cout << "usage: playbook-creator --export-booklets FILE DIRECTORY [COLUMNS ROWS]" << std::endl;
+        return 1;
+    }
+    std::string password;
+    std::cerr << "Password: ";
+    std::getline(std::cin, password);
+    PBCBookletReport report;
+    try {
+        PBCPDFLayout layout{210, 297, 2, 3, 0, 0, 0, 0};
+        if (arguments.size() == 4) {
+            layout.columns = std::stoul(arguments[2]);
+            layout.rows = std::stoul(arguments[3]);
+            if (layout.columns == 0 || layout.rows == 0) {
+                throw std::invalid_argument("the grid must have at least one column and row");
+            }
+        }
+        PBCPlaybookSP playbook = PBCStorage::getInstance()->openPlaybook(password, arguments[0]);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        report = PBCBookletExport::exportBooklets(playbook, arguments[1], layout);
+        std::cout << "done in " << std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+    } catch (std::exception& e) {
+        std::cout << arguments[0] << ": " << e.what() << std::endl;
+        return 1;
+    }
+    std::cout << report.written.size() << " booklets built, "
+              << report.skipped.size() << " unchanged booklets skipped, "
+              << report.removed.size() << " obsolete booklets removed" << std::endl;
+    for (const std::pair<std::string, std::string>& failure : report.failures) {
+        std::cout << failure.first << ": " << failure.second << std::endl;
+    }
+    return report.failures.empty() ? 0 : 1;
+}
+
+/**
+ * @brief Exports one PDF booklet per position of a playbook on A4 paper, in
+ * which the assignment of the position is emphasized, without starting the
+ * GUI (playbook-creator --export-role-booklets FILE DIRECTORY [ROLE...]).
+ * Without roles, there is a booklet for every role of the plays. The
+ * password is read from the standard input.
+ * @param arguments The playbook file, the export directory and optionally the
+ * short names of the roles
+ * @return 0 if all booklets could be built
+ */
+static int exportRoleBooklets(const std::vector<std::string>& arguments) {
+    if (arguments.size() < 2) {
+        std::cout << "usage: playbook-creator --export-role-booklets FILE DIRECTORY [ROLE...]" << std::endl;
+        return 1;
+    }
+    std::string password;
+    std::cerr << "Password: ";
+    std::getline(std::cin, password);
+    PBCBookletReport report;
+    try {
+        PBCPlaybookSP playbook = PBCStorage::getInstance()->openPlaybook(password, arguments[0]);
+        std::vector<PBCPlaySP> plays;
+        for (const std::string& name : playbook->getPlayNames()) {
+            plays.push_back(playbook->getPlay(name));
+        }
+        std::vector<std::string> roles(arguments.begin() + 2, arguments.end());
+        PBCPDFLayout layout{210, 297, 2, 3, 0, 0, 0, 0};
+        report = PBCBookletExport::exportRoleBooklets(plays, roles, arguments[1], layout);
+    } catch (std::exception& e) {
+        std::cout << arguments[0] << ": " << e.what() << std::endl;
+        return 1;
+    }
+    std::cout << report.written.size() << " booklets built" << std::endl;
+    for (const std::pair<std::string, std::string>& failure : report.failures) {
+        std::cout << failure.first << ": " << failure.second << std::endl;
+    }
+    return report.failures.empty() ? 0 : 1;
+}
+
+/**
+ * @brief Exports all plays of a playbook into several PDF files with
+ * different layouts without starting the GUI
+ * (playbook-creator --export-layouts FILE BASENAME LAYOUT...). A layout is
+ * given as columns x rows, optionally with the paper size in millimeters
+ * (e.g. "4x2" or "3x1@100x50"), the default paper is A4. Every play is
+ * rendered only once for all layouts. The password is read from the standard
+ * input.
+ * @param arguments The playbook file, the base name of the PDF files and the
+ * layouts
+ * @return 0 if all files could be written
+ */
+static int exportLayouts(const std::vector<std::string>& arguments) {
+    if (arguments.size() < 3) {
+        std::cout << "usage: playbook-creator --export-layouts FILE BASENAME LAYOUT..." << std::endl;
+        return 1;
+    }
+    std::vector<PBCPDFTarget> targets;
+    for (size_t i = 2; i < arguments.size(); ++i) {
+        PBCPDFLayout layout{210, 297, 1, 1, 0, 0, 0, 0};
+        if (PBCMultiLayoutExportJob::parseLayout(arguments[i], layout) == false) {
+            std::cout << "invalid layout: " << arguments[i] << std::endl;
+            return 1;
+        }
+        targets.push_back(PBCPDFTarget{PBCMultiLayoutExportJob::fileName(arguments[1], layout), layout});
+    }
+    std::string password;
+    std::cerr << "Password: ";
+    std::getline(std::cin, password);
+    try {
+        PBCPlaybookSP playbook = PBCStorage::getInstance()->openPlaybook(password, arguments[0]);
+        std::vector<PBCPlaySP> plays;
+        for (const std::string& name : playbook->getPlayNames()) {
+            plays.push_back(playbook->getPlay(name));
+        }
+        if (plays.empty()) {
+            std::cout << arguments[0] << ": the playbook has no plays" << std::endl;
+            return 1;
+        }
+        PBCMultiLayoutExportJob job(plays, targets);
+        job.run();
+    } catch (std::exception& e) {
+        std::cout << arguments[0] << ": " << e.what() << std::endl;
+        return 1;
+    }
+    for (const PBCPDFTarget& target : targets) {
+        std::cout << target.fileName << std::endl;
+    }
+    return 0;
+}
 
 /**
  * @brief the main function
@@ -36,77 +448,100 @@
  * @return Returns the return value of the Qt application execution.
  */
 int main(int argc, char *argv[]) {
-    std::cout << "Playbook Creator Version: "
-              << PBCVersion::getVersionString()
-              << std::endl;
-    std::cout << "built with Qt version: " << QT_VERSION_STR << std::endl;
-    std::cout << "built with boost version: " << BOOST_LIB_VERSION << std::endl;
-    std::cout << "built with botan verison: "
-              << BOTAN_VERSION_MAJOR << "."
-              << BOTAN_VERSION_MINOR << "."
-              << BOTAN_VERSION_PATCH << std::endl;
+    const char TRACE_OPTION[] = "--trace=";
+    const char LOG_OPTION[] = "--log=";
+    const char LOG_FILE_OPTION[] = "--log-file=";
+    PBCLog::addSink(PBCLogSinkSP(new PBCStreamLogSink(std::clog)));
+    // the global options may appear anywhere and are removed from the
+    // arguments, so that they are not taken for a command line mode or for
+    // one of its arguments
+    int remaining = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--profile-startup") == 0) {
+            PBCStartupProfiler::enable();
+        } else if (std::strncmp(argv[i], TRACE_OPTION, std::strlen(TRACE_OPTION)) == 0) {
+            // the spans of the whole session are written when the application exits
+            PBCTrace::setEnabled(true);
+            PBCTrace::setThreadName("GUI");
+            PBCTrace::writeAtExit(argv[i] + std::strlen(TRACE_OPTION));
+        } else if (std::strncmp(argv[i], LOG_OPTION, std::strlen(LOG_OPTION)) == 0) {
+            // e.g. --log=debug or --log=info,gui.mouse=trace
+            if (PBCLog::configure(argv[i] + std::strlen(LOG_OPTION)) == false) {
+                PBC_LOG_ERROR("app", "invalid log levels: " << argv[i] + std::strlen(LOG_OPTION));
+            }
+        } else if (std::strncmp(argv[i], LOG_FILE_OPTION, std::strlen(LOG_FILE_OPTION)) == 0) {
+            PBCLog::addSink(PBCLogSinkSP(new PBCFileLogSink(argv[i] + std::strlen(LOG_FILE_OPTION))));
+        } else {
+            argv[remaining++] = argv[i];
+        }
+    }
+    argc = remaining;
+    argv[argc] = NULL;
+
+    // the command line modes share the settings (e.g. the key derivation) of the GUI
+    QCoreApplication::setApplicationName("Playbook Creator");
+    if (argc > 1 && std::strcmp(argv[1], "--inspect") == 0) {
+        return inspectPlaybooks(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--change-password") == 0) {
+        return changePasswords(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--benchmark-kdf") == 0) {
+        return benchmarkKeyDerivation(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--benchmark-render") == 0) {
+        // rendering needs fonts, so the application must exist (e.g. with -platform offscreen)
+        QApplication application(argc, argv);
+        return benchmarkRendering(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--export-images") == 0) {
+        QApplication application(argc, argv);
+        return exportImages(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--export-booklets") == 0) {
+        QApplication application(argc, argv);
+        return exportBooklets(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--export-role-booklets") == 0) {
+        QApplication application(argc, argv);
+        return exportRoleBooklets(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--export-layouts") == 0) {
+        QApplication application(argc, argv);
+        return exportLayouts(std::vector<std::string>(argv + 2, argv + argc));
+    }
+
+    PBC_LOG_INFO("app", "Playbook Creator Version: " << PBCVersion::getVersionString());
+    PBC_LOG_INFO("app", "built with Qt version: " << QT_VERSION_STR);
+    PBC_LOG_INFO("app", "built with boost version: " << BOOST_LIB_VERSION);
+    PBC_LOG_INFO("app", "built with botan version: "
+                 << BOTAN_VERSION_MAJOR << "."
+                 << BOTAN_VERSION_MINOR << "."
+                 << BOTAN_VERSION_PATCH);
 
 
     QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QApplication a(argc, argv);
     a.setApplicationName("Playbook Creator");
+    PBCStartupProfiler::phaseFinished("Qt initialization");
+
+    // the default routes and formations are filled in on first use and
+    // reported separately by the profiler
+    PBCController::getInstance()->getPlaybook();
+    PBCStartupProfiler::phaseFinished("model creation");
 
     MainDialog w;
+    PBCStartupProfiler::phaseFinished("UI construction");
+    PBCFirstPaintObserver firstPaintObserver;
+    if (PBCStartupProfiler::enabled()) {
+        a.installEventFilter(&firstPaintObserver);
+    }
     try {
-        QMessageBox::StandardButton shall_search_update =
-                    QMessageBox::question(NULL,
-                                          "PBC Update Checker",
-                                          "Do you want to look for updates and news?\n"
-                                          "Recommended only, if you have stable internet connection."  // NOLINT
-                                          "This should only take a few seconds. Please press OK and wait...",
-                                          QMessageBox::Ok | QMessageBox::Cancel); //NOLINT
-
-        if(shall_search_update == QMessageBox::Ok) {
-            std::cout << "Looking for updates. This should only take a few seconds. Please wait..." << std::endl;
-            const uint32_t BUFF_LEN = 500;
-            uint8_t buffer[BUFF_LEN] = {0};
-            CBuffer desc_result_buf = CBuffer{buffer, BUFF_LEN};
-            UpdateCheckingStatus ucs = updates_available(PBC_VERSION_MAJOR, PBC_VERSION_MINOR, PBC_VERSION_PATCH, &desc_result_buf); // TODO: numeric conversions might be problematic here!
-            switch (ucs.tag) {
-                case UpdateCheckingStatus::Tag::UpdatesAvailable:
-                    {
-                        unsigned major = ucs.updates_available._0;
-                        uint64_t minor = ucs.updates_available._1;
-                        uint64_t patch = ucs.updates_available._2;
-                        std::string desc( reinterpret_cast<char const*>(buffer), BUFF_LEN ) ;
-                        std::string latest_version = "v" + std::to_string(major) +  "." + std::to_string(minor) + "." + std::to_string(patch);
-                        std::string msg = "A new version of PlaybookCreator is available!"
-                                        "<br><br>Description of release " + latest_version + ":\n" + desc +
-                                        "<br><br>Please visit <a href='https://github.com/obraunsdorf/playbook-creator/releases'>https://github.com/obraunsdorf/playbook-creator/releases</a> "
-                                        "to update to the current version!";
-
-                        QMessageBox info;
-                        info.setWindowTitle("PBC Update Checker");
-                        info.setTextFormat(Qt::RichText);
-                        info.setText(QString::fromStdString(msg));
-                        info.exec();
-                    }
-                    break;
-
-                case UpdateCheckingStatus::Tag::Error:
-                    {
-                        QMessageBox::information(&w, "PBC Update Checker", "An error occured during checking for updates"
-                                                                        " (maybe bad internet connection?). Please visit "
-                                                                        "https://github.com/obraunsdorf/playbook-creator/releases "
-                                                                        "and see if a new version of PBC has been released",
-                                                QMessageBox::Ok);
-                    }
-                    break;
-
-                case UpdateCheckingStatus::Tag::UpToDate:
-                    std::cout << "No updates available" << std::endl;
-                    break;
-
-            }
-        }
         QString playbookPath;
-        if (argc == 2) {
-            playbookPath = QString(argv[1]);
+        for (const QString& argument : a.arguments().mid(1)) {
+            if (argument.startsWith("--") == false) {
+                playbookPath = argument;
+            }
         }
         w.show(playbookPath);
         a.exec();
@@ -40,9 +40,25 @@ friend class boost::serialization::access;
     void serialize(Archive& ar, const unsigned int version) {  // NOLINT
         pbcAssert(version == 0);
         ar & _paths;
+        _contentHash.invalidate();
     }
 
  protected:
+    PBCHashCache _contentHash;
+
+    /**
+     * @brief Combines the given hash with the content hashes of all paths
+     * @param seed The hash of the movement's own fields
+     * @return the combined hash
+     */
+    PBCHash combinePathHashes(PBCHash seed) const {
+        PBCHash hash = PBCContentHash::number(static_cast<uint64_t>(_paths.size()), seed);
+        for (const PBCPathSP& path : _paths) {
+            hash = PBCContentHash::combine(hash, path->contentHash());
+        }
+        return hash;
+    }
+
     /**
      * @brief Empty default constructor, needed by Boost Serialization
      */
@@ -70,6 +86,7 @@ friend class boost::serialization::access;
      */
     void setPaths(const std::vector<PBCPathSP> paths) {
         _paths = paths;
+        _contentHash.invalidate();
     }
 
     /**
@@ -78,6 +95,7 @@ friend class boost::serialization::access;
      */
     void addPath(const PBCPathSP& path) {
         _paths.push_back(path);
+        _contentHash.invalidate();
     }
 };
 
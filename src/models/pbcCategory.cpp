@@ -21,8 +21,10 @@
 
 #include "pbcCategory.h"
 #include "pbcPlay.h"
+#include <algorithm>
 #include <set>
 #include <string>
+#include <vector>
 
 /**
  * @class PBCCategory.cpp
@@ -48,6 +50,7 @@ std::string PBCCategory::name() const {
  */
 void PBCCategory::setName(const std::string &name) {
     _name = name;
+    _contentHash.invalidate();
 }
 
 /**
@@ -56,6 +59,7 @@ void PBCCategory::setName(const std::string &name) {
  */
 void PBCCategory::addPlay(const PBCPlaySP &play) {
     _plays.insert(play);
+    _contentHash.invalidate();
 }
 
 /**
@@ -64,6 +68,7 @@ void PBCCategory::addPlay(const PBCPlaySP &play) {
  */
 void PBCCategory::removePlay(const PBCPlaySP &play) {
     _plays.erase(play);
+    _contentHash.invalidate();
 }
 
 /**
@@ -73,3 +78,27 @@ void PBCCategory::removePlay(const PBCPlaySP &play) {
 std::set<PBCPlaySP> PBCCategory::plays() const {
     return _plays;
 }
+
+/**
+ * @brief Computes the content hash of the category.
+ *
+ * The plays are included by their names only (in alphabetical order), because
+ * the plays refer back to their categories.
+ * @return the content hash
+ */
+PBCHash PBCCategory::contentHash() const {
+    return _contentHash.get(
+        [this]() { return PBCContentHash::string(_name); },
+        [this](PBCHash ownHash) {
+            std::vector<std::string> playNames;
+            for (const PBCPlaySP& play : _plays) {
+                playNames.push_back(play->name());
+            }
+            std::sort(playNames.begin(), playNames.end());
+            PBCHash hash = PBCContentHash::number(static_cast<uint64_t>(playNames.size()), ownHash);
+            for (const std::string& playName : playNames) {
+                hash = PBCContentHash::string(playName, hash);
+            }
+            return hash;
+        });
+}
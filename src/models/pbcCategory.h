@@ -23,6 +23,7 @@
 #define PBCCATEGORY_H
 
 #include "util/pbcDeclarations.h"
+#include "util/pbcContentHash.h"
 #include <string>
 #include <boost/shared_ptr.hpp>
 #include <boost/serialization/access.hpp>
@@ -46,6 +47,7 @@ friend class boost::serialization::access;
         pbcAssert(version == 0);
         ar & _name;
         ar & _plays;
+        _contentHash.invalidate();
     }
     PBCCategory() {}
 
@@ -53,6 +55,7 @@ friend class boost::serialization::access;
     std::string _name;
     // char _shortName[5];
     std::set<PBCPlaySP> _plays;
+    PBCHashCache _contentHash;
 
  public:
     explicit PBCCategory(const std::string& name) : _name(name) {}
@@ -61,6 +64,7 @@ friend class boost::serialization::access;
     void addPlay(const PBCPlaySP& play);
     void removePlay(const PBCPlaySP& play);
     std::set<PBCPlaySP> plays() const;
+    PBCHash contentHash() const;
 };
 
 #endif  // PBCCATEGORY_H
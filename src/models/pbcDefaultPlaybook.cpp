@@ -4,109 +4,101 @@
 
 #include "models/pbcRoute.h"
 #include "models/pbcFormation.h"
-
-//#define ROUTE(name, pathVector) routes.insert(std::make_pair(name, PBCRouteSP(new PBCRoute(name, "", pathVector))));
-
-static void route(PBCModelMap<PBCRouteSP> &routes, const std::string &name, std::vector<PBCPathSP> paths) {
-    routes.insert(std::make_pair(name, PBCRouteSP(new PBCRoute(name, "", paths))));
-}
+#include <algorithm>
+
+// The defaults are plain constant tables, so they cost nothing until a
+// playbook actually needs them (see PBCPlaybook::materializeDefaults()).
+
+struct PBCDefaultPath {
+    double x;
+    double y;
+    bool curved;
+    double controlX;
+    double controlY;
+};
+
+struct PBCDefaultRoute {
+    const char* name;
+    PBCDefaultPath paths[2];
+};
+
+struct PBCDefaultPlayer {
+    const char* fullName;
+    char shortName[4];
+    double x;
+    double y;
+    unsigned int minPlayerNumber;  // the player is part of the formation if there are at least that many players
+};
+
+static constexpr PBCDefaultRoute DEFAULT_ROUTES[] = {
+    {"Hook",     {{0, 6},                   {1, 5}}},
+    {"Comeback", {{0, 12},                  {-2, 10}}},
+    {"5 In",     {{0, 5},                   {10, 5}}},
+    {"10 In",    {{0, 10},                  {10, 10}}},
+    {"5 Out",    {{0, 5},                   {-10, 5}}},
+    {"10 Out",   {{0, 10},                  {-10, 10}}},
+    {"Slant",    {{0, 2},                   {9, 5}}},
+    {"Shallow",  {{13, 2, true, 2, 2},      {15, 2}}},
+    {"Curl",     {{0, 12},                  {2, 10}}},
+    {"Post",     {{0, 7},                   {7, 14}}},
+    {"Corner",   {{0, 7},                   {-7, 14}}},
+    {"Fly",      {{-1, 12, true, -0.7, 3},  {-1, 14}}},
+    {"Seam",     {{0.7, 12, true, -0.3, 3}, {1, 14}}},
+    {"Fade",     {{-1, 5, true, -0.7, 1},   {-1, 7}}}
+};
+
+static constexpr const char* DEFAULT_FORMATION_NAME = "Spread Right";
+
+static constexpr PBCDefaultPlayer DEFAULT_FORMATION[] = {
+    {"Center",              "C",   0,   0,  5},
+    {"Quarterback",         "QB",  0,   -5, 5},
+    {"Wide Receiver Left",  "WRL", -10, 0,  5},
+    {"Wide Receiver Right", "WRR", 10,  0,  5},
+    {"Halfback",            "HB",  5,   0,  5},
+    {"Left Guard",          "LG",  -1,  0,  7},
+    {"Right Guard",         "RG",  1,   0,  7},
+    {"Fullback",            "FB",  0,   -3, 9},
+    {"Tight End",           "TE",  3,   -1, 9},
+    {"Left Tackle",         "LT",  -2,  0,  11},
+    {"Right Tackle",        "RT",  2,   0,  11}
+};
 
 static void default_routes(PBCModelMap<PBCRouteSP> &routes) {
-    route(routes, "Hook", {PBCPathSP(new PBCPath(0, 6)),
-                           PBCPathSP(new PBCPath(1, 5))});
-
-    route(routes, "Comeback", {PBCPathSP(new PBCPath(0, 12)),
-                               PBCPathSP(new PBCPath(-2, 10))});
-
-    route(routes, "5 In", {PBCPathSP(new PBCPath(0, 5)),
-                           PBCPathSP(new PBCPath(10, 5))});
-
-    route(routes, "10 In", {PBCPathSP(new PBCPath(0, 10)),
-                           PBCPathSP(new PBCPath(10, 10))});
-
-    route(routes, "5 Out", {PBCPathSP(new PBCPath(0, 5)),
-                           PBCPathSP(new PBCPath(-10, 5))});
-
-    route(routes, "10 Out", {PBCPathSP(new PBCPath(0, 10)),
-                            PBCPathSP(new PBCPath(-10, 10))});
-
-    route(routes, "Slant", {PBCPathSP(new PBCPath(0, 2)),
-                            PBCPathSP(new PBCPath(9, 5))});
-
-    route(routes, "Shallow", {PBCPathSP(new PBCPath(13, 2, 2, 2)),
-                            PBCPathSP(new PBCPath(15,2))});
-
-    route(routes, "Curl", {PBCPathSP(new PBCPath(0, 12)),
-                               PBCPathSP(new PBCPath(2, 10))});
-
-    route(routes, "Post", {PBCPathSP(new PBCPath(0, 7)),
-                           PBCPathSP(new PBCPath(7, 14))});
-
-    route(routes, "Corner", {PBCPathSP(new PBCPath(0, 7)),
-                           PBCPathSP(new PBCPath(-7, 14))});
-
-    route(routes, "Fly", {PBCPathSP(new PBCPath(-1, 12, -0.7, 3)),
-                          PBCPathSP(new PBCPath(-1, 14))});
-
-    route(routes, "Seam", {PBCPathSP(new PBCPath(0.7, 12, -0.3, 3)),
-                           PBCPathSP(new PBCPath(1, 14))});
-
-    route(routes, "Fade", {PBCPathSP(new PBCPath(-1, 5, -0.7, 1)),
-                          PBCPathSP(new PBCPath(-1, 7))});
-}
-
-static void default_formations(PBCModelMap<PBCFormationSP> &formations, const unsigned int playerNumber) {
-    PBCFormationSP spread_right_formation(new PBCFormation("Spread Right"));
-    spread_right_formation->push_back(PBCPlayerSP(new PBCPlayer(PBCRole{"Center", "C"},
-                                                                PBCColor(),
-                                                                PBCDPoint(0, 0))));
-
-    spread_right_formation->push_back(PBCPlayerSP(new PBCPlayer(PBCRole{"Quarterback", "QB"},
-                                                                PBCColor(),
-                                                                PBCDPoint(0, -5))));
-
-    spread_right_formation->push_back(PBCPlayerSP(new PBCPlayer(PBCRole{"Wide Receiver Left", "WRL"},  // NOLINT
-                                                                PBCColor(),
-                                                                PBCDPoint(-10, 0))));
-
-    spread_right_formation->push_back(PBCPlayerSP(new PBCPlayer(PBCRole{"Wide Receiver Right", "WRR"}, // NOLINT
-                                                                PBCColor(),
-                                                                PBCDPoint(10, 0))));
-
-    spread_right_formation->push_back(PBCPlayerSP(new PBCPlayer(PBCRole{"Halfback", "HB"},
-                                                                PBCColor(),
-                                                                PBCDPoint(5, 0))));
-
-    if (playerNumber >= 7) {
-        spread_right_formation->push_back(PBCPlayerSP(new PBCPlayer(PBCRole{"Left Guard", "LG"}, // NOLINT
-                                                                    PBCColor(),
-                                                                    PBCDPoint(-1, 0))));
-
-        spread_right_formation->push_back(PBCPlayerSP(new PBCPlayer(PBCRole{"Right Guard", "RG"}, // NOLINT
-                                                                    PBCColor(),
-                                                                    PBCDPoint(1, 0))));
+    for (const PBCDefaultRoute& defaultRoute : DEFAULT_ROUTES) {
+        std::vector<PBCPathSP> paths;
+        for (const PBCDefaultPath& path : defaultRoute.paths) {
+            if (path.curved) {
+                paths.push_back(PBCPathSP(new PBCPath(path.x, path.y, path.controlX, path.controlY)));
+            } else {
+                paths.push_back(PBCPathSP(new PBCPath(path.x, path.y)));
+            }
+        }
+        routes.insert(std::make_pair(defaultRoute.name, PBCRouteSP(new PBCRoute(defaultRoute.name, "", paths))));
     }
+}
 
-    if (playerNumber >= 9) {
-        spread_right_formation->push_back(PBCPlayerSP(new PBCPlayer(PBCRole{"Fullback", "FB"}, // NOLINT
-                                                                    PBCColor(),
-                                                                    PBCDPoint(0, -3))));
-
-        spread_right_formation->push_back(PBCPlayerSP(new PBCPlayer(PBCRole{"Tight End", "TE"}, // NOLINT
-                                                                    PBCColor(),
-                                                                    PBCDPoint(3, -1))));
+static bool is_default_route(const std::string& name) {
+    for (const PBCDefaultRoute& defaultRoute : DEFAULT_ROUTES) {
+        if (name == defaultRoute.name) {
+            return true;
+        }
     }
+    return false;
+}
 
-    if (playerNumber == 11) {
-        spread_right_formation->push_back(PBCPlayerSP(new PBCPlayer(PBCRole{"Left Tackle", "LT"}, // NOLINT
-                                                                    PBCColor(),
-                                                                    PBCDPoint(-2, 0))));
-
-        spread_right_formation->push_back(PBCPlayerSP(new PBCPlayer(PBCRole{"Right Tackle", "RT"}, // NOLINT
-                                                                    PBCColor(),
-                                                                    PBCDPoint(2, 0))));
+static void default_formations(PBCModelMap<PBCFormationSP> &formations, const unsigned int playerNumber) {
+    PBCFormationSP formation(new PBCFormation(DEFAULT_FORMATION_NAME));
+    for (const PBCDefaultPlayer& player : DEFAULT_FORMATION) {
+        if (playerNumber < player.minPlayerNumber) {
+            continue;
+        }
+        PBCRole role{player.fullName, {}};
+        std::copy(std::begin(player.shortName), std::end(player.shortName), role.shortName.begin());
+        formation->push_back(PBCPlayerSP(new PBCPlayer(role, PBCColor(), PBCDPoint(player.x, player.y))));
     }
+    formations.insert(std::make_pair(formation->name(), formation));
+}
 
-
-    formations.insert(std::make_pair(spread_right_formation->name(), spread_right_formation));
-}
\ No newline at end of file
+static bool is_default_formation(const std::string& name) {
+    return name == DEFAULT_FORMATION_NAME;
+}
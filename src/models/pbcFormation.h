@@ -39,6 +39,9 @@ typedef boost::shared_ptr<PBCFormation> PBCFormationSP;
  *
  * A formation is a vector of players (which store the position information) and
  * also a category.
+ *
+ * The player vector is only filled on construction. Code that changes the
+ * vector of an existing formation has to call invalidateContentHash().
  */
 class PBCFormation : public PBCCategory, public std::vector<PBCPlayerSP> {
 friend class boost::serialization::access;
@@ -49,6 +52,7 @@ friend class boost::serialization::access;
         pbcAssert(version == 0);
         ar & boost::serialization::base_object<PBCCategory>(*this);
         ar & boost::serialization::base_object<std::vector<PBCPlayerSP>>(*this);
+        _contentHash.invalidate();
     }
     PBCFormation() : PBCCategory("") {}
 
@@ -73,6 +77,31 @@ friend class boost::serialization::access;
             this->push_back(player);
         }
     }
+
+    /**
+     * @brief Marks the formation as changed, e.g. after players have been
+     * added or removed
+     */
+    void invalidateContentHash() {
+        _contentHash.invalidate();
+    }
+
+    /**
+     * @brief Computes the content hash of the formation (name and players in
+     * their order)
+     * @return the content hash
+     */
+    PBCHash contentHash() const {
+        return _contentHash.get(
+            [this]() { return PBCContentHash::string(name()); },
+            [this](PBCHash ownHash) {
+                PBCHash hash = PBCContentHash::number(static_cast<uint64_t>(size()), ownHash);
+                for (const PBCPlayerSP& player : *this) {
+                    hash = PBCContentHash::combine(hash, player->contentHash());
+                }
+                return hash;
+            });
+    }
 };
 
 #endif  // PBCFORMATION_H
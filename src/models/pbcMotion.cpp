@@ -62,3 +62,16 @@ void PBCMotion::addPath(const PBCPathSP& pathSP) {
 PBCDPoint PBCMotion::motionEndPoint() const {
     return _motionEndPoint;
 }
+
+/**
+ * @brief Computes the content hash of the motion (endpoint and paths)
+ * @return the content hash
+ */
+PBCHash PBCMotion::contentHash() const {
+    return _contentHash.get(
+        [this]() {
+            PBCHash hash = PBCContentHash::number(_motionEndPoint.get<0>());
+            return PBCContentHash::number(_motionEndPoint.get<1>(), hash);
+        },
+        [this](PBCHash ownHash) { return combinePathHashes(ownHash); });
+}
@@ -58,6 +58,7 @@ friend class boost::serialization::access;
         ar >> y;
         _motionEndPoint.set<0>(x);
         _motionEndPoint.set<1>(y);
+        _contentHash.invalidate();
     }
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 
@@ -65,6 +66,7 @@ friend class boost::serialization::access;
     PBCMotion(const std::vector<PBCPathSP>& paths =  std::vector<PBCPathSP>());
     void addPath(const PBCPathSP& pathSP);
     PBCDPoint motionEndPoint() const;
+    PBCHash contentHash() const;
 };
 
 #endif  // PBCMOTION_H
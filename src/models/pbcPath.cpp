@@ -63,3 +63,18 @@ PBCPath::PBCPath(PBCDPoint endpoint, PBCDPoint controlPoint) :
 PBCPath::PBCPath(double endpointX, double endpointY, double controlX, double controlY) :
     _endpoint(PBCDPoint(endpointX, endpointY)),
     _bezierControlPoint(PBCDPoint(controlX, controlY)) {}
+
+/**
+ * @brief Computes the content hash of the path (endpoint and control point)
+ * @return the content hash
+ */
+PBCHash PBCPath::contentHash() const {
+    return _contentHash.get(
+        [this]() {
+            PBCHash hash = PBCContentHash::number(_endpoint.get<0>());
+            hash = PBCContentHash::number(_endpoint.get<1>(), hash);
+            hash = PBCContentHash::number(_bezierControlPoint.get<0>(), hash);
+            return PBCContentHash::number(_bezierControlPoint.get<1>(), hash);
+        },
+        [](PBCHash ownHash) { return ownHash; });
+}
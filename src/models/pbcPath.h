@@ -23,6 +23,7 @@
 #define PBCPATH_H
 
 #include "util/pbcDeclarations.h"
+#include "util/pbcContentHash.h"
 #include "pbcVersion.h"
 #include "pbcController.h"
 #include "models/pbcPlaybook.h"
@@ -39,6 +40,8 @@ friend class boost::serialization::access;
     bool _arc;
     bool _concave;
 
+    PBCHashCache _contentHash;
+
     template<class Archive>
     void save(Archive& ar, const unsigned int version) const {  // NOLINT
         ar << _endpoint.get<0>();
@@ -67,6 +70,7 @@ friend class boost::serialization::access;
         _endpoint.set<1>(y);
         _bezierControlPoint.set<0>(cx);
         _bezierControlPoint.set<1>(cy);
+        _contentHash.invalidate();
     }
     BOOST_SERIALIZATION_SPLIT_MEMBER()
     PBCPath() {}
@@ -80,6 +84,7 @@ friend class boost::serialization::access;
             double controlY = DUMMY_POINT.get<1>());
     PBCDPoint endpoint() const;
     PBCDPoint bezierControlPoint() const;
+    PBCHash contentHash() const;
 };
 BOOST_CLASS_VERSION(PBCPath, 2)
 
@@ -21,8 +21,10 @@
 
 #include "pbcPlay.h"
 #include <string>
+#include <algorithm>
 #include <set>
 #include <list>
+#include <vector>
 
 /**
  * @class PBCPlay
@@ -43,6 +45,7 @@ std::string PBCPlay::name() const {
  */
 void PBCPlay::setName(const std::string &name) {
     _name = name;
+    _contentHash.invalidate();
 }
 
 /**
@@ -59,6 +62,7 @@ std::string PBCPlay::codeName() const {
  */
 void PBCPlay::setCodeName(const std::string &codeName) {
     _codeName = codeName;
+    _contentHash.invalidate();
 }
 
 
@@ -76,6 +80,7 @@ PBCFormationSP PBCPlay::formation() const {
  */
 void PBCPlay::setFormation(const PBCFormationSP &formation) {
     _formation = formation;
+    _contentHash.invalidate();
 }
 
 
@@ -94,6 +99,7 @@ std::set<PBCCategorySP> PBCPlay::categories() const {
  */
 void PBCPlay::addCategory(const PBCCategorySP &category) {
     _categories.insert(category);
+    _contentHash.invalidate();
 }
 
 
@@ -103,6 +109,7 @@ void PBCPlay::addCategory(const PBCCategorySP &category) {
  */
 void PBCPlay::removeCategory(const PBCCategorySP &category) {
     _categories.erase(category);
+    _contentHash.invalidate();
 }
 
 
@@ -167,4 +174,34 @@ std::string PBCPlay::comment() const {
 
 void PBCPlay::setComment(const std::string &comment) {
     _comment = comment;
-}
\ No newline at end of file
+    _contentHash.invalidate();
+}
+
+/**
+ * @brief Computes the content hash of the play.
+ *
+ * The categories are included by their names only (in alphabetical order),
+ * because the categories refer back to their plays.
+ * @return the content hash
+ */
+PBCHash PBCPlay::contentHash() const {
+    return _contentHash.get(
+        [this]() {
+            PBCHash hash = PBCContentHash::string(_name);
+            hash = PBCContentHash::string(_codeName, hash);
+            return PBCContentHash::string(_comment, hash);
+        },
+        [this](PBCHash ownHash) {
+            PBCHash hash = PBCContentHash::combine(ownHash, _formation ? _formation->contentHash() : 0);
+            std::vector<std::string> categoryNames;
+            for (const PBCCategorySP& category : _categories) {
+                categoryNames.push_back(category->name());
+            }
+            std::sort(categoryNames.begin(), categoryNames.end());
+            hash = PBCContentHash::number(static_cast<uint64_t>(categoryNames.size()), hash);
+            for (const std::string& categoryName : categoryNames) {
+                hash = PBCContentHash::string(categoryName, hash);
+            }
+            return hash;
+        });
+}
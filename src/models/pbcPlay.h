@@ -48,6 +48,7 @@ friend class PBCCategory;
     PBCFormationSP _formation;
     std::set<PBCCategorySP> _categories;
     std::string _comment;
+    PBCHashCache _contentHash;
 
 private:
 
@@ -69,12 +70,14 @@ private:
         if (version >=1) {
             ar >> _comment;
         }
+        _contentHash.invalidate();
     }
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 
-    PBCPlay() {
-        PBCPlay("", "", "", "");
-    }
+    // only used by Boost Serialization, which sets all members afterwards, so
+    // it must not look up formations in the active playbook (plays are also
+    // loaded on worker threads, see PBCLoadJob)
+    PBCPlay() {}
 
  public:
     PBCPlay(const std::string& name,
@@ -94,6 +97,7 @@ private:
     void setComment(const std::string &comment);
     void addCategory(const PBCCategorySP &category);
     void removeCategory(const PBCCategorySP& category);
+    PBCHash contentHash() const;
 };
 BOOST_CLASS_VERSION(PBCPlay, 1)
 
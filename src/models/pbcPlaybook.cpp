@@ -20,14 +20,33 @@
 */
 
 #include "pbcPlaybook.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <list>
 #include <utility>
 #include <string>
 #include <vector>
 #include "util/pbcExceptions.h"
+#include "util/pbcPerf.h"
+#include "util/pbcStartupProfiler.h"
 #include "util/pbcStorage.h"
+#include "models/pbcUndoCommands.h"
 #include "models/pbcDefaultPlaybook.cpp"
 
+/**
+ * @brief Looks up an entry of one of the playbook's maps.
+ * @return The entry with the given name or NULL if it does not exist
+ */
+template<typename T>
+static T findOrNull(const PBCModelMap<T>& map, const std::string& name) {
+    const auto& it = map.find(name);
+    if (it == map.end()) {
+        return T();
+    }
+    return it->second;
+}
+
 /**
  * @class PBCPlaybook
  * @brief This is a data model class representing a playbook.
@@ -41,7 +60,7 @@
  * @brief The default constructor. It is only called by PBCSingleton and creates
  * a new empty playbook when the application is started.
  */
-PBCPlaybook::PBCPlaybook() {
+PBCPlaybook::PBCPlaybook() : _defaultsPending(false) {
     resetToNewEmptyPlaybook("new Playbook", 5);
 }
 
@@ -49,7 +68,8 @@ PBCPlaybook::PBCPlaybook() {
 /**
  * @brief Resets the playbook if the user wants to create a new one.
  *
- * Standard Routes (5 In, Post, Fly, Slant) and a Spread Right formation are inserted.
+ * Standard Routes (5 In, Post, Fly, Slant, ...) and a Spread Right formation
+ * are inserted when they are first used.
  * @param name The name of the new Playbook
  * @param playerNumber number of players on the field
  */
@@ -62,10 +82,59 @@ void PBCPlaybook::resetToNewEmptyPlaybook(const std::string &name,
     _routes.clear();
     _categories.clear();
     _plays.clear();
+    _history.clear();
+    _usages.clear();
+    _defaultsPending = true;
+    _contentHash.invalidate();
+}
 
+/**
+ * @brief Fills in the standard routes and formations of a new playbook from
+ * the constant tables in pbcDefaultPlaybook.cpp.
+ *
+ * This is deferred until the routes or formations are first used, so that the
+ * playbook which is created at startup (and usually replaced by an opened one
+ * right away) does not build them at all.
+ */
+void PBCPlaybook::materializeDefaults() const {
+    if (_defaultsPending.load(std::memory_order_acquire) == false) {
+        return;
+    }
+    // concurrent readers wait until the defaults are complete
+    std::lock_guard<std::mutex> lock(_defaultsMutex);
+    if (_defaultsPending.load(std::memory_order_relaxed) == false) {
+        return;
+    }
+    PBC_PERF_SCOPE("model.defaults");
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
     default_routes(_routes);
-
     default_formations(_formations, _playerNumber);
+    _defaultsPending.store(false, std::memory_order_release);
+    PBCStartupProfiler::measured("model defaults", std::chrono::steady_clock::now() - start);
+}
+
+/**
+ * @brief Exchanges the content of two playbooks, e.g. to replace the active
+ * playbook by one that has been loaded completely in the background. The
+ * history of both playbooks is cleared, as it is when a playbook is loaded.
+ * @param other The other playbook
+ */
+void PBCPlaybook::swap(PBCPlaybook &other) {
+    std::swap(_builtWithPBCVersion, other._builtWithPBCVersion);
+    std::swap(_name, other._name);
+    std::swap(_formations, other._formations);
+    std::swap(_routes, other._routes);
+    std::swap(_categories, other._categories);
+    std::swap(_plays, other._plays);
+    std::swap(_playerNumber, other._playerNumber);
+    std::swap(_usages, other._usages);
+    bool defaultsPending = _defaultsPending;
+    _defaultsPending = other._defaultsPending.load();
+    other._defaultsPending = defaultsPending;
+    _history.clear();
+    other._history.clear();
+    _contentHash.invalidate();
+    other._contentHash.invalidate();
 }
 
 /**
@@ -73,7 +142,9 @@ void PBCPlaybook::resetToNewEmptyPlaybook(const std::string &name,
  * previously).
  */
 void PBCPlaybook::reloadDefaultFormations() {
+    materializeDefaults();
     default_formations(_formations, _playerNumber);
+    _contentHash.invalidate();
 }
 
 /**
@@ -88,9 +159,16 @@ void PBCPlaybook::reloadDefaultFormations() {
  * @return true if the formation has been successfully added to the playbook
  */
 bool PBCPlaybook::addFormation(PBCFormationSP formation, bool overwrite, bool disable_autosave) {
+    PBC_PERF_SCOPE("model.addFormation");
+    materializeDefaults();
     if (overwrite == true) {
         PBCFormationSP formationCopy(new PBCFormation(*formation));
+        PBCFormationSP before = findOrNull(_formations, formationCopy->name());
         _formations[formationCopy->name()] = formationCopy;
+        PBCPlaybookEditCommandSP command(new PBCPlaybookEditCommand(this, "Save Formation"));
+        command->formationChanged(formationCopy->name(), before, formationCopy);
+        _history.push(command);
+        _contentHash.invalidate();
         PBCStorage::getInstance()->automaticSavePlaybook();
         return true;
     } else {
@@ -98,6 +176,12 @@ bool PBCPlaybook::addFormation(PBCFormationSP formation, bool overwrite, bool di
         InsertResult<PBCFormationSP> result =
                 _formations.insert(std::make_pair(formation->name(),
                                                   formationCopy));
+        if (result.second == true) {
+            PBCPlaybookEditCommandSP command(new PBCPlaybookEditCommand(this, "Add Formation"));
+            command->formationChanged(formation->name(), PBCFormationSP(), formationCopy);
+            _history.push(command);
+            _contentHash.invalidate();
+        }
         if (result.second == true && disable_autosave == false) {
             PBCStorage::getInstance()->automaticSavePlaybook();
         }
@@ -122,14 +206,33 @@ bool PBCPlaybook::addFormation(PBCFormationSP formation, bool overwrite, bool di
  * @return true if the route has been successfully added to the playbook
  */
 bool PBCPlaybook::addRoute(PBCRouteSP route, bool overwrite, bool disable_autosave) {
+    PBC_PERF_SCOPE("model.addRoute");
+    materializeDefaults();
     if (overwrite == true) {
-        *_routes[route->name()] = *route;  // TODO(obr): does this create memory leaks?  //NOLINT
-        //_routes[route->name()] = route;  //--> Routes in Plays are not changed when you overwrite them // NOLINT
+        PBCPlaybookEditCommandSP command(new PBCPlaybookEditCommand(this, "Save Route"));
+        PBCRouteSP existingRoute = findOrNull(_routes, route->name());
+        if (existingRoute != NULL) {
+            PBCRoute before(*existingRoute);
+            *existingRoute = *route;
+            //_routes[route->name()] = route;  //--> Routes in Plays are not changed when you overwrite them // NOLINT
+            command->routeOverwritten(existingRoute, before);
+        } else {
+            _routes[route->name()] = route;
+            command->routeChanged(route->name(), PBCRouteSP(), route);
+        }
+        _history.push(command);
+        _contentHash.invalidate();
         PBCStorage::getInstance()->automaticSavePlaybook();
         return true;
     } else {
         InsertResult<PBCRouteSP> result =
                 _routes.insert(std::make_pair(route->name(), route));
+        if (result.second == true) {
+            PBCPlaybookEditCommandSP command(new PBCPlaybookEditCommand(this, "Add Route"));
+            command->routeChanged(route->name(), PBCRouteSP(), route);
+            _history.push(command);
+            _contentHash.invalidate();
+        }
         if (result.second == true && disable_autosave == false) {
             PBCStorage::getInstance()->automaticSavePlaybook();
         }
@@ -149,13 +252,24 @@ bool PBCPlaybook::addRoute(PBCRouteSP route, bool overwrite, bool disable_autosa
  * @return true if the category has been successfully added to the playbook
  */
 bool PBCPlaybook::addCategory(PBCCategorySP category, bool overwrite, bool disable_autosave) {
+    PBC_PERF_SCOPE("model.addCategory");
     if (overwrite == true) {
+        PBCPlaybookEditCommandSP command(new PBCPlaybookEditCommand(this, "Save Category"));
+        command->categoryChanged(category->name(), findOrNull(_categories, category->name()), category);
         _categories[category->name()] = category;
+        _history.push(command);
+        _contentHash.invalidate();
         PBCStorage::getInstance()->automaticSavePlaybook();
         return true;
     } else {
         InsertResult<PBCCategorySP> result =
                 _categories.insert(std::make_pair(category->name(), category));
+        if (result.second == true) {
+            PBCPlaybookEditCommandSP command(new PBCPlaybookEditCommand(this, "Add Category"));
+            command->categoryChanged(category->name(), PBCCategorySP(), category);
+            _history.push(command);
+            _contentHash.invalidate();
+        }
         if (result.second == true && disable_autosave == false) {
             PBCStorage::getInstance()->automaticSavePlaybook();
         }
@@ -175,13 +289,27 @@ bool PBCPlaybook::addCategory(PBCCategorySP category, bool overwrite, bool disab
  * @return true if the play has been successfully added to the playbook
  */
 bool PBCPlaybook::addPlay(PBCPlaySP play, bool overwrite, bool disable_autosave) {
+    PBC_PERF_SCOPE("model.addPlay");
     if (overwrite == true) {
+        PBCPlaybookEditCommandSP command(new PBCPlaybookEditCommand(this, "Save Play"));
+        PBCPlaySP before = findOrNull(_plays, play->name());
+        command->playChanged(play->name(), before, play);
         _plays[play->name()] = play;
+        _usages.replacePlay(before, play);
+        _history.push(command);
+        _contentHash.invalidate();
         PBCStorage::getInstance()->automaticSavePlaybook();
         return true;
     } else {
         InsertResult<PBCPlaySP> result =
                 _plays.insert(std::make_pair(play->name(), play));
+        if (result.second == true) {
+            PBCPlaybookEditCommandSP command(new PBCPlaybookEditCommand(this, "Add Play"));
+            command->playChanged(play->name(), PBCPlaySP(), play);
+            _usages.addPlay(play);
+            _history.push(command);
+            _contentHash.invalidate();
+        }
         if (result.second == true && disable_autosave == false) {
             PBCStorage::getInstance()->automaticSavePlaybook();
         }
@@ -191,26 +319,55 @@ bool PBCPlaybook::addPlay(PBCPlaySP play, bool overwrite, bool disable_autosave)
 
 
 void PBCPlaybook::deleteFormation(const std::string &name) {
+    materializeDefaults();
+    PBCPlaybookEditCommandSP command(new PBCPlaybookEditCommand(this, "Delete Formation"));
+    command->formationChanged(name, findOrNull(_formations, name), PBCFormationSP());
     _formations.erase(name);
+    _history.push(command);
+    _contentHash.invalidate();
     PBCStorage::getInstance()->automaticSavePlaybook();
 }
 
 void PBCPlaybook::deleteRoute(const std::string &name) {
+    materializeDefaults();
+    PBCPlaybookEditCommandSP command(new PBCPlaybookEditCommand(this, "Delete Route"));
+    command->routeChanged(name, findOrNull(_routes, name), PBCRouteSP());
     _routes.erase(name);
+    _history.push(command);
+    _contentHash.invalidate();
     PBCStorage::getInstance()->automaticSavePlaybook();
 }
 
 void PBCPlaybook::deletePlay(const std::string &name) {
+    PBCPlaybookEditCommandSP command(new PBCPlaybookEditCommand(this, "Delete Play"));
+    PBCPlaySP play = findOrNull(_plays, name);
+    command->playChanged(name, play, PBCPlaySP());
     _plays.erase(name);
+    if (play != NULL) {
+        _usages.removePlay(play);
+        for (auto& category : play->categories()) {
+            category->removePlay(play);
+            play->removeCategory(category);
+            command->categoryLinkChanged(play, category, false);
+        }
+    }
+    _history.push(command);
+    _contentHash.invalidate();
     PBCStorage::getInstance()->automaticSavePlaybook();
 }
 
 void PBCPlaybook::deleteCategory(const std::string &name) {
     PBCCategorySP category = getCategory(name);
+    PBCPlaybookEditCommandSP command(new PBCPlaybookEditCommand(this, "Delete Category"));
     for (auto& play : category->plays()) {
         play->removeCategory(category);
+        category->removePlay(play);
+        command->categoryLinkChanged(play, category, false);
     }
+    command->categoryChanged(name, category, PBCCategorySP());
     _categories.erase(name);
+    _history.push(command);
+    _contentHash.invalidate();
     PBCStorage::getInstance()->automaticSavePlaybook();
 }
 
@@ -229,6 +386,7 @@ std::string PBCPlaybook::builtWithPBCVersion() {
  */
 void PBCPlaybook::setName(const std::string &name) {
     _name = name;
+    _contentHash.invalidate();
 }
 
 /**
@@ -244,6 +402,7 @@ std::string PBCPlaybook::name() const {
  * @return A list of the playbook's formations
  */
 std::list<PBCFormationSP> PBCPlaybook::formations() const {
+    materializeDefaults();
     return mapToList<PBCFormationSP>(_formations);
 }
 
@@ -252,6 +411,7 @@ std::list<PBCFormationSP> PBCPlaybook::formations() const {
  * @return A list of the playbook's routes
  */
 std::list<PBCRouteSP> PBCPlaybook::routes() const {
+    materializeDefaults();
     return mapToList<PBCRouteSP>(_routes);
 }
 
@@ -277,6 +437,7 @@ std::list<PBCPlaySP> PBCPlaybook::plays() const {
  * @return true if the formation exists, else otherwise
  */
 bool PBCPlaybook::hasFormation(const std::string &name) {
+    materializeDefaults();
     if (_formations.count(name) == 0) {
         return false;
     } else {
@@ -284,6 +445,15 @@ bool PBCPlaybook::hasFormation(const std::string &name) {
     }
 }
 
+/**
+ * @brief Checks if a play exists in the playbook.
+ * @param name The name of the play
+ * @return true if the play exists, else otherwise
+ */
+bool PBCPlaybook::hasPlay(const std::string &name) const {
+    return _plays.count(name) > 0;
+}
+
 /**
  * @brief Selects a formation by name. The formation must exist
  * in the playbook.
@@ -291,6 +461,7 @@ bool PBCPlaybook::hasFormation(const std::string &name) {
  * @return The formation with the given name
  */
 PBCFormationSP PBCPlaybook::getFormation(const std::string &name) {
+    materializeDefaults();
     const auto &it = _formations.find(name);
     pbcAssert(it != _formations.end());
     return PBCFormationSP(new PBCFormation(*it->second));
@@ -315,6 +486,7 @@ PBCPlaySP PBCPlaybook::getPlay(const std::string &name) {
  * @return The route with the given name.
  */
 PBCRouteSP PBCPlaybook::getRoute(const std::string &name) {
+    materializeDefaults();
     const auto &it = _routes.find(name);
     pbcAssert(it != _routes.end());
     return it->second;
@@ -337,6 +509,7 @@ PBCCategorySP PBCPlaybook::getCategory(const std::string &name) {
  * @return a list of formation names
  */
 std::vector<std::string> PBCPlaybook::getFormationNames() const {
+    materializeDefaults();
     std::vector<std::string> formationNames;
     for (const auto &kv : _formations) {
         PBCFormationSP formation = kv.second;
@@ -362,6 +535,7 @@ std::vector<std::string> PBCPlaybook::getPlayNames() const {
  * @return a list of route names
  */
 std::vector<std::string> PBCPlaybook::getRouteNames() const {
+    materializeDefaults();
     std::vector<std::string> routeNames;
     for (const auto &kv : _routes) {
         PBCRouteSP route = kv.second;
@@ -387,3 +561,259 @@ std::vector<std::string> PBCPlaybook::getCategoryNames() const {
 unsigned int PBCPlaybook::numberOfPlayers() const {
     return _playerNumber;
 }
+
+/**
+ * @brief The undo/redo history of this playbook. It is cleared whenever the
+ * playbook is reset or loaded from a file.
+ * @return The playbook's history
+ */
+PBCUndoStack& PBCPlaybook::history() {
+    return _history;
+}
+
+/**
+ * @brief Combines the given hash with the names and content hashes of all
+ * entries of one of the playbook's maps (in the order of their names)
+ */
+template<typename T>
+static PBCHash combineMapHashes(PBCHash seed, const PBCModelMap<T>& map) {
+    PBCHash hash = PBCContentHash::number(static_cast<uint64_t>(map.size()), seed);
+    for (const auto& kv : map) {
+        hash = PBCContentHash::string(kv.first, hash);
+        hash = PBCContentHash::combine(hash, kv.second->contentHash());
+    }
+    return hash;
+}
+
+/**
+ * @brief Computes the content hash of the playbook.
+ *
+ * The hash covers everything that is stored in the playbook file except the
+ * version of the application, so two playbooks with equal hashes result in
+ * equal files. After an edit, only the changed objects rehash their fields.
+ * @return the content hash
+ */
+PBCHash PBCPlaybook::contentHash() const {
+    materializeDefaults();
+    return _contentHash.get(
+        [this]() {
+            PBCHash hash = PBCContentHash::string(_name);
+            return PBCContentHash::number(static_cast<uint64_t>(_playerNumber), hash);
+        },
+        [this](PBCHash ownHash) {
+            PBCHash hash = combineMapHashes(ownHash, _formations);
+            hash = combineMapHashes(hash, _routes);
+            hash = combineMapHashes(hash, _categories);
+            return combineMapHashes(hash, _plays);
+        });
+}
+
+/**
+ * @brief Indexes all plays of the playbook again, e.g. after loading it
+ */
+void PBCPlaybook::rebuildUsageIndex() {
+    _usages.clear();
+    for (const auto& kv : _plays) {
+        _usages.addPlay(kv.second);
+    }
+}
+
+/**
+ * @brief Gets all players (and their plays) that use a route as route,
+ * alternative route or option route.
+ *
+ * The route does not need to be in the playbook anymore, e.g. after it has
+ * been deleted.
+ * @param routeName The name of the route
+ * @return the references to the route
+ */
+std::vector<PBCRouteUsage> PBCPlaybook::routeUsages(const std::string &routeName) const {
+    materializeDefaults();
+    PBCRouteSP route = findOrNull(_routes, routeName);
+    if (route == NULL) {
+        return std::vector<PBCRouteUsage>();
+    }
+    return _usages.routeUsages(route);
+}
+
+/**
+ * @brief Gets the plays that would be affected by overwriting or deleting a
+ * route
+ * @param routeName The name of the route
+ * @return the plays in which the route is used
+ */
+std::set<PBCPlaySP> PBCPlaybook::playsUsingRoute(const std::string &routeName) const {
+    materializeDefaults();
+    PBCRouteSP route = findOrNull(_routes, routeName);
+    if (route == NULL) {
+        return std::set<PBCPlaySP>();
+    }
+    return _usages.playsUsingRoute(route);
+}
+
+/**
+ * @brief Gets the plays that have been created from a formation
+ * @param formationName The name of the formation
+ * @return the plays
+ */
+std::set<PBCPlaySP> PBCPlaybook::playsUsingFormation(const std::string &formationName) const {
+    return _usages.playsUsingFormation(formationName);
+}
+
+/**
+ * @brief Gets the plays of a category. Categories keep track of their plays
+ * themselves, so no additional index is needed.
+ * @param categoryName The name of the category
+ * @return the plays
+ */
+std::set<PBCPlaySP> PBCPlaybook::playsInCategory(const std::string &categoryName) const {
+    PBCCategorySP category = findOrNull(_categories, categoryName);
+    if (category == NULL) {
+        return std::set<PBCPlaySP>();
+    }
+    return category->plays();
+}
+
+/**
+ * @brief Updates the usage index after a play of the playbook has been changed
+ * in place (e.g. a player's route). Plays that are not part of the playbook
+ * (e.g. working copies) are ignored.
+ * @param play The changed play
+ */
+void PBCPlaybook::updateUsages(const PBCPlaySP &play) {
+    _usages.updatePlay(play);
+}
+
+/**
+ * @brief Checks whether nothing has been selected
+ * @return true if the selection cannot match any play
+ */
+bool PBCPlaySelection::empty() const {
+    return plays.empty() && categories.empty() && terms.empty();
+}
+
+static std::string lowerCase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    return text;
+}
+
+/**
+ * @brief Checks whether a play is selected by its name, one of its categories
+ * or one of the search terms
+ * @param play The play
+ * @return true if the play is selected
+ */
+bool PBCPlaySelection::matches(const PBCPlay &play) const {
+    if (plays.count(play.name()) > 0) {
+        return true;
+    }
+    for (const PBCCategorySP& category : play.categories()) {
+        if (categories.count(category->name()) > 0) {
+            return true;
+        }
+    }
+    if (terms.empty()) {
+        return false;
+    }
+    const std::string text = lowerCase(play.name() + "\n" + play.codeName() + "\n" + play.comment());
+    for (const std::string& term : terms) {
+        if (term.empty() == false && text.find(lowerCase(term)) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void insertRoutesOf(const PBCPlaySP& play, std::set<PBCRouteSP>& routes) {  // NOLINT
+    for (const PBCPlayerSP& player : *play->formation()) {
+        routes.insert(player->route());
+        routes.insert(player->alternativeRoute(1));
+        routes.insert(player->alternativeRoute(2));
+        for (const PBCRouteSP& route : player->optionRoutes()) {
+            routes.insert(route);
+        }
+    }
+}
+
+/**
+ * @brief Creates a playbook that contains only the selected plays and what
+ * they reference: their formations, the routes of the route library that
+ * their players use and their categories (with only the selected plays).
+ *
+ * The plays are shallow copies that share their routes and motions with this
+ * playbook, so routes which are shared between plays stay shared when the
+ * result is serialized. Neither this playbook nor its objects are changed,
+ * so the result must not be edited but only be written to a file.
+ * @param selection The selected plays
+ * @param name The name of the new playbook
+ * @return the new playbook
+ */
+PBCPlaybookSP PBCPlaybook::extract(const PBCPlaySelection &selection, const std::string &name) const {
+    PBC_PERF_SCOPE("model.extract");
+    materializeDefaults();
+    PBCPlaybookSP result(new PBCPlaybook());
+    result->resetToNewEmptyPlaybook(name, _playerNumber);
+    result->_defaultsPending = false;
+
+    for (const std::string& categoryName : selection.categories) {
+        if (_categories.count(categoryName) > 0) {
+            result->_categories[categoryName].reset(new PBCCategory(categoryName));
+        }
+    }
+
+    std::set<PBCRouteSP> routes;
+    for (const auto& kv : _plays) {
+        const PBCPlaySP& play = kv.second;
+        if (selection.matches(*play) == false) {
+            continue;
+        }
+        PBCPlaySP copy(new PBCPlay(*play));
+        for (const PBCCategorySP& category : play->categories()) {
+            copy->removeCategory(category);
+            if (findOrNull(_categories, category->name()) != category) {
+                continue;  // a link to a deleted category
+            }
+            PBCCategorySP& target = result->_categories[category->name()];
+            if (target == NULL) {
+                target.reset(new PBCCategory(category->name()));
+            }
+            copy->addCategory(target);
+            target->addPlay(copy);
+        }
+        result->_plays[kv.first] = copy;
+
+        PBCFormationSP formation = findOrNull(_formations, play->formation()->name());
+        if (formation != NULL) {
+            result->_formations[formation->name()] = formation;
+        }
+        insertRoutesOf(play, routes);
+    }
+
+    for (const auto& kv : _routes) {
+        if (routes.count(kv.second) > 0) {
+            result->_routes.insert(kv);
+        }
+    }
+    result->rebuildUsageIndex();
+    return result;
+}
+
+/**
+ * @brief Checks whether a route is one of the standard routes of a new
+ * playbook
+ * @param name The name of the route
+ * @return true if it is a standard route
+ */
+bool PBCPlaybook::isDefaultRoute(const std::string &name) {
+    return is_default_route(name);
+}
+
+/**
+ * @brief Checks whether a formation is the standard formation of a new
+ * playbook
+ * @param name The name of the formation
+ * @return true if it is the standard formation
+ */
+bool PBCPlaybook::isDefaultFormation(const std::string &name) {
+    return is_default_formation(name);
+}
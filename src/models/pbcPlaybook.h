@@ -25,6 +25,11 @@
 #include "util/pbcSingleton.h"
 #include "util/pbcDeclarations.h"
 #include "models/pbcCategory.h"
+#include "util/pbcUndoStack.h"
+#include "util/pbcContentHash.h"
+#include "models/pbcUsageIndex.h"
+#include <atomic>
+#include <mutex>
 #include <ostream>
 #include <boost/serialization/map.hpp>
 #include <boost/serialization/access.hpp>
@@ -32,6 +37,7 @@
 #include <vector>
 #include <string>
 #include <list>
+#include <set>
 
 class PBCFormation;
 typedef boost::shared_ptr<PBCFormation> PBCFormationSP;
@@ -40,19 +46,47 @@ typedef boost::shared_ptr<PBCRoute> PBCRouteSP;
 class PBCPlaybook;
 typedef boost::shared_ptr<PBCPlaybook> PBCPlaybookSP;
 
+/**
+ * @brief Selects plays of a playbook, e.g. for handing out a part of it.
+ * A play is selected if any of the criteria matches.
+ */
+struct PBCPlaySelection {
+    std::set<std::string> plays;
+    std::set<std::string> categories;  // selects all plays of these categories
+    // selects the plays whose name, code name or comment contains one of the terms (ignoring case)
+    std::vector<std::string> terms;
+
+    bool empty() const;
+    bool matches(const PBCPlay& play) const;
+};
+
 class PBCPlaybook {
 friend class boost::serialization::access;
+friend class PBCPlaybookEditCommand;
+friend class PBCPlaybookMerge;
+friend class PBCPlaybookCompaction;
  private:
     std::string _builtWithPBCVersion;
     std::string _name;
-    PBCModelMap<PBCFormationSP> _formations;
-    PBCModelMap<PBCRouteSP> _routes;
+    // mutable, because the default formations and routes are filled in lazily
+    // (guarded by _defaultsMutex, see materializeDefaults())
+    mutable PBCModelMap<PBCFormationSP> _formations;
+    mutable PBCModelMap<PBCRouteSP> _routes;
     PBCModelMap<PBCCategorySP> _categories;
     PBCModelMap<PBCPlaySP> _plays;
     unsigned int _playerNumber;
+    PBCUndoStack _history;
+    PBCHashCache _contentHash;
+    PBCUsageIndex _usages;
+    mutable std::atomic<bool> _defaultsPending;
+    mutable std::mutex _defaultsMutex;
+
+    void rebuildUsageIndex();
+    void materializeDefaults() const;
 
     template<class Archive>
     void save(Archive& ar, const unsigned int version) const {  // NOLINT
+        materializeDefaults();
         ar << _builtWithPBCVersion;
         ar << _name;
         ar << _playerNumber;
@@ -73,6 +107,10 @@ friend class boost::serialization::access;
         ar >> _routes;
         ar >> _plays;
         ar >> _categories;
+        _defaultsPending = false;
+        _history.clear();
+        _contentHash.invalidate();
+        rebuildUsageIndex();
     }
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 
@@ -82,6 +120,7 @@ friend class boost::serialization::access;
     void resetToNewEmptyPlaybook(const std::string& name,
                                  const unsigned int playerNumber);
     void reloadDefaultFormations();
+    void swap(PBCPlaybook& other);  // NOLINT
     void setName(const std::string& name);
     bool addFormation(PBCFormationSP formation, bool overwrite = false, bool disable_autosave = false);
     bool addRoute(PBCRouteSP route, bool overwrite = false, bool disable_autosave = false);
@@ -98,6 +137,7 @@ friend class boost::serialization::access;
     std::list<PBCCategorySP> categories() const;
     std::list<PBCPlaySP> plays() const;
     bool hasFormation(const std::string& name);
+    bool hasPlay(const std::string& name) const;
     PBCFormationSP getFormation(const std::string& name);
     PBCPlaySP getPlay(const std::string& name);
     PBCRouteSP getRoute(const std::string& name);
@@ -107,6 +147,16 @@ friend class boost::serialization::access;
     std::vector<std::string> getPlayNames() const;
     std::vector<std::string> getCategoryNames() const;
     unsigned int numberOfPlayers() const;
+    PBCUndoStack& history();
+    PBCHash contentHash() const;
+    std::vector<PBCRouteUsage> routeUsages(const std::string& routeName) const;
+    std::set<PBCPlaySP> playsUsingRoute(const std::string& routeName) const;
+    std::set<PBCPlaySP> playsUsingFormation(const std::string& formationName) const;
+    std::set<PBCPlaySP> playsInCategory(const std::string& categoryName) const;
+    void updateUsages(const PBCPlaySP& play);
+    PBCPlaybookSP extract(const PBCPlaySelection& selection, const std::string& name) const;
+    static bool isDefaultRoute(const std::string& name);
+    static bool isDefaultFormation(const std::string& name);
 };
 BOOST_CLASS_VERSION(PBCPlaybook, 1)
 
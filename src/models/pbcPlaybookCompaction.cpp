@@ -0,0 +1,222 @@
+/** @file pbcPlaybookCompaction.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcPlaybookCompaction.h"
+#include "models/pbcPlay.h"
+#include "models/pbcPlayer.h"
+#include "models/pbcMotion.h"
+#include "models/pbcRoute.h"
+#include "models/pbcFormation.h"
+#include "models/pbcCategory.h"
+#include "models/pbcUndoCommands.h"
+#include "util/pbcPerf.h"
+#include "util/pbcStorage.h"
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <sstream>
+#include <string>
+
+static const unsigned int LOAD_RUNS = 3;
+
+/**
+ * @brief Checks whether the compaction has found anything to remove or repair
+ * @return true if the playbook is already compact
+ */
+bool PBCCompactionReport::empty() const {
+    return routes.empty() && formations.empty() && categoryLinks.empty() && emptyMotions == 0;
+}
+
+/**
+ * @brief Collects the objects that are part of one of the playbook's maps
+ */
+template<typename T>
+static std::set<T> entries(const PBCModelMap<T>& map) {
+    std::set<T> result;
+    for (const auto& kv : map) {
+        result.insert(kv.second);
+    }
+    return result;
+}
+
+/**
+ * @brief Finds the unreachable objects of a playbook and reports them
+ * (apply == false) or removes them (apply == true).
+ *
+ * Applying the compaction is a single undo step and saves the playbook once.
+ * Undoing a repaired link removes it from both sides, so the history never
+ * restores a half-recorded link.
+ * @param playbook The playbook to compact
+ * @param apply Whether the playbook should be changed
+ * @param keepDefaults Whether unused routes and formations that are part of
+ * every new playbook should be kept
+ * @return the report
+ */
+PBCCompactionReport PBCPlaybookCompaction::compact(PBCPlaybook &playbook, bool apply, bool keepDefaults) {
+    PBC_PERF_SCOPE("model.compact");
+    PBCCompactionReport report;
+    report.staleCategoryPlays = 0;
+    report.emptyMotions = 0;
+    report.applied = apply;
+
+    const std::string before = serialize(playbook);
+    report.bytesBefore = before.size();
+    report.loadMicrosBefore = measureLoad(before);
+
+    std::string after;
+    if (apply) {
+        {
+            PBCUndoMacroScope macro(playbook._history, "Compact Playbook");
+            sweep(playbook, keepDefaults, report);
+        }
+        after = serialize(playbook);
+        if (report.empty() == false) {
+            PBCStorage::getInstance()->automaticSavePlaybook();
+        }
+    } else {
+        PBCPlaybook copy;
+        std::istringstream istream(before);
+        boost::archive::text_iarchive archive(istream);
+        archive >> copy;
+        sweep(copy, keepDefaults, report);
+        after = serialize(copy);
+    }
+    report.bytesAfter = after.size();
+    report.loadMicrosAfter = measureLoad(after);
+    return report;
+}
+
+void PBCPlaybookCompaction::sweep(PBCPlaybook &playbook, bool keepDefaults, PBCCompactionReport &report) {
+    playbook.materializeDefaults();
+    PBCPlaybookEditCommandSP command(new PBCPlaybookEditCommand(&playbook, "Compact Playbook"));
+
+    const std::set<PBCPlaySP> plays = entries(playbook._plays);
+    const std::set<PBCCategorySP> categories = entries(playbook._categories);
+
+    // links from the categories' side, e.g. to plays that have been deleted
+    std::set<PBCPlaySP> stalePlays;
+    for (const auto& kv : playbook._categories) {
+        const PBCCategorySP& category = kv.second;
+        for (const PBCPlaySP& play : category->plays()) {
+            if (plays.count(play) == 0) {
+                category->removePlay(play);
+                play->removeCategory(category);
+                command->categoryLinkChanged(play, category, false);
+                report.categoryLinks.push_back(PBCStaleCategoryLink{kv.first, play->name(), false});
+                stalePlays.insert(play);
+            } else if (play->categories().count(category) == 0) {
+                play->addCategory(category);
+                command->categoryLinkChanged(play, category, true);
+                report.categoryLinks.push_back(PBCStaleCategoryLink{kv.first, play->name(), true});
+            }
+        }
+    }
+    report.staleCategoryPlays = stalePlays.size();
+
+    // links from the plays' side, e.g. to categories that have been deleted
+    for (const auto& kv : playbook._plays) {
+        const PBCPlaySP& play = kv.second;
+        for (const PBCCategorySP& category : play->categories()) {
+            if (categories.count(category) == 0) {
+                play->removeCategory(category);
+                category->removePlay(play);
+                command->categoryLinkChanged(play, category, false);
+                report.categoryLinks.push_back(PBCStaleCategoryLink{category->name(), kv.first, false});
+            } else if (category->plays().count(play) == 0) {
+                category->addPlay(play);
+                command->categoryLinkChanged(play, category, true);
+                report.categoryLinks.push_back(PBCStaleCategoryLink{category->name(), kv.first, true});
+            }
+        }
+    }
+
+    // motions without paths are left behind by "Delete Motion" and look like no motion at all
+    for (const auto& kv : playbook._plays) {
+        for (const PBCPlayerSP& player : *kv.second->formation()) {
+            PBCMotionSP motion = player->motion();
+            if (motion != NULL && motion->paths().empty()) {
+                PBCPlayer before(*player);
+                player->setMotion(PBCMotionSP());
+                playbook._history.push(PBCUndoCommandSP(
+                    new PBCPlayerEditCommand("Compact Playbook", kv.second, player, before)));
+                ++report.emptyMotions;
+            }
+        }
+    }
+
+    // the libraries are only reachable through the usage index of the plays
+    for (auto it = playbook._routes.begin(); it != playbook._routes.end();) {
+        if (playbook._usages.playsUsingRoute(it->second).empty() &&
+            (keepDefaults == false || PBCPlaybook::isDefaultRoute(it->first) == false)) {
+            report.routes.push_back(it->first);
+            command->routeChanged(it->first, it->second, PBCRouteSP());
+            it = playbook._routes.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = playbook._formations.begin(); it != playbook._formations.end();) {
+        if (playbook._usages.playsUsingFormation(it->first).empty() &&
+            (keepDefaults == false || PBCPlaybook::isDefaultFormation(it->first) == false)) {
+            report.formations.push_back(it->first);
+            command->formationChanged(it->first, it->second, PBCFormationSP());
+            it = playbook._formations.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (command->empty() == false) {
+        playbook._history.push(command);
+    }
+    playbook._contentHash.invalidate();
+}
+
+std::string PBCPlaybookCompaction::serialize(const PBCPlaybook &playbook) {
+    std::ostringstream ostream;
+    {
+        boost::archive::text_oarchive archive(ostream);
+        archive << playbook;
+    }
+    return ostream.str();
+}
+
+/**
+ * @brief Measures how long it takes to load a serialized playbook
+ * @param serializedPlaybook The serialized playbook
+ * @return the fastest of a few loads in microseconds
+ */
+uint64_t PBCPlaybookCompaction::measureLoad(const std::string &serializedPlaybook) {
+    uint64_t fastest = UINT64_MAX;
+    for (unsigned int i = 0; i < LOAD_RUNS; ++i) {
+        PBCPlaybook playbook;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::istringstream istream(serializedPlaybook);
+        boost::archive::text_iarchive archive(istream);
+        archive >> playbook;
+        uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        fastest = std::min(fastest, micros);
+    }
+    return fastest;
+}
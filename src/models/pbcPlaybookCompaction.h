@@ -0,0 +1,80 @@
+/** @file pbcPlaybookCompaction.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCPLAYBOOKCOMPACTION_H
+#define PBCPLAYBOOKCOMPACTION_H
+
+#include "models/pbcPlaybook.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A link between a category and a play that is recorded on one side
+ * only or that leads to an object which is not part of the playbook anymore
+ */
+struct PBCStaleCategoryLink {
+    std::string category;
+    std::string play;
+    bool repaired;  // both objects are part of the playbook, so the missing side is added
+};
+
+/**
+ * @brief The result of a compaction: what is (or would be) removed and what
+ * the playbook costs before and after
+ */
+struct PBCCompactionReport {
+    std::vector<std::string> routes;
+    std::vector<std::string> formations;
+    std::vector<PBCStaleCategoryLink> categoryLinks;
+    unsigned int staleCategoryPlays;  // plays that are only kept alive by a category
+    unsigned int emptyMotions;
+    size_t bytesBefore;
+    size_t bytesAfter;
+    uint64_t loadMicrosBefore;
+    uint64_t loadMicrosAfter;
+    bool applied;
+
+    bool empty() const;
+};
+
+/**
+ * @class PBCPlaybookCompaction
+ * @brief Removes the objects of a playbook that cannot be reached from any of
+ * its plays.
+ *
+ * The plays are the roots. Routes of the route library that are not used by
+ * any player, formations that no play has been created from, links between
+ * categories and plays that are not recorded on both sides or lead to deleted
+ * objects, and motions without paths are unreachable. A dry run compacts a
+ * copy of the playbook, so the reported sizes are exact.
+ */
+class PBCPlaybookCompaction {
+ public:
+    static PBCCompactionReport compact(PBCPlaybook& playbook, bool apply, bool keepDefaults = true);  // NOLINT
+
+ private:
+    static void sweep(PBCPlaybook& playbook, bool keepDefaults, PBCCompactionReport& report);  // NOLINT
+    static std::string serialize(const PBCPlaybook& playbook);
+    static uint64_t measureLoad(const std::string& serializedPlaybook);
+};
+
+#endif  // PBCPLAYBOOKCOMPACTION_H
@@ -0,0 +1,287 @@
+/** @file pbcPlaybookMerge.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcPlaybookMerge.h"
+#include "models/pbcPlay.h"
+#include "models/pbcPlayer.h"
+#include "models/pbcMotion.h"
+#include "models/pbcRoute.h"
+#include "models/pbcFormation.h"
+#include "models/pbcCategory.h"
+#include "util/pbcExceptions.h"
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+template<typename T>
+static T findOrNull(const PBCModelMap<T>& map, const std::string& name) {
+    const auto& it = map.find(name);
+    if (it == map.end()) {
+        return T();
+    }
+    return it->second;
+}
+
+/**
+ * @brief Compares two versions of an entry by their content hashes
+ * @return true if both are missing or both have the same content
+ */
+template<typename T>
+static bool sameContent(const T& first, const T& second) {
+    if (first == NULL || second == NULL) {
+        return first == second;
+    }
+    return first == second || first->contentHash() == second->contentHash();
+}
+
+template<typename T>
+static PBCDiffEntry::Change changeOf(const T& from, const T& to) {
+    if (from == NULL) {
+        return to == NULL ? PBCDiffEntry::UNCHANGED : PBCDiffEntry::ADDED;
+    }
+    if (to == NULL) {
+        return PBCDiffEntry::REMOVED;
+    }
+    return sameContent(from, to) ? PBCDiffEntry::UNCHANGED : PBCDiffEntry::MODIFIED;
+}
+
+/**
+ * @brief Compares two of the playbooks' maps in a single pass over their
+ * sorted names
+ */
+template<typename T>
+static void diffMaps(PBCDiffEntry::Type type,
+                     const PBCModelMap<T>& from,
+                     const PBCModelMap<T>& to,
+                     std::vector<PBCDiffEntry>& result) {  // NOLINT
+    auto fromIt = from.begin();
+    auto toIt = to.begin();
+    while (fromIt != from.end() || toIt != to.end()) {
+        if (toIt == to.end() || (fromIt != from.end() && fromIt->first < toIt->first)) {
+            result.push_back(PBCDiffEntry{type, fromIt->first, PBCDiffEntry::REMOVED});
+            ++fromIt;
+        } else if (fromIt == from.end() || toIt->first < fromIt->first) {
+            result.push_back(PBCDiffEntry{type, toIt->first, PBCDiffEntry::ADDED});
+            ++toIt;
+        } else {
+            if (!sameContent(fromIt->second, toIt->second)) {
+                result.push_back(PBCDiffEntry{type, toIt->first, PBCDiffEntry::MODIFIED});
+            }
+            ++fromIt;
+            ++toIt;
+        }
+    }
+}
+
+/**
+ * @brief Merges one of the playbooks' maps. An entry that has only been
+ * changed on one side is taken from that side. If both sides changed an entry
+ * differently, a conflict is reported and our version is taken (or theirs, if
+ * we have deleted the entry).
+ * @return The merged map. Its entries are still shared with the input playbooks.
+ */
+template<typename T>
+static PBCModelMap<T> mergeMaps(PBCDiffEntry::Type type,
+                                const PBCModelMap<T>& base,
+                                const PBCModelMap<T>& ours,
+                                const PBCModelMap<T>& theirs,
+                                std::vector<PBCMergeConflict>& conflicts) {  // NOLINT
+    std::set<std::string> names;
+    for (const auto& kv : base) { names.insert(kv.first); }
+    for (const auto& kv : ours) { names.insert(kv.first); }
+    for (const auto& kv : theirs) { names.insert(kv.first); }
+
+    PBCModelMap<T> result;
+    for (const std::string& name : names) {
+        T baseEntry = findOrNull(base, name);
+        T ourEntry = findOrNull(ours, name);
+        T theirEntry = findOrNull(theirs, name);
+        T mergedEntry;
+        if (sameContent(ourEntry, theirEntry) || sameContent(baseEntry, theirEntry)) {
+            mergedEntry = ourEntry;
+        } else if (sameContent(baseEntry, ourEntry)) {
+            mergedEntry = theirEntry;
+        } else {
+            conflicts.push_back(PBCMergeConflict{type,
+                                                 name,
+                                                 changeOf(baseEntry, ourEntry),
+                                                 changeOf(baseEntry, theirEntry)});
+            mergedEntry = ourEntry != NULL ? ourEntry : theirEntry;
+        }
+        if (mergedEntry != NULL) {
+            result[name] = mergedEntry;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Computes the changes that turn one playbook into another one
+ * @param from The older playbook
+ * @param to The newer playbook
+ * @return The added, removed and modified entries (unchanged entries are
+ * omitted)
+ */
+std::vector<PBCDiffEntry> PBCPlaybookMerge::diff(const PBCPlaybook &from, const PBCPlaybook &to) {
+    std::vector<PBCDiffEntry> result;
+    // (computing the content hashes also fills in pending default routes and formations)
+    if (from.contentHash() == to.contentHash()) {
+        return result;
+    }
+    if (from._name != to._name || from._playerNumber != to._playerNumber) {
+        result.push_back(PBCDiffEntry{PBCDiffEntry::PLAYBOOK, to._name, PBCDiffEntry::MODIFIED});
+    }
+    diffMaps(PBCDiffEntry::FORMATION, from._formations, to._formations, result);
+    diffMaps(PBCDiffEntry::ROUTE, from._routes, to._routes, result);
+    diffMaps(PBCDiffEntry::CATEGORY, from._categories, to._categories, result);
+    diffMaps(PBCDiffEntry::PLAY, from._plays, to._plays, result);
+    return result;
+}
+
+/**
+ * @brief Merges the changes of two playbooks that have been derived from a
+ * common ancestor.
+ *
+ * The merged playbook is a new playbook, which does not share any mutable
+ * objects with the input playbooks. Plays are linked to the merged routes and
+ * categories by name.
+ * @param base The common ancestor
+ * @param ours Our version of the playbook
+ * @param theirs Their version of the playbook
+ * @return The merged playbook and the conflicts
+ */
+PBCMergeResult PBCPlaybookMerge::merge(const PBCPlaybook &base,
+                                       const PBCPlaybook &ours,
+                                       const PBCPlaybook &theirs) {
+    if (ours._playerNumber != theirs._playerNumber) {
+        throw PBCImportException("the playbooks to merge have different numbers of players ("
+                                 + std::to_string(ours._playerNumber) + " and "
+                                 + std::to_string(theirs._playerNumber) + ")");
+    }
+
+    base.materializeDefaults();
+    ours.materializeDefaults();
+    theirs.materializeDefaults();
+
+    PBCMergeResult result;
+    PBCModelMap<PBCFormationSP> formations =
+            mergeMaps(PBCDiffEntry::FORMATION, base._formations, ours._formations, theirs._formations, result.conflicts);  // NOLINT
+    PBCModelMap<PBCRouteSP> routes =
+            mergeMaps(PBCDiffEntry::ROUTE, base._routes, ours._routes, theirs._routes, result.conflicts);
+    PBCModelMap<PBCCategorySP> categories =
+            mergeMaps(PBCDiffEntry::CATEGORY, base._categories, ours._categories, theirs._categories, result.conflicts);  // NOLINT
+    PBCModelMap<PBCPlaySP> plays =
+            mergeMaps(PBCDiffEntry::PLAY, base._plays, ours._plays, theirs._plays, result.conflicts);
+
+    PBCPlaybookSP playbook(new PBCPlaybook());
+    playbook->_playerNumber = ours._playerNumber;
+    if (ours._name == theirs._name || base._name == theirs._name) {
+        playbook->_name = ours._name;
+    } else if (base._name == ours._name) {
+        playbook->_name = theirs._name;
+    } else {
+        result.conflicts.push_back(PBCMergeConflict{PBCDiffEntry::PLAYBOOK,
+                                                    ours._name,
+                                                    PBCDiffEntry::MODIFIED,
+                                                    PBCDiffEntry::MODIFIED});
+        playbook->_name = ours._name;
+    }
+    playbook->_defaultsPending = false;
+    playbook->_formations.clear();
+    playbook->_routes.clear();
+    playbook->_categories.clear();
+    playbook->_plays.clear();
+
+    for (const auto& kv : formations) {
+        playbook->_formations[kv.first] = PBCFormationSP(new PBCFormation(*kv.second));
+    }
+    for (const auto& kv : routes) {
+        playbook->_routes[kv.first] = PBCRouteSP(new PBCRoute(*kv.second));
+    }
+
+    // routes that are used by plays, but are not part of the playbook anymore
+    std::map<PBCRouteSP, PBCRouteSP> orphanedRoutes;
+    auto mergedRoute = [&playbook, &orphanedRoutes](const PBCRouteSP& route) {
+        if (route == NULL) {
+            return route;
+        }
+        PBCRouteSP namedRoute = findOrNull(playbook->_routes, route->name());
+        if (namedRoute != NULL) {
+            return namedRoute;
+        }
+        PBCRouteSP& orphan = orphanedRoutes[route];
+        if (orphan == NULL) {
+            orphan.reset(new PBCRoute(*route));
+        }
+        return orphan;
+    };
+
+    for (const auto& kv : plays) {
+        PBCPlaySP play(new PBCPlay(*kv.second));
+        for (const PBCCategorySP& category : play->categories()) {
+            play->removeCategory(category);
+        }
+        for (const PBCPlayerSP& player : *play->formation()) {
+            player->setRoute(mergedRoute(player->route()));
+            player->setAlternativeRoute(1, mergedRoute(player->alternativeRoute(1)));
+            player->setAlternativeRoute(2, mergedRoute(player->alternativeRoute(2)));
+            std::vector<PBCRouteSP> optionRoutes = player->optionRoutes();
+            player->resetOptionRoutes();
+            for (const PBCRouteSP& route : optionRoutes) {
+                player->addOptionRoute(mergedRoute(route));
+            }
+            // motions belong to a single player, so every motion is copied
+            if (player->motion() != NULL) {
+                player->setMotion(PBCMotionSP(new PBCMotion(*player->motion())));
+            }
+        }
+        playbook->_plays[kv.first] = play;
+    }
+
+    for (const auto& kv : categories) {
+        playbook->_categories[kv.first] = PBCCategorySP(new PBCCategory(kv.second->name()));
+    }
+    auto link = [&playbook](const std::string& categoryName, const std::string& playName) {
+        PBCCategorySP category = findOrNull(playbook->_categories, categoryName);
+        PBCPlaySP play = findOrNull(playbook->_plays, playName);
+        if (category != NULL && play != NULL) {
+            category->addPlay(play);
+            play->addCategory(category);
+        }
+    };
+    for (const auto& kv : categories) {
+        for (const PBCPlaySP& play : kv.second->plays()) {
+            link(kv.first, play->name());
+        }
+    }
+    for (const auto& kv : plays) {
+        for (const PBCCategorySP& category : kv.second->categories()) {
+            link(category->name(), kv.first);
+        }
+    }
+
+    playbook->_history.clear();
+    playbook->rebuildUsageIndex();
+    playbook->_contentHash.invalidate();
+    result.playbook = playbook;
+    return result;
+}
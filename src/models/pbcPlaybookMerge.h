@@ -0,0 +1,88 @@
+/** @file pbcPlaybookMerge.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCPLAYBOOKMERGE_H
+#define PBCPLAYBOOKMERGE_H
+
+#include "models/pbcPlaybook.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief A difference of one entry between two playbooks
+ */
+struct PBCDiffEntry {
+    enum Type {
+        PLAYBOOK,  // the playbook's own attributes (name)
+        FORMATION,
+        ROUTE,
+        CATEGORY,
+        PLAY
+    };
+    enum Change {
+        UNCHANGED,
+        ADDED,
+        REMOVED,
+        MODIFIED
+    };
+
+    Type type;
+    std::string name;
+    Change change;
+};
+
+/**
+ * @brief An entry that has been changed differently in both merged playbooks
+ */
+struct PBCMergeConflict {
+    PBCDiffEntry::Type type;
+    std::string name;
+    PBCDiffEntry::Change ourChange;
+    PBCDiffEntry::Change theirChange;
+};
+
+/**
+ * @brief The result of a three-way merge. Conflicting entries are taken from
+ * "our" playbook.
+ */
+struct PBCMergeResult {
+    PBCPlaybookSP playbook;
+    std::vector<PBCMergeConflict> conflicts;
+};
+
+/**
+ * @class PBCPlaybookMerge
+ * @brief Compares playbooks and merges concurrent changes of the same
+ * playbook.
+ *
+ * Entries are matched by their name and compared by their content hash, so
+ * comparing two playbooks costs a single pass over their (sorted) entries.
+ * The compared playbooks are never changed.
+ */
+class PBCPlaybookMerge {
+ public:
+    static std::vector<PBCDiffEntry> diff(const PBCPlaybook& from, const PBCPlaybook& to);
+    static PBCMergeResult merge(const PBCPlaybook& base,
+                                const PBCPlaybook& ours,
+                                const PBCPlaybook& theirs);
+};
+
+#endif  // PBCPLAYBOOKMERGE_H
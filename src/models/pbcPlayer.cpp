@@ -46,6 +46,7 @@ PBCRole PBCPlayer::role() const {
  */
 void PBCPlayer::setRole(const PBCRole &role) {
     _role = role;
+    _contentHash.invalidate();
 }
 
 /**
@@ -66,6 +67,7 @@ PBCColor PBCPlayer::color() const {
  */
 void PBCPlayer::setColor(const PBCColor &color) {
     _color = color;
+    _contentHash.invalidate();
 }
 
 /**
@@ -82,6 +84,7 @@ PBCDPoint PBCPlayer::pos() const {
  */
 void PBCPlayer::setPos(const PBCDPoint &pos) {
     _pos = pos;
+    _contentHash.invalidate();
 }
 
 /**
@@ -98,6 +101,7 @@ PBCRouteSP PBCPlayer::route() const {
  */
 void PBCPlayer::setRoute(const PBCRouteSP &route) {
     _route = route;
+    _contentHash.invalidate();
 }
 
 /**
@@ -105,6 +109,7 @@ void PBCPlayer::setRoute(const PBCRouteSP &route) {
  */
 void PBCPlayer::resetRoute() {
     _route.reset();
+    _contentHash.invalidate();
 }
 
 /*
@@ -133,6 +138,7 @@ void PBCPlayer::setAlternativeRoute(unsigned int alternativeVersionNr, const PBC
     } else {
         pbcAssert(false && "not alternativeRoute 1 or 2?");
     }
+    _contentHash.invalidate();
 }
 
 /**
@@ -147,6 +153,7 @@ void PBCPlayer::resetAlternativeRoute(unsigned int alternativeVersionNr) {
     } else {
         pbcAssert(false && "not alternativeRoute 1 or 2?");
     }
+    _contentHash.invalidate();
 }
 
 
@@ -164,6 +171,7 @@ PBCMotionSP PBCPlayer::motion() const {
  */
 void PBCPlayer::setMotion(const PBCMotionSP &motion) {
     _motion = motion;
+    _contentHash.invalidate();
 }
 
 /**
@@ -195,6 +203,7 @@ const std::string &PBCPlayer::name() const {
 
 void PBCPlayer::setName(const std::string &name) {
     _name = name;
+    _contentHash.invalidate();
 }
 
 unsigned int PBCPlayer::nr() const {
@@ -203,18 +212,50 @@ unsigned int PBCPlayer::nr() const {
 
 void PBCPlayer::setNr(unsigned int nr) {
     _nr = nr;
+    _contentHash.invalidate();
 }
 
 void PBCPlayer::addOptionRoute(const PBCRouteSP &route) {
     _optionRoutes.push_back(route);
+    _contentHash.invalidate();
 }
 
 void PBCPlayer::resetOptionRoutes() {
     _optionRoutes.clear();
+    _contentHash.invalidate();
 }
 
-std::vector<PBCRouteSP> PBCPlayer::optionRoutes() {
+std::vector<PBCRouteSP> PBCPlayer::optionRoutes() const {
     return _optionRoutes;
 }
 
-
+/**
+ * @brief Computes the content hash of the player. Routes and motion are
+ * included via their own (cached) content hashes.
+ * @return the content hash
+ */
+PBCHash PBCPlayer::contentHash() const {
+    return _contentHash.get(
+        [this]() {
+            PBCHash hash = PBCContentHash::string(_role.fullName);
+            hash = PBCContentHash::bytes(_role.shortName.data(), _role.shortName.size(), hash);
+            hash = PBCContentHash::number(static_cast<uint64_t>(_color.r()), hash);
+            hash = PBCContentHash::number(static_cast<uint64_t>(_color.g()), hash);
+            hash = PBCContentHash::number(static_cast<uint64_t>(_color.b()), hash);
+            hash = PBCContentHash::number(_pos.get<0>(), hash);
+            hash = PBCContentHash::number(_pos.get<1>(), hash);
+            hash = PBCContentHash::string(_name, hash);
+            return PBCContentHash::number(static_cast<uint64_t>(_nr), hash);
+        },
+        [this](PBCHash ownHash) {
+            PBCHash hash = PBCContentHash::combine(ownHash, _route ? _route->contentHash() : 0);
+            hash = PBCContentHash::combine(hash, _motion ? _motion->contentHash() : 0);
+            hash = PBCContentHash::combine(hash, _alternativeRoute1 ? _alternativeRoute1->contentHash() : 0);  // NOLINT
+            hash = PBCContentHash::combine(hash, _alternativeRoute2 ? _alternativeRoute2->contentHash() : 0);  // NOLINT
+            hash = PBCContentHash::number(static_cast<uint64_t>(_optionRoutes.size()), hash);
+            for (const PBCRouteSP& optionRoute : _optionRoutes) {
+                hash = PBCContentHash::combine(hash, optionRoute ? optionRoute->contentHash() : 0);
+            }
+            return hash;
+        });
+}
@@ -27,6 +27,7 @@
 #include "models/pbcMotion.h"
 #include "models/pbcPath.h"
 #include "models/pbcColor.h"
+#include "util/pbcContentHash.h"
 #include <boost/serialization/access.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/array.hpp>
@@ -63,6 +64,7 @@ friend class boost::serialization::access;
     PBCMotionSP _motion;
     std::string _name;
     unsigned int _nr;
+    PBCHashCache _contentHash;
 
     template<class Archive>
     void save(Archive& ar, const unsigned int version) const {  // NOLINT
@@ -108,6 +110,7 @@ friend class boost::serialization::access;
             ar >> _alternativeRoute1;
             ar >> _alternativeRoute2;
         }
+        _contentHash.invalidate();
     }
     BOOST_SERIALIZATION_SPLIT_MEMBER()
     PBCPlayer() :
@@ -145,8 +148,9 @@ friend class boost::serialization::access;
     PBCMotionSP motion() const;
     void setMotion(const PBCMotionSP &motion);
     void addOptionRoute(const PBCRouteSP &route);
-    std::vector<PBCRouteSP> optionRoutes();
+    std::vector<PBCRouteSP> optionRoutes() const;
     void resetOptionRoutes();
+    PBCHash contentHash() const;
 };
 BOOST_CLASS_VERSION(PBCPlayer, 3)
 
@@ -61,4 +61,17 @@ std::string PBCRoute::codeName() const {
 
 void PBCRoute::setName(const std::string &name) {
     _name = name;
+    _contentHash.invalidate();
+}
+
+/**
+ * @brief Computes the content hash of the route (name, code name and paths)
+ * @return the content hash
+ */
+PBCHash PBCRoute::contentHash() const {
+    return _contentHash.get(
+        [this]() {
+            return PBCContentHash::string(_codeName, PBCContentHash::string(_name));
+        },
+        [this](PBCHash ownHash) { return combinePathHashes(ownHash); });
 }
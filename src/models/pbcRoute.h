@@ -58,6 +58,7 @@ friend class boost::serialization::access;
     std::string name() const;
     std::string codeName() const;
     void setName(const std::string& name);
+    PBCHash contentHash() const;
 };
 
 #endif  // PBCROUTE_H
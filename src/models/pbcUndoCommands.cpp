@@ -0,0 +1,273 @@
+/** @file pbcUndoCommands.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcUndoCommands.h"
+#include "pbcController.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief The constructor. Must be called after the player has been changed.
+ * @param text The description of the edit
+ * @param play The play the player belongs to
+ * @param player The changed player
+ * @param before A copy of the player's state before the edit
+ */
+PBCPlayerEditCommand::PBCPlayerEditCommand(const std::string &text,
+                                           PBCPlaySP play,
+                                           PBCPlayerSP player,
+                                           const PBCPlayer &before) :
+    _text(text),
+    _play(play),
+    _player(player),
+    _before(before),
+    _after(*player) {}
+
+size_t PBCPlayerEditCommand::playerByteSize(const PBCPlayer &player) {
+    return sizeof(PBCPlayer) +
+           player.name().capacity() +
+           player.role().fullName.size() +
+           player.optionRoutes().size() * sizeof(PBCRouteSP);
+}
+
+void PBCPlayerEditCommand::undo() {
+    *_player = _before;
+    PBCController::getInstance()->getPlaybook()->updateUsages(_play);
+}
+
+void PBCPlayerEditCommand::redo() {
+    *_player = _after;
+    PBCController::getInstance()->getPlaybook()->updateUsages(_play);
+}
+
+size_t PBCPlayerEditCommand::byteSize() const {
+    return sizeof(*this) - 2 * sizeof(PBCPlayer) + _text.capacity() +
+           playerByteSize(_before) + playerByteSize(_after);
+}
+
+std::string PBCPlayerEditCommand::text() const {
+    return _text;
+}
+
+/**
+ * @brief Merges consecutive edits of the same kind on the same player, e.g.
+ * dragging the color wheel or typing the player's name.
+ * @param other The command that is about to be pushed
+ * @return true if other has been merged into this command
+ */
+bool PBCPlayerEditCommand::mergeWith(const PBCUndoCommand &other) {
+    const PBCPlayerEditCommand* otherEdit = dynamic_cast<const PBCPlayerEditCommand*>(&other);
+    if (otherEdit == NULL ||
+        otherEdit->_player != _player ||
+        otherEdit->_text != _text) {
+        return false;
+    }
+    _after = otherEdit->_after;
+    return true;
+}
+
+PBCPlaySP PBCPlayerEditCommand::affectedPlay() const {
+    return _play;
+}
+
+
+/**
+ * @brief The constructor.
+ * @param playbook The playbook that owns the changed entries
+ * @param text The description of the edit
+ */
+PBCPlaybookEditCommand::PBCPlaybookEditCommand(PBCPlaybook *playbook, const std::string &text) :
+    _playbook(playbook),
+    _text(text) {
+    pbcAssert(_playbook != NULL);
+}
+
+/**
+ * @brief Records that a formation has been added (before == NULL), replaced
+ * or deleted (after == NULL).
+ */
+void PBCPlaybookEditCommand::formationChanged(const std::string &name,
+                                              PBCFormationSP before,
+                                              PBCFormationSP after) {
+    _formations.push_back(SlotChange<PBCFormationSP>{name, before, after});
+}
+
+/**
+ * @brief Records that a route has been added (before == NULL), replaced
+ * or deleted (after == NULL).
+ */
+void PBCPlaybookEditCommand::routeChanged(const std::string &name,
+                                          PBCRouteSP before,
+                                          PBCRouteSP after) {
+    _routes.push_back(SlotChange<PBCRouteSP>{name, before, after});
+}
+
+/**
+ * @brief Records that a route has been overwritten in place, so that all plays
+ * that share the route see the change.
+ * @param route The overwritten route (already holding the new value)
+ * @param before The value of the route before it has been overwritten
+ */
+void PBCPlaybookEditCommand::routeOverwritten(PBCRouteSP route, const PBCRoute &before) {
+    _routeValues.push_back(RouteValueChange{route,
+                                            PBCRouteSP(new PBCRoute(before)),
+                                            PBCRouteSP(new PBCRoute(*route))});
+}
+
+/**
+ * @brief Records that a category has been added (before == NULL), replaced
+ * or deleted (after == NULL).
+ */
+void PBCPlaybookEditCommand::categoryChanged(const std::string &name,
+                                             PBCCategorySP before,
+                                             PBCCategorySP after) {
+    _categories.push_back(SlotChange<PBCCategorySP>{name, before, after});
+}
+
+/**
+ * @brief Records that a play has been added (before == NULL), replaced
+ * or deleted (after == NULL).
+ */
+void PBCPlaybookEditCommand::playChanged(const std::string &name,
+                                         PBCPlaySP before,
+                                         PBCPlaySP after) {
+    _plays.push_back(SlotChange<PBCPlaySP>{name, before, after});
+}
+
+/**
+ * @brief Records that a play has been assigned to (linked == true) or removed
+ * from (linked == false) a category.
+ */
+void PBCPlaybookEditCommand::categoryLinkChanged(PBCPlaySP play,
+                                                 PBCCategorySP category,
+                                                 bool linked) {
+    _categoryLinks.push_back(CategoryLinkChange{play, category, linked});
+}
+
+/**
+ * @brief Checks whether any change has been recorded
+ * @return true if nothing has been recorded
+ */
+bool PBCPlaybookEditCommand::empty() const {
+    return _formations.empty() && _routes.empty() && _categories.empty() &&
+           _plays.empty() && _routeValues.empty() && _categoryLinks.empty();
+}
+
+template<typename T>
+void PBCPlaybookEditCommand::restore(PBCModelMap<T> &map, const std::string &name, const T &value) {
+    if (value == NULL) {
+        map.erase(name);
+    } else {
+        map[name] = value;
+    }
+}
+
+void PBCPlaybookEditCommand::undo() {
+    for (auto it = _categoryLinks.rbegin(); it != _categoryLinks.rend(); ++it) {
+        if (it->linked) {
+            it->play->removeCategory(it->category);
+            it->category->removePlay(it->play);
+        } else {
+            it->play->addCategory(it->category);
+            it->category->addPlay(it->play);
+        }
+    }
+    for (auto it = _routeValues.rbegin(); it != _routeValues.rend(); ++it) {
+        *it->route = *it->before;
+    }
+    for (auto it = _plays.rbegin(); it != _plays.rend(); ++it) {
+        restore(_playbook->_plays, it->name, it->before);
+        _playbook->_usages.replacePlay(it->after, it->before);
+    }
+    for (auto it = _categories.rbegin(); it != _categories.rend(); ++it) {
+        restore(_playbook->_categories, it->name, it->before);
+    }
+    for (auto it = _routes.rbegin(); it != _routes.rend(); ++it) {
+        restore(_playbook->_routes, it->name, it->before);
+    }
+    for (auto it = _formations.rbegin(); it != _formations.rend(); ++it) {
+        restore(_playbook->_formations, it->name, it->before);
+    }
+    _playbook->_contentHash.invalidate();
+}
+
+void PBCPlaybookEditCommand::redo() {
+    for (const auto& change : _formations) {
+        restore(_playbook->_formations, change.name, change.after);
+    }
+    for (const auto& change : _routes) {
+        restore(_playbook->_routes, change.name, change.after);
+    }
+    for (const auto& change : _categories) {
+        restore(_playbook->_categories, change.name, change.after);
+    }
+    for (const auto& change : _plays) {
+        restore(_playbook->_plays, change.name, change.after);
+        _playbook->_usages.replacePlay(change.before, change.after);
+    }
+    for (const auto& change : _routeValues) {
+        *change.route = *change.after;
+    }
+    for (const auto& change : _categoryLinks) {
+        if (change.linked) {
+            change.play->addCategory(change.category);
+            change.category->addPlay(change.play);
+        } else {
+            change.play->removeCategory(change.category);
+            change.category->removePlay(change.play);
+        }
+    }
+    _playbook->_contentHash.invalidate();
+}
+
+template<typename T>
+size_t PBCPlaybookEditCommand::slotsByteSize(const std::vector<SlotChange<T>> &slots) {
+    size_t size = slots.capacity() * sizeof(SlotChange<T>);
+    for (const SlotChange<T>& slot : slots) {
+        size += slot.name.capacity();
+    }
+    return size;
+}
+
+size_t PBCPlaybookEditCommand::routeByteSize(const PBCRouteSP &route) {
+    return sizeof(PBCRoute) +
+           route->name().size() +
+           route->codeName().size() +
+           route->paths().capacity() * sizeof(PBCPathSP);
+}
+
+size_t PBCPlaybookEditCommand::byteSize() const {
+    size_t size = sizeof(*this) + _text.capacity();
+    size += slotsByteSize(_formations);
+    size += slotsByteSize(_routes);
+    size += slotsByteSize(_categories);
+    size += slotsByteSize(_plays);
+    size += _categoryLinks.capacity() * sizeof(CategoryLinkChange);
+    size += _routeValues.capacity() * sizeof(RouteValueChange);
+    for (const RouteValueChange& change : _routeValues) {
+        size += routeByteSize(change.before) + routeByteSize(change.after);
+    }
+    return size;
+}
+
+std::string PBCPlaybookEditCommand::text() const {
+    return _text;
+}
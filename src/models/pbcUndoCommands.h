@@ -0,0 +1,130 @@
+/** @file pbcUndoCommands.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCUNDOCOMMANDS_H
+#define PBCUNDOCOMMANDS_H
+
+#include "util/pbcUndoStack.h"
+#include "models/pbcPlaybook.h"
+#include "models/pbcPlay.h"
+#include "models/pbcPlayer.h"
+#include "models/pbcFormation.h"
+#include "models/pbcRoute.h"
+#include "models/pbcCategory.h"
+#include <string>
+#include <vector>
+
+/**
+ * @class PBCPlayerEditCommand
+ * @brief Records an edit of a single player of a play (position, color,
+ * route, motion, name, number).
+ *
+ * Only the player's own attributes are stored. Routes and motions are shared
+ * with the model, so a step costs a few hundred bytes.
+ */
+class PBCPlayerEditCommand : public PBCUndoCommand {
+ private:
+    std::string _text;
+    PBCPlaySP _play;
+    PBCPlayerSP _player;
+    PBCPlayer _before;
+    PBCPlayer _after;
+
+    static size_t playerByteSize(const PBCPlayer& player);
+
+ public:
+    PBCPlayerEditCommand(const std::string& text,
+                         PBCPlaySP play,
+                         PBCPlayerSP player,
+                         const PBCPlayer& before);
+    void undo();
+    void redo();
+    size_t byteSize() const;
+    std::string text() const;
+    bool mergeWith(const PBCUndoCommand& other);
+    PBCPlaySP affectedPlay() const;
+};
+
+/**
+ * @class PBCPlaybookEditCommand
+ * @brief Records changes of the playbook's formations, routes, categories
+ * and plays.
+ *
+ * For every changed map entry the previous and the new smart pointer are
+ * stored. The objects themselves are shared with the model. Routes that are
+ * overwritten in place (so that the change is visible in all plays) are
+ * stored as shallow copies, which share their paths with the model.
+ */
+class PBCPlaybookEditCommand : public PBCUndoCommand {
+ private:
+    template<typename T>
+    struct SlotChange {
+        std::string name;
+        T before;
+        T after;
+    };
+
+    struct RouteValueChange {
+        PBCRouteSP route;
+        PBCRouteSP before;
+        PBCRouteSP after;
+    };
+
+    struct CategoryLinkChange {
+        PBCPlaySP play;
+        PBCCategorySP category;
+        bool linked;  // the link state after the edit
+    };
+
+    PBCPlaybook* _playbook;
+    std::string _text;
+    std::vector<SlotChange<PBCFormationSP>> _formations;
+    std::vector<SlotChange<PBCRouteSP>> _routes;
+    std::vector<SlotChange<PBCCategorySP>> _categories;
+    std::vector<SlotChange<PBCPlaySP>> _plays;
+    std::vector<RouteValueChange> _routeValues;
+    std::vector<CategoryLinkChange> _categoryLinks;
+
+    template<typename T>
+    static void restore(PBCModelMap<T>& map, const std::string& name, const T& value);  // NOLINT
+
+    template<typename T>
+    static size_t slotsByteSize(const std::vector<SlotChange<T>>& slots);
+
+    static size_t routeByteSize(const PBCRouteSP& route);
+
+ public:
+    PBCPlaybookEditCommand(PBCPlaybook* playbook, const std::string& text);
+    void formationChanged(const std::string& name, PBCFormationSP before, PBCFormationSP after);
+    void routeChanged(const std::string& name, PBCRouteSP before, PBCRouteSP after);
+    void routeOverwritten(PBCRouteSP route, const PBCRoute& before);
+    void categoryChanged(const std::string& name, PBCCategorySP before, PBCCategorySP after);
+    void playChanged(const std::string& name, PBCPlaySP before, PBCPlaySP after);
+    void categoryLinkChanged(PBCPlaySP play, PBCCategorySP category, bool linked);
+    bool empty() const;
+    void undo();
+    void redo();
+    size_t byteSize() const;
+    std::string text() const;
+};
+typedef boost::shared_ptr<PBCPlaybookEditCommand> PBCPlaybookEditCommandSP;
+
+#endif  // PBCUNDOCOMMANDS_H
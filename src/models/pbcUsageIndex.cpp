@@ -0,0 +1,175 @@
+/** @file pbcUsageIndex.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcUsageIndex.h"
+#include "models/pbcPlay.h"
+#include "models/pbcPlayer.h"
+#include "models/pbcRoute.h"
+#include "models/pbcFormation.h"
+#include <set>
+#include <string>
+#include <vector>
+
+void PBCUsageIndex::addRouteUsage(const PBCRouteSP &route,
+                                  const PBCRouteUsage &usage,
+                                  PlayEntry &entry) {
+    if (route == NULL) {
+        return;
+    }
+    std::vector<PBCRouteUsage>& usages = _routeUsages[route][usage.play];
+    if (usages.empty()) {
+        entry.routes.push_back(route);
+    }
+    usages.push_back(usage);
+}
+
+/**
+ * @brief Indexes the routes and the formation of a play
+ * @param play The play to index. If it is indexed already, it is indexed again.
+ */
+void PBCUsageIndex::addPlay(const PBCPlaySP &play) {
+    pbcAssert(play != NULL);
+    if (contains(play)) {
+        removePlay(play);
+    }
+    PlayEntry& entry = _plays[play];
+    for (const PBCPlayerSP& player : *play->formation()) {
+        addRouteUsage(player->route(), PBCRouteUsage{play, player, PBCRouteUsage::ROUTE}, entry);
+        addRouteUsage(player->alternativeRoute(1),
+                      PBCRouteUsage{play, player, PBCRouteUsage::ALTERNATIVE_ROUTE_1},
+                      entry);
+        addRouteUsage(player->alternativeRoute(2),
+                      PBCRouteUsage{play, player, PBCRouteUsage::ALTERNATIVE_ROUTE_2},
+                      entry);
+        for (const PBCRouteSP& route : player->optionRoutes()) {
+            addRouteUsage(route, PBCRouteUsage{play, player, PBCRouteUsage::OPTION_ROUTE}, entry);
+        }
+    }
+    entry.formationName = play->formation()->name();
+    _formationUsages[entry.formationName].insert(play);
+}
+
+/**
+ * @brief Removes a play from the index. Only the entries of this play are
+ * touched.
+ * @param play The play to remove
+ */
+void PBCUsageIndex::removePlay(const PBCPlaySP &play) {
+    auto playIt = _plays.find(play);
+    if (playIt == _plays.end()) {
+        return;
+    }
+    for (const PBCRouteSP& route : playIt->second.routes) {
+        auto routeIt = _routeUsages.find(route);
+        pbcAssert(routeIt != _routeUsages.end());
+        routeIt->second.erase(play);
+        if (routeIt->second.empty()) {
+            _routeUsages.erase(routeIt);
+        }
+    }
+    auto formationIt = _formationUsages.find(playIt->second.formationName);
+    pbcAssert(formationIt != _formationUsages.end());
+    formationIt->second.erase(play);
+    if (formationIt->second.empty()) {
+        _formationUsages.erase(formationIt);
+    }
+    _plays.erase(playIt);
+}
+
+/**
+ * @brief Indexes a play again after it has been changed in place. Plays that
+ * are not indexed are ignored.
+ * @param play The changed play
+ */
+void PBCUsageIndex::updatePlay(const PBCPlaySP &play) {
+    if (contains(play)) {
+        addPlay(play);
+    }
+}
+
+/**
+ * @brief Replaces a play of the index by another one
+ * @param before The play to remove (may be NULL)
+ * @param after The play to add (may be NULL)
+ */
+void PBCUsageIndex::replacePlay(const PBCPlaySP &before, const PBCPlaySP &after) {
+    if (before != NULL) {
+        removePlay(before);
+    }
+    if (after != NULL) {
+        addPlay(after);
+    }
+}
+
+void PBCUsageIndex::clear() {
+    _routeUsages.clear();
+    _formationUsages.clear();
+    _plays.clear();
+}
+
+bool PBCUsageIndex::contains(const PBCPlaySP &play) const {
+    return _plays.count(play) > 0;
+}
+
+/**
+ * @brief Gets all references of players to a route
+ * @param route The route
+ * @return The references ordered by play
+ */
+std::vector<PBCRouteUsage> PBCUsageIndex::routeUsages(const PBCRouteSP &route) const {
+    std::vector<PBCRouteUsage> result;
+    auto routeIt = _routeUsages.find(route);
+    if (routeIt != _routeUsages.end()) {
+        for (const auto& kv : routeIt->second) {
+            result.insert(result.end(), kv.second.begin(), kv.second.end());
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Gets the plays in which at least one player references a route
+ * @param route The route
+ * @return the plays
+ */
+std::set<PBCPlaySP> PBCUsageIndex::playsUsingRoute(const PBCRouteSP &route) const {
+    std::set<PBCPlaySP> result;
+    auto routeIt = _routeUsages.find(route);
+    if (routeIt != _routeUsages.end()) {
+        for (const auto& kv : routeIt->second) {
+            result.insert(kv.first);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Gets the plays which have been created from a formation
+ * @param formationName The name of the formation
+ * @return the plays
+ */
+std::set<PBCPlaySP> PBCUsageIndex::playsUsingFormation(const std::string &formationName) const {
+    auto formationIt = _formationUsages.find(formationName);
+    if (formationIt == _formationUsages.end()) {
+        return std::set<PBCPlaySP>();
+    }
+    return formationIt->second;
+}
@@ -0,0 +1,90 @@
+/** @file pbcUsageIndex.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCUSAGEINDEX_H
+#define PBCUSAGEINDEX_H
+
+#include <boost/shared_ptr.hpp>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+class PBCPlay;
+typedef boost::shared_ptr<PBCPlay> PBCPlaySP;
+class PBCPlayer;
+typedef boost::shared_ptr<PBCPlayer> PBCPlayerSP;
+class PBCRoute;
+typedef boost::shared_ptr<PBCRoute> PBCRouteSP;
+
+/**
+ * @brief A reference from a player of a play to a route
+ */
+struct PBCRouteUsage {
+    enum Kind {
+        ROUTE,
+        ALTERNATIVE_ROUTE_1,
+        ALTERNATIVE_ROUTE_2,
+        OPTION_ROUTE
+    };
+
+    PBCPlaySP play;
+    PBCPlayerSP player;
+    Kind kind;
+};
+
+/**
+ * @class PBCUsageIndex
+ * @brief Maps routes and formation names to the plays (and players) that
+ * reference them.
+ *
+ * The index is updated whenever a play is added to, replaced in or removed
+ * from the playbook, so "where used" queries only cost time proportional to
+ * their result. For every indexed play the index remembers what has been
+ * indexed, so removing a play does not need to scan the index.
+ */
+class PBCUsageIndex {
+ private:
+    struct PlayEntry {
+        std::vector<PBCRouteSP> routes;
+        std::string formationName;
+    };
+
+    std::map<PBCRouteSP, std::map<PBCPlaySP, std::vector<PBCRouteUsage>>> _routeUsages;
+    std::map<std::string, std::set<PBCPlaySP>> _formationUsages;
+    std::map<PBCPlaySP, PlayEntry> _plays;
+
+    void addRouteUsage(const PBCRouteSP& route, const PBCRouteUsage& usage, PlayEntry& entry);  // NOLINT
+
+ public:
+    void addPlay(const PBCPlaySP& play);
+    void removePlay(const PBCPlaySP& play);
+    void updatePlay(const PBCPlaySP& play);
+    void replacePlay(const PBCPlaySP& before, const PBCPlaySP& after);
+    void clear();
+    bool contains(const PBCPlaySP& play) const;
+
+    std::vector<PBCRouteUsage> routeUsages(const PBCRouteSP& route) const;
+    std::set<PBCPlaySP> playsUsingRoute(const PBCRouteSP& route) const;
+    std::set<PBCPlaySP> playsUsingFormation(const std::string& formationName) const;
+};
+
+#endif  // PBCUSAGEINDEX_H
@@ -0,0 +1,475 @@
+/** @file pbcBackupStore.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcBackupStore.h"
+#include "util/pbcDeclarations.h"
+#include "util/pbcExceptions.h"
+#include "util/pbcPerf.h"
+#include "pbcVersion.h"
+#include <botan/aead.h>
+#include <botan/auto_rng.h>
+#include <botan/hex.h>
+#include <botan/kdf.h>
+#include <botan/mac.h>
+#include <algorithm>
+#include <array>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+static const char* const CIPHER = "AES-256/GCM";
+static const char* const MAC = "HMAC(SHA-256)";
+static const char* const SUBKEY_KDF = "HKDF(SHA-256)";
+static const char* const SNAPSHOT_MAGIC = "Playbook-Creator backup 3";
+static const size_t IV_SIZE = 12;  // in Bytes
+static const size_t TAG_SIZE = 16;  // in Bytes, of the GCM authentication tag
+static const size_t ID_SIZE = 16;  // in Bytes, of the keyed hash that names a chunk
+
+// Chunks are cut where the rolling hash of the last bytes has its upper bits
+// cleared, which happens every 8 KiB on average (after the minimum size).
+static const size_t MIN_CHUNK_SIZE = 2048;
+static const size_t MAX_CHUNK_SIZE = 65536;
+static const uint64_t CHUNK_MASK = 0xFFF8000000000000ull;  // 13 bits
+
+/**
+ * @brief The table of the gear hash. It is part of the chunk boundaries, so
+ * it must never change.
+ */
+static const std::array<uint64_t, 256>& gearTable() {
+    static const std::array<uint64_t, 256> table = []() {
+        std::array<uint64_t, 256> result;
+        uint64_t state = 0x5042432d42414b55ull;
+        for (uint64_t& value : result) {  // splitmix64
+            state += 0x9E3779B97F4A7C15ull;
+            uint64_t z = state;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            value = z ^ (z >> 31);
+        }
+        return result;
+    }();
+    return table;
+}
+
+/**
+ * @brief Splits data at content-defined boundaries
+ * @param data The data
+ * @return The offset and the size of each chunk
+ */
+std::vector<std::pair<size_t, size_t>> PBCBackupStore::chunkBoundaries(const std::string &data) {
+    const std::array<uint64_t, 256>& gear = gearTable();
+    std::vector<std::pair<size_t, size_t>> chunks;
+    size_t start = 0;
+    while (start < data.size()) {
+        size_t end = std::min(data.size(), start + MAX_CHUNK_SIZE);
+        size_t cut = end;
+        uint64_t hash = 0;
+        for (size_t i = start; i < end; ++i) {
+            hash = (hash << 1) + gear[static_cast<unsigned char>(data[i])];
+            if (i + 1 - start >= MIN_CHUNK_SIZE && (hash & CHUNK_MASK) == 0) {
+                cut = i + 1;
+                break;
+            }
+        }
+        chunks.push_back(std::make_pair(start, cut - start));
+        start = cut;
+    }
+    return chunks;
+}
+
+uint64_t PBCBackupStore::Snapshot::size() const {
+    uint64_t result = 0;
+    for (const Chunk& chunk : chunks) {
+        result += chunk.size;
+    }
+    return result;
+}
+
+/**
+ * @brief The constructor. The directory is created when the first snapshot
+ * is written.
+ * @param playbookFileName The playbook file whose snapshots are stored
+ */
+PBCBackupStore::PBCBackupStore(const std::string &playbookFileName) :
+    _dirName(playbookFileName + ".backups") {}
+
+std::string PBCBackupStore::chunkFileName(const std::string &id) const {
+    return _dirName + "/chunks/" + id;
+}
+
+std::string PBCBackupStore::snapshotFileName(const std::string &id) const {
+    return _dirName + "/snapshots/" + id + ".snapshot";
+}
+
+/**
+ * @brief Derives a subkey of the key of the playbook file, so that the
+ * encryption and the keyed hash that names the chunks never share a key
+ * @param key The key of the playbook file
+ * @param label The purpose of the subkey
+ * @return The subkey
+ */
+static Botan::OctetString subkey(const Botan::OctetString& key, const std::string& label) {
+    std::unique_ptr<Botan::KDF> kdf(Botan::KDF::create(SUBKEY_KDF));
+    pbcAssert(kdf != NULL);
+    return Botan::OctetString(kdf->derive_key(key.length(), key.bits_of(), "", label));
+}
+
+static Botan::OctetString encryptionKey(const Botan::OctetString& key) {
+    return subkey(key, "Playbook-Creator backup encryption");
+}
+
+static Botan::OctetString chunkIdKey(const Botan::OctetString& key) {
+    return subkey(key, "Playbook-Creator backup chunk id");
+}
+
+static void processAEAD(Botan::Cipher_Dir direction,
+                        const Botan::OctetString& key,
+                        const Botan::byte* iv,
+                        const std::string& associatedData,
+                        Botan::SecureVector<Botan::byte>& data) {
+    std::unique_ptr<Botan::AEAD_Mode> aead = Botan::AEAD_Mode::create(CIPHER, direction);
+    pbcAssert(aead != NULL);
+    aead->set_key(key);
+    aead->set_associated_data(reinterpret_cast<const Botan::byte*>(associatedData.data()), associatedData.size());
+    aead->start(iv, IV_SIZE);
+    try {
+        aead->finish(data);
+    } catch (Botan::Integrity_Failure& e) {
+        throw PBCDecryptionException("Error while decrypting the backup. "
+                                     "Maybe you entered the wrong password "
+                                     "or someone tampered the backup.");
+    }
+}
+
+static std::string readFile(const std::string& fileName) {
+    QFile file(QString::fromStdString(fileName));
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw PBCStorageException("Could not read " + fileName + ": " + file.errorString().toStdString());
+    }
+    QByteArray content = file.readAll();
+    return std::string(content.constData(), content.size());
+}
+
+static void writeFile(const std::string& fileName, const Botan::byte* data, size_t size) {
+    QSaveFile file(QString::fromStdString(fileName));
+    if (!file.open(QIODevice::WriteOnly) ||
+        file.write(reinterpret_cast<const char*>(data), size) != static_cast<qint64>(size) ||
+        !file.commit()) {
+        throw PBCStorageException("Could not write " + fileName + ": " + file.errorString().toStdString());
+    }
+}
+
+/**
+ * @brief Reads a line "NAME VALUE" of a snapshot file
+ * @return false if the line does not match
+ */
+template<typename T>
+static bool readField(std::istream& stream, const std::string& name, T& value) {
+    std::string line;
+    std::string field;
+    if (!std::getline(stream, line)) {
+        return false;
+    }
+    std::istringstream fields(line);
+    return fields >> field >> value && field == name;
+}
+
+/**
+ * @brief Reads the plain part of a snapshot file
+ * @param id The id of the snapshot
+ * @param header Is set to the plain part (which is authenticated with the
+ * metadata), if not NULL
+ * @param encryptedMetadata Is set to the IV and the encrypted metadata, if not
+ * NULL
+ * @throws PBCStorageException if the file does not exist or is corrupted
+ */
+PBCBackupStore::Snapshot PBCBackupStore::readSnapshot(const std::string &id,
+                                                      std::string *header,
+                                                      std::string *encryptedMetadata) const {
+    const std::string content = readFile(snapshotFileName(id));
+    std::istringstream stream(content);
+    Snapshot snapshot;
+    snapshot.id = id;
+    std::string magic;
+    std::string kdf;
+    std::string salt;
+    size_t chunks = 0;
+    size_t metadataSize = 0;
+    bool valid = std::getline(stream, magic) && magic == SNAPSHOT_MAGIC &&
+            readField(stream, "time", snapshot.time) &&
+            readField(stream, "version", snapshot.version) &&
+            std::getline(stream, kdf) && kdf.compare(0, 4, "kdf ") == 0 &&
+            readField(stream, "salt", salt) &&
+            readField(stream, "chunks", chunks);
+    for (size_t i = 0; valid && i < chunks; ++i) {
+        std::string line;
+        Chunk chunk;
+        valid = std::getline(stream, line) && std::istringstream(line) >> chunk.id >> chunk.size &&
+                chunk.id.size() == 2 * ID_SIZE;
+        snapshot.chunks.push_back(chunk);
+    }
+    valid = valid && readField(stream, "metadata", metadataSize);
+    const std::streamoff headerSize = valid ? static_cast<std::streamoff>(stream.tellg()) : -1;
+    if (headerSize < 0 || content.size() != static_cast<size_t>(headerSize) + metadataSize || metadataSize < IV_SIZE) {
+        throw PBCStorageException("The backup " + id + " is corrupted.");
+    }
+    try {
+        snapshot.kdf = PBCKdfSettings::fromString(kdf.substr(4));
+        snapshot.salt = Botan::hex_decode_locked(salt);
+    } catch (std::exception& e) {
+        throw PBCStorageException("The backup " + id + " is corrupted.");
+    }
+    if (header != NULL) {
+        *header = content.substr(0, headerSize);
+    }
+    if (encryptedMetadata != NULL) {
+        *encryptedMetadata = content.substr(headerSize);
+    }
+    return snapshot;
+}
+
+/**
+ * @brief Lists the snapshots
+ * @return The snapshots, the newest first. Corrupted snapshots are skipped.
+ */
+std::vector<PBCBackupStore::Snapshot> PBCBackupStore::snapshots() const {
+    std::vector<Snapshot> result;
+    QDir dir(QString::fromStdString(_dirName + "/snapshots"));
+    for (const QString& fileName : dir.entryList(QStringList("*.snapshot"), QDir::Files)) {
+        try {
+            result.push_back(readSnapshot(QFileInfo(fileName).completeBaseName().toStdString(), NULL, NULL));
+        } catch (PBCStorageException&) {
+            continue;
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const Snapshot& a, const Snapshot& b) {
+        return a.time > b.time || (a.time == b.time && a.id > b.id);
+    });
+    return result;
+}
+
+/**
+ * @brief Reads the plain part of a snapshot
+ * @param id The id of the snapshot
+ * @throws PBCStorageException if there is no such snapshot
+ */
+PBCBackupStore::Snapshot PBCBackupStore::snapshot(const std::string &id) const {
+    return readSnapshot(id, NULL, NULL);
+}
+
+/**
+ * @brief Writes a snapshot. Only the chunks that are not stored yet are
+ * written; the snapshot file is written last, so an interrupted write leaves
+ * only unreferenced chunks (which are removed by prune()).
+ * @param data The serialized playbook
+ * @param metadata The serialized metadata of the playbook
+ * @param key The key of the playbook file
+ * @param salt The salt the key has been derived with
+ * @param kdf The key derivation the key has been derived with
+ * @param time The time of the snapshot (seconds since the epoch)
+ * @return The snapshot
+ */
+PBCBackupStore::Snapshot PBCBackupStore::write(const std::string &data,
+                                               const std::string &metadata,
+                                               const Botan::OctetString &key,
+                                               const Botan::SecureVector<Botan::byte> &salt,
+                                               const PBCKdfSettings &kdf,
+                                               int64_t time) {
+    PBC_PERF_SCOPE("backup.write");
+    if (!QDir().mkpath(QString::fromStdString(_dirName + "/chunks")) ||
+        !QDir().mkpath(QString::fromStdString(_dirName + "/snapshots"))) {
+        throw PBCStorageException("Could not create " + _dirName);
+    }
+    Botan::AutoSeeded_RNG rng;
+    const Botan::OctetString cipherKey = encryptionKey(key);
+    std::unique_ptr<Botan::MessageAuthenticationCode> mac = Botan::MessageAuthenticationCode::create(MAC);
+    pbcAssert(mac != NULL);
+    mac->set_key(chunkIdKey(key));
+
+    Snapshot snapshot;
+    snapshot.id = std::to_string(time) + "-" + Botan::hex_encode(rng.random_vec(4), false);
+    snapshot.time = time;
+    snapshot.version = PBCVersion::getVersionString();
+    snapshot.kdf = kdf;
+    snapshot.salt = salt;
+    for (const std::pair<size_t, size_t>& boundary : chunkBoundaries(data)) {
+        const Botan::byte* chunkData = reinterpret_cast<const Botan::byte*>(data.data()) + boundary.first;
+        mac->update(chunkData, boundary.second);
+        Botan::SecureVector<Botan::byte> hash = mac->final();
+        Chunk chunk{Botan::hex_encode(hash.data(), ID_SIZE, false), static_cast<uint32_t>(boundary.second)};
+        snapshot.chunks.push_back(chunk);
+        if (QFileInfo::exists(QString::fromStdString(chunkFileName(chunk.id)))) {
+            PBC_PERF_COUNT("backup.sharedChunks", 1);
+            continue;
+        }
+        Botan::SecureVector<Botan::byte> iv = rng.random_vec(IV_SIZE);
+        Botan::SecureVector<Botan::byte> encrypted(chunkData, chunkData + boundary.second);
+        processAEAD(Botan::Cipher_Dir::ENCRYPTION, cipherKey, iv.data(), chunk.id, encrypted);
+        encrypted.insert(encrypted.begin(), iv.begin(), iv.end());
+        writeFile(chunkFileName(chunk.id), encrypted.data(), encrypted.size());
+        PBC_PERF_COUNT("backup.writtenBytes", encrypted.size());
+    }
+
+    Botan::SecureVector<Botan::byte> iv = rng.random_vec(IV_SIZE);
+    Botan::SecureVector<Botan::byte> encryptedMetadata(metadata.begin(), metadata.end());
+    std::ostringstream header;
+    header << SNAPSHOT_MAGIC << "\n"
+           << "time " << time << "\n"
+           << "version " << snapshot.version << "\n"
+           << "kdf " << kdf.toString() << "\n"
+           << "salt " << Botan::hex_encode(salt, false) << "\n"
+           << "chunks " << snapshot.chunks.size() << "\n";
+    for (const Chunk& chunk : snapshot.chunks) {
+        header << chunk.id << " " << chunk.size << "\n";
+    }
+    header << "metadata " << IV_SIZE + metadata.size() + TAG_SIZE << "\n";
+    processAEAD(Botan::Cipher_Dir::ENCRYPTION, cipherKey, iv.data(), header.str(), encryptedMetadata);
+    pbcAssert(encryptedMetadata.size() == metadata.size() + TAG_SIZE);
+
+    std::string content = header.str();
+    content.append(reinterpret_cast<const char*>(iv.data()), iv.size());
+    content.append(reinterpret_cast<const char*>(encryptedMetadata.data()), encryptedMetadata.size());
+    writeFile(snapshotFileName(snapshot.id), reinterpret_cast<const Botan::byte*>(content.data()), content.size());
+    return snapshot;
+}
+
+/**
+ * @brief Reads the serialized playbook of a snapshot
+ * @param snapshot The snapshot
+ * @param key The key that has been derived from the password of the playbook
+ * file with the snapshot's key derivation and salt
+ * @param metadata Is set to the serialized metadata, if not NULL
+ * @return The serialized playbook
+ * @throws PBCDecryptionException if the key is wrong or the snapshot has been
+ * tampered with
+ */
+std::string PBCBackupStore::read(const Snapshot &snapshot,
+                                 const Botan::OctetString &key,
+                                 std::string *metadata) const {
+    PBC_PERF_SCOPE("backup.read");
+    const Botan::OctetString cipherKey = encryptionKey(key);
+    // the metadata authenticates the list of chunks
+    std::string header;
+    std::string encryptedMetadata;
+    Snapshot verified = readSnapshot(snapshot.id, &header, &encryptedMetadata);
+    Botan::SecureVector<Botan::byte> plainMetadata(encryptedMetadata.begin() + IV_SIZE, encryptedMetadata.end());
+    processAEAD(Botan::Cipher_Dir::DECRYPTION, cipherKey,
+                reinterpret_cast<const Botan::byte*>(encryptedMetadata.data()), header, plainMetadata);
+    if (metadata != NULL) {
+        metadata->assign(plainMetadata.begin(), plainMetadata.end());
+    }
+
+    std::string data;
+    data.reserve(verified.size());
+    for (const Chunk& chunk : verified.chunks) {
+        std::string content = readFile(chunkFileName(chunk.id));
+        if (content.size() < IV_SIZE) {
+            throw PBCStorageException("The backup " + snapshot.id + " is corrupted.");
+        }
+        Botan::SecureVector<Botan::byte> plain(content.begin() + IV_SIZE, content.end());
+        processAEAD(Botan::Cipher_Dir::DECRYPTION, cipherKey,
+                    reinterpret_cast<const Botan::byte*>(content.data()), chunk.id, plain);
+        if (plain.size() != chunk.size) {
+            throw PBCStorageException("The backup " + snapshot.id + " is corrupted.");
+        }
+        data.append(plain.begin(), plain.end());
+    }
+    return data;
+}
+
+/**
+ * @brief Removes the snapshots that the policy does not keep and the chunks
+ * that are not used by the remaining snapshots. The newest snapshot is always
+ * kept.
+ * @param policy The retention policy
+ * @param now The current time (seconds since the epoch)
+ * @return The removed snapshots
+ */
+std::vector<PBCBackupStore::Snapshot> PBCBackupStore::prune(const PBCBackupPolicy &policy, int64_t now) {
+    PBC_PERF_SCOPE("backup.prune");
+    const int64_t HOUR = 3600;
+    const int64_t DAY = 24 * HOUR;
+    std::vector<Snapshot> all = snapshots();
+    std::set<int64_t> keptHours;
+    std::set<int64_t> keptDays;
+    std::set<std::string> usedChunks;
+    std::vector<Snapshot> removed;
+    for (size_t i = 0; i < all.size(); ++i) {
+        const Snapshot& snapshot = all[i];
+        const int64_t age = now - snapshot.time;
+        const int64_t hour = snapshot.time / HOUR;
+        const int64_t day = snapshot.time / DAY;
+        bool keep = i == 0 || age < policy.keepAll.count();
+        if (!keep && age < policy.hourly * HOUR) {
+            keep = keptHours.count(hour) == 0;
+        } else if (!keep && age < policy.daily * DAY) {
+            keep = keptDays.count(day) == 0;
+        }
+        if (keep) {
+            keptHours.insert(hour);
+            keptDays.insert(day);
+            for (const Chunk& chunk : snapshot.chunks) {
+                usedChunks.insert(chunk.id);
+            }
+        } else if (QFile::remove(QString::fromStdString(snapshotFileName(snapshot.id)))) {
+            removed.push_back(snapshot);
+        }
+    }
+
+    // Chunks of corrupted snapshots are removed, too; they cannot be
+    // restored anyway.
+    QDir chunkDir(QString::fromStdString(_dirName + "/chunks"));
+    for (const QString& fileName : chunkDir.entryList(QDir::Files)) {
+        if (usedChunks.count(fileName.toStdString()) == 0) {
+            chunkDir.remove(fileName);
+        }
+    }
+    return removed;
+}
+
+/**
+ * @brief Counts the snapshots and the stored bytes
+ */
+PBCBackupStore::Statistics PBCBackupStore::statistics() const {
+    Statistics statistics;
+    for (const Snapshot& snapshot : snapshots()) {
+        ++statistics.snapshots;
+        statistics.snapshotBytes += snapshot.size();
+    }
+    for (const char* subDir : {"/chunks", "/snapshots"}) {
+        QDir dir(QString::fromStdString(_dirName + subDir));
+        for (const QFileInfo& info : dir.entryInfoList(QDir::Files)) {
+            statistics.storedBytes += info.size();
+            if (std::string(subDir) == "/chunks") {
+                ++statistics.chunks;
+            }
+        }
+    }
+    return statistics;
+}
@@ -0,0 +1,120 @@
+/** @file pbcBackupStore.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCBACKUPSTORE_H
+#define PBCBACKUPSTORE_H
+
+#include "util/pbcKeyDerivation.h"
+#include <botan/secmem.h>
+#include <botan/symkey.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief When snapshots are taken and how long they are kept
+ */
+struct PBCBackupPolicy {
+    bool enabled = true;
+    // the minimum time between two snapshots of automatic saves
+    std::chrono::seconds interval = std::chrono::minutes(5);
+    // all snapshots that are younger are kept
+    std::chrono::seconds keepAll = std::chrono::hours(1);
+    // of older snapshots, the newest of each of the last hours and days is kept
+    unsigned int hourly = 24;
+    unsigned int daily = 30;
+};
+
+/**
+ * @class PBCBackupStore
+ * @brief A store of snapshots of a playbook file, which is kept in a
+ * directory next to the file ("NAME.pbc.backups").
+ *
+ * The serialized playbook of a snapshot is split into chunks at
+ * content-defined boundaries, so an edit changes only the chunks around it.
+ * Chunks are stored once and shared by all snapshots that contain them, so
+ * the store grows with the changes, not with the size of the playbook. Each
+ * chunk is encrypted with a subkey of the key of the playbook file and named
+ * by a keyed hash of its content under another subkey. A snapshot lists its
+ * chunks in plain text (so they can be collected without a password), the
+ * version of Playbook Creator that has written it and the key derivation and
+ * salt of the key; its metadata is encrypted.
+ *
+ * The chunk names depend on the key, so chunks are only shared between
+ * snapshots with the same key. Every manual save (and every new password)
+ * derives a new key from a new salt, so the first snapshot after it stores
+ * all of its chunks again.
+ */
+class PBCBackupStore {
+ public:
+    struct Chunk {
+        std::string id;
+        uint32_t size;
+    };
+
+    struct Snapshot {
+        std::string id;
+        int64_t time;  // seconds since the epoch
+        std::string version;  // of Playbook Creator when the snapshot has been taken
+        PBCKdfSettings kdf;
+        Botan::SecureVector<Botan::byte> salt;
+        std::vector<Chunk> chunks;
+
+        uint64_t size() const;
+    };
+
+    struct Statistics {
+        unsigned int snapshots = 0;
+        unsigned int chunks = 0;
+        uint64_t storedBytes = 0;    // on disk
+        uint64_t snapshotBytes = 0;  // the sum of the sizes of the snapshots
+    };
+
+    explicit PBCBackupStore(const std::string& playbookFileName);
+
+    const std::string& dirName() const { return _dirName; }
+    std::vector<Snapshot> snapshots() const;
+    Snapshot snapshot(const std::string& id) const;
+    Snapshot write(const std::string& data,
+                   const std::string& metadata,
+                   const Botan::OctetString& key,
+                   const Botan::SecureVector<Botan::byte>& salt,
+                   const PBCKdfSettings& kdf,
+                   int64_t time);
+    std::string read(const Snapshot& snapshot,
+                     const Botan::OctetString& key,
+                     std::string* metadata = NULL) const;
+    std::vector<Snapshot> prune(const PBCBackupPolicy& policy, int64_t now);
+    Statistics statistics() const;
+
+    static std::vector<std::pair<size_t, size_t>> chunkBoundaries(const std::string& data);
+
+ private:
+    std::string _dirName;
+
+    std::string chunkFileName(const std::string& id) const;
+    std::string snapshotFileName(const std::string& id) const;
+    Snapshot readSnapshot(const std::string& id, std::string* header, std::string* encryptedMetadata) const;
+};
+
+#endif  // PBCBACKUPSTORE_H
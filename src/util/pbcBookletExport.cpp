@@ -0,0 +1,370 @@
+/** @file pbcBookletExport.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcBookletExport.h"
+#include "gui/pbcPlayRenderer.h"
+#include "util/pbcContentHash.h"
+#include "util/pbcConfig.h"
+#include "util/pbcDeclarations.h"
+#include "util/pbcExceptions.h"
+#include "util/pbcExportUtil.h"
+#include "util/pbcImageExport.h"
+#include "util/pbcLog.h"
+#include "util/pbcPerf.h"
+#include <boost/shared_ptr.hpp>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+const char PBCBookletExport::MANIFEST_FILE[] = "pbc-booklets.json";
+
+// the canvas size of the style whose hash is part of the settings (the look
+// of the plays must not depend on the current size of the main window)
+static const unsigned int REFERENCE_CANVAS_SIZE = 1000;
+
+/**
+ * @brief The booklet of a category or a role
+ */
+struct PBCBooklet {
+    std::string name;  // of the category or the role
+    std::string fileName;
+    std::vector<PBCPlaySP> plays;
+    QJsonObject entry;  // the manifest entry
+    boost::shared_ptr<PBCPDFExportJob> job;  // only set if the booklet is rebuilt
+    std::string error;
+};
+
+/**
+ * @brief Describes everything besides the plays that changes the booklets
+ */
+static QString layoutSettings(const PBCPDFLayout& layout) {
+    std::ostringstream settings;
+    settings << layout.columns << "x" << layout.rows << " "
+             << layout.paperWidth << "x" << layout.paperHeight << "mm "
+             << layout.marginLeft << " " << layout.marginRight << " "
+             << layout.marginTop << " " << layout.marginBottom << " "
+             << PBCExportUtil::hashString(PBCRenderStyle::fromConfig(REFERENCE_CANVAS_SIZE,
+                                                      REFERENCE_CANVAS_SIZE).contentHash()).toStdString();
+    if (layout.paperWidth == 0 || layout.paperHeight == 0) {
+        // the paper size is derived from the canvas size
+        settings << " " << PBCConfig::getInstance()->canvasWidth() << "x" << PBCConfig::getInstance()->canvasHeight();
+    }
+    return QString::fromStdString(settings.str());
+}
+
+/**
+ * @brief Creates the manifest entry of a booklet: its category and the plays
+ * on each of its pages
+ */
+static QJsonObject manifestEntry(const PBCBooklet& booklet, unsigned int playsPerPage) {
+    QJsonArray pages;
+    QJsonArray page;
+    for (const PBCPlaySP& play : booklet.plays) {
+        QJsonObject tile;
+        tile.insert("play", QString::fromStdString(play->name()));
+        tile.insert("hash", PBCExportUtil::hashString(play->contentHash()));
+        page.append(tile);
+        if (static_cast<unsigned int>(page.size()) == playsPerPage) {
+            pages.append(page);
+            page = QJsonArray();
+        }
+    }
+    if (page.isEmpty() == false) {
+        pages.append(page);
+    }
+    QJsonObject entry;
+    entry.insert("category", QString::fromStdString(booklet.name));
+    entry.insert("pages", pages);
+    return entry;
+}
+
+/**
+ * @brief Finds a file name for a booklet that differs (ignoring case) from
+ * the names that are used already
+ */
+static std::string uniqueFileName(const std::string& name, std::set<std::string>& usedNames) {  // NOLINT
+    const std::string base = PBCImageExport::fileName(name);
+    std::string fileName = base + ".pdf";
+    for (unsigned int i = 2; usedNames.count(QString::fromStdString(fileName).toLower().toStdString()) > 0; ++i) {
+        fileName = base + "-" + std::to_string(i) + ".pdf";
+    }
+    usedNames.insert(QString::fromStdString(fileName).toLower().toStdString());
+    return fileName;
+}
+
+/**
+ * @brief Runs the jobs of the booklets in parallel. The error of a failed
+ * booklet is stored in the booklet.
+ */
+static void buildBooklets(const std::vector<PBCBooklet*>& booklets, unsigned int threads) {
+    PBCExportUtil::parallelFor(booklets.size(), threads, [&](size_t i) {
+        if (booklets[i]->job == NULL) {
+            return;
+        }
+        PBC_PERF_SCOPE("booklets.build");
+        try {
+            booklets[i]->job->run();
+        } catch (std::exception& e) {
+            booklets[i]->error = e.what();
+        }
+    });
+}
+
+/**
+ * @brief Exports one PDF booklet per non-empty category into a directory.
+ * The plays of a booklet are ordered by name.
+ * @param playbook The playbook of the categories
+ * @param directory The directory into which the booklets are written. It is
+ * created if necessary.
+ * @param layout The page layout of the booklets
+ * @param threads The number of booklets that are built at the same time, 0
+ * means one per core
+ * @return The booklets that have been built, skipped or removed, and the
+ * failures
+ * @throws PBCStorageException if the directory or the manifest cannot be
+ * written
+ */
+PBCBookletReport PBCBookletExport::exportBooklets(PBCPlaybookSP playbook,
+                                                  const std::string& directory,
+                                                  const PBCPDFLayout& layout,
+                                                  unsigned int threads) {
+    PBC_PERF_SCOPE("booklets.export");
+    pbcAssert(layout.columns > 0 && layout.rows > 0);
+    QDir dir(QString::fromStdString(directory));
+    if (dir.mkpath(".") == false) {
+        throw PBCStorageException("Could not create the directory '" + directory + "'.");
+    }
+
+    const QString settings = layoutSettings(layout);
+    QJsonObject previousFiles;
+    bool sameSettings = false;
+    {
+        QFile file(dir.filePath(MANIFEST_FILE));
+        if (file.open(QIODevice::ReadOnly)) {
+            QJsonObject manifest = QJsonDocument::fromJson(file.readAll()).object();
+            previousFiles = manifest.value("booklets").toObject();
+            sameSettings = manifest.value("settings").toString() == settings;
+            if (sameSettings == false) {
+                PBC_LOG_INFO("booklets", "the layout has changed, all booklets are rebuilt");
+            }
+        }
+    }
+
+    // collect the booklets and their pages
+    const unsigned int playsPerPage = layout.columns * layout.rows;
+    std::vector<PBCBooklet> booklets;
+    std::set<std::string> usedNames;
+    for (const std::string& category : playbook->getCategoryNames()) {
+        std::set<PBCPlaySP> plays = playbook->playsInCategory(category);
+        if (plays.empty()) {
+            continue;
+        }
+        booklets.push_back(PBCBooklet());
+        PBCBooklet& booklet = booklets.back();
+        booklet.name = category;
+        booklet.plays.assign(plays.begin(), plays.end());
+        std::sort(booklet.plays.begin(), booklet.plays.end(), [](const PBCPlaySP& a, const PBCPlaySP& b) {
+            return a->name() < b->name();
+        });
+        booklet.fileName = uniqueFileName(category, usedNames);
+        booklet.entry = manifestEntry(booklet, playsPerPage);
+    }
+
+    PBCBookletReport report;
+    std::vector<PBCBooklet*> dirty;
+    for (PBCBooklet& booklet : booklets) {
+        const QString fileName = QString::fromStdString(booklet.fileName);
+        if (sameSettings &&
+            previousFiles.value(fileName).toObject() == booklet.entry &&
+            dir.exists(fileName)) {
+            report.skipped.push_back(dir.filePath(fileName).toStdString());
+            continue;
+        }
+        // the jobs read PBCConfig, so they are created here and only run on the workers
+        try {
+            booklet.job.reset(new PBCPDFExportJob(dir.filePath(fileName).toStdString(), booklet.plays, layout));
+        } catch (std::exception& e) {
+            booklet.error = e.what();
+        }
+        dirty.push_back(&booklet);
+    }
+
+    // remove the booklets of the categories that have been deleted or emptied
+    for (QJsonObject::const_iterator it = previousFiles.constBegin(); it != previousFiles.constEnd(); ++it) {
+        if (usedNames.count(it.key().toLower().toStdString()) == 0 && QFile::remove(dir.filePath(it.key()))) {
+            report.removed.push_back(dir.filePath(it.key()).toStdString());
+        }
+    }
+
+    buildBooklets(dirty, threads);
+
+    for (PBCBooklet* booklet : dirty) {
+        booklet->job.reset();
+        const std::string path = dir.filePath(QString::fromStdString(booklet->fileName)).toStdString();
+        if (booklet->error.empty()) {
+            report.written.push_back(path);
+        } else {
+            report.failures.push_back(std::make_pair(path, booklet->error));
+        }
+    }
+    PBC_LOG_INFO("booklets", report.written.size() << " booklets built, "
+                 << report.skipped.size() << " skipped, "
+                 << report.removed.size() << " removed");
+
+    if (sameSettings && dirty.empty() && report.removed.empty()) {
+        return report;  // the manifest is up to date
+    }
+    QJsonObject files;
+    for (const PBCBooklet& booklet : booklets) {
+        // failed booklets are left out, so that they are rebuilt next time
+        if (booklet.error.empty()) {
+            files.insert(QString::fromStdString(booklet.fileName), booklet.entry);
+        }
+    }
+    QJsonObject manifest;
+    manifest.insert("settings", settings);
+    manifest.insert("booklets", files);
+    PBCExportUtil::writeJson(dir, MANIFEST_FILE, manifest);
+    return report;
+}
+
+static bool hasRole(const PBCPlayGeometry& geometry, const std::string& role) {
+    for (const PBCPlayGeometry::Player& player : geometry.players) {
+        if (player.shortName == role) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Exports one PDF booklet per role into a directory (e.g.
+ * "role-WRL.pdf"). The booklet of a role contains the plays in which the
+ * role takes part, with the assignment of the role emphasized.
+ *
+ * The plays are laid out once and the geometries are shared by all
+ * booklets, so only painting is repeated for every role.
+ * @param plays The plays, in the order in which they are arranged in the
+ * booklets
+ * @param roles The short names of the roles (see PBCRole). If there are
+ * none, there is a booklet for every role of the plays' formations.
+ * @param directory The directory into which the booklets are written. It is
+ * created if necessary.
+ * @param layout The page layout of the booklets
+ * @param threads The number of booklets that are built at the same time, 0
+ * means one per core
+ * @return The booklets that have been built, and the booklets and plays that
+ * failed
+ * @throws PBCStorageException if the directory cannot be created
+ */
+PBCBookletReport PBCBookletExport::exportRoleBooklets(const std::vector<PBCPlaySP>& plays,
+                                                      const std::vector<std::string>& roles,
+                                                      const std::string& directory,
+                                                      const PBCPDFLayout& layout,
+                                                      unsigned int threads) {
+    PBC_PERF_SCOPE("booklets.exportRoles");
+    pbcAssert(layout.columns > 0 && layout.rows > 0);
+    QDir dir(QString::fromStdString(directory));
+    if (dir.mkpath(".") == false) {
+        throw PBCStorageException("Could not create the directory '" + directory + "'.");
+    }
+
+    // lay out every play once for all booklets
+    PBCBookletReport report;
+    const PBCRenderStyle style = PBCPDFExportJob::renderStyle(layout);
+    std::vector<PBCPlaySP> laidOutPlays;
+    std::vector<boost::shared_ptr<const PBCPlayGeometry>> geometries;
+    for (const PBCPlaySP& play : plays) {
+        try {
+            geometries.push_back(boost::shared_ptr<const PBCPlayGeometry>(
+                new PBCPlayGeometry(PBCPlayRenderer::layout(*play, style))));
+            laidOutPlays.push_back(play);
+        } catch (std::exception& e) {
+            report.failures.push_back(std::make_pair(play->name(), std::string(e.what())));
+        }
+    }
+
+    std::vector<std::string> bookletRoles = roles;
+    if (bookletRoles.empty()) {
+        std::set<std::string> allRoles;
+        for (const boost::shared_ptr<const PBCPlayGeometry>& geometry : geometries) {
+            for (const PBCPlayGeometry::Player& player : geometry->players) {
+                allRoles.insert(player.shortName);
+            }
+        }
+        bookletRoles.assign(allRoles.begin(), allRoles.end());
+    }
+
+    std::vector<PBCBooklet> booklets(bookletRoles.size());
+    std::vector<PBCBooklet*> jobs;
+    std::set<std::string> usedNames;
+    for (size_t r = 0; r < bookletRoles.size(); ++r) {
+        PBCBooklet& booklet = booklets[r];
+        booklet.name = bookletRoles[r];
+        booklet.fileName = uniqueFileName("role-" + booklet.name, usedNames);
+        std::vector<boost::shared_ptr<const PBCPlayGeometry>> bookletGeometries;
+        for (size_t i = 0; i < laidOutPlays.size(); ++i) {
+            if (hasRole(*geometries[i], booklet.name)) {
+                booklet.plays.push_back(laidOutPlays[i]);
+                bookletGeometries.push_back(geometries[i]);
+            }
+        }
+        jobs.push_back(&booklet);
+        if (booklet.plays.empty()) {
+            booklet.error = "None of the plays has a player with the role '" + booklet.name + "'.";
+            continue;
+        }
+        try {
+            booklet.job.reset(new PBCPDFExportJob(dir.filePath(QString::fromStdString(booklet.fileName)).toStdString(),
+                                                  booklet.plays,
+                                                  layout));
+            pbcAssert(booklet.job->style().contentHash() == style.contentHash());
+            booklet.job->setGeometries(bookletGeometries);
+            PBCRenderEmphasis emphasis;
+            emphasis.role = booklet.name;
+            booklet.job->setEmphasis(emphasis);
+        } catch (std::exception& e) {
+            booklet.error = e.what();
+        }
+    }
+
+    buildBooklets(jobs, threads);
+
+    for (PBCBooklet* booklet : jobs) {
+        booklet->job.reset();
+        const std::string path = dir.filePath(QString::fromStdString(booklet->fileName)).toStdString();
+        if (booklet->error.empty()) {
+            report.written.push_back(path);
+        } else {
+            report.failures.push_back(std::make_pair(path, booklet->error));
+        }
+    }
+    PBC_LOG_INFO("booklets", report.written.size() << " role booklets built from " << geometries.size() << " layouts");
+    return report;
+}
@@ -0,0 +1,77 @@
+/** @file pbcBookletExport.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCBOOKLETEXPORT_H
+#define PBCBOOKLETEXPORT_H
+
+#include "models/pbcPlaybook.h"
+#include "util/pbcPDFExportJob.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief The result of a booklet export
+ */
+struct PBCBookletReport {
+    std::vector<std::string> written;  // the booklets that have been (re-)built
+    std::vector<std::string> skipped;  // the booklets whose plays have not changed
+    std::vector<std::string> removed;  // the booklets of categories that no longer exist (or are empty)
+    // the booklets (or the plays of role booklets) that could not be built, with the reason
+    std::vector<std::pair<std::string, std::string>> failures;
+};
+
+/**
+ * @class PBCBookletExport
+ * @brief Exports one PDF booklet per category into a directory.
+ *
+ * The directory contains a manifest (MANIFEST_FILE) which records which
+ * plays, with which content hashes, are on which page of which booklet.
+ * Exporting into the same directory again only rebuilds the booklets whose
+ * pages would change, so a rebuild after editing a single play usually
+ * writes a single file and a rebuild without changes writes none at all.
+ * Changing the layout or the look of the plays rebuilds all booklets.
+ *
+ * Role booklets (exportRoleBooklets()) contain the plays of one position
+ * with its assignment emphasized (see PBCRenderEmphasis). They are always
+ * rebuilt, but every play is laid out only once for all roles.
+ *
+ * The booklets that have to be built are rendered in parallel, one
+ * PBCPDFExportJob per booklet. The export reads the plays and PBCConfig, so
+ * it must be started on the GUI thread (or without a GUI at all) and the
+ * plays must not be modified meanwhile.
+ */
+class PBCBookletExport {
+ public:
+    static const char MANIFEST_FILE[];
+
+    static PBCBookletReport exportBooklets(PBCPlaybookSP playbook,
+                                           const std::string& directory,
+                                           const PBCPDFLayout& layout,
+                                           unsigned int threads = 0);
+    static PBCBookletReport exportRoleBooklets(const std::vector<PBCPlaySP>& plays,
+                                               const std::vector<std::string>& roles,
+                                               const std::string& directory,
+                                               const PBCPDFLayout& layout,
+                                               unsigned int threads = 0);
+};
+
+#endif  // PBCBOOKLETEXPORT_H
@@ -0,0 +1,203 @@
+/** @file pbcContentHash.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcContentHash.h"
+#include <boost/weak_ptr.hpp>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+const PBCHash PBCContentHash::EMPTY;
+
+/**
+ * @brief Hashes a sequence of bytes (FNV-1a)
+ * @param data The bytes to hash
+ * @param size The number of bytes
+ * @param seed The hash to continue from
+ * @return the hash
+ */
+PBCHash PBCContentHash::bytes(const void *data, size_t size, PBCHash seed) {
+    const unsigned char* byte = static_cast<const unsigned char*>(data);
+    PBCHash hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= byte[i];
+        hash *= 0x100000001b3ULL;  // FNV-1a prime
+    }
+    return hash;
+}
+
+/**
+ * @brief Hashes a string including its length, so that the concatenation of
+ * two strings cannot collide with a different split of the same characters.
+ */
+PBCHash PBCContentHash::string(const std::string &value, PBCHash seed) {
+    PBCHash hash = number(static_cast<uint64_t>(value.size()), seed);
+    return bytes(value.data(), value.size(), hash);
+}
+
+/**
+ * @brief Hashes an unsigned integer independent of the platform's endianness
+ */
+PBCHash PBCContentHash::number(uint64_t value, PBCHash seed) {
+    unsigned char buffer[8];
+    for (unsigned int i = 0; i < 8; ++i) {
+        buffer[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+    return bytes(buffer, sizeof(buffer), seed);
+}
+
+/**
+ * @brief Hashes a floating point number by its bit pattern. 0.0 and -0.0 are
+ * treated as equal.
+ */
+PBCHash PBCContentHash::number(double value, PBCHash seed) {
+    if (value == 0.0) {
+        value = 0.0;
+    }
+    uint64_t bits;
+    static_assert(sizeof(bits) == sizeof(value), "unexpected size of double");
+    std::memcpy(&bits, &value, sizeof(bits));
+    return number(bits, seed);
+}
+
+/**
+ * @brief Combines a hash with the hash of a child object. The order of
+ * combination matters.
+ */
+PBCHash PBCContentHash::combine(PBCHash seed, PBCHash value) {
+    // finalizer of MurmurHash3, so that similar child hashes spread well
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return number(value, seed);
+}
+
+/**
+ * @brief The shared part of a cache, which its children link to
+ */
+struct PBCHashCache::Node {
+    bool hashValid = false;
+    // the caches that have combined this hash (pointers only for comparison)
+    std::vector<std::pair<const Node*, boost::weak_ptr<Node>>> parents;
+};
+
+thread_local const boost::shared_ptr<PBCHashCache::Node>* PBCHashCache::_currentParent = NULL;
+
+/**
+ * @brief Marks the combined hash of a node and of all its ancestors as dirty.
+ * An ancestor of a dirty node is always dirty, so the walk stops there.
+ */
+void PBCHashCache::markDirty(Node& node) {  // NOLINT
+    if (node.hashValid == false) {
+        return;
+    }
+    node.hashValid = false;
+    auto parents = std::move(node.parents);
+    node.parents.clear();
+    for (const auto& parent : parents) {
+        boost::shared_ptr<Node> locked = parent.second.lock();
+        if (locked != NULL) {
+            markDirty(*locked);
+        }
+    }
+}
+
+PBCHashCache::PBCHashCache() :
+    _node(new Node()),
+    _ownHash(0),
+    _hash(0),
+    _ownHashValid(false) {}
+
+/**
+ * @brief Copies the own hash. The combined hash is computed again, because
+ * the copy is not linked to the children yet.
+ */
+PBCHashCache::PBCHashCache(const PBCHashCache &other) :
+    _node(new Node()),
+    _ownHash(other._ownHash),
+    _hash(0),
+    _ownHashValid(other._ownHashValid) {}
+
+/**
+ * @brief Copies the own hash of another object whose content is assigned to
+ * this object. The parents of this object are marked as dirty.
+ */
+PBCHashCache &PBCHashCache::operator=(const PBCHashCache &other) {
+    _ownHash = other._ownHash;
+    _ownHashValid = other._ownHashValid;
+    markDirty(*_node);
+    _node->hashValid = false;
+    return *this;
+}
+
+/**
+ * @brief Marks the own hash of the object as dirty. Must be called by every
+ * mutator of a model object.
+ */
+void PBCHashCache::invalidate() {
+    _ownHashValid = false;
+    markDirty(*_node);
+}
+
+bool PBCHashCache::valid() const {
+    return _ownHashValid && _node->hashValid;
+}
+
+void PBCHashCache::validate() const {
+    _node->hashValid = true;
+}
+
+/**
+ * @brief Links the cache to the cache that is currently combining the
+ * hashes of its children (if any)
+ */
+void PBCHashCache::attachToParent() const {
+    if (_currentParent == NULL) {
+        return;
+    }
+    const Node* parent = _currentParent->get();
+    std::vector<std::pair<const Node*, boost::weak_ptr<Node>>>& parents = _node->parents;
+    // a pointer is only compared while its node is alive, it may be reused afterwards
+    parents.erase(std::remove_if(parents.begin(), parents.end(),
+                                 [](const std::pair<const Node*, boost::weak_ptr<Node>>& link) {
+                                     return link.second.expired();
+                                 }),
+                  parents.end());
+    for (const auto& link : parents) {
+        if (link.first == parent) {
+            return;
+        }
+    }
+    parents.push_back(std::make_pair(parent, boost::weak_ptr<Node>(*_currentParent)));
+}
+
+PBCHashCache::ParentScope::ParentScope(const PBCHashCache &cache) :
+    _previous(_currentParent) {
+    _currentParent = &cache._node;
+}
+
+PBCHashCache::ParentScope::~ParentScope() {
+    _currentParent = _previous;
+}
@@ -0,0 +1,140 @@
+/** @file pbcContentHash.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCCONTENTHASH_H
+#define PBCCONTENTHASH_H
+
+#include <boost/shared_ptr.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief A 64 bit content hash of a model object
+ */
+typedef uint64_t PBCHash;
+
+/**
+ * @class PBCContentHash
+ * @brief Helper functions to compute content hashes of model objects.
+ *
+ * The hashes are stable across runs and platforms (they never depend on
+ * pointer values), so they can be used as cache keys and can be compared
+ * between different playbooks.
+ */
+class PBCContentHash {
+ public:
+    static const PBCHash EMPTY = 0xcbf29ce484222325ULL;  // FNV-1a offset basis
+
+    static PBCHash bytes(const void* data, size_t size, PBCHash seed = EMPTY);
+    static PBCHash string(const std::string& value, PBCHash seed = EMPTY);
+    static PBCHash number(uint64_t value, PBCHash seed = EMPTY);
+    static PBCHash number(double value, PBCHash seed = EMPTY);
+    static PBCHash combine(PBCHash seed, PBCHash value);
+};
+
+/**
+ * @class PBCHashCache
+ * @brief Caches the content hash of a model object.
+ *
+ * The hash of an object consists of the hash of its own fields ("own hash")
+ * combined with the hashes of its children (e.g. a player's routes). Every
+ * mutator of a model object calls invalidate(), which marks the own hash of
+ * that object as dirty and the combined hashes of all objects whose hash has
+ * been combined from it, up to the playbook.
+ *
+ * A child learns its parents when they combine its hash, so no back pointers
+ * are needed in the model (routes are shared between many players). The
+ * links are weak, and a link to an object that does not use the child
+ * anymore only causes one unnecessary recombination. So when a hash is
+ * requested, only the objects on the dirty path recompute their hash; all
+ * other children return their cached hashes.
+ *
+ * The cache is not synchronized. The hashes of a model must only be
+ * requested by one thread at a time while nobody modifies it, i.e. on the
+ * GUI thread for the active playbook. A worker thread may only hash a model
+ * that is not shared yet (e.g. one that is being loaded by PBCLoadJob).
+ */
+class PBCHashCache {
+ private:
+    struct Node;
+
+    // the cache whose children are currently combined on this thread
+    static thread_local const boost::shared_ptr<Node>* _currentParent;
+
+    boost::shared_ptr<Node> _node;
+    mutable PBCHash _ownHash;
+    mutable PBCHash _hash;
+    mutable bool _ownHashValid;
+
+    static void markDirty(Node& node);  // NOLINT
+    bool valid() const;
+    void validate() const;
+    void attachToParent() const;
+
+    /**
+     * @brief Makes the cache the parent of all caches that are requested
+     * during its lifetime (on the same thread)
+     */
+    class ParentScope {
+     private:
+        const boost::shared_ptr<Node>* _previous;
+
+     public:
+        explicit ParentScope(const PBCHashCache& cache);
+        ~ParentScope();
+        ParentScope(const ParentScope&) = delete;
+        ParentScope& operator=(const ParentScope&) = delete;
+    };
+
+ public:
+    PBCHashCache();
+    PBCHashCache(const PBCHashCache& other);
+    PBCHashCache& operator=(const PBCHashCache& other);
+    void invalidate();
+
+    /**
+     * @brief Returns the cached hash or recomputes it
+     * @param ownHash A function that hashes the object's own fields
+     * @param combineChildren A function that combines the own hash with
+     * the hashes of the object's children
+     * @return the content hash
+     */
+    template<typename OwnHashFn, typename CombineFn>
+    PBCHash get(OwnHashFn ownHash, CombineFn combineChildren) const {
+        attachToParent();
+        if (valid()) {
+            return _hash;
+        }
+        if (!_ownHashValid) {
+            _ownHash = ownHash();
+            _ownHashValid = true;
+        }
+        {
+            ParentScope scope(*this);
+            _hash = combineChildren(_ownHash);
+        }
+        validate();
+        return _hash;
+    }
+};
+
+#endif  // PBCCONTENTHASH_H
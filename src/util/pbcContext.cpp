@@ -0,0 +1,72 @@
+/** @file pbcContext.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcContext.h"
+#include <atomic>
+#include <stddef.h>
+
+static thread_local PBCContext* boundContext = NULL;
+static std::atomic<uint64_t> nextContextId(1);
+
+PBCContext::PBCContext() :
+    _id(nextContextId.fetch_add(1, std::memory_order_relaxed)) {}
+
+/**
+ * @brief The destructor. Destroys the services in reverse order of their
+ * creation, so that a service outlives the services that use it.
+ */
+PBCContext::~PBCContext() {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    for (auto it = _creationOrder.rbegin(); it != _creationOrder.rend(); ++it) {
+        _services.erase(*it);
+    }
+}
+
+/**
+ * @brief The context of the application. It is never destroyed, so services
+ * can be used until the process exits (like the former singletons).
+ * @return the global context
+ */
+PBCContext& PBCContext::global() {
+    static PBCContext* globalContext = new PBCContext();
+    return *globalContext;
+}
+
+/**
+ * @brief The context that is bound to the calling thread
+ * @return the bound context or the global context if no context is bound
+ */
+PBCContext& PBCContext::current() {
+    if (boundContext != NULL) {
+        return *boundContext;
+    }
+    return global();
+}
+
+
+PBCContextScope::PBCContextScope(PBCContext &context) :
+    _previous(boundContext) {
+    boundContext = &context;
+}
+
+PBCContextScope::~PBCContextScope() {
+    boundContext = _previous;
+}
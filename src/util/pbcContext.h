@@ -0,0 +1,127 @@
+/** @file pbcContext.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCCONTEXT_H
+#define PBCCONTEXT_H
+
+#include <boost/shared_ptr.hpp>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <typeindex>
+#include <typeinfo>
+#include <vector>
+
+/**
+ * @class PBCContext
+ * @brief A thread-safe registry that owns the application's services
+ * (PBCController with the active playbook, PBCStorage, PBCConfig and
+ * PBCPositionTranslator).
+ *
+ * Every service exists at most once per context. It is created on its first
+ * request and destroyed together with the context (in reverse order of
+ * creation). PBCSingleton<T>::getInstance() returns the service of the context
+ * that is bound to the calling thread (see PBCContextScope) or of the global
+ * context if no context is bound. So several playbooks can be loaded, edited
+ * and saved concurrently in one process by running each of them on a thread
+ * with its own context.
+ *
+ * Every context has an id that is unique in the process, even if a context
+ * is created at the address of a destroyed one. PBCSingleton uses it to
+ * cache the services per thread, so only the first request of a service on
+ * a thread takes the lock.
+ */
+class PBCContext {
+ private:
+    const uint64_t _id;
+    std::recursive_mutex _mutex;
+    std::map<std::type_index, boost::shared_ptr<void>> _services;
+    std::vector<std::type_index> _creationOrder;
+
+    PBCContext(const PBCContext& other) = delete;
+    PBCContext& operator=(const PBCContext& other) = delete;
+
+ public:
+    PBCContext();
+    ~PBCContext();
+
+    static PBCContext& global();
+    static PBCContext& current();
+
+    uint64_t id() const { return _id; }
+
+    /**
+     * @brief Returns the service of type T and creates it if necessary.
+     *
+     * The service is created while holding the context's lock, so
+     * concurrent first requests get the same instance. The lock is
+     * recursive, so a service may request other services in its
+     * constructor.
+     * @param create A function returning a new instance of T
+     * @return The service
+     */
+    template<class T, class Factory>
+    T* service(Factory create) {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        auto it = _services.find(std::type_index(typeid(T)));
+        if (it != _services.end()) {
+            return static_cast<T*>(it->second.get());
+        }
+        T* instance = create();
+        _services[std::type_index(typeid(T))] =
+                boost::shared_ptr<void>(instance, [](void* service) { delete static_cast<T*>(service); });
+        _creationOrder.push_back(std::type_index(typeid(T)));
+        return instance;
+    }
+
+    /**
+     * @brief Returns the service of type T of this context, independent of
+     * the context that is bound to the calling thread
+     * @return The service
+     */
+    template<class T>
+    T* get();
+};
+
+/**
+ * @class PBCContextScope
+ * @brief Binds a context to the current thread for the lifetime of the scope.
+ * The previously bound context is restored afterwards.
+ */
+class PBCContextScope {
+ private:
+    PBCContext* _previous;
+
+    PBCContextScope(const PBCContextScope& other) = delete;
+    PBCContextScope& operator=(const PBCContextScope& other) = delete;
+
+ public:
+    explicit PBCContextScope(PBCContext& context);  // NOLINT
+    ~PBCContextScope();
+};
+
+template<class T>
+T* PBCContext::get() {
+    PBCContextScope scope(*this);
+    return T::getInstance();
+}
+
+#endif  // PBCCONTEXT_H
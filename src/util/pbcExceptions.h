@@ -154,4 +154,26 @@ public:
             PBCStorageException("Cannot save playbook automatically. The playbook must be saved manually first " + msg) {}
 };
 
+/**
+ * @class PBCSaveException
+ * @brief An exception that is thrown when a playbook could not be written to
+ * its file. The file keeps its previous content.
+ */
+class PBCSaveException : public PBCStorageException {
+public:
+    explicit PBCSaveException(const std::string& msg = "") :
+            PBCStorageException("Could not save the playbook. The playbook file has not been changed: " + msg) {}
+};
+
+/**
+ * @class PBCCancelledException
+ * @brief An exception that is thrown when the user has cancelled a running
+ * storage operation (see PBCLoadJob).
+ */
+class PBCCancelledException : public PBCStorageException {
+public:
+    explicit PBCCancelledException(const std::string& msg = "") :
+            PBCStorageException("The operation has been cancelled. " + msg) {}
+};
+
 #endif  // PBCEXCEPTIONS_H
@@ -0,0 +1,109 @@
+/** @file pbcExportUtil.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcExportUtil.h"
+#include "util/pbcExceptions.h"
+#include <QFontDatabase>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Formats a content hash for a manifest
+ */
+QString PBCExportUtil::hashString(PBCHash hash) {
+    return QString::number(static_cast<qulonglong>(hash), 16);
+}
+
+/**
+ * @brief Writes a JSON document (e.g. a manifest) atomically, so an
+ * interrupted export leaves the previous version
+ * @param directory The directory of the file
+ * @param name The name of the file
+ * @param object The content
+ * @throws PBCStorageException if the file cannot be written
+ */
+void PBCExportUtil::writeJson(const QDir &directory, const QString &name, const QJsonObject &object) {
+    const QString path = directory.filePath(name);
+    QSaveFile file(path);
+    if (file.open(QIODevice::WriteOnly) == false ||
+        file.write(QJsonDocument(object).toJson()) < 0 ||
+        file.commit() == false) {
+        throw PBCStorageException(path.toStdString() + ": " + file.errorString().toStdString());
+    }
+}
+
+/**
+ * @brief Calls a function for the indices 0 to count - 1 on several threads.
+ * The calling thread is one of them. The indices are handed out one at a time,
+ * so slow tasks do not hold up the others.
+ *
+ * The tasks usually draw text, so they run on one thread only if the
+ * platform cannot render fonts outside of the GUI thread.
+ * @param count The number of tasks
+ * @param threads The maximum number of threads, 0 means one per core
+ * @param function The task. If it throws, the remaining tasks are still run
+ * and the first exception is rethrown afterwards.
+ */
+void PBCExportUtil::parallelFor(size_t count,
+                                unsigned int threads,
+                                const std::function<void(size_t)> &function) {
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    if (QFontDatabase::supportsThreadedFontRendering() == false) {
+        threads = 1;
+    }
+    threads = std::min<size_t>(threads, std::max<size_t>(count, 1));
+
+    std::atomic<size_t> next(0);
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    auto work = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                function(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned int i = 1; i < threads; ++i) {
+        workers.push_back(std::thread(work));
+    }
+    work();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
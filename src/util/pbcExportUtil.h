@@ -0,0 +1,44 @@
+/** @file pbcExportUtil.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCEXPORTUTIL_H
+#define PBCEXPORTUTIL_H
+
+#include "util/pbcContentHash.h"
+#include <QDir>
+#include <QJsonObject>
+#include <QString>
+#include <cstddef>
+#include <functional>
+
+/**
+ * @class PBCExportUtil
+ * @brief Helpers that are shared by the exports which write a directory of
+ * files with a manifest (see PBCImageExport and PBCBookletExport).
+ */
+class PBCExportUtil {
+ public:
+    static QString hashString(PBCHash hash);
+    static void writeJson(const QDir& directory, const QString& name, const QJsonObject& object);
+    static void parallelFor(size_t count, unsigned int threads, const std::function<void(size_t)>& function);
+};
+
+#endif  // PBCEXPORTUTIL_H
@@ -0,0 +1,348 @@
+/** @file pbcImageExport.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcImageExport.h"
+#include "gui/pbcPlayRenderer.h"
+#include "util/pbcDeclarations.h"
+#include "util/pbcExceptions.h"
+#include "util/pbcExportUtil.h"
+#include "util/pbcLog.h"
+#include "util/pbcPerf.h"
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QPicture>
+#include <QSaveFile>
+#include <QSvgGenerator>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+const char PBCImageExport::MANIFEST_FILE[] = "pbc-manifest.json";
+const char PBCImageExport::SPRITE_INDEX_FILE[] = "sprites.json";
+
+// SVG images are measured in CSS pixels
+static const unsigned int SVG_DPI = 96;
+
+/**
+ * @brief A file of the export and the plays in it
+ */
+struct PBCImageFile {
+    std::string name;
+    std::vector<PBCPlaySP> plays;
+    std::vector<PBCHash> hashes;
+    QPicture picture;  // the recorded play of an SVG image
+    std::string error;
+};
+
+/**
+ * @brief Reads the entries of the manifest of a previous export
+ * @return The entries by file name, or nothing if there is no manifest or it
+ * has been written with other settings
+ */
+static std::map<std::string, QJsonObject> readManifest(const QDir& directory, const QString& settings) {
+    std::map<std::string, QJsonObject> entries;
+    QFile file(directory.filePath(PBCImageExport::MANIFEST_FILE));
+    if (file.open(QIODevice::ReadOnly) == false) {
+        return entries;
+    }
+    QJsonObject manifest = QJsonDocument::fromJson(file.readAll()).object();
+    if (manifest.value("settings").toString() != settings) {
+        PBC_LOG_INFO("images", "the settings have changed, all images are rewritten");
+        return entries;
+    }
+    QJsonObject files = manifest.value("files").toObject();
+    for (QJsonObject::const_iterator it = files.constBegin(); it != files.constEnd(); ++it) {
+        entries[it.key().toStdString()] = it.value().toObject();
+    }
+    return entries;
+}
+
+static QJsonObject manifestEntry(const PBCImageFile& file) {
+    QJsonArray plays;
+    QJsonArray hashes;
+    for (size_t i = 0; i < file.plays.size(); ++i) {
+        plays.append(QString::fromStdString(file.plays[i]->name()));
+        hashes.append(PBCExportUtil::hashString(file.hashes[i]));
+    }
+    QJsonObject entry;
+    entry.insert("plays", plays);
+    entry.insert("hashes", hashes);
+    return entry;
+}
+
+/**
+ * @brief Renders the plays of a PNG image or a sprite sheet and writes it, or
+ * records the play of an SVG image (which is written afterwards, because
+ * QSvgGenerator must not be used on worker threads)
+ */
+static void renderFile(PBCImageFile& file,
+                       const PBCRenderStyle& style,
+                       const PBCImageExportOptions& options,
+                       const QDir& directory) {
+    PBC_PERF_SCOPE("images.render");
+    const QSizeF tile(style.canvasWidth, style.canvasHeight);
+    if (options.format == PBCImageExportOptions::SVG) {
+        QPainter painter(&file.picture);
+        painter.setRenderHint(QPainter::Antialiasing);
+        PBCPlayRenderer::render(&painter, *file.plays.front(), style, QRectF(QPointF(0, 0), tile));
+        return;
+    }
+
+    const unsigned int columns = options.format == PBCImageExportOptions::SPRITE_SHEET ? options.columns : 1;
+    const unsigned int rows = (file.plays.size() + columns - 1) / columns;
+    QImage image(columns * style.canvasWidth, rows * style.canvasHeight, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    const int dotsPerMeter = std::lround(options.dpi / 0.0254);
+    image.setDotsPerMeterX(dotsPerMeter);
+    image.setDotsPerMeterY(dotsPerMeter);
+    {
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setRenderHint(QPainter::TextAntialiasing);
+        for (size_t i = 0; i < file.plays.size(); ++i) {
+            QPointF position((i % columns) * tile.width(), (i / columns) * tile.height());
+            PBCPlayRenderer::render(&painter, *file.plays[i], style, QRectF(position, tile));
+        }
+    }
+
+    const QString path = directory.filePath(QString::fromStdString(file.name));
+    QSaveFile output(path);
+    if (output.open(QIODevice::WriteOnly) == false ||
+        image.save(&output, "PNG") == false ||
+        output.commit() == false) {
+        throw PBCStorageException(path.toStdString() + ": " + output.errorString().toStdString());
+    }
+}
+
+static void writeSvg(PBCImageFile& file, const PBCRenderStyle& style, const QDir& directory) {
+    const QString path = directory.filePath(QString::fromStdString(file.name));
+    QSaveFile output(path);
+    if (output.open(QIODevice::WriteOnly) == false) {
+        throw PBCStorageException(path.toStdString() + ": " + output.errorString().toStdString());
+    }
+    QSvgGenerator generator;
+    generator.setOutputDevice(&output);
+    generator.setSize(QSize(style.canvasWidth, style.canvasHeight));
+    generator.setViewBox(QRect(0, 0, style.canvasWidth, style.canvasHeight));
+    generator.setResolution(SVG_DPI);
+    generator.setTitle(QString::fromStdString(file.plays.front()->name()));
+    {
+        QPainter painter(&generator);
+        painter.drawPicture(0, 0, file.picture);
+    }
+    if (output.commit() == false) {
+        throw PBCStorageException(path.toStdString() + ": " + output.errorString().toStdString());
+    }
+}
+
+/**
+ * @brief Derives a file name (without extension) from the name of a play.
+ * Characters that are not allowed in file names on some platforms are
+ * replaced by '_'.
+ */
+std::string PBCImageExport::fileName(const std::string &playName) {
+    std::string name;
+    for (char c : playName) {
+        bool allowed = std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == ' ';
+        name += allowed ? c : '_';
+    }
+    if (name.empty()) {
+        name = "play";
+    }
+    return name;
+}
+
+/**
+ * @brief Exports plays as images into a directory
+ * @param playbook The playbook of the plays
+ * @param playNames The plays to export, in the order in which they are
+ * packed into sprite sheets
+ * @param directory The directory into which the images are written. It is
+ * created if necessary.
+ * @param options The format and size of the images
+ * @return The files that have been written or skipped, and the failures
+ * @throws PBCStorageException if the manifest or the sprite index cannot be
+ * written
+ */
+PBCImageExportReport PBCImageExport::exportPlays(PBCPlaybookSP playbook,
+                                                 const std::vector<std::string>& playNames,
+                                                 const std::string& directory,
+                                                 const PBCImageExportOptions& options) {
+    PBC_PERF_SCOPE("images.export");
+    pbcAssert(options.height > 0);
+    pbcAssert(options.columns > 0 && options.rows > 0);
+    pbcAssert(options.dpi >= PBCImageExportOptions::MIN_DPI && options.dpi <= PBCImageExportOptions::MAX_DPI);
+    QDir dir(QString::fromStdString(directory));
+    if (dir.mkpath(".") == false) {
+        throw PBCStorageException("Could not create the directory '" + directory + "'.");
+    }
+
+    const unsigned int dpi = options.format == PBCImageExportOptions::SVG ? SVG_DPI : options.dpi;
+    const unsigned int pixels = std::max(1L, std::lround(options.height / 25.4 * dpi));
+    const PBCRenderStyle style = PBCRenderStyle::fromConfig(pixels, pixels);
+    const char* formatNames[] = {"png", "svg", "sprites"};
+    const QString settings = QString("%1 %2dpi %3mm %4x%5 %6").arg(
+            formatNames[options.format],
+            QString::number(dpi),
+            QString::number(options.height),
+            QString::number(options.columns),
+            QString::number(options.rows),
+            PBCExportUtil::hashString(style.contentHash()));
+    std::map<std::string, QJsonObject> manifest = readManifest(dir, settings);
+
+    // distribute the plays to the files
+    std::vector<PBCImageFile> files;
+    if (options.format == PBCImageExportOptions::SPRITE_SHEET) {
+        const size_t playsPerSheet = options.columns * options.rows;
+        for (size_t i = 0; i < playNames.size(); ++i) {
+            if (i % playsPerSheet == 0) {
+                files.push_back(PBCImageFile());
+                files.back().name = "sheet-" + std::to_string(files.size()) + ".png";
+            }
+            PBCPlaySP play = playbook->getPlay(playNames[i]);
+            pbcAssert(play != NULL);
+            files.back().plays.push_back(play);
+            files.back().hashes.push_back(play->contentHash());
+        }
+    } else {
+        const std::string extension = options.format == PBCImageExportOptions::SVG ? ".svg" : ".png";
+        // plays keep the files of the previous export, new plays get unused names
+        std::map<std::string, std::string> previousFiles;
+        std::set<std::string> usedNames;
+        for (const auto& kv : manifest) {
+            QJsonArray plays = kv.second.value("plays").toArray();
+            if (plays.size() == 1) {
+                previousFiles[plays.first().toString().toStdString()] = kv.first;
+            }
+            usedNames.insert(QString::fromStdString(kv.first).toLower().toStdString());
+        }
+        for (const std::string& playName : playNames) {
+            PBCPlaySP play = playbook->getPlay(playName);
+            pbcAssert(play != NULL);
+            files.push_back(PBCImageFile());
+            PBCImageFile& file = files.back();
+            file.plays.push_back(play);
+            file.hashes.push_back(play->contentHash());
+            auto previous = previousFiles.find(playName);
+            if (previous != previousFiles.end()) {
+                file.name = previous->second;
+                continue;
+            }
+            const std::string base = fileName(playName);
+            file.name = base + extension;
+            for (unsigned int i = 2; usedNames.count(QString::fromStdString(file.name).toLower().toStdString()) > 0; ++i) {  // NOLINT
+                file.name = base + "-" + std::to_string(i) + extension;
+            }
+            usedNames.insert(QString::fromStdString(file.name).toLower().toStdString());
+        }
+    }
+
+    PBCImageExportReport report;
+    std::vector<PBCImageFile*> dirty;
+    for (PBCImageFile& file : files) {
+        auto entry = manifest.find(file.name);
+        if (entry != manifest.end() &&
+            entry->second == manifestEntry(file) &&
+            dir.exists(QString::fromStdString(file.name))) {
+            report.skipped.push_back(dir.filePath(QString::fromStdString(file.name)).toStdString());
+        } else {
+            dirty.push_back(&file);
+        }
+    }
+
+    // render the changed files in parallel
+    PBCExportUtil::parallelFor(dirty.size(), options.threads, [&](size_t i) {
+        try {
+            renderFile(*dirty[i], style, options, dir);
+        } catch (std::exception& e) {
+            dirty[i]->error = e.what();
+        }
+    });
+
+    for (PBCImageFile* file : dirty) {
+        if (file->error.empty() && options.format == PBCImageExportOptions::SVG) {
+            try {
+                writeSvg(*file, style, dir);
+            } catch (std::exception& e) {
+                file->error = e.what();
+            }
+        }
+        const std::string path = dir.filePath(QString::fromStdString(file->name)).toStdString();
+        if (file->error.empty()) {
+            report.written.push_back(path);
+        } else {
+            report.failures.push_back(std::make_pair(path, file->error));
+            manifest.erase(file->name);
+        }
+    }
+
+    QJsonObject manifestFiles;
+    for (const auto& kv : manifest) {
+        manifestFiles.insert(QString::fromStdString(kv.first), kv.second);
+    }
+    for (const PBCImageFile& file : files) {
+        if (file.error.empty()) {
+            manifestFiles.insert(QString::fromStdString(file.name), manifestEntry(file));
+        }
+    }
+    QJsonObject manifestObject;
+    manifestObject.insert("settings", settings);
+    manifestObject.insert("files", manifestFiles);
+    PBCExportUtil::writeJson(dir, MANIFEST_FILE, manifestObject);
+
+    if (options.format == PBCImageExportOptions::SPRITE_SHEET) {
+        QJsonArray sheets;
+        for (const PBCImageFile& file : files) {
+            QJsonArray plays;
+            for (size_t i = 0; i < file.plays.size(); ++i) {
+                QJsonObject play;
+                play.insert("name", QString::fromStdString(file.plays[i]->name()));
+                play.insert("codeName", QString::fromStdString(file.plays[i]->codeName()));
+                play.insert("x", static_cast<int>((i % options.columns) * style.canvasWidth));
+                play.insert("y", static_cast<int>((i / options.columns) * style.canvasHeight));
+                play.insert("width", static_cast<int>(style.canvasWidth));
+                play.insert("height", static_cast<int>(style.canvasHeight));
+                plays.append(play);
+            }
+            QJsonObject sheet;
+            sheet.insert("file", QString::fromStdString(file.name));
+            sheet.insert("plays", plays);
+            sheets.append(sheet);
+        }
+        QJsonObject index;
+        index.insert("dpi", static_cast<int>(dpi));
+        index.insert("sheets", sheets);
+        PBCExportUtil::writeJson(dir, SPRITE_INDEX_FILE, index);
+    }
+
+    PBC_LOG_INFO("images", report.written.size() << " images written, " << report.skipped.size()
+                 << " unchanged, " << report.failures.size() << " failed");
+    return report;
+}
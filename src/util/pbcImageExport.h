@@ -0,0 +1,88 @@
+/** @file pbcImageExport.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCIMAGEEXPORT_H
+#define PBCIMAGEEXPORT_H
+
+#include "models/pbcPlaybook.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief The settings of an image export
+ */
+struct PBCImageExportOptions {
+    enum Format {
+        PNG,          // one PNG image per play
+        SVG,          // one SVG image per play
+        SPRITE_SHEET  // PNG images with a grid of plays and a JSON index
+    };
+
+    static const unsigned int MIN_DPI = 30;
+    static const unsigned int MAX_DPI = 1200;
+
+    Format format = PNG;
+    unsigned int dpi = 150;  // the resolution of PNG images and sprite sheets, from MIN_DPI to MAX_DPI
+    double height = 80;  // the height of one play in millimeters
+    unsigned int columns = 4;  // the size of the grid of a sprite sheet
+    unsigned int rows = 4;
+    unsigned int threads = 0;  // the number of render threads, 0 means one per core
+};
+
+/**
+ * @brief The result of an image export
+ */
+struct PBCImageExportReport {
+    std::vector<std::string> written;  // the files that have been (re-)written
+    std::vector<std::string> skipped;  // the files whose plays have not changed
+    // the files that could not be written, with the reason
+    std::vector<std::pair<std::string, std::string>> failures;
+};
+
+/**
+ * @class PBCImageExport
+ * @brief Exports plays as individual images or sprite sheets, e.g. for
+ * video-coaching software or wristband printers.
+ *
+ * The images are rendered in parallel with PBCPlayRenderer. The export
+ * directory contains a manifest (MANIFEST_FILE) with the content hashes of
+ * the plays in each file, so exporting into the same directory again only
+ * rewrites the files whose plays have changed. Changing the settings
+ * rewrites all files.
+ *
+ * The export reads the plays and PBCConfig, so it must be started on the GUI
+ * thread (or without a GUI at all) and the plays must not be modified
+ * meanwhile.
+ */
+class PBCImageExport {
+ public:
+    static const char MANIFEST_FILE[];
+    static const char SPRITE_INDEX_FILE[];
+
+    static PBCImageExportReport exportPlays(PBCPlaybookSP playbook,
+                                            const std::vector<std::string>& playNames,
+                                            const std::string& directory,
+                                            const PBCImageExportOptions& options);
+    static std::string fileName(const std::string& playName);
+};
+
+#endif  // PBCIMAGEEXPORT_H
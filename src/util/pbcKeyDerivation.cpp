@@ -0,0 +1,170 @@
+/** @file pbcKeyDerivation.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcKeyDerivation.h"
+#include "util/pbcExceptions.h"
+#include <botan/pwdhash.h>
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+const char* const PBCKdfSettings::PBKDF2 = "PBKDF2(SHA-256)";
+const char* const PBCKdfSettings::ARGON2ID = "Argon2id";
+
+static const size_t BENCHMARK_KEY_SIZE = 32;  // in Bytes
+
+// The settings are read from files before the password is checked, so a
+// crafted file must not make the key derivation run for hours or allocate
+// all memory. The limits are far above what calibrate() chooses.
+static const size_t MAX_PBKDF2_ITERATIONS = 100000000;
+static const size_t MAX_ARGON2_MEMORY = 4 * 1024 * 1024;  // in KiB
+static const size_t MAX_ARGON2_ITERATIONS = 1000;
+static const size_t MAX_ARGON2_PARALLELISM = 64;
+
+/**
+ * @brief Formats the settings as they are stored in playbook files
+ * @return The algorithm followed by the parameters, separated by spaces
+ */
+std::string PBCKdfSettings::toString() const {
+    std::ostringstream settings;
+    settings << algorithm;
+    for (size_t parameter : parameters) {
+        settings << " " << parameter;
+    }
+    return settings.str();
+}
+
+/**
+ * @brief Parses settings that have been formatted with toString()
+ * @throws PBCStorageException if the algorithm is unknown, the number of
+ * parameters does not fit the algorithm or a parameter exceeds its limit
+ */
+PBCKdfSettings PBCKdfSettings::fromString(const std::string &settings) {
+    PBCKdfSettings result;
+    std::istringstream stream(settings);
+    stream >> result.algorithm;
+    size_t parameter;
+    while (stream >> parameter) {
+        result.parameters.push_back(parameter);
+    }
+    bool valid = stream.eof() &&
+            ((result.algorithm == PBKDF2 && result.parameters.size() == 1) ||
+             (result.algorithm == ARGON2ID && result.parameters.size() == 3));
+    if (!valid || std::find(result.parameters.begin(), result.parameters.end(), 0) != result.parameters.end()) {
+        throw PBCStorageException("Unknown key derivation: " + settings);
+    }
+    const std::vector<size_t> limits = result.algorithm == PBKDF2 ?
+            std::vector<size_t>({MAX_PBKDF2_ITERATIONS}) :
+            std::vector<size_t>({MAX_ARGON2_MEMORY, MAX_ARGON2_ITERATIONS, MAX_ARGON2_PARALLELISM});
+    for (size_t i = 0; i < limits.size(); ++i) {
+        if (result.parameters[i] > limits[i]) {
+            throw PBCStorageException("The cost of the key derivation is too high: " + settings);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief The key derivation of playbook files that do not record theirs
+ * (written before version 2 of the file format)
+ */
+PBCKdfSettings PBCKdfSettings::legacy() {
+    return PBCKdfSettings{PBKDF2, {10000}};
+}
+
+static std::unique_ptr<Botan::PasswordHash> passwordHash(const PBCKdfSettings& settings) {
+    std::unique_ptr<Botan::PasswordHashFamily> family = Botan::PasswordHashFamily::create(settings.algorithm);
+    if (family == NULL) {
+        throw PBCStorageException("Key derivation is not supported: " + settings.algorithm);
+    }
+    std::vector<size_t> parameters(settings.parameters);
+    parameters.resize(3, 0);
+    return family->from_params(parameters[0], parameters[1], parameters[2]);
+}
+
+/**
+ * @brief Derives a key from a password
+ * @param settings The key derivation function and its parameters
+ * @param password The password
+ * @param salt The salt
+ * @param keySize The size of the key in bytes
+ * @return The key
+ */
+Botan::OctetString PBCKeyDerivation::deriveKey(const PBCKdfSettings &settings,
+                                               const std::string &password,
+                                               const Botan::SecureVector<Botan::byte> &salt,
+                                               size_t keySize) {
+    Botan::SecureVector<Botan::byte> key(keySize);
+    passwordHash(settings)->derive_key(key.data(), key.size(),
+                                       password.data(), password.size(),
+                                       salt.data(), salt.size());
+    return Botan::OctetString(key);
+}
+
+/**
+ * @brief Chooses the parameters of a key derivation function, so that
+ * deriving a key takes about the target time on this machine. The
+ * parameters never fall below the legacy PBKDF2 iterations.
+ * @param algorithm PBCKdfSettings::PBKDF2 or PBCKdfSettings::ARGON2ID
+ * @param targetTime The desired time of one key derivation
+ * @param maxMemoryMiB The maximum memory that Argon2id may use
+ * @return The settings
+ */
+PBCKdfSettings PBCKeyDerivation::calibrate(const std::string &algorithm,
+                                           std::chrono::milliseconds targetTime,
+                                           size_t maxMemoryMiB) {
+    std::unique_ptr<Botan::PasswordHashFamily> family = Botan::PasswordHashFamily::create(algorithm);
+    if (family == NULL) {
+        throw PBCStorageException("Key derivation is not supported: " + algorithm);
+    }
+    std::unique_ptr<Botan::PasswordHash> tuned = family->tune(BENCHMARK_KEY_SIZE, targetTime, maxMemoryMiB);
+    PBCKdfSettings settings;
+    settings.algorithm = algorithm;
+    if (algorithm == PBCKdfSettings::PBKDF2) {
+        settings.parameters = {std::min(std::max(tuned->iterations(), PBCKdfSettings::legacy().parameters[0]),
+                                        MAX_PBKDF2_ITERATIONS)};
+    } else {
+        settings.parameters = {std::min(tuned->memory_param(), MAX_ARGON2_MEMORY),
+                               std::min(tuned->iterations(), MAX_ARGON2_ITERATIONS),
+                               std::min(tuned->parallelism(), MAX_ARGON2_PARALLELISM)};
+    }
+    return settings;
+}
+
+/**
+ * @brief Measures the time of a key derivation
+ * @param settings The key derivation function and its parameters
+ * @param runs The number of derivations
+ * @return The fastest of the runs
+ */
+std::chrono::microseconds PBCKeyDerivation::benchmark(const PBCKdfSettings &settings, unsigned int runs) {
+    Botan::SecureVector<Botan::byte> salt(16, 0x42);
+    std::chrono::microseconds fastest = std::chrono::microseconds::max();
+    for (unsigned int run = 0; run < runs; ++run) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        deriveKey(settings, "benchmark", salt, BENCHMARK_KEY_SIZE);
+        fastest = std::min(fastest, std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start));
+    }
+    return fastest;
+}
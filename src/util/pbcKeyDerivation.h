@@ -0,0 +1,71 @@
+/** @file pbcKeyDerivation.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCKEYDERIVATION_H
+#define PBCKEYDERIVATION_H
+
+#include <botan/secmem.h>
+#include <botan/symkey.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A password-based key derivation function and its cost parameters,
+ * e.g. "PBKDF2(SHA-256) 10000" or "Argon2id 65536 3 1"
+ */
+struct PBCKdfSettings {
+    static const char* const PBKDF2;    // parameters: iterations
+    static const char* const ARGON2ID;  // parameters: memory in KiB, iterations, parallelism
+
+    std::string algorithm;
+    std::vector<size_t> parameters;
+
+    std::string toString() const;
+    static PBCKdfSettings fromString(const std::string& settings);
+    static PBCKdfSettings legacy();
+
+    bool operator==(const PBCKdfSettings& other) const {
+        return algorithm == other.algorithm && parameters == other.parameters;
+    }
+    bool operator!=(const PBCKdfSettings& other) const {
+        return !(*this == other);
+    }
+};
+
+/**
+ * @class PBCKeyDerivation
+ * @brief Derives keys from passwords with the key derivation functions
+ * supported by Botan and chooses their cost parameters.
+ */
+class PBCKeyDerivation {
+ public:
+    static Botan::OctetString deriveKey(const PBCKdfSettings& settings,
+                                        const std::string& password,
+                                        const Botan::SecureVector<Botan::byte>& salt,
+                                        size_t keySize);
+    static PBCKdfSettings calibrate(const std::string& algorithm,
+                                    std::chrono::milliseconds targetTime,
+                                    size_t maxMemoryMiB = 256);
+    static std::chrono::microseconds benchmark(const PBCKdfSettings& settings, unsigned int runs = 3);
+};
+
+#endif  // PBCKEYDERIVATION_H
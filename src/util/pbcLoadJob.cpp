@@ -0,0 +1,251 @@
+/** @file pbcLoadJob.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcLoadJob.h"
+#include "util/pbcDeclarations.h"
+#include "util/pbcExceptions.h"
+#include "util/pbcPerf.h"
+#include <boost/archive/text_iarchive.hpp>
+#include <algorithm>
+#include <fstream>
+#include <istream>
+#include <sstream>
+#include <string>
+
+static const size_t READ_CHUNK_SIZE = 1 << 20;
+static const size_t DESERIALIZE_CHUNK_SIZE = 1 << 18;
+
+/**
+ * @brief A read-only stream buffer over data in memory, which hands out the
+ * data in chunks and calls a function before each chunk (e.g. to report the
+ * progress or to cancel by throwing an exception)
+ */
+class PBCLoadJob::MemoryBuffer : public std::streambuf {
+ public:
+    MemoryBuffer(const char* data,
+                 size_t size,
+                 size_t chunkSize = SIZE_MAX,
+                 std::function<void(double)> onChunk = std::function<void(double)>()) :
+        _data(const_cast<char*>(data)),
+        _size(size),
+        _chunkSize(chunkSize),
+        _onChunk(onChunk) {
+        setg(_data, _data, _data);
+    }
+
+ protected:
+    int_type underflow() override {
+        if (gptr() < egptr()) {
+            return traits_type::to_int_type(*gptr());
+        }
+        size_t position = egptr() - _data;
+        if (position >= _size) {
+            return traits_type::eof();
+        }
+        if (_onChunk) {
+            _onChunk(static_cast<double>(position) / _size);
+        }
+        // the data that has been read stays in the get area, so that it can be put back
+        setg(_data, _data + position, _data + position + std::min(_chunkSize, _size - position));
+        return traits_type::to_int_type(*gptr());
+    }
+
+ private:
+    char* _data;
+    size_t _size;
+    size_t _chunkSize;
+    std::function<void(double)> _onChunk;
+};
+
+/**
+ * @brief The constructor
+ * @param fileName The playbook file that should be loaded
+ */
+PBCLoadJob::PBCLoadJob(const std::string &fileName) :
+    _fileName(fileName),
+    _fileRead(false),
+    _cancelled(false),
+    _status(IDLE) {}
+
+/**
+ * @brief The destructor. Cancels a running job and waits until it has stopped.
+ */
+PBCLoadJob::~PBCLoadJob() {
+    cancel();
+    wait();
+}
+
+/**
+ * @brief Starts loading the playbook and returns immediately. A job that has
+ * failed (e.g. because of a wrong password) can be started again.
+ * @param password The decryption password
+ * @param progress Is called whenever a phase makes progress
+ * @param finished Is called when the job has succeeded, failed or has been
+ * cancelled. The results can be used after wait() has returned.
+ */
+void PBCLoadJob::start(const std::string &password, ProgressCallback progress, FinishedCallback finished) {
+    pbcAssert(_status != RUNNING && _status != SUCCEEDED);
+    wait();
+    _cancelled = false;
+    _error = std::exception_ptr();
+    _playbook.reset();
+    _status = RUNNING;
+    _thread = std::thread(&PBCLoadJob::run, this, password, progress, finished);
+}
+
+/**
+ * @brief Asks a running job to stop. The job stops at the next point where it
+ * can be cancelled; the key derivation and the decryption are finished first.
+ */
+void PBCLoadJob::cancel() {
+    _cancelled = true;
+}
+
+/**
+ * @brief Waits until the job has finished
+ */
+void PBCLoadJob::wait() {
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+PBCLoadJob::Status PBCLoadJob::status() const {
+    return _status;
+}
+
+/**
+ * @brief Throws the exception that a failed job has failed with, e.g. a
+ * PBCDecryptionException if the password is wrong
+ */
+void PBCLoadJob::rethrow() const {
+    pbcAssert(_status == FAILED && _error != NULL);
+    std::rethrow_exception(_error);
+}
+
+void PBCLoadJob::checkCancelled() const {
+    if (_cancelled) {
+        throw PBCCancelledException();
+    }
+}
+
+void PBCLoadJob::run(const std::string &password, ProgressCallback progress, FinishedCallback finished) {
+    PBC_PERF_SCOPE("storage.load");
+    auto report = [&progress](Phase phase, double value) {
+        if (progress) {
+            progress(phase, value);
+        }
+    };
+    try {
+        if (_fileRead == false) {
+            readFile(progress);
+        }
+        checkCancelled();
+
+        PBCStorage* storage = PBCStorage::getInstance();
+        MemoryBuffer fileBuffer(_fileContent.data(), _fileContent.size());
+        std::istream file(&fileBuffer);
+        PBCStorage::Preamble preamble = storage->readPreamble(file);
+
+        // the key is cached, so decrypt() does not derive it again
+        report(DERIVING_KEY, 0);
+        if (_fileContent.size() < preamble.text.size() + storage->_SALT_SIZE) {
+            throw PBCStorageException("The playbook file is truncated.");
+        }
+        const Botan::byte* salt = reinterpret_cast<const Botan::byte*>(_fileContent.data()) + preamble.text.size();
+        storage->deriveKey(password,
+                           Botan::SecureVector<Botan::byte>(salt, salt + storage->_SALT_SIZE),
+                           preamble.kdf);
+        report(DERIVING_KEY, 1);
+        checkCancelled();
+
+        report(DECRYPTING, 0);
+        std::ostringstream decrypted;
+        PBCCryptoKey cryptoKey;
+        try {
+            cryptoKey = storage->decrypt(password, decrypted, file, preamble);
+        } catch (PBCStorageException&) {
+            throw;
+        } catch (std::exception& e) {
+            throw PBCStorageException(e.what());
+        }
+        report(DECRYPTING, 1);
+        checkCancelled();
+
+        const std::string serializedPlaybook = decrypted.str();
+        MemoryBuffer playbookBuffer(serializedPlaybook.data(), serializedPlaybook.size(), DESERIALIZE_CHUNK_SIZE,
+                                    [this, &report](double value) {
+                                        checkCancelled();
+                                        report(DESERIALIZING, value);
+                                    });
+        PBCPlaybookSP playbook(new PBCPlaybook());
+        {
+            PBC_PERF_SCOPE("storage.deserialize");
+            std::istream istream(&playbookBuffer);
+            boost::archive::text_iarchive archive(istream);
+            archive >> *playbook;
+        }
+        checkCancelled();
+        report(DESERIALIZING, 1);
+
+        _playbook = playbook;
+        _cryptoKey = cryptoKey;
+        _status = SUCCEEDED;
+    } catch (...) {
+        // a cancellation inside of the deserialization surfaces as a stream error
+        if (_cancelled) {
+            _status = CANCELLED;
+        } else {
+            _error = std::current_exception();
+            _status = FAILED;
+        }
+    }
+    if (finished) {
+        finished();
+    }
+}
+
+void PBCLoadJob::readFile(const ProgressCallback &progress) {
+    PBC_PERF_SCOPE("storage.read");
+    pbcAssert(_fileName.size() > 4 && _fileName.substr(_fileName.size() - 4) == ".pbc");
+    std::ifstream file(_fileName, std::ios_base::binary | std::ios_base::ate);
+    if (!file) {
+        throw PBCStorageException("Could not open " + _fileName);
+    }
+    const size_t size = file.tellg();
+    file.seekg(0);
+    std::string content(size, '\0');
+    for (size_t position = 0; position < size; position += READ_CHUNK_SIZE) {
+        checkCancelled();
+        if (progress) {
+            progress(READING, static_cast<double>(position) / size);
+        }
+        const size_t chunkSize = std::min(READ_CHUNK_SIZE, size - position);
+        if (!file.read(&content[position], chunkSize)) {
+            throw PBCStorageException("Could not read " + _fileName);
+        }
+    }
+    if (progress) {
+        progress(READING, 1);
+    }
+    _fileContent.swap(content);
+    _fileRead = true;
+}
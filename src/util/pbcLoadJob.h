@@ -0,0 +1,100 @@
+/** @file pbcLoadJob.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCLOADJOB_H
+#define PBCLOADJOB_H
+
+#include "util/pbcStorage.h"
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <string>
+#include <thread>
+
+/**
+ * @class PBCLoadJob
+ * @brief Reads, decrypts and deserializes a playbook file on a worker thread.
+ *
+ * The job reports the progress of each phase and can be cancelled between
+ * the phases and while the file is read or the playbook is deserialized. The
+ * file is read only once: if the password is wrong, the job can be started
+ * again with another password and only runs the key derivation, the
+ * decryption and the deserialization again. The active playbook is not
+ * touched; a successfully loaded playbook is activated or imported afterwards
+ * on the GUI thread (see PBCStorage::activatePlaybook()).
+ */
+class PBCLoadJob {
+ public:
+    enum Phase {
+        READING,
+        DERIVING_KEY,
+        DECRYPTING,
+        DESERIALIZING
+    };
+    enum Status {
+        IDLE,
+        RUNNING,
+        SUCCEEDED,
+        FAILED,
+        CANCELLED
+    };
+    // is called on the worker thread with the progress (0 to 1) of the current phase
+    typedef std::function<void(Phase phase, double progress)> ProgressCallback;
+    // is called on the worker thread when the job has finished
+    typedef std::function<void()> FinishedCallback;
+
+    explicit PBCLoadJob(const std::string& fileName);
+    ~PBCLoadJob();
+
+    void start(const std::string& password,
+               ProgressCallback progress = ProgressCallback(),
+               FinishedCallback finished = FinishedCallback());
+    void cancel();
+    void wait();
+
+    Status status() const;
+    void rethrow() const;
+    const std::string& fileName() const { return _fileName; }
+    PBCPlaybookSP playbook() const { return _playbook; }
+    const PBCCryptoKey& cryptoKey() const { return _cryptoKey; }
+
+ private:
+    class MemoryBuffer;
+
+    const std::string _fileName;
+    std::string _fileContent;
+    bool _fileRead;
+    std::atomic<bool> _cancelled;
+    std::atomic<Status> _status;
+    std::exception_ptr _error;
+    PBCPlaybookSP _playbook;
+    PBCCryptoKey _cryptoKey;
+    std::thread _thread;
+
+    PBCLoadJob(const PBCLoadJob& other) = delete;
+    PBCLoadJob& operator=(const PBCLoadJob& other) = delete;
+
+    void run(const std::string& password, ProgressCallback progress, FinishedCallback finished);
+    void readFile(const ProgressCallback& progress);
+    void checkCancelled() const;
+};
+
+#endif  // PBCLOADJOB_H
@@ -0,0 +1,307 @@
+/** @file pbcLog.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcLog.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <cctype>
+#include <ctime>
+#include <deque>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+std::atomic<int> PBCLog::_threshold(PBCLogRecord::LEVEL_OFF);
+std::atomic<bool> PBCLog::_hasCategoryLevels(false);
+
+static const char* LEVEL_NAMES[] = {"TRACE", "DEBUG", "INFO", "WARNING", "ERROR", "OFF"};
+
+/**
+ * @brief Formats the record as "<local time> <level> [<category>] <message>"
+ */
+std::string PBCLogRecord::format() const {
+    std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+    int milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+            time.time_since_epoch()).count() % 1000;
+    std::ostringstream line;
+    // std::localtime is not thread-safe, but records are formatted on the logging thread only
+    line << std::put_time(std::localtime(&seconds), "%Y-%m-%d %H:%M:%S")
+         << "." << std::setw(3) << std::setfill('0') << milliseconds
+         << " " << LEVEL_NAMES[level]
+         << " [" << category << "] "
+         << message;
+    return line.str();
+}
+
+
+void PBCStreamLogSink::write(const PBCLogRecord &record) {
+    _stream << record.format() << '\n';
+}
+
+void PBCStreamLogSink::flush() {
+    _stream.flush();
+}
+
+
+PBCFileLogSink::PBCFileLogSink(const std::string &fileName) :
+    _file(fileName, std::ios::app) {}
+
+void PBCFileLogSink::write(const PBCLogRecord &record) {
+    _file << record.format() << '\n';
+}
+
+void PBCFileLogSink::flush() {
+    _file.flush();
+}
+
+
+/**
+ * @brief The state of the logging facility. It is never destroyed, so
+ * messages can be logged until the process exits.
+ */
+struct PBCLogger {
+    static const size_t MAX_QUEUED = 10000;
+
+    std::mutex mutex;
+    std::condition_variable queued;  // a record has been queued or the thread should stop
+    std::condition_variable idle;  // the thread has written all queued records
+    std::deque<PBCLogRecord> queue;
+    uint64_t dropped = 0;
+    bool writing = false;
+    bool stopping = false;
+    std::thread thread;
+    std::vector<PBCLogSinkSP> sinks;
+    PBCLogRecord::Level level = PBCLogRecord::LEVEL_INFO;
+    std::map<std::string, PBCLogRecord::Level> categoryLevels;
+};
+
+static PBCLogger& logger() {
+    static PBCLogger* instance = new PBCLogger();
+    return *instance;
+}
+
+static void writeQueuedRecords() {
+    PBCLogger& log = logger();
+    std::unique_lock<std::mutex> lock(log.mutex);
+    while (true) {
+        log.queued.wait(lock, [&log]() {
+            return !log.queue.empty() || log.stopping;
+        });
+        if (log.queue.empty()) {
+            break;  // stopping
+        }
+        std::deque<PBCLogRecord> records;
+        records.swap(log.queue);
+        if (log.dropped > 0) {
+            records.push_back(PBCLogRecord{std::chrono::system_clock::now(),
+                                           PBCLogRecord::LEVEL_WARNING,
+                                           "log",
+                                           std::to_string(log.dropped) + " messages have been dropped"});
+            log.dropped = 0;
+        }
+        std::vector<PBCLogSinkSP> sinks = log.sinks;
+        log.writing = true;
+        lock.unlock();
+
+        for (const PBCLogSinkSP& sink : sinks) {
+            try {
+                for (const PBCLogRecord& record : records) {
+                    sink->write(record);
+                }
+                sink->flush();
+            } catch (std::exception&) {
+                // there is nowhere left to report a failing sink to
+            }
+        }
+
+        lock.lock();
+        log.writing = false;
+        log.idle.notify_all();
+    }
+}
+
+static void stopLogging() {
+    PBCLogger& log = logger();
+    {
+        std::lock_guard<std::mutex> lock(log.mutex);
+        log.stopping = true;
+    }
+    log.queued.notify_all();
+    log.thread.join();
+}
+
+/**
+ * @brief Logs a message. Use the logging macros instead, they check the level
+ * before the message is formatted.
+ */
+void PBCLog::write(PBCLogRecord::Level level, const char *category, const std::string &message) {
+    PBCLogRecord record{std::chrono::system_clock::now(), level, category, message};
+    PBCLogger& log = logger();
+    {
+        std::lock_guard<std::mutex> lock(log.mutex);
+        if (log.stopping) {
+            return;
+        }
+        if (log.queue.size() >= PBCLogger::MAX_QUEUED) {
+            ++log.dropped;
+            return;
+        }
+        log.queue.push_back(record);
+    }
+    log.queued.notify_one();
+}
+
+bool PBCLog::categoryEnabled(PBCLogRecord::Level level, const char *category) {
+    PBCLogger& log = logger();
+    std::lock_guard<std::mutex> lock(log.mutex);
+    std::string name(category);
+    while (true) {
+        auto it = log.categoryLevels.find(name);
+        if (it != log.categoryLevels.end()) {
+            return level >= it->second;
+        }
+        size_t dot = name.rfind('.');
+        if (dot == std::string::npos) {
+            return level >= log.level;
+        }
+        name.resize(dot);
+    }
+}
+
+/**
+ * @brief Sets the global level, which applies to all categories without a
+ * level of their own
+ */
+void PBCLog::setLevel(PBCLogRecord::Level level) {
+    std::lock_guard<std::mutex> lock(logger().mutex);
+    logger().level = level;
+    updateThreshold();
+}
+
+/**
+ * @brief Sets the level of a category and its subcategories
+ * @param category The category, e.g. "gui" (which includes "gui.mouse")
+ * @param level The level
+ */
+void PBCLog::setLevel(const std::string &category, PBCLogRecord::Level level) {
+    std::lock_guard<std::mutex> lock(logger().mutex);
+    logger().categoryLevels[category] = level;
+    _hasCategoryLevels.store(true, std::memory_order_relaxed);
+    updateThreshold();
+}
+
+static bool parseLevel(const std::string& name, PBCLogRecord::Level& level) {
+    for (int i = PBCLogRecord::LEVEL_TRACE; i <= PBCLogRecord::LEVEL_OFF; ++i) {
+        std::string levelName = LEVEL_NAMES[i];
+        std::transform(levelName.begin(), levelName.end(), levelName.begin(), ::tolower);
+        if (name == levelName) {
+            level = static_cast<PBCLogRecord::Level>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Sets the levels from a specification like "info,gui=trace,pdf=off",
+ * i.e. an optional global level and levels for categories, separated by commas
+ * @return false (without changing any level) if the specification is invalid
+ */
+bool PBCLog::configure(const std::string &specification) {
+    std::vector<std::pair<std::string, PBCLogRecord::Level>> levels;
+    std::istringstream stream(specification);
+    std::string entry;
+    while (std::getline(stream, entry, ',')) {
+        size_t separator = entry.find('=');
+        std::string category = separator == std::string::npos ? "" : entry.substr(0, separator);
+        PBCLogRecord::Level level;
+        if (!parseLevel(entry.substr(separator == std::string::npos ? 0 : separator + 1), level) ||
+            (separator != std::string::npos && category.empty())) {
+            return false;
+        }
+        levels.push_back(std::make_pair(category, level));
+    }
+    for (const auto& categoryLevel : levels) {
+        if (categoryLevel.first.empty()) {
+            setLevel(categoryLevel.second);
+        } else {
+            setLevel(categoryLevel.first, categoryLevel.second);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Adds a sink. The logging thread is started with the first sink and
+ * stopped when the process exits.
+ */
+void PBCLog::addSink(PBCLogSinkSP sink) {
+    PBCLogger& log = logger();
+    std::lock_guard<std::mutex> lock(log.mutex);
+    log.sinks.push_back(sink);
+    if (log.thread.joinable() == false && log.stopping == false) {
+        log.thread = std::thread(writeQueuedRecords);
+        std::atexit(stopLogging);
+    }
+    updateThreshold();
+}
+
+/**
+ * @brief Removes a sink. Queued messages may still be written to it.
+ */
+void PBCLog::removeSink(PBCLogSinkSP sink) {
+    PBCLogger& log = logger();
+    std::lock_guard<std::mutex> lock(log.mutex);
+    log.sinks.erase(std::remove(log.sinks.begin(), log.sinks.end(), sink), log.sinks.end());
+    updateThreshold();
+}
+
+/**
+ * @brief Blocks until all messages that have been logged before have been
+ * written and the sinks have been flushed
+ */
+void PBCLog::flush() {
+    PBCLogger& log = logger();
+    std::unique_lock<std::mutex> lock(log.mutex);
+    if (log.thread.joinable() == false) {
+        return;
+    }
+    log.idle.wait(lock, [&log]() {
+        return (log.queue.empty() && log.writing == false) || log.stopping;
+    });
+}
+
+// must be called with the logger's mutex locked
+void PBCLog::updateThreshold() {
+    PBCLogRecord::Level threshold = PBCLogRecord::LEVEL_OFF;
+    if (!logger().sinks.empty()) {
+        threshold = logger().level;
+        for (const auto& kv : logger().categoryLevels) {
+            threshold = std::min(threshold, kv.second);
+        }
+    }
+    _threshold.store(threshold, std::memory_order_relaxed);
+}
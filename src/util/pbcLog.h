@@ -0,0 +1,190 @@
+/** @file pbcLog.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCLOG_H
+#define PBCLOG_H
+
+#include <boost/shared_ptr.hpp>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+#define PBC_LOG_LEVEL_TRACE 0
+#define PBC_LOG_LEVEL_DEBUG 1
+#define PBC_LOG_LEVEL_INFO 2
+#define PBC_LOG_LEVEL_WARNING 3
+#define PBC_LOG_LEVEL_ERROR 4
+
+// Log statements below this level are removed at compile time.
+#ifndef PBC_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define PBC_LOG_MIN_LEVEL PBC_LOG_LEVEL_INFO
+#else
+#define PBC_LOG_MIN_LEVEL PBC_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+/**
+ * @brief A log message
+ */
+struct PBCLogRecord {
+    enum Level {
+        LEVEL_TRACE = PBC_LOG_LEVEL_TRACE,
+        LEVEL_DEBUG = PBC_LOG_LEVEL_DEBUG,
+        LEVEL_INFO = PBC_LOG_LEVEL_INFO,
+        LEVEL_WARNING = PBC_LOG_LEVEL_WARNING,
+        LEVEL_ERROR = PBC_LOG_LEVEL_ERROR,
+        LEVEL_OFF
+    };
+
+    std::chrono::system_clock::time_point time;
+    Level level;
+    std::string category;
+    std::string message;
+
+    std::string format() const;
+};
+
+/**
+ * @class PBCLogSink
+ * @brief Writes log records somewhere. Sinks are only called from the
+ * logging thread, so they need no synchronization.
+ */
+class PBCLogSink {
+ public:
+    virtual ~PBCLogSink() {}
+    virtual void write(const PBCLogRecord& record) = 0;
+    virtual void flush() {}
+};
+typedef boost::shared_ptr<PBCLogSink> PBCLogSinkSP;
+
+/**
+ * @class PBCStreamLogSink
+ * @brief Writes formatted log records to a stream, e.g. std::clog
+ */
+class PBCStreamLogSink : public PBCLogSink {
+ public:
+    explicit PBCStreamLogSink(std::ostream& stream) : _stream(stream) {}
+    void write(const PBCLogRecord& record) override;
+    void flush() override;
+
+ private:
+    std::ostream& _stream;
+};
+
+/**
+ * @class PBCFileLogSink
+ * @brief Appends formatted log records to a file
+ */
+class PBCFileLogSink : public PBCLogSink {
+ public:
+    explicit PBCFileLogSink(const std::string& fileName);
+    void write(const PBCLogRecord& record) override;
+    void flush() override;
+
+ private:
+    std::ofstream _file;
+};
+
+/**
+ * @class PBCLog
+ * @brief Leveled and categorized logging.
+ *
+ * Messages are formatted on the calling thread and handed to the sinks by a
+ * logging thread, so logging never waits for a console or a file. Sinks are
+ * flushed once the queue has been emptied instead of once per message. If the
+ * queue is full, messages are dropped (and the number of dropped messages is
+ * logged later).
+ *
+ * A message is logged if its level is at least the level of its category. The
+ * level of a category "a.b" is the level that has been set for "a.b", else
+ * the level of "a", else the global level (LEVEL_INFO by default). Without
+ * sinks, nothing is logged.
+ */
+class PBCLog {
+ public:
+    static bool enabled(PBCLogRecord::Level level, const char* category) {
+        if (level < _threshold.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        return _hasCategoryLevels.load(std::memory_order_relaxed) == false ||
+               categoryEnabled(level, category);
+    }
+    static void write(PBCLogRecord::Level level, const char* category, const std::string& message);
+    static void setLevel(PBCLogRecord::Level level);
+    static void setLevel(const std::string& category, PBCLogRecord::Level level);
+    static bool configure(const std::string& specification);
+    static void addSink(PBCLogSinkSP sink);
+    static void removeSink(PBCLogSinkSP sink);
+    static void flush();
+
+ private:
+    static std::atomic<int> _threshold;
+    static std::atomic<bool> _hasCategoryLevels;
+
+    static bool categoryEnabled(PBCLogRecord::Level level, const char* category);
+    static void updateThreshold();
+};
+
+#define PBC_LOG(level, category, message) \
+    do { \
+        if (PBCLog::enabled(level, category)) { \
+            std::ostringstream pbcLogStream; \
+            pbcLogStream << message; \
+            PBCLog::write(level, category, pbcLogStream.str()); \
+        } \
+    } while (0)
+
+/**
+ * @brief The logging macros. The message may be a chain of stream
+ * insertions, e.g. PBC_LOG_DEBUG("storage", "imported play: " << name). It is
+ * only evaluated if the message is logged.
+ */
+#if PBC_LOG_MIN_LEVEL <= PBC_LOG_LEVEL_TRACE
+#define PBC_LOG_TRACE(category, message) PBC_LOG(PBCLogRecord::LEVEL_TRACE, category, message)
+#else
+#define PBC_LOG_TRACE(category, message) do {} while (0)
+#endif
+
+#if PBC_LOG_MIN_LEVEL <= PBC_LOG_LEVEL_DEBUG
+#define PBC_LOG_DEBUG(category, message) PBC_LOG(PBCLogRecord::LEVEL_DEBUG, category, message)
+#else
+#define PBC_LOG_DEBUG(category, message) do {} while (0)
+#endif
+
+#if PBC_LOG_MIN_LEVEL <= PBC_LOG_LEVEL_INFO
+#define PBC_LOG_INFO(category, message) PBC_LOG(PBCLogRecord::LEVEL_INFO, category, message)
+#else
+#define PBC_LOG_INFO(category, message) do {} while (0)
+#endif
+
+#if PBC_LOG_MIN_LEVEL <= PBC_LOG_LEVEL_WARNING
+#define PBC_LOG_WARNING(category, message) PBC_LOG(PBCLogRecord::LEVEL_WARNING, category, message)
+#else
+#define PBC_LOG_WARNING(category, message) do {} while (0)
+#endif
+
+#define PBC_LOG_ERROR(category, message) PBC_LOG(PBCLogRecord::LEVEL_ERROR, category, message)
+
+#endif  // PBCLOG_H
@@ -0,0 +1,172 @@
+/** @file pbcMultiLayoutExportJob.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcMultiLayoutExportJob.h"
+#include "util/pbcDeclarations.h"
+#include "util/pbcLog.h"
+#include "util/pbcPerf.h"
+#include <QRegularExpression>
+#include <QRegularExpressionMatch>
+#include <QString>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The constructor. Creates the PDF files and sets up their pages.
+ * @param plays The exported plays, in the order in which they are arranged
+ * in the grids
+ * @param targets The PDF files and their layouts
+ * @throws PBCStorageException if a file cannot be written
+ */
+PBCMultiLayoutExportJob::PBCMultiLayoutExportJob(const std::vector<PBCPlaySP> &plays,
+                                                 const std::vector<PBCPDFTarget> &targets) :
+    _plays(plays),
+    _targets(targets),
+    _recordedPlays(0),
+    _steps(plays.size()),
+    _stepsDone(0),
+    _finished(false),
+    _cancelled(false) {
+    pbcAssert(plays.empty() == false);
+    pbcAssert(targets.empty() == false);
+    for (const PBCPDFTarget& target : targets) {
+        _jobs.push_back(boost::shared_ptr<PBCPDFExportJob>(new PBCPDFExportJob(target.fileName, plays, target.layout)));
+        _steps += _jobs.back()->pages();
+        if (_jobs.size() == 1 || _jobs.back()->style().canvasHeight > _recordingStyle.canvasHeight) {
+            _recordingStyle = _jobs.back()->style();
+        }
+    }
+    if (_recordingStyle.canvasHeight > MAX_RECORDING_HEIGHT) {
+        _recordingStyle = PBCRenderStyle::fromConfig(MAX_RECORDING_HEIGHT, MAX_RECORDING_HEIGHT);
+    }
+    PBC_LOG_DEBUG("pdf", "recording " << plays.size() << " plays for " << targets.size()
+                  << " layouts with a canvas height of " << _recordingStyle.canvasHeight);
+}
+
+/**
+ * @brief Renders the next page of the layout that is furthest behind, or
+ * records the next play if that page needs it
+ * @return true if the job has finished (or has been cancelled)
+ */
+bool PBCMultiLayoutExportJob::step() {
+    if (_finished || _cancelled) {
+        return true;
+    }
+    try {
+        size_t current = _jobs.size();
+        for (size_t i = 0; i < _jobs.size(); ++i) {
+            if (_jobs[i]->finished() == false &&
+                (current == _jobs.size() || _jobs[i]->nextPlay() < _jobs[current]->nextPlay())) {
+                current = i;
+            }
+        }
+        pbcAssert(current < _jobs.size());
+        const PBCPDFLayout& layout = _targets[current].layout;
+        const size_t pageEnd = std::min<size_t>(_jobs[current]->nextPlay() + layout.columns * layout.rows,
+                                                _plays.size());
+        if (_recordedPlays < pageEnd) {
+            PBC_PERF_SCOPE("pdf.recordPlay");
+            const PBCPlay& play = *_plays[_recordedPlays];
+            // the jobs hold the recording until they have rendered it
+            boost::shared_ptr<const PBCPlayRecording> recording(
+                new PBCPlayRecording(PBCPlayRenderer::record(PBCPlayRenderer::layout(play, _recordingStyle))));
+            for (const boost::shared_ptr<PBCPDFExportJob>& job : _jobs) {
+                job->setRecording(_recordedPlays, recording);
+            }
+            ++_recordedPlays;
+        } else {
+            _jobs[current]->step();
+        }
+    } catch (...) {
+        cancel();
+        throw;
+    }
+    ++_stepsDone;
+    _finished = std::all_of(_jobs.begin(), _jobs.end(), [](const boost::shared_ptr<PBCPDFExportJob>& job) {
+        return job->finished();
+    });
+    return _finished;
+}
+
+/**
+ * @brief Records all plays and renders all pages at once
+ */
+void PBCMultiLayoutExportJob::run() {
+    PBC_PERF_SCOPE("pdf.exportLayouts");
+    while (step() == false) {}
+}
+
+/**
+ * @brief Stops an unfinished job and removes the files that have not been
+ * finished
+ */
+void PBCMultiLayoutExportJob::cancel() {
+    if (_finished || _cancelled) {
+        return;
+    }
+    _cancelled = true;
+    for (const boost::shared_ptr<PBCPDFExportJob>& job : _jobs) {
+        job->cancel();
+    }
+}
+
+/**
+ * @brief Parses a layout, e.g. "4x2" (columns x rows) or "3x1@100x50" (with
+ * the paper width and height in millimeters)
+ * @param spec The layout
+ * @param layout Is set to the grid and the paper size of the layout. The
+ * margins (and the paper size, if there is none in the layout) are kept.
+ * @return false if the layout is invalid
+ */
+bool PBCMultiLayoutExportJob::parseLayout(const std::string &spec, PBCPDFLayout &layout) {
+    static const QRegularExpression expression("^\\s*(\\d+)\\s*x\\s*(\\d+)\\s*(?:@\\s*(\\d+)\\s*x\\s*(\\d+)\\s*)?$");
+    QRegularExpressionMatch match = expression.match(QString::fromStdString(spec));
+    if (match.hasMatch() == false) {
+        return false;
+    }
+    PBCPDFLayout result = layout;
+    result.columns = match.captured(1).toUInt();
+    result.rows = match.captured(2).toUInt();
+    if (match.captured(3).isEmpty() == false) {
+        result.paperWidth = match.captured(3).toUInt();
+        result.paperHeight = match.captured(4).toUInt();
+    }
+    if (result.columns == 0 || result.rows == 0) {
+        return false;
+    }
+    layout = result;
+    return true;
+}
+
+/**
+ * @brief Derives the file name of a layout, e.g. "Playbook-4x2.pdf" or
+ * "Playbook-3x1-100x50mm.pdf"
+ * @param baseName The file name without the extension
+ * @param layout The layout
+ */
+std::string PBCMultiLayoutExportJob::fileName(const std::string &baseName, const PBCPDFLayout &layout) {
+    std::string name = baseName + "-" + std::to_string(layout.columns) + "x" + std::to_string(layout.rows);
+    if (layout.paperWidth != 0 && layout.paperHeight != 0) {
+        name += "-" + std::to_string(layout.paperWidth) + "x" + std::to_string(layout.paperHeight) + "mm";
+    }
+    return name + ".pdf";
+}
@@ -0,0 +1,96 @@
+/** @file pbcMultiLayoutExportJob.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCMULTILAYOUTEXPORTJOB_H
+#define PBCMULTILAYOUTEXPORTJOB_H
+
+#include "gui/pbcPlayRenderer.h"
+#include "models/pbcPlay.h"
+#include "util/pbcPDFExportJob.h"
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A PDF file of a multi-layout export and its page layout
+ */
+struct PBCPDFTarget {
+    std::string fileName;
+    PBCPDFLayout layout;
+};
+
+/**
+ * @class PBCMultiLayoutExportJob
+ * @brief Exports the same plays into several PDF files with different page
+ * layouts (e.g. a full-page coach sheet, a call sheet and a wristband insert).
+ *
+ * Every play is laid out and painted only once, into a PBCPlayRecording,
+ * which is then replayed into the tiles of all layouts. The plays are
+ * recorded at the size of the largest tile (up to MAX_RECORDING_HEIGHT
+ * pixels, because drop shadows are recorded as images).
+ *
+ * The layouts render their pages in turns, always the one that is furthest
+ * behind, and a play is only recorded when the first page that shows it is
+ * due. A recording is freed as soon as every layout has rendered it, so only
+ * about one page of recordings per layout is held in memory, no matter how
+ * many plays are exported.
+ *
+ * Like PBCPDFExportJob, each call of step() does a small part of the work
+ * (recording one play or rendering one page), so the caller can keep the
+ * event loop running, show the progress and cancel the export. A cancelled
+ * or destroyed unfinished job removes the files that have not been finished.
+ * The job must be used on the GUI thread.
+ */
+class PBCMultiLayoutExportJob {
+ public:
+    static const unsigned int MAX_RECORDING_HEIGHT = 2000;
+
+    PBCMultiLayoutExportJob(const std::vector<PBCPlaySP>& plays, const std::vector<PBCPDFTarget>& targets);
+
+    bool step();
+    void run();
+    void cancel();
+
+    bool finished() const { return _finished; }
+    bool cancelled() const { return _cancelled; }
+    unsigned int steps() const { return _steps; }
+    unsigned int stepsDone() const { return _stepsDone; }
+    const std::vector<PBCPDFTarget>& targets() const { return _targets; }
+
+    static bool parseLayout(const std::string& spec, PBCPDFLayout& layout);  // NOLINT
+    static std::string fileName(const std::string& baseName, const PBCPDFLayout& layout);
+
+ private:
+    const std::vector<PBCPlaySP> _plays;
+    const std::vector<PBCPDFTarget> _targets;
+    PBCRenderStyle _recordingStyle;
+    std::vector<boost::shared_ptr<PBCPDFExportJob>> _jobs;
+    unsigned int _recordedPlays;
+    unsigned int _steps;
+    unsigned int _stepsDone;
+    bool _finished;
+    bool _cancelled;
+
+    PBCMultiLayoutExportJob(const PBCMultiLayoutExportJob& other) = delete;
+    PBCMultiLayoutExportJob& operator=(const PBCMultiLayoutExportJob& other) = delete;
+};
+
+#endif  // PBCMULTILAYOUTEXPORTJOB_H
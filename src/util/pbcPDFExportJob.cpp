@@ -0,0 +1,372 @@
+/** @file pbcPDFExportJob.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcPDFExportJob.h"
+#include "pbcController.h"
+#include "models/pbcCategory.h"
+#include "models/pbcPlaybook.h"
+#include "util/pbcConfig.h"
+#include "util/pbcDeclarations.h"
+#include "util/pbcExceptions.h"
+#include "util/pbcLog.h"
+#include "util/pbcPerf.h"
+#include <QColor>
+#include <QFile>
+#include <QFont>
+#include <QPainter>
+#include <QPrinter>
+#include <algorithm>
+#include <map>
+#include <string>
+
+static std::vector<PBCPlaySP> playsOfActivePlaybook(const QStringList& playNames) {
+    std::vector<PBCPlaySP> plays;
+    for (const QString& name : playNames) {
+        PBCPlaySP play = PBCController::getInstance()->getPlaybook()->getPlay(name.toStdString());
+        pbcAssert(play != NULL);
+        plays.push_back(play);
+    }
+    return plays;
+}
+
+/**
+ * @brief The constructor. Creates the PDF file and sets up the pages.
+ * @param fileName The PDF file to which the plays are exported
+ * @param playNames The names of the exported plays of the active playbook,
+ * in the order in which they are arranged in the grid
+ * @param layout The page layout
+ * @throws PBCStorageException if the file cannot be written
+ */
+PBCPDFExportJob::PBCPDFExportJob(const std::string &fileName,
+                                 const QStringList &playNames,
+                                 const PBCPDFLayout &layout) :
+    PBCPDFExportJob(fileName, playsOfActivePlaybook(playNames), layout) {}
+
+/**
+ * @brief Sets the paper size and the margins of a layout
+ */
+static void setUpPage(QPrinter& printer, const PBCPDFLayout& layout) {  // NOLINT
+    printer.setOutputFormat(QPrinter::PdfFormat);
+    unsigned int autoPaperWidth = layout.paperWidth;
+    unsigned int autoPaperHeight = layout.paperHeight;
+    if (layout.paperWidth == 0 || layout.paperHeight == 0) {
+        // is needed because play views are rendered to pixel graphics,
+        // which would result in huge files if not scaled down
+        float scaleFactor = 0.025;
+
+        autoPaperWidth = (PBCConfig::getInstance()->canvasWidth() * layout.columns +
+                          layout.marginLeft + layout.marginRight) * scaleFactor;
+        autoPaperHeight = (PBCConfig::getInstance()->canvasHeight() * layout.rows +
+                           layout.marginTop + layout.marginBottom) * scaleFactor;
+    }
+    PBC_LOG_DEBUG("pdf", "paper width = " << autoPaperWidth << "; paper height = " << autoPaperHeight);
+    printer.setPaperSize(QSizeF(autoPaperWidth, autoPaperHeight), QPrinter::Millimeter);
+    printer.setPageMargins(layout.marginLeft,
+                           layout.marginTop,
+                           layout.marginRight,
+                           layout.marginBottom,
+                           QPrinter::Millimeter);
+}
+
+/**
+ * @brief The size of a play's tile in device pixels
+ */
+static QSize playSize(const QPrinter& printer, const PBCPDFLayout& layout) {
+    QSize size = printer.pageRect().size();
+    size.setWidth(size.width() / layout.columns);
+    size.setHeight(size.height() / layout.rows);
+    return size;
+}
+
+/**
+ * @brief Computes the drawing parameters of the plays of a job with the given
+ * layout without creating a file, e.g. to lay out plays that are shared by
+ * several jobs (see setGeometries()). Must be called on the GUI thread.
+ */
+PBCRenderStyle PBCPDFExportJob::renderStyle(const PBCPDFLayout &layout) {
+    pbcAssert(layout.columns > 0);
+    pbcAssert(layout.rows > 0);
+    QPrinter printer(QPrinter::HighResolution);
+    setUpPage(printer, layout);
+    QSize size = playSize(printer, layout);
+    return PBCRenderStyle::fromConfig(size.width(), size.height());
+}
+
+/**
+ * @brief The constructor. Creates the PDF file and sets up the pages.
+ * @param fileName The PDF file to which the plays are exported
+ * @param plays The exported plays, in the order in which they are arranged
+ * in the grid
+ * @param layout The page layout
+ * @throws PBCStorageException if the file cannot be written
+ */
+PBCPDFExportJob::PBCPDFExportJob(const std::string &fileName,
+                                 const std::vector<PBCPlaySP> &plays,
+                                 const PBCPDFLayout &layout) :
+    _fileName(fileName),
+    _plays(plays),
+    _layout(layout),
+    _printer(new QPrinter(QPrinter::HighResolution)),
+    _pixelMarginLeft(0),
+    _pixelMarginTop(0),
+    _pagesDone(0),
+    _nextPlay(0),
+    _finished(false),
+    _cancelled(false) {
+    std::string extension = fileName.substr(fileName.size() - 4);
+    pbcAssert(extension == ".pdf");
+    pbcAssert(layout.columns > 0);
+    pbcAssert(layout.rows > 0);
+    const unsigned int tilesPerPage = layout.columns * layout.rows;
+    _pages = (plays.size() + tilesPerPage - 1) / tilesPerPage;
+
+    _printer->setOutputFileName(QString::fromStdString(fileName));
+    setUpPage(*_printer, layout);
+
+    qreal pixelMarginRight;
+    qreal pixelMarginBottom;
+    _printer->getPageMargins(&_pixelMarginLeft,
+                             &_pixelMarginTop,
+                             &pixelMarginRight,
+                             &pixelMarginBottom,
+                             QPrinter::DevicePixel);
+    _playSize = playSize(*_printer, layout);
+    _style = PBCRenderStyle::fromConfig(_playSize.width(), _playSize.height());
+
+    _printer->setPageMargins(0.0, 0.0, 0.0, 0.0, QPrinter::Millimeter);
+    _painter.reset(new QPainter());
+    if (_painter->begin(_printer.get()) == false) {
+        throw PBCStorageException("Could not write '" + fileName + "'.");
+    }
+    _paintBorder = layout.marginLeft != 0 ||
+                   layout.marginRight != 0 ||
+                   layout.marginTop != 0 ||
+                   layout.marginBottom != 0;
+    _painter->setPen(QPen(QBrush(Qt::red), 20, Qt::DashLine));
+    _borderRect = QRectF(10,
+                         10,
+                         _printer->paperRect().width() - 10,
+                         _printer->paperRect().height() - 10);
+    if (_paintBorder == true) {
+        _painter->drawRect(_printer->paperRect());
+    }
+}
+
+/**
+ * @brief The destructor. Removes the partial file of an unfinished job.
+ */
+PBCPDFExportJob::~PBCPDFExportJob() {
+    cancel();
+}
+
+/**
+ * @brief Emphasizes the assignment of a role on all pages
+ */
+void PBCPDFExportJob::setEmphasis(const PBCRenderEmphasis &emphasis) {
+    _emphasis = emphasis;
+}
+
+/**
+ * @brief Sets the geometries of the plays, so that they are not laid out
+ * again. Jobs with the same layout can share the geometries, also when they
+ * run on different threads.
+ * @param geometries One geometry per play, laid out with style()
+ */
+void PBCPDFExportJob::setGeometries(const std::vector<boost::shared_ptr<const PBCPlayGeometry>> &geometries) {
+    pbcAssert(geometries.size() == _plays.size());
+    _geometries = geometries;
+}
+
+/**
+ * @brief Sets the recording of a play, which is replayed instead of painting
+ * the play. Once a job has got a recording, every play must have one by the
+ * time its page is rendered. The job releases each recording after rendering
+ * it, so recordings that are shared by jobs with different layouts are freed
+ * as soon as the last job has rendered them. Jobs must not replay a shared
+ * recording at the same time.
+ * @param play The index of the play
+ * @param recording The recording
+ */
+void PBCPDFExportJob::setRecording(unsigned int play, const boost::shared_ptr<const PBCPlayRecording> &recording) {
+    pbcAssert(play >= _nextPlay && play < _plays.size());
+    if (_recordings.empty()) {
+        _recordings.resize(_plays.size());
+    }
+    _recordings[play] = recording;
+}
+
+/**
+ * @brief The names of a play that are not shown on its tile
+ */
+static QString hiddenText(const PBCPlay& play, const PBCRenderStyle& style) {
+    if (style.printPlayName) {
+        // the renderer prints the code name instead of the name if there is one
+        return play.codeName() != "" ? QString::fromStdString(play.name()) : QString();
+    }
+    return QString::fromStdString(play.name() + " " + play.codeName()).trimmed();
+}
+
+/**
+ * @brief Renders the next page
+ * @return true if the job has finished (or has been cancelled)
+ */
+bool PBCPDFExportJob::step() {
+    if (_finished || _cancelled) {
+        return true;
+    }
+    if (_nextPlay >= _plays.size()) {
+        finish();
+        return true;
+    }
+
+    PBC_PERF_SCOPE("pdf.page");
+    try {
+        if (_pagesDone > 0) {
+            bool successful = _printer->newPage();
+            pbcAssert(successful == true);
+            PBC_PERF_COUNT("pdf.pageBreaks", 1);
+            if (_paintBorder == true) {
+                _painter->drawRect(_borderRect);
+            }
+        }
+        const unsigned int tilesPerPage = _layout.columns * _layout.rows;
+        for (unsigned int tile = 0; tile < tilesPerPage && _nextPlay < _plays.size(); ++tile, ++_nextPlay) {
+            PBC_PERF_SCOPE("pdf.renderTile");
+            QPointF position(_pixelMarginLeft + (tile % _layout.columns) * _playSize.width(),
+                             _pixelMarginTop + (tile / _layout.columns) * _playSize.height());
+            const QRectF target(position, _playSize);
+            const PBCPlay& play = *_plays[_nextPlay];
+            if (_recordings.empty() == false) {
+                pbcAssert(_recordings[_nextPlay] != NULL);
+                PBCPlayRenderer::render(_painter.get(), *_recordings[_nextPlay], target);
+                _recordings[_nextPlay].reset();
+            } else if (_geometries.empty()) {
+                PBCPlayRenderer::render(_painter.get(), PBCPlayRenderer::layout(play, _style), target, _emphasis);
+            } else {
+                PBCPlayRenderer::render(_painter.get(), *_geometries[_nextPlay], target, _emphasis);
+            }
+            QString hidden = hiddenText(play, _style);
+            if (hidden.isEmpty() == false) {
+                // a fully transparent pen, because text with Qt::NoPen is not written at all
+                _painter->save();
+                QFont font(QString::fromStdString(_style.playNameFont));
+                font.setPixelSize(std::max(1, _playSize.height() / 40));
+                _painter->setFont(font);
+                _painter->setPen(QColor(0, 0, 0, 0));
+                _painter->drawText(target, Qt::AlignLeft | Qt::AlignTop, hidden);
+                _painter->restore();
+            }
+
+            PBCPDFBookmark bookmark;
+            bookmark.title = play.codeName() != "" ? play.name() + " (" + play.codeName() + ")" : play.name();
+            bookmark.page = _pagesDone;
+            bookmark.left = position.x() * 72 / _printer->resolution();
+            bookmark.top = _printer->paperRect(QPrinter::Point).height() - position.y() * 72 / _printer->resolution();
+            _playBookmarks.push_back(bookmark);
+        }
+    } catch (...) {
+        cancel();
+        throw;
+    }
+    ++_pagesDone;
+
+    if (_nextPlay >= _plays.size()) {
+        finish();
+    }
+    return _finished;
+}
+
+/**
+ * @brief Renders all remaining pages at once
+ */
+void PBCPDFExportJob::run() {
+    PBC_PERF_SCOPE("pdf.export");
+    while (step() == false) {}
+}
+
+/**
+ * @brief Stops an unfinished job and removes the partial file
+ */
+void PBCPDFExportJob::cancel() {
+    if (_finished || _cancelled) {
+        return;
+    }
+    _cancelled = true;
+    _painter->end();
+    _painter.reset();
+    _printer.reset();
+    QFile::remove(QString::fromStdString(_fileName));
+    PBC_LOG_INFO("pdf", "export to '" << _fileName << "' cancelled after " << _pagesDone << " of " << _pages << " pages");
+}
+
+void PBCPDFExportJob::finish() {
+    bool successful = _painter->end();
+    _painter.reset();
+    _printer.reset();
+    _finished = true;
+    if (successful == false) {
+        QFile::remove(QString::fromStdString(_fileName));
+        throw PBCStorageException("Could not write '" + _fileName + "'.");
+    }
+    addOutline();
+}
+
+/**
+ * @brief Adds bookmarks for the plays (in the order of the pages) and for
+ * the categories (with their plays) to the finished file. The PDF is still
+ * usable without them, so a failure is only logged.
+ */
+void PBCPDFExportJob::addOutline() {
+    PBC_PERF_SCOPE("pdf.outline");
+    std::map<std::string, std::vector<PBCPDFBookmark>> categories;
+    for (unsigned int i = 0; i < _plays.size(); ++i) {
+        for (const PBCCategorySP& category : _plays[i]->categories()) {
+            categories[category->name()].push_back(_playBookmarks[i]);
+        }
+    }
+
+    std::vector<PBCPDFBookmark> outline;
+    if (_playBookmarks.empty() == false) {
+        PBCPDFBookmark plays = _playBookmarks.front();
+        plays.title = "Plays";
+        plays.open = true;
+        plays.children = _playBookmarks;
+        outline.push_back(plays);
+    }
+    if (categories.empty() == false) {
+        PBCPDFBookmark categoryGroup = categories.begin()->second.front();
+        categoryGroup.title = "Categories";
+        categoryGroup.open = true;
+        for (const auto& kv : categories) {
+            PBCPDFBookmark category = kv.second.front();
+            category.title = kv.first;
+            category.children = kv.second;
+            categoryGroup.children.push_back(category);
+        }
+        outline.push_back(categoryGroup);
+    }
+
+    try {
+        PBCPDFOutline::addToFile(_fileName, outline);
+    } catch (PBCStorageException& e) {
+        PBC_LOG_WARNING("pdf", "no outline added to '" << _fileName << "': " << e.what());
+    }
+}
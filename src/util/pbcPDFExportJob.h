@@ -0,0 +1,131 @@
+/** @file pbcPDFExportJob.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCPDFEXPORTJOB_H
+#define PBCPDFEXPORTJOB_H
+
+#include "gui/pbcPlayRenderer.h"
+#include "models/pbcPlay.h"
+#include "util/pbcPDFOutline.h"
+#include <boost/shared_ptr.hpp>
+#include <QRectF>
+#include <QSize>
+#include <QStringList>
+#include <string>
+#include <vector>
+
+class QPainter;
+class QPrinter;
+
+/**
+ * @brief The page layout of a PDF export (see PBCExportPDFDialog). Lengths
+ * are in millimeters; a paper width or height of 0 means that the paper size
+ * is derived from the canvas size.
+ */
+struct PBCPDFLayout {
+    unsigned int paperWidth;
+    unsigned int paperHeight;
+    unsigned int columns;
+    unsigned int rows;
+    unsigned int marginLeft;
+    unsigned int marginRight;
+    unsigned int marginTop;
+    unsigned int marginBottom;
+};
+
+/**
+ * @class PBCPDFExportJob
+ * @brief Exports plays to a PDF file page by page.
+ *
+ * Each call of step() renders one page, so the caller can keep the event loop
+ * running between the pages, show the progress and cancel the export. The
+ * plays are drawn directly with PBCPlayRenderer, so no graphics scenes are
+ * built and only the page that is being rendered is held in memory, no matter
+ * how many plays are exported. A cancelled or destroyed unfinished job
+ * removes the partial file.
+ *
+ * Names and numbers are written as text, so the PDF can be searched. Names
+ * that are not shown on the tiles (e.g. the full name of a play with a code
+ * name) are written as invisible text. A finished file gets an outline with
+ * a bookmark per play and per category.
+ *
+ * The job must be created on the GUI thread, because it reads PBCConfig.
+ * Afterwards it only reads its plays, so it may render on another thread as
+ * long as the plays are not modified meanwhile (QPainter supports painting
+ * on a QPrinter outside of the GUI thread).
+ */
+class PBCPDFExportJob {
+ public:
+    PBCPDFExportJob(const std::string& fileName, const QStringList& playNames, const PBCPDFLayout& layout);
+    PBCPDFExportJob(const std::string& fileName, const std::vector<PBCPlaySP>& plays, const PBCPDFLayout& layout);
+    ~PBCPDFExportJob();
+
+    static PBCRenderStyle renderStyle(const PBCPDFLayout& layout);
+
+    void setEmphasis(const PBCRenderEmphasis& emphasis);
+    void setGeometries(const std::vector<boost::shared_ptr<const PBCPlayGeometry>>& geometries);
+    void setRecording(unsigned int play, const boost::shared_ptr<const PBCPlayRecording>& recording);
+
+    bool step();
+    void run();
+    void cancel();
+
+    bool finished() const { return _finished; }
+    bool cancelled() const { return _cancelled; }
+    unsigned int pages() const { return _pages; }
+    unsigned int pagesDone() const { return _pagesDone; }
+    unsigned int nextPlay() const { return _nextPlay; }
+    const std::string& fileName() const { return _fileName; }
+    const PBCRenderStyle& style() const { return _style; }
+
+ private:
+    const std::string _fileName;
+    const std::vector<PBCPlaySP> _plays;
+    const PBCPDFLayout _layout;
+    boost::shared_ptr<QPrinter> _printer;
+    boost::shared_ptr<QPainter> _painter;
+    PBCRenderStyle _style;
+    PBCRenderEmphasis _emphasis;
+    // the precomputed geometries of the plays (empty if every page lays out its plays)
+    std::vector<boost::shared_ptr<const PBCPlayGeometry>> _geometries;
+    // the recorded plays (empty if the plays are painted), released once they have been rendered
+    std::vector<boost::shared_ptr<const PBCPlayRecording>> _recordings;
+    // the bookmarks of the rendered plays
+    std::vector<PBCPDFBookmark> _playBookmarks;
+    QSize _playSize;
+    QRectF _borderRect;
+    qreal _pixelMarginLeft;
+    qreal _pixelMarginTop;
+    bool _paintBorder;
+    unsigned int _pages;
+    unsigned int _pagesDone;
+    unsigned int _nextPlay;
+    bool _finished;
+    bool _cancelled;
+
+    PBCPDFExportJob(const PBCPDFExportJob& other) = delete;
+    PBCPDFExportJob& operator=(const PBCPDFExportJob& other) = delete;
+
+    void finish();
+    void addOutline();
+};
+
+#endif  // PBCPDFEXPORTJOB_H
@@ -0,0 +1,699 @@
+/** @file pbcPDFOutline.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcPDFOutline.h"
+#include "util/pbcExceptions.h"
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <locale>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+// A reference to an indirect object: the object number and the generation
+typedef std::pair<unsigned int, unsigned int> PBCPDFReference;
+
+// The entries of a dictionary, in the order of the file. The values are the
+// raw bytes of the file.
+typedef std::vector<std::pair<std::string, std::string>> PBCPDFDictionary;
+
+struct PBCPDFXrefEntry {
+    size_t offset;
+    unsigned int generation;
+};
+
+/**
+ * @brief Reads parts of a PDF file, so that only the end of the file and the
+ * objects that are needed for the outline are read
+ */
+struct PBCPDFSource {
+    size_t size;
+    // reads up to length bytes from the offset on
+    std::function<std::string(size_t offset, size_t length)> read;
+};
+
+// Thrown by the parser when it reaches the end of the part of the file that
+// has been read, so that a larger part is read (see parseAt())
+struct PBCPDFEndOfData {};
+
+// Thrown by the parser for invalid or unsupported syntax. The message is
+// completed with the location and turned into a PBCStorageException.
+struct PBCPDFSyntaxError {
+    std::string message;
+};
+
+// the size of the part of the file that is read at first for every object
+static const size_t READ_SIZE = 4096;
+// the offset of the last cross-reference table must be within this many bytes
+// from the end of the file
+static const size_t TAIL_SIZE = 1024;
+
+static void fail(const std::string& msg) {
+    throw PBCStorageException("Could not add the outline to the PDF file: " + msg);
+}
+
+static void syntaxError(const std::string& msg) {
+    throw PBCPDFSyntaxError{msg};
+}
+
+static bool isWhitespace(char c) {
+    return c == '\0' || c == '\t' || c == '\n' || c == '\f' || c == '\r' || c == ' ';
+}
+
+static bool isDelimiter(char c) {
+    return std::strchr("()<>[]{}/%", c) != NULL;
+}
+
+/**
+ * @brief Makes sure that the given number of bytes from the position on has
+ * been read
+ */
+static void need(const std::string& pdf, size_t pos, size_t count) {
+    if (pos + count > pdf.size()) {
+        throw PBCPDFEndOfData();
+    }
+}
+
+static void skipWhitespace(const std::string& pdf, size_t& pos) {  // NOLINT
+    while (true) {
+        need(pdf, pos, 1);
+        if (pdf[pos] == '%') {
+            while (pos < pdf.size() && pdf[pos] != '\n' && pdf[pos] != '\r') {
+                ++pos;
+            }
+        } else if (isWhitespace(pdf[pos])) {
+            ++pos;
+        } else {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Reads a regular token (a number, a keyword or a boolean)
+ */
+static std::string readToken(const std::string& pdf, size_t& pos) {  // NOLINT
+    skipWhitespace(pdf, pos);
+    size_t start = pos;
+    while (pos < pdf.size() && !isWhitespace(pdf[pos]) && !isDelimiter(pdf[pos])) {
+        ++pos;
+    }
+    // the token may go on in the part of the file that has not been read
+    need(pdf, pos, 1);
+    return pdf.substr(start, pos - start);
+}
+
+static bool isNumber(const std::string& token) {
+    return token.empty() == false && token.find_first_not_of("0123456789") == std::string::npos;
+}
+
+static unsigned long readNumber(const std::string& pdf,
+                                size_t& pos,  // NOLINT
+                                unsigned long max = std::numeric_limits<unsigned long>::max()) {
+    std::string token = readToken(pdf, pos);
+    if (isNumber(token) == false) {
+        syntaxError("expected a number at position " + std::to_string(pos));
+    }
+    unsigned long number = 0;
+    try {
+        number = std::stoul(token);
+    } catch (std::out_of_range&) {
+        syntaxError("the number " + token + " is too large");
+    }
+    if (number > max) {
+        syntaxError("the number " + token + " is too large");
+    }
+    return number;
+}
+
+static unsigned int readObjectNumber(const std::string& pdf, size_t& pos) {  // NOLINT
+    return readNumber(pdf, pos, std::numeric_limits<unsigned int>::max());
+}
+
+static void expectKeyword(const std::string& pdf, size_t& pos, const std::string& keyword) {  // NOLINT
+    if (readToken(pdf, pos) != keyword) {
+        syntaxError("expected '" + keyword + "' at position " + std::to_string(pos));
+    }
+}
+
+/**
+ * @brief Skips a direct object. References ("1 0 R") are skipped as a whole.
+ */
+static void skipObject(const std::string& pdf, size_t& pos) {  // NOLINT
+    skipWhitespace(pdf, pos);
+    need(pdf, pos, 2);
+    if (pdf.compare(pos, 2, "<<") == 0) {
+        pos += 2;
+        while (true) {
+            skipWhitespace(pdf, pos);
+            need(pdf, pos, 2);
+            if (pdf.compare(pos, 2, ">>") == 0) {
+                pos += 2;
+                return;
+            }
+            skipObject(pdf, pos);
+        }
+    } else if (pdf[pos] == '[') {
+        ++pos;
+        while (true) {
+            skipWhitespace(pdf, pos);
+            if (pdf[pos] == ']') {
+                ++pos;
+                return;
+            }
+            skipObject(pdf, pos);
+        }
+    } else if (pdf[pos] == '(') {
+        unsigned int depth = 0;
+        for (++pos; pos < pdf.size(); ++pos) {
+            if (pdf[pos] == '\\') {
+                ++pos;
+            } else if (pdf[pos] == '(') {
+                ++depth;
+            } else if (pdf[pos] == ')') {
+                if (depth == 0) {
+                    ++pos;
+                    return;
+                }
+                --depth;
+            }
+        }
+        throw PBCPDFEndOfData();
+    } else if (pdf[pos] == '<') {
+        pos = pdf.find('>', pos);
+        if (pos == std::string::npos) {
+            throw PBCPDFEndOfData();
+        }
+        ++pos;
+    } else if (pdf[pos] == '/') {
+        ++pos;
+        readToken(pdf, pos);
+    } else {
+        std::string token = readToken(pdf, pos);
+        if (token.empty()) {
+            syntaxError("unexpected '" + std::string(1, pdf[pos]) + "' at position " + std::to_string(pos));
+        }
+        if (isNumber(token)) {
+            size_t end = pos;
+            if (isNumber(readToken(pdf, end)) && readToken(pdf, end) == "R") {
+                pos = end;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Parses the dictionary at the given position
+ * @return The entries of the dictionary, without the slashes of the keys
+ */
+static PBCPDFDictionary parseDictionary(const std::string& pdf, size_t& pos) {  // NOLINT
+    skipWhitespace(pdf, pos);
+    need(pdf, pos, 2);
+    if (pdf.compare(pos, 2, "<<") != 0) {
+        syntaxError("expected a dictionary at position " + std::to_string(pos));
+    }
+    pos += 2;
+    PBCPDFDictionary dictionary;
+    while (true) {
+        skipWhitespace(pdf, pos);
+        need(pdf, pos, 2);
+        if (pdf.compare(pos, 2, ">>") == 0) {
+            pos += 2;
+            return dictionary;
+        }
+        if (pdf[pos] != '/') {
+            syntaxError("expected a name at position " + std::to_string(pos));
+        }
+        ++pos;
+        std::string key = readToken(pdf, pos);
+        skipWhitespace(pdf, pos);
+        size_t start = pos;
+        skipObject(pdf, pos);
+        dictionary.push_back(std::make_pair(key, pdf.substr(start, pos - start)));
+    }
+}
+
+/**
+ * @brief Parses the part of the file that starts at the given offset. If the
+ * parser reaches the end of the part that has been read, a part twice as
+ * large is read and parsed again.
+ * @param source The file
+ * @param offset The offset of the parsed object
+ * @param what The parsed object, for error messages
+ * @param parse Parses the part from position 0 on
+ */
+static void parseAt(const PBCPDFSource& source,
+                    size_t offset,
+                    const std::string& what,
+                    const std::function<void(const std::string&)>& parse) {
+    if (offset >= source.size) {
+        fail("invalid offset " + std::to_string(offset) + " of " + what);
+    }
+    for (size_t length = READ_SIZE; ; length *= 2) {
+        std::string part = source.read(offset, length);
+        if (part.size() < std::min(length, source.size - offset)) {
+            fail("could not read " + what);
+        }
+        const bool complete = offset + part.size() == source.size;
+        if (complete) {
+            part += '\n';  // ends the last token of the file
+        }
+        try {
+            parse(part);
+            return;
+        } catch (PBCPDFEndOfData&) {
+            if (complete) {
+                fail("unexpected end of file in " + what);
+            }
+        } catch (PBCPDFSyntaxError& e) {
+            fail(e.message + " in " + what + " at offset " + std::to_string(offset));
+        }
+    }
+}
+
+static const std::string* findValue(const PBCPDFDictionary& dictionary, const std::string& key) {
+    for (const auto& entry : dictionary) {
+        if (entry.first == key) {
+            return &entry.second;
+        }
+    }
+    return NULL;
+}
+
+// The values of dictionaries end with their last token, so a space is
+// appended before parsing them
+static unsigned long parseNumber(const std::string& value,
+                                 unsigned long max = std::numeric_limits<unsigned long>::max()) {
+    const std::string text = value + " ";
+    size_t pos = 0;
+    return readNumber(text, pos, max);
+}
+
+static PBCPDFReference parseReference(const std::string& value) {
+    const std::string text = value + " ";
+    size_t pos = 0;
+    PBCPDFReference reference;
+    reference.first = readObjectNumber(text, pos);
+    reference.second = readObjectNumber(text, pos);
+    expectKeyword(text, pos, "R");
+    return reference;
+}
+
+/**
+ * @brief Reads a cross-reference table and the tables of the previous
+ * updates. Entries that are already known (from later updates) are kept.
+ * @return The trailer of the table at the given offset
+ */
+static PBCPDFDictionary readXref(const PBCPDFSource& source,
+                                 size_t offset,
+                                 std::map<unsigned int, PBCPDFXrefEntry>& xref,  // NOLINT
+                                 std::set<size_t>& visited) {  // NOLINT
+    if (visited.insert(offset).second == false) {
+        fail("invalid cross-reference offset " + std::to_string(offset));
+    }
+    std::map<unsigned int, PBCPDFXrefEntry> entries;
+    PBCPDFDictionary trailer;
+    parseAt(source, offset, "the cross-reference table", [&](const std::string& pdf) {
+        entries.clear();
+        size_t pos = 0;
+        std::string token = readToken(pdf, pos);
+        if (token != "xref") {
+            syntaxError("cross-reference streams are not supported");
+        }
+        while (true) {
+            size_t start = pos;
+            token = readToken(pdf, pos);
+            if (token == "trailer") {
+                break;
+            }
+            pos = start;
+            const unsigned int first = readObjectNumber(pdf, pos);
+            const unsigned int count = readObjectNumber(pdf, pos);
+            if (count > std::numeric_limits<unsigned int>::max() - first) {
+                syntaxError("invalid cross-reference section at position " + std::to_string(pos));
+            }
+            for (unsigned int i = 0; i < count; ++i) {
+                PBCPDFXrefEntry entry;
+                entry.offset = readNumber(pdf, pos);
+                entry.generation = readObjectNumber(pdf, pos);
+                std::string type = readToken(pdf, pos);
+                if (type != "n" && type != "f") {
+                    syntaxError("invalid cross-reference entry at position " + std::to_string(pos));
+                }
+                if (type == "n") {
+                    entries.insert(std::make_pair(first + i, entry));
+                }
+            }
+        }
+        trailer = parseDictionary(pdf, pos);
+    });
+    xref.insert(entries.begin(), entries.end());
+    const std::string* prev = findValue(trailer, "Prev");
+    if (prev != NULL) {
+        readXref(source, parseNumber(*prev), xref, visited);
+    }
+    return trailer;
+}
+
+static PBCPDFDictionary readObject(const PBCPDFSource& source,
+                                   const std::map<unsigned int, PBCPDFXrefEntry>& xref,
+                                   const PBCPDFReference& reference) {
+    auto it = xref.find(reference.first);
+    if (it == xref.end() || it->second.generation != reference.second) {
+        fail("object " + std::to_string(reference.first) + " is missing");
+    }
+    PBCPDFDictionary dictionary;
+    parseAt(source, it->second.offset, "object " + std::to_string(reference.first), [&](const std::string& pdf) {
+        size_t pos = 0;
+        if (readNumber(pdf, pos) != reference.first || readNumber(pdf, pos) != reference.second) {
+            syntaxError("another object is at its offset");
+        }
+        expectKeyword(pdf, pos, "obj");
+        dictionary = parseDictionary(pdf, pos);
+    });
+    return dictionary;
+}
+
+/**
+ * @brief Collects the pages of a page tree in document order
+ */
+static void collectPages(const PBCPDFSource& source,
+                         const std::map<unsigned int, PBCPDFXrefEntry>& xref,
+                         const PBCPDFReference& node,
+                         std::vector<PBCPDFReference>& pages,  // NOLINT
+                         unsigned int depth = 0) {
+    if (depth > 64) {
+        fail("the page tree is too deep");
+    }
+    PBCPDFDictionary dictionary = readObject(source, xref, node);
+    const std::string* type = findValue(dictionary, "Type");
+    if (type != NULL && *type == "/Page") {
+        pages.push_back(node);
+        return;
+    }
+    const std::string* kids = findValue(dictionary, "Kids");
+    if (kids == NULL || kids->empty() || (*kids)[0] != '[') {
+        fail("unsupported page tree");
+    }
+    // the array ends with ']', so the parser does not reach its end
+    size_t pos = 1;
+    while (true) {
+        skipWhitespace(*kids, pos);
+        if ((*kids)[pos] == ']') {
+            break;
+        }
+        size_t start = pos;
+        skipObject(*kids, pos);
+        collectPages(source, xref, parseReference(kids->substr(start, pos - start)), pages, depth + 1);
+    }
+}
+
+/**
+ * @brief Encodes a UTF-8 string as a hexadecimal UTF-16BE text string.
+ * Invalid bytes are replaced with U+FFFD.
+ */
+static std::string textString(const std::string& utf8) {
+    std::string result = "<FEFF";
+    char buffer[5];
+    auto append = [&result, &buffer](unsigned int unit) {
+        std::snprintf(buffer, sizeof(buffer), "%04X", unit);
+        result += buffer;
+    };
+    for (size_t i = 0; i < utf8.size();) {
+        unsigned char c = utf8[i];
+        unsigned int length = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 0;
+        unsigned int codePoint = length == 1 ? c : length == 2 ? c & 0x1F : length == 3 ? c & 0x0F : c & 0x07;
+        bool valid = length != 0 && i + length <= utf8.size();
+        for (unsigned int j = 1; valid && j < length; ++j) {
+            unsigned char continuation = utf8[i + j];
+            valid = (continuation >> 6) == 0x2;
+            codePoint = (codePoint << 6) | (continuation & 0x3F);
+        }
+        if (valid == false || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+            append(0xFFFD);
+            ++i;
+            continue;
+        }
+        if (codePoint >= 0x10000) {
+            codePoint -= 0x10000;
+            append(0xD800 + (codePoint >> 10));
+            append(0xDC00 + (codePoint & 0x3FF));
+        } else {
+            append(codePoint);
+        }
+        i += length;
+    }
+    return result + ">";
+}
+
+/**
+ * @brief The number of entries that are shown if the given entries are shown
+ */
+static unsigned int visibleCount(const std::vector<PBCPDFBookmark>& bookmarks) {
+    unsigned int count = 0;
+    for (const PBCPDFBookmark& bookmark : bookmarks) {
+        count += 1 + (bookmark.open ? visibleCount(bookmark.children) : 0);
+    }
+    return count;
+}
+
+/**
+ * @brief Makes a stream write numbers the way PDF expects them
+ */
+static void setUpNumbers(std::ostream& stream) {  // NOLINT
+    stream.imbue(std::locale::classic());
+    stream.setf(std::ios::fixed);
+    stream.precision(2);
+}
+
+/**
+ * @brief Writes the outline items of the given siblings (and their
+ * descendants). The siblings get consecutive object numbers.
+ */
+static void writeItems(const std::vector<PBCPDFBookmark>& siblings,
+                       unsigned int parent,
+                       const std::vector<PBCPDFReference>& pages,
+                       unsigned int& nextNumber,  // NOLINT
+                       std::map<unsigned int, std::string>& objects) {  // NOLINT
+    const unsigned int first = nextNumber;
+    nextNumber += siblings.size();
+    for (unsigned int i = 0; i < siblings.size(); ++i) {
+        const PBCPDFBookmark& bookmark = siblings[i];
+        if (bookmark.page >= pages.size()) {
+            fail("a bookmark refers to page " + std::to_string(bookmark.page + 1) + " of a document with " +
+                 std::to_string(pages.size()) + " pages");
+        }
+        const unsigned int number = first + i;
+        std::ostringstream item;
+        setUpNumbers(item);
+        item << "<<\n/Title " << textString(bookmark.title) << "\n/Parent " << parent << " 0 R\n";
+        if (i > 0) {
+            item << "/Prev " << number - 1 << " 0 R\n";
+        }
+        if (i + 1 < siblings.size()) {
+            item << "/Next " << number + 1 << " 0 R\n";
+        }
+        if (bookmark.children.empty() == false) {
+            const unsigned int firstChild = nextNumber;
+            writeItems(bookmark.children, number, pages, nextNumber, objects);
+            const int count = visibleCount(bookmark.children);
+            item << "/First " << firstChild << " 0 R\n"
+                 << "/Last " << firstChild + bookmark.children.size() - 1 << " 0 R\n"
+                 << "/Count " << (bookmark.open ? count : -count) << "\n";
+        }
+        item << "/Dest [" << pages[bookmark.page].first << " " << pages[bookmark.page].second << " R /XYZ "
+             << bookmark.left << " " << bookmark.top << " null]\n>>";
+        objects[number] = item.str();
+    }
+}
+
+/**
+ * @brief Computes the incremental update (see PBCPDFOutline::update())
+ */
+static std::string createUpdate(const PBCPDFSource& source, const std::vector<PBCPDFBookmark>& bookmarks) {
+    const size_t tailSize = std::min(source.size, TAIL_SIZE);
+    const std::string tail = source.read(source.size - tailSize, tailSize) + "\n";
+    size_t pos = tail.rfind("startxref");
+    if (pos == std::string::npos) {
+        fail("no cross-reference table");
+    }
+    pos += std::strlen("startxref");
+    const size_t startXref = readNumber(tail, pos);
+    std::map<unsigned int, PBCPDFXrefEntry> xref;
+    std::set<size_t> visited;
+    PBCPDFDictionary trailer = readXref(source, startXref, xref, visited);
+    const std::string* sizeValue = findValue(trailer, "Size");
+    const std::string* rootValue = findValue(trailer, "Root");
+    if (sizeValue == NULL || rootValue == NULL) {
+        fail("incomplete trailer");
+    }
+    // leaves room for the numbers of the new objects
+    const unsigned int size = parseNumber(*sizeValue, std::numeric_limits<unsigned int>::max() / 2);
+    const PBCPDFReference root = parseReference(*rootValue);
+    PBCPDFDictionary catalog = readObject(source, xref, root);
+    const std::string* pagesValue = findValue(catalog, "Pages");
+    if (pagesValue == NULL) {
+        fail("the document has no pages");
+    }
+    std::vector<PBCPDFReference> pages;
+    collectPages(source, xref, parseReference(*pagesValue), pages);
+
+    // the outline root gets the first free object number, the items the next ones
+    std::map<unsigned int, std::string> objects;
+    const unsigned int outlineRoot = size;
+    unsigned int nextNumber = size + 1;
+    writeItems(bookmarks, outlineRoot, pages, nextNumber, objects);
+    std::ostringstream outline;
+    outline << "<<\n/Type /Outlines\n/First " << size + 1 << " 0 R\n/Last " << size + bookmarks.size()
+            << " 0 R\n/Count " << visibleCount(bookmarks) << "\n>>";
+    objects[outlineRoot] = outline.str();
+
+    std::ostringstream catalogStream;
+    catalogStream << "<<\n";
+    for (const auto& entry : catalog) {
+        if (entry.first != "Outlines" && entry.first != "PageMode") {
+            catalogStream << "/" << entry.first << " " << entry.second << "\n";
+        }
+    }
+    catalogStream << "/Outlines " << outlineRoot << " 0 R\n/PageMode /UseOutlines\n>>";
+
+    std::string result;
+    const char last = tail[tail.size() - 2];  // the tail ends with an additional newline
+    if (last != '\n' && last != '\r') {
+        result += "\n";
+    }
+    std::map<unsigned int, PBCPDFXrefEntry> offsets;
+    offsets[root.first] = PBCPDFXrefEntry{source.size + result.size(), root.second};
+    result += std::to_string(root.first) + " " + std::to_string(root.second) + " obj\n" +
+              catalogStream.str() + "\nendobj\n";
+    for (const auto& object : objects) {
+        offsets[object.first] = PBCPDFXrefEntry{source.size + result.size(), 0};
+        result += std::to_string(object.first) + " 0 obj\n" + object.second + "\nendobj\n";
+    }
+
+    const size_t newXref = source.size + result.size();
+    result += "xref\n";
+    char entry[21];
+    for (auto it = offsets.begin(); it != offsets.end();) {
+        auto end = it;
+        unsigned int count = 0;
+        while (end != offsets.end() && end->first == it->first + count) {
+            ++end;
+            ++count;
+        }
+        result += std::to_string(it->first) + " " + std::to_string(count) + "\n";
+        for (; it != end; ++it) {
+            std::snprintf(entry, sizeof(entry), "%010lu %05u n \n",
+                          static_cast<unsigned long>(it->second.offset), it->second.generation);
+            result += entry;
+        }
+    }
+
+    result += "trailer\n<<\n/Size " + std::to_string(nextNumber) + "\n/Root " + *rootValue + "\n";
+    for (const char* key : {"Info", "ID"}) {
+        const std::string* value = findValue(trailer, key);
+        if (value != NULL) {
+            result += std::string("/") + key + " " + *value + "\n";
+        }
+    }
+    result += "/Prev " + std::to_string(startXref) + "\n>>\nstartxref\n" + std::to_string(newXref) + "\n%%EOF\n";
+    return result;
+}
+
+/**
+ * @brief Computes the update and reports every error as a
+ * PBCStorageException, because a file without an outline is still usable
+ */
+static std::string outlineUpdate(const PBCPDFSource& source, const std::vector<PBCPDFBookmark>& bookmarks) {
+    if (bookmarks.empty()) {
+        return "";
+    }
+    try {
+        return createUpdate(source, bookmarks);
+    } catch (PBCStorageException&) {
+        throw;
+    } catch (PBCPDFEndOfData&) {
+        fail("unexpected end of a value");
+    } catch (PBCPDFSyntaxError& e) {
+        fail(e.message);
+    } catch (std::exception& e) {
+        fail(e.what());
+    }
+    return "";
+}
+
+/**
+ * @brief Computes the incremental update that adds an outline to a PDF file.
+ * An existing outline is replaced.
+ * @param pdf The content of the PDF file
+ * @param bookmarks The top level entries of the outline
+ * @return The bytes that have to be appended to the file (empty if there are
+ * no bookmarks)
+ * @throws PBCStorageException if the structure of the file is not supported
+ */
+std::string PBCPDFOutline::update(const std::string &pdf, const std::vector<PBCPDFBookmark> &bookmarks) {
+    PBCPDFSource source{pdf.size(), [&pdf](size_t offset, size_t length) {
+        return pdf.substr(offset, length);
+    }};
+    return outlineUpdate(source, bookmarks);
+}
+
+/**
+ * @brief Adds an outline to a PDF file (see update()). Only the parts of the
+ * file that are needed are read. If the update cannot be written completely,
+ * the file is cut back to its original size.
+ * @throws PBCStorageException if the file cannot be read or written or if
+ * its structure is not supported
+ */
+void PBCPDFOutline::addToFile(const std::string &fileName, const std::vector<PBCPDFBookmark> &bookmarks) {
+    QFile file(QString::fromStdString(fileName));
+    // opening a file that does not exist for writing would create it
+    if (file.exists() == false || file.open(QIODevice::ReadWrite) == false) {
+        throw PBCStorageException("Could not open '" + fileName + "': " + file.errorString().toStdString());
+    }
+    const qint64 size = file.size();
+    PBCPDFSource source{static_cast<size_t>(size), [&file](size_t offset, size_t length) {
+        if (file.seek(offset) == false) {
+            return std::string();
+        }
+        return file.read(length).toStdString();
+    }};
+    const std::string appended = outlineUpdate(source, bookmarks);
+    if (appended.empty()) {
+        return;
+    }
+    if (file.seek(size) == false ||
+        file.write(appended.data(), appended.size()) != static_cast<qint64>(appended.size()) ||
+        file.flush() == false) {
+        // a partial update would break the file
+        const std::string error = file.errorString().toStdString();
+        file.resize(size);
+        throw PBCStorageException("Could not write '" + fileName + "': " + error);
+    }
+}
@@ -0,0 +1,61 @@
+/** @file pbcPDFOutline.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCPDFOUTLINE_H
+#define PBCPDFOUTLINE_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief An entry of the outline (the bookmarks) of a PDF file
+ */
+struct PBCPDFBookmark {
+    std::string title;  // UTF-8
+    // the zero-based page the bookmark jumps to
+    unsigned int page = 0;
+    // the position that is shown at the top left of the window, in points
+    // from the bottom left corner of the page
+    double left = 0;
+    double top = 0;
+    // true if the children are shown initially
+    bool open = false;
+    std::vector<PBCPDFBookmark> children;
+};
+
+/**
+ * @class PBCPDFOutline
+ * @brief Adds an outline to an existing PDF file.
+ *
+ * Qt cannot write outlines, so the outline is appended to the finished file
+ * as an incremental update: the outline objects and a new version of the
+ * document catalog that refers to them. The rest of the file is left
+ * untouched, and only its end, the cross-reference tables, the catalog and
+ * the page tree are read. Only files with classic cross-reference tables (as
+ * written by QPrinter) are supported.
+ */
+class PBCPDFOutline {
+ public:
+    static std::string update(const std::string& pdf, const std::vector<PBCPDFBookmark>& bookmarks);
+    static void addToFile(const std::string& fileName, const std::vector<PBCPDFBookmark>& bookmarks);
+};
+
+#endif  // PBCPDFOUTLINE_H
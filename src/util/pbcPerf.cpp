@@ -0,0 +1,216 @@
+/** @file pbcPerf.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcPerf.h"
+#include "util/pbcJson.h"
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+std::atomic<bool> PBCPerf::_enabled(false);
+
+static unsigned int bucketOf(uint64_t value) {
+    unsigned int bucket = 0;
+    while (value > 0 && bucket < PBCPerfMetric::BUCKETS - 1) {
+        value >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+/**
+ * @brief The upper limit (exclusive) of the values that are counted in a bucket
+ * @param bucket The index of the bucket
+ * @return 2^bucket
+ */
+uint64_t PBCPerfSnapshot::bucketLimit(unsigned int bucket) {
+    return static_cast<uint64_t>(1) << bucket;
+}
+
+double PBCPerfSnapshot::mean() const {
+    return count == 0 ? 0.0 : static_cast<double>(sum) / count;
+}
+
+/**
+ * @brief Estimates a percentile from the histogram
+ * @param p The percentile (between 0 and 1)
+ * @return The upper limit of the bucket that contains the percentile (but at
+ * most the maximum value)
+ */
+uint64_t PBCPerfSnapshot::percentile(double p) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(p * count);
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen > rank || seen == count) {
+            return std::min(bucketLimit(i) - 1, max);
+        }
+    }
+    return max;
+}
+
+
+PBCPerfMetric::PBCPerfMetric(const std::string &name, PBCPerfSnapshot::Kind kind) :
+    _name(name),
+    _kind(kind) {
+    reset();
+}
+
+/**
+ * @brief Records a value
+ * @param value A duration in microseconds (for timers) or an increment (for
+ * counters)
+ */
+void PBCPerfMetric::record(uint64_t value) {
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(value, std::memory_order_relaxed);
+    _buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t min = _min.load(std::memory_order_relaxed);
+    while (value < min && !_min.compare_exchange_weak(min, value, std::memory_order_relaxed)) {}
+    uint64_t max = _max.load(std::memory_order_relaxed);
+    while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+}
+
+PBCPerfSnapshot PBCPerfMetric::snapshot() const {
+    PBCPerfSnapshot snapshot;
+    snapshot.name = _name;
+    snapshot.kind = _kind;
+    snapshot.count = _count.load(std::memory_order_relaxed);
+    snapshot.sum = _sum.load(std::memory_order_relaxed);
+    snapshot.min = snapshot.count == 0 ? 0 : _min.load(std::memory_order_relaxed);
+    snapshot.max = _max.load(std::memory_order_relaxed);
+    for (const std::atomic<uint64_t>& bucket : _buckets) {
+        snapshot.buckets.push_back(bucket.load(std::memory_order_relaxed));
+    }
+    return snapshot;
+}
+
+void PBCPerfMetric::reset() {
+    _count = 0;
+    _sum = 0;
+    _min = std::numeric_limits<uint64_t>::max();
+    _max = 0;
+    for (std::atomic<uint64_t>& bucket : _buckets) {
+        bucket = 0;
+    }
+}
+
+
+/**
+ * @brief The metrics by name. They are never destroyed, so call sites can
+ * keep pointers to them.
+ */
+static std::map<std::string, std::unique_ptr<PBCPerfMetric>>& registry(std::unique_lock<std::mutex>& lock) {  // NOLINT
+    static std::mutex* mutex = new std::mutex();
+    static auto* metrics = new std::map<std::string, std::unique_ptr<PBCPerfMetric>>();
+    lock = std::unique_lock<std::mutex>(*mutex);
+    return *metrics;
+}
+
+void PBCPerf::setEnabled(bool enabled) {
+    _enabled.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Gets a metric and creates it if necessary
+ * @param name The name of the metric
+ * @param kind The kind of a new metric
+ * @return The metric
+ */
+PBCPerfMetric* PBCPerf::metric(const std::string &name, PBCPerfSnapshot::Kind kind) {
+    std::unique_lock<std::mutex> lock;
+    std::map<std::string, std::unique_ptr<PBCPerfMetric>>& metrics = registry(lock);
+    std::unique_ptr<PBCPerfMetric>& metric = metrics[name];
+    if (metric == NULL) {
+        metric.reset(new PBCPerfMetric(name, kind));
+    }
+    return metric.get();
+}
+
+/**
+ * @brief Gets the current values of all metrics
+ * @return The metrics ordered by name
+ */
+std::vector<PBCPerfSnapshot> PBCPerf::snapshot() {
+    std::unique_lock<std::mutex> lock;
+    std::vector<PBCPerfSnapshot> result;
+    for (const auto& kv : registry(lock)) {
+        result.push_back(kv.second->snapshot());
+    }
+    return result;
+}
+
+/**
+ * @brief Sets all metrics back to zero
+ */
+void PBCPerf::reset() {
+    std::unique_lock<std::mutex> lock;
+    for (const auto& kv : registry(lock)) {
+        kv.second->reset();
+    }
+}
+
+/**
+ * @brief Dumps all metrics as JSON. Empty histogram buckets are omitted.
+ * @return The JSON document
+ */
+std::string PBCPerf::toJson() {
+    std::ostringstream json;
+    json << "{\n  \"enabled\": " << (enabled() ? "true" : "false") << ",\n  \"metrics\": [";
+    bool firstMetric = true;
+    for (const PBCPerfSnapshot& metric : snapshot()) {
+        json << (firstMetric ? "\n" : ",\n");
+        firstMetric = false;
+        bool timer = metric.kind == PBCPerfSnapshot::TIMER;
+        std::string unit = timer ? "_us" : "";
+        json << "    {\"name\": " << PBCJson::string(metric.name)
+             << ", \"kind\": \"" << (timer ? "timer" : "counter") << "\""
+             << ", \"count\": " << metric.count
+             << ", \"sum" << unit << "\": " << metric.sum
+             << ", \"min" << unit << "\": " << metric.min
+             << ", \"max" << unit << "\": " << metric.max
+             << ", \"mean" << unit << "\": " << metric.mean()
+             << ", \"p50" << unit << "\": " << metric.percentile(0.5)
+             << ", \"p95" << unit << "\": " << metric.percentile(0.95)
+             << ", \"histogram\": [";
+        bool firstBucket = true;
+        for (unsigned int i = 0; i < metric.buckets.size(); ++i) {
+            if (metric.buckets[i] == 0) {
+                continue;
+            }
+            json << (firstBucket ? "" : ", ")
+                 << "{\"below" << unit << "\": " << PBCPerfSnapshot::bucketLimit(i)
+                 << ", \"count\": " << metric.buckets[i] << "}";
+            firstBucket = false;
+        }
+        json << "]}";
+    }
+    json << "\n  ]\n}\n";
+    return json.str();
+}
@@ -0,0 +1,176 @@
+/** @file pbcPerf.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCPERF_H
+#define PBCPERF_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "util/pbcTrace.h"
+
+/**
+ * @brief A copy of the values of a metric at one point in time
+ */
+struct PBCPerfSnapshot {
+    enum Kind {
+        TIMER,    // values are durations in microseconds
+        COUNTER   // values are increments
+    };
+
+    std::string name;
+    Kind kind;
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    std::vector<uint64_t> buckets;
+
+    double mean() const;
+    uint64_t percentile(double p) const;
+    static uint64_t bucketLimit(unsigned int bucket);
+};
+
+/**
+ * @class PBCPerfMetric
+ * @brief A timer or counter which aggregates its values into a histogram.
+ *
+ * Bucket i counts the values below 2^i (and at least 2^(i-1)). Recording is
+ * lock-free, so metrics can be used from background threads.
+ */
+class PBCPerfMetric {
+ public:
+    static const unsigned int BUCKETS = 32;
+
+    PBCPerfMetric(const std::string& name, PBCPerfSnapshot::Kind kind);
+    void record(uint64_t value);
+    const std::string& name() const { return _name; }
+    PBCPerfSnapshot snapshot() const;
+    void reset();
+
+ private:
+    const std::string _name;
+    const PBCPerfSnapshot::Kind _kind;
+    std::atomic<uint64_t> _count;
+    std::atomic<uint64_t> _sum;
+    std::atomic<uint64_t> _min;
+    std::atomic<uint64_t> _max;
+    std::array<std::atomic<uint64_t>, BUCKETS> _buckets;
+
+    PBCPerfMetric(const PBCPerfMetric& other) = delete;
+    PBCPerfMetric& operator=(const PBCPerfMetric& other) = delete;
+};
+
+/**
+ * @class PBCPerf
+ * @brief The registry of all performance metrics of the process.
+ *
+ * Recording is disabled by default. Then a PBC_PERF_COUNT costs a single
+ * relaxed atomic load and a PBC_PERF_SCOPE two (one for tracing). Defining PBC_DISABLE_PERF removes them
+ * completely at compile time.
+ */
+class PBCPerf {
+ public:
+    static bool enabled() {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+    static void setEnabled(bool enabled);
+    static PBCPerfMetric* metric(const std::string& name, PBCPerfSnapshot::Kind kind);
+    static std::vector<PBCPerfSnapshot> snapshot();
+    static void reset();
+    static std::string toJson();
+
+ private:
+    static std::atomic<bool> _enabled;
+};
+
+/**
+ * @class PBCPerfTimer
+ * @brief Records the lifetime of the scope it has been created in (if
+ * recording has been enabled when the scope has been entered). If tracing has
+ * been enabled, the scope is also recorded as a span (see PBCTrace).
+ */
+class PBCPerfTimer {
+ public:
+    explicit PBCPerfTimer(PBCPerfMetric* metric) :
+        _metric(metric),
+        _recorded(PBCPerf::enabled()),
+        _traced(PBCTrace::enabled()) {
+        if (_recorded || _traced) {
+            _start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~PBCPerfTimer() {
+        if (_recorded || _traced) {
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            if (_recorded) {
+                _metric->record(std::chrono::duration_cast<std::chrono::microseconds>(end - _start).count());
+            }
+            if (_traced) {
+                PBCTrace::record(&_metric->name(), _start, end);
+            }
+        }
+    }
+
+ private:
+    PBCPerfMetric* _metric;
+    const bool _recorded;
+    const bool _traced;
+    std::chrono::steady_clock::time_point _start;
+
+    PBCPerfTimer(const PBCPerfTimer& other) = delete;
+    PBCPerfTimer& operator=(const PBCPerfTimer& other) = delete;
+};
+
+#define PBC_PERF_CONCAT_IMPL(a, b) a##b
+#define PBC_PERF_CONCAT(a, b) PBC_PERF_CONCAT_IMPL(a, b)
+
+#ifdef PBC_DISABLE_PERF
+#define PBC_PERF_SCOPE(name) do {} while (0)
+#define PBC_PERF_COUNT(name, value) do {} while (0)
+#else
+/**
+ * @brief Times the rest of the enclosing scope as metric "name". The metric is
+ * looked up only once per call site.
+ */
+#define PBC_PERF_SCOPE(name) \
+    static PBCPerfMetric* const PBC_PERF_CONCAT(pbcPerfMetric, __LINE__) = \
+        PBCPerf::metric(name, PBCPerfSnapshot::TIMER); \
+    PBCPerfTimer PBC_PERF_CONCAT(pbcPerfTimer, __LINE__)(PBC_PERF_CONCAT(pbcPerfMetric, __LINE__))
+
+/**
+ * @brief Adds a value to the counter "name"
+ */
+#define PBC_PERF_COUNT(name, value) \
+    do { \
+        if (PBCPerf::enabled()) { \
+            static PBCPerfMetric* const pbcPerfCounter = PBCPerf::metric(name, PBCPerfSnapshot::COUNTER); \
+            pbcPerfCounter->record(value); \
+        } \
+    } while (0)
+#endif
+
+#endif  // PBCPERF_H
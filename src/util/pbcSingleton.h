@@ -22,7 +22,8 @@
 #ifndef PBCSINGLETON_H
 #define PBCSINGLETON_H
 
-#include <stddef.h>
+#include "util/pbcContext.h"
+#include <cstdint>
 
 /**
  * @class PBCSingleton
@@ -30,14 +31,15 @@
  * that inherits PBCSingleton.
  *
  * A class C has to inherit PBCSingleton<C> and must have a protected
- * constructor. Then it is enforced to have only one instance in the whole
- * application. For more information on the singleton pattern see
+ * constructor. Then it is enforced to have only one instance per PBCContext.
+ * The instance is owned by the context that is bound to the calling thread
+ * (the global context if there is none), so the application as a whole still
+ * sees a single instance. For more information on the singleton pattern see
  * https://en.wikipedia.org/wiki/Singleton_pattern
  */
 template <class T>
 class PBCSingleton {
  private:
-    static T* _instance;
     PBCSingleton(const PBCSingleton& obj) {}
 
  protected:
@@ -46,13 +48,17 @@ class PBCSingleton {
 
  public:
     static T* getInstance() {
-        if(_instance == NULL) {
-            _instance = new T();
+        // services live as long as their context, so the last one found on
+        // this thread can be returned without locking
+        static thread_local uint64_t cachedContextId = 0;
+        static thread_local T* cachedInstance = NULL;
+        PBCContext& context = PBCContext::current();
+        if (context.id() != cachedContextId) {
+            cachedInstance = context.service<T>([]() { return new T(); });
+            cachedContextId = context.id();
         }
-        return _instance;
+        return cachedInstance;
     }
 };
 
-template <class T> T* PBCSingleton<T>::_instance = NULL;
-
 #endif  // PBCSINGLETON_H
@@ -0,0 +1,111 @@
+/** @file pbcStartupProfiler.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcStartupProfiler.h"
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static bool profilerEnabled = false;
+static Clock::time_point startTime;
+static Clock::time_point lastPhaseEnd;
+static std::vector<std::pair<std::string, Clock::duration>> phases;
+static std::mutex measurementsMutex;
+static std::vector<std::pair<std::string, Clock::duration>> measurements;
+
+/**
+ * @brief Enables the profiler and starts the first phase. Should be called
+ * as early as possible.
+ */
+void PBCStartupProfiler::enable() {
+    profilerEnabled = true;
+    startTime = Clock::now();
+    lastPhaseEnd = startTime;
+    phases.clear();
+    std::lock_guard<std::mutex> lock(measurementsMutex);
+    measurements.clear();
+}
+
+bool PBCStartupProfiler::enabled() {
+    return profilerEnabled;
+}
+
+/**
+ * @brief Ends the current phase and starts the next one
+ * @param phase The name of the ended phase
+ */
+void PBCStartupProfiler::phaseFinished(const std::string &phase) {
+    if (profilerEnabled == false) {
+        return;
+    }
+    Clock::time_point now = Clock::now();
+    phases.push_back(std::make_pair(phase, now - lastPhaseEnd));
+    lastPhaseEnd = now;
+}
+
+/**
+ * @brief Records the duration of some work within the phases
+ * @param name The name of the work
+ * @param duration The time it took
+ */
+void PBCStartupProfiler::measured(const std::string &name, Clock::duration duration) {
+    if (profilerEnabled == false) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(measurementsMutex);
+    measurements.push_back(std::make_pair(name, duration));
+}
+
+/**
+ * @brief Prints the duration of every phase and the time since enable(),
+ * followed by the work that has been measured within the phases
+ * @param out The stream to print to
+ */
+void PBCStartupProfiler::report(std::ostream &out) {
+    if (profilerEnabled == false) {
+        return;
+    }
+    typedef std::chrono::duration<double, std::milli> Milliseconds;
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << "startup profile:" << std::endl;
+    Clock::duration total = Clock::duration::zero();
+    for (const auto& phase : phases) {
+        total += phase.second;
+        out << "  " << std::left << std::setw(24) << phase.first
+            << std::right << std::fixed << std::setprecision(1)
+            << std::setw(9) << Milliseconds(phase.second).count() << " ms"
+            << "  (total " << Milliseconds(total).count() << " ms)" << std::endl;
+    }
+    std::lock_guard<std::mutex> lock(measurementsMutex);
+    for (const auto& measurement : measurements) {
+        out << "    within: " << std::left << std::setw(16) << measurement.first
+            << std::right << std::fixed << std::setprecision(1)
+            << std::setw(9) << Milliseconds(measurement.second).count() << " ms" << std::endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,49 @@
+/** @file pbcStartupProfiler.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCSTARTUPPROFILER_H
+#define PBCSTARTUPPROFILER_H
+
+#include <chrono>
+#include <ostream>
+#include <string>
+
+/**
+ * @class PBCStartupProfiler
+ * @brief Measures the phases of the application startup (enabled by the
+ * command line option --profile-startup).
+ *
+ * Each phase lasts from the end of the previous phase (or from enable()) to
+ * the call of phaseFinished(). Work that is done lazily at an unknown point
+ * in time (e.g. filling in the default routes) is reported separately with
+ * measured(), which may also be called on other threads. If the profiler is
+ * not enabled, all calls are no-ops.
+ */
+class PBCStartupProfiler {
+ public:
+    static void enable();
+    static bool enabled();
+    static void phaseFinished(const std::string& phase);
+    static void measured(const std::string& name, std::chrono::steady_clock::duration duration);
+    static void report(std::ostream& out);  // NOLINT
+};
+
+#endif  // PBCSTARTUPPROFILER_H
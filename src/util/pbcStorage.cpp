@@ -23,7 +23,13 @@
 #include "pbcController.h"
 #include "models/pbcPlaybook.h"
 #include "util/pbcConfig.h"
+#include "util/pbcBackupStore.h"
 #include "util/pbcExceptions.h"
+#include "util/pbcKeyDerivation.h"
+#include "util/pbcLoadJob.h"
+#include "util/pbcLog.h"
+#include "util/pbcPDFExportJob.h"
+#include "util/pbcPerf.h"
 #include "gui/pbcSettings.h"
 #include <botan/version.h>
 #include <botan/pipe.h>
@@ -35,13 +41,24 @@
 #include <botan/cipher_filter.h>
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <istream>
-#include <iostream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <sstream>
 #include <string>
-#include <QPrinter>
-#include <QPainter>
+#include <vector>
+#include <QDateTime>
+#include <QSaveFile>
 #include "pbcVersion.h"
+#ifndef Q_OS_WIN
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 /**
  * @class PBCStorage
@@ -68,52 +85,365 @@ void PBCStorage::checkVersion(const std::string &version) {
 }
 
 /**
- * @brief Generates a cryptographic key from a password and a random salt value
- * and set them as the current key and salt
+ * @brief Generates a random salt value and derives a cryptographic key from a
+ * password and the salt with the current key derivation (see keyDerivation())
  * @param password The password that the key is derived from
+ * @return The key, the salt and the key derivation
  */
-void PBCStorage::generateAndSetKey(const std::string &password) {
+PBCCryptoKey PBCStorage::deriveKey(const std::string &password) {
     Botan::AutoSeeded_RNG rng;
     Botan::SecureVector<Botan::byte> salt = rng.random_vec(_SALT_SIZE);
-    boost::shared_ptr<Botan::PBKDF> pbkdf(Botan::get_pbkdf(_PBKDF));  // NOLINT
-    Botan::OctetString key = pbkdf->derive_key(_KEY_SIZE, password,
-                                               &salt[0], salt.size(),
-                                               _PBKDF_ITERATIONS);
-    setCryptoKey(key, salt);
+    PBCKdfSettings kdf = keyDerivation();
+    return PBCCryptoKey{deriveKey(password, salt, kdf),
+                        SaltSP(new Botan::SecureVector<Botan::byte>(salt)),
+                        kdf};
 }
 
 /**
- * @brief Resets the current key and salt
- * @param key The new key
- * @param salt The new salt
+ * @brief Derives a cryptographic key from a password and a salt. The keys are
+ * cached, so that reading several files with the same salt (e.g. the
+ * metadata and then the playbook) runs the key derivation only once.
+ * @param password The password that the key is derived from
+ * @param salt The salt
+ * @param kdf The key derivation function and its parameters
+ * @return The key
  */
-void PBCStorage::setCryptoKey(Botan::OctetString key,
-                        Botan::SecureVector<Botan::byte> salt) {
-    _saltSP.reset(new Botan::SecureVector<Botan::byte>(salt));
-    _keySP.reset(new Botan::OctetString(key));
+KeySP PBCStorage::deriveKey(const std::string &password,
+                            const Botan::SecureVector<Botan::byte> &salt,
+                            const PBCKdfSettings &kdf) {
+    std::string kdfString = kdf.toString() + "\n";
+    Botan::SecureVector<Botan::byte> cacheKey(kdfString.begin(), kdfString.end());
+    cacheKey.insert(cacheKey.end(), salt.begin(), salt.end());
+    cacheKey.insert(cacheKey.end(), password.begin(), password.end());
+    {
+        std::lock_guard<std::mutex> lock(_keyCacheMutex);
+        auto it = _keyCache.find(cacheKey);
+        if (it != _keyCache.end()) {
+            return it->second;
+        }
+    }
+
+    PBC_PERF_SCOPE("storage.deriveKey");
+    KeySP key(new Botan::OctetString(PBCKeyDerivation::deriveKey(kdf, password, salt, _KEY_SIZE)));
+    std::lock_guard<std::mutex> lock(_keyCacheMutex);
+    if (_keyCache.size() >= 64) {
+        _keyCache.clear();
+    }
+    _keyCache[cacheKey] = key;
+    return key;
 }
 
 /**
- * @brief Encrypts the input string and writes the result to a file stream
- * @param input The input string (usually the serialized playbook)
- * @param outFile The output file
+ * @brief The key derivation that new keys are derived with. Unless it has
+ * been set before, it is read from the settings or, on first use, calibrated
+ * for this machine and stored in the settings.
+ * @return The key derivation function and its parameters
+ */
+PBCKdfSettings PBCStorage::keyDerivation() {
+    if (_keyDerivation.algorithm.empty()) {
+        std::string setting = getKeyDerivationSetting().toStdString();
+        try {
+            _keyDerivation = PBCKdfSettings::fromString(setting);
+        } catch (PBCStorageException&) {
+            if (!setting.empty()) {
+                PBC_LOG_WARNING("storage", "ignoring invalid key derivation setting: " << setting);
+            }
+            calibrateKeyDerivation(PBCKdfSettings::PBKDF2, _KDF_TARGET_TIME);
+        }
+    }
+    return _keyDerivation;
+}
+
+/**
+ * @brief Sets the key derivation that new keys are derived with. Files that
+ * have been written before keep their key derivation until they are saved
+ * with a new password.
+ * @param kdf The key derivation function and its parameters
+ */
+void PBCStorage::setKeyDerivation(const PBCKdfSettings &kdf) {
+    _keyDerivation = kdf;
+    setKeyDerivationSetting(QString::fromStdString(kdf.toString()));
+}
+
+/**
+ * @brief Chooses the parameters of a key derivation function for this
+ * machine (see PBCKeyDerivation::calibrate()) and uses it for new keys
+ * @param algorithm PBCKdfSettings::PBKDF2 or PBCKdfSettings::ARGON2ID
+ * @param targetTime The desired time of one key derivation
+ * @return The chosen key derivation
+ */
+PBCKdfSettings PBCStorage::calibrateKeyDerivation(const std::string &algorithm,
+                                                  std::chrono::milliseconds targetTime) {
+    PBC_PERF_SCOPE("storage.calibrateKeyDerivation");
+    PBCKdfSettings kdf = PBCKeyDerivation::calibrate(algorithm, targetTime);
+    PBC_LOG_INFO("storage", "calibrated key derivation: " << kdf.toString());
+    setKeyDerivation(kdf);
+    return kdf;
+}
+
+/**
+ * @brief Encrypts or decrypts data with the AEAD cipher
+ * @param cipher The name of the cipher
+ * @param direction Encryption or decryption
+ * @param key The key
+ * @param iv The initialization vector
+ * @param associatedData The data that is authenticated, but not encrypted
+ * @param data The input data. It is replaced by the output data.
+ */
+static void processAEAD(const std::string& cipher,
+                        Botan::Cipher_Dir direction,
+                        const Botan::OctetString& key,
+                        const Botan::SecureVector<Botan::byte>& iv,
+                        const std::vector<Botan::byte>& associatedData,
+                        Botan::SecureVector<Botan::byte>& data) {
+    std::unique_ptr<Botan::AEAD_Mode> aead = Botan::AEAD_Mode::create(cipher, direction);
+    pbcAssert(aead != NULL);
+    aead->set_key(key);
+    aead->set_associated_data(associatedData.data(), associatedData.size());
+    aead->start(iv.data(), iv.size());
+    aead->finish(data);
+}
+
+/**
+ * @brief Reads exactly size bytes from a stream
+ * @throws PBCStorageException if the stream ends before
+ */
+static void readBytes(std::istream& inFile, Botan::byte* data, size_t size) {
+    if (size > 0 && !inFile.read(reinterpret_cast<char*>(data), size)) {
+        throw PBCStorageException("The playbook file is truncated.");
+    }
+}
+
+static void appendBytes(std::vector<Botan::byte>& target, const Botan::byte* data, size_t size) {
+    target.insert(target.end(), data, data + size);
+}
+
+// sizes are stored as 4 bytes in big-endian order
+static void encodeSize(uint32_t size, Botan::byte* bytes) {
+    bytes[0] = static_cast<Botan::byte>(size >> 24);
+    bytes[1] = static_cast<Botan::byte>(size >> 16);
+    bytes[2] = static_cast<Botan::byte>(size >> 8);
+    bytes[3] = static_cast<Botan::byte>(size);
+}
+
+static uint32_t decodeSize(const Botan::byte* bytes) {
+    return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+           (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+}
+
+/**
+ * @brief Syncs a directory to disk, so that a file that has been renamed into
+ * it survives a crash or power loss. On Windows, renames are journaled by the
+ * file system and directories cannot be synced.
+ * @param dirName The directory
+ * @return false if the directory could not be synced
+ */
+static bool syncDirectory(const QString& dirName) {
+#ifdef Q_OS_WIN
+    Q_UNUSED(dirName);
+    return true;
+#else
+    int fd = ::open(QFile::encodeName(dirName).constData(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+#endif
+}
+
+/**
+ * @brief Opens a file for an atomic replacement (see commitFile()). The data
+ * is written to a temporary file in the same directory.
+ * @throws PBCSaveException if the temporary file cannot be created
+ */
+static void openFile(QSaveFile& file, const std::string& fileName) {
+    file.setFileName(QString::fromStdString(fileName));
+    if (!file.open(QIODevice::WriteOnly)) {
+        throw PBCSaveException(fileName + ": " + file.errorString().toStdString());
+    }
+}
+
+/**
+ * @brief Writes data to a file that has been opened with openFile()
+ * @throws PBCSaveException if the data cannot be written
+ */
+static void writeFile(QSaveFile& file, const std::string& fileName, const void* data, size_t size) {
+    if (file.write(reinterpret_cast<const char*>(data), size) != static_cast<qint64>(size)) {
+        throw PBCSaveException(fileName + ": " + file.errorString().toStdString());
+    }
+}
+
+/**
+ * @brief Replaces a file atomically by the temporary file that has been
+ * written with writeFile(). The temporary file is synced to disk (by
+ * QSaveFile) and renamed over the file, then the directory is synced. A
+ * crash leaves either the old or the new file, never a truncated one.
+ * @throws PBCSaveException if the file cannot be replaced. Then the old file
+ * is unchanged and the temporary file is removed.
  */
-void PBCStorage::encrypt(const std::string& input,
-                         std::ofstream& outFile) {
-    pbcAssert(_keySP != NULL && _saltSP != NULL);
-    outFile.write((const char*)_saltSP->data(), _saltSP->size());
+static void commitFile(QSaveFile& file, const std::string& fileName) {
+    PBC_PERF_SCOPE("storage.commit");
+    if (!file.commit()) {
+        throw PBCSaveException(fileName + ": " + file.errorString().toStdString());
+    }
+    if (!syncDirectory(QFileInfo(file.fileName()).absolutePath())) {
+        // the file has been replaced, only its durability is uncertain
+        PBC_LOG_WARNING("storage", "could not sync the directory of " << fileName);
+    }
+}
+
+/**
+ * @brief Collects the metadata of a playbook
+ */
+static PBCPlaybookMetadata metadataOf(const PBCPlaybook& playbook) {
+    PBCPlaybookMetadata metadata;
+    metadata.name = playbook.name();
+    metadata.version = PBCVersion::getVersionString();
+    metadata.numberOfPlayers = playbook.numberOfPlayers();
+    metadata.plays = playbook.plays().size();
+    metadata.categories = playbook.categories().size();
+    metadata.formations = playbook.formations().size();
+    metadata.routes = playbook.routes().size();
+    metadata.lastModified = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    return metadata;
+}
+
+/**
+ * @brief Serializes the metadata of a playbook (see metadataOf())
+ */
+static std::string serializeMetadata(const PBCPlaybook& playbook) {
+    std::ostringstream serializedMetadata;
+    boost::archive::text_oarchive archive(serializedMetadata);
+    archive << metadataOf(playbook);
+    return serializedMetadata.str();
+}
+
+/**
+ * @brief Deserializes a playbook that has been serialized with
+ * PBCStorage::serializePlaybook()
+ * @param serializedPlaybook The serialized playbook
+ * @param targetPlaybook The playbook that is replaced by the deserialized one
+ */
+static void deserializePlaybook(const std::string& serializedPlaybook, PBCPlaybookSP targetPlaybook) {
+    PBC_PERF_SCOPE("storage.deserialize");
+    std::istringstream istream(serializedPlaybook);
+    boost::archive::text_iarchive archive(istream);
+    archive >> *targetPlaybook;
+}
 
-    /*Botan::OctetString preambleBytes(_PREAMBLE);
-    aead->set_ad(preambleBytes.bits_of());*/
+/**
+ * @brief Encrypts the playbook and writes it to a file stream
+ * @param playbook The playbook
+ * @param outFile The output file
+ */
+void PBCStorage::encrypt(const PBCPlaybook& playbook,
+                         std::ostream& outFile) {
+    encrypt(playbook, outFile, _cryptoKey);
+}
 
+/**
+ * @brief Encrypts the playbook and its metadata with the given key and writes
+ * the result (in the newest file format) to a file stream
+ * @param playbook The playbook
+ * @param outFile The output file
+ * @param cryptoKey The encryption key, the salt and the key derivation it
+ * has been derived with
+ */
+void PBCStorage::encrypt(const PBCPlaybook& playbook,
+                         std::ostream& outFile,
+                         const PBCCryptoKey& cryptoKey) {
+    const KeySP& keySP = cryptoKey.key;
+    const SaltSP& saltSP = cryptoKey.salt;
+    pbcAssert(keySP != NULL && saltSP != NULL);
+    std::string serializedPlaybook = serializePlaybook(playbook);
+    std::string metadata = serializeMetadata(playbook);
 
+    PBC_PERF_SCOPE("storage.encrypt");
     Botan::AutoSeeded_RNG rng;
-    Botan::InitializationVector iv = rng.random_vec(_IV_SIZE); //TODO make constant in header
-    outFile.write((const char*)iv.bits_of().data(), iv.bits_of().size());
+    const std::string preambleText = newestPreamble(cryptoKey.kdf);
+    std::vector<Botan::byte> associatedData(preambleText.begin(), preambleText.end());
+    appendBytes(associatedData, saltSP->data(), saltSP->size());
+
+    Botan::SecureVector<Botan::byte> headerIV = rng.random_vec(_IV_SIZE);
+    Botan::SecureVector<Botan::byte> header(metadata.begin(), metadata.end());
+    processAEAD(_CIPHER, Botan::Cipher_Dir::ENCRYPTION, *keySP, headerIV, associatedData, header);
+    pbcAssert(header.size() <= _MAX_METADATA_SIZE);
+    Botan::byte headerSize[4];
+    encodeSize(header.size(), headerSize);
+
+    // the playbook is bound to its header
+    appendBytes(associatedData, headerIV.data(), headerIV.size());
+    appendBytes(associatedData, headerSize, sizeof(headerSize));
+    appendBytes(associatedData, header.data(), header.size());
+    Botan::SecureVector<Botan::byte> bodyIV = rng.random_vec(_IV_SIZE);
+    Botan::SecureVector<Botan::byte> body(serializedPlaybook.begin(), serializedPlaybook.end());
+    processAEAD(_CIPHER, Botan::Cipher_Dir::ENCRYPTION, *keySP, bodyIV, associatedData, body);
+
+    outFile << preambleText;
+    outFile.write((const char*)saltSP->data(), saltSP->size());
+    outFile.write((const char*)headerIV.data(), headerIV.size());
+    outFile.write((const char*)headerSize, sizeof(headerSize));
+    outFile.write((const char*)header.data(), header.size());
+    outFile.write((const char*)bodyIV.data(), bodyIV.size());
+    outFile.write((const char*)body.data(), body.size());
+    if (!outFile) {
+        throw PBCStorageException("Could not write the playbook file.");
+    }
+}
+
+/**
+ * @brief The unencrypted preamble of a playbook file in the newest format
+ * @param kdf The key derivation that the key of the file has been derived with
+ */
+std::string PBCStorage::newestPreamble(const PBCKdfSettings &kdf) const {
+    return "Playbook-Creator\n" +
+           PBCVersion::getVersionString() + "\n" +
+           "playbook " + std::to_string(_FORMAT) + "\n" +
+           "kdf " + kdf.toString() + "\n";
+}
+
+/**
+ * @brief Reads and checks the unencrypted preamble of a playbook file
+ * @param inFile The playbook file
+ * @return The preamble
+ */
+PBCStorage::Preamble PBCStorage::readPreamble(std::istream &inFile) {
+    Preamble preamble;
+    std::string pbcString;
+    std::getline(inFile, pbcString);
+    pbcAssert(pbcString == "Playbook-Creator");
 
-    Botan::Pipe encryptor(Botan::get_cipher(_CIPHER, *_keySP, iv, Botan::Cipher_Dir::ENCRYPTION),
-            new Botan::DataSink_Stream(outFile));
-    encryptor.process_msg(input);
+    std::getline(inFile, preamble.version);
+    checkVersion(preamble.version);
+
+    std::string filetypeString;
+    std::getline(inFile, filetypeString);
+    if (filetypeString == "playbook") {
+        preamble.format = 1;
+    } else if (filetypeString == "playbook 2") {
+        preamble.format = 2;
+    } else if (filetypeString == "playbook " + std::to_string(_FORMAT)) {
+        preamble.format = _FORMAT;
+    } else {
+        throw PBCStorageException("Unknown playbook file format: " + filetypeString);
+    }
+    preamble.text = pbcString + "\n" + preamble.version + "\n" + filetypeString + "\n";
+
+    preamble.kdf = PBCKdfSettings::legacy();
+    if (preamble.format >= 3) {
+        // the line is authenticated as part of the preamble
+        std::string kdfString;
+        std::getline(inFile, kdfString);
+        if (kdfString.compare(0, 4, "kdf ") != 0) {
+            throw PBCStorageException("The playbook file is corrupted.");
+        }
+        preamble.kdf = PBCKdfSettings::fromString(kdfString.substr(4));
+        preamble.text += kdfString + "\n";
+    }
+    return preamble;
 }
 
 /**
@@ -121,38 +451,93 @@ void PBCStorage::encrypt(const std::string& input,
  * an  output stream
  * @param password The password string, which the decryption key is derived from
  * @param ostream The output stream to which the decrypted playbook is written
- * @param inFile The file where the encrypted playbook is stored
+ * @param inFile The file where the encrypted playbook is stored (positioned
+ * behind the preamble)
+ * @param preamble The preamble of the file
  */
-std::pair<KeySP, SaltSP> PBCStorage::decrypt(const std::string &password,
+PBCCryptoKey PBCStorage::decrypt(const std::string &password,
                          std::ostream &ostream,
-                         std::ifstream &inFile) {
-    boost::shared_ptr<Botan::PBKDF> pbkdf(Botan::get_pbkdf(_PBKDF));
+                         std::istream &inFile,
+                         const Preamble &preamble) {
     Botan::SecureVector<Botan::byte> salt(_SALT_SIZE);
-    inFile.read(reinterpret_cast<char*>(&salt[0]), _SALT_SIZE);
-    Botan::SecureVector<Botan::byte> iv(_IV_SIZE);
-    inFile.read(reinterpret_cast<char*>(&iv[0]), _IV_SIZE);
+    readBytes(inFile, &salt[0], _SALT_SIZE);
+    KeySP keySP = deriveKey(password, salt, preamble.kdf);
+    PBCCryptoKey cryptoKey{keySP, SaltSP(new Botan::SecureVector<Botan::byte>(salt)), preamble.kdf};
+
+    PBC_PERF_SCOPE("storage.decrypt");
+    if (preamble.format == 1) {
+        Botan::SecureVector<Botan::byte> iv(_IV_SIZE);
+        readBytes(inFile, &iv[0], _IV_SIZE);
+        Botan::Keyed_Filter* cipher = Botan::get_cipher(_CIPHER, *keySP, iv, Botan::Cipher_Dir::DECRYPTION);
+        Botan::Pipe decryptor(cipher, new Botan::DataSink_Stream(ostream));
+
+        Botan::DataSource_Stream source(inFile);
+        try {
+            decryptor.process_msg(source);
+        } catch (Botan::Integrity_Failure& e) {
+            throw PBCDecryptionException("Error while decrypting playbook. "
+                                         "Maybe you entered the wrong password to often "
+                                         "or someone tampered the playbook file.");
+        }
+        return cryptoKey;
+    }
 
-    Botan::OctetString key = pbkdf->derive_key(_KEY_SIZE, password,
-                                               &salt[0], salt.size(),
-                                               _PBKDF_ITERATIONS);
+    // The header is only authenticated as part of the playbook, not decrypted.
+    std::vector<Botan::byte> associatedData(preamble.text.begin(), preamble.text.end());
+    appendBytes(associatedData, salt.data(), salt.size());
+    std::vector<Botan::byte> headerPrefix(_IV_SIZE + 4);  // IV and size of the header
+    readBytes(inFile, headerPrefix.data(), headerPrefix.size());
+    appendBytes(associatedData, headerPrefix.data(), headerPrefix.size());
+    uint32_t headerSize = decodeSize(&headerPrefix[_IV_SIZE]);
+    if (headerSize > _MAX_METADATA_SIZE) {
+        throw PBCStorageException("The playbook file is corrupted.");
+    }
+    std::vector<Botan::byte> header(headerSize);
+    readBytes(inFile, header.data(), headerSize);
+    appendBytes(associatedData, header.data(), headerSize);
 
-    Botan::Keyed_Filter* cipher = Botan::get_cipher(_CIPHER, key, iv, Botan::Cipher_Dir::DECRYPTION);
-    Botan::Pipe decryptor(cipher, new Botan::DataSink_Stream(ostream));
+    Botan::SecureVector<Botan::byte> iv(_IV_SIZE);
+    readBytes(inFile, &iv[0], _IV_SIZE);
+    std::unique_ptr<Botan::AEAD_Mode> decryption = Botan::AEAD_Mode::create(_CIPHER, Botan::Cipher_Dir::DECRYPTION);
+    pbcAssert(decryption != NULL);
+    decryption->set_key(*keySP);
+    decryption->set_associated_data(associatedData.data(), associatedData.size());
+    decryption->start(iv.data(), iv.size());
 
-    Botan::DataSource_Stream source(inFile);
+    // The body is streamed through the decryption in chunks (as in
+    // rekeyPlaybookFile()). The last tag_size() bytes read are held back,
+    // because the tag is only known at the end of the file. The decrypted
+    // chunks are not authenticated before the tag has been verified, so the
+    // callers must discard the output stream if an exception is thrown.
+    const size_t granularity = decryption->update_granularity();
+    const size_t chunkSize = std::max<size_t>(granularity, 65536 / granularity * granularity);
+    const size_t tagSize = decryption->tag_size();
+    Botan::SecureVector<Botan::byte> buffer(chunkSize + tagSize);
+    size_t filled = 0;
+    while (true) {
+        inFile.read(reinterpret_cast<char*>(buffer.data() + filled), buffer.size() - filled);
+        filled += inFile.gcount();
+        if (filled < buffer.size()) {
+            break;
+        }
+        decryption->process(buffer.data(), chunkSize);
+        ostream.write(reinterpret_cast<const char*>(buffer.data()), chunkSize);
+        std::copy(buffer.begin() + chunkSize, buffer.end(), buffer.begin());
+        filled = tagSize;
+    }
+    if (filled < tagSize) {
+        throw PBCStorageException("The playbook file is truncated.");
+    }
+    buffer.resize(filled);
     try {
-        decryptor.process_msg(source);
+        decryption->finish(buffer);
     } catch (Botan::Integrity_Failure& e) {
         throw PBCDecryptionException("Error while decrypting playbook. "
                                      "Maybe you entered the wrong password to often "
                                      "or someone tampered the playbook file.");
     }
-    /*std::string readPreamble(preambleBytes.begin(), preambleBytes.end());
-    std::cout << "read preamble: " << readPreamble << std::endl*/
-
-    KeySP keySP(new Botan::OctetString(key));
-    SaltSP saltSP(new Botan::SecureVector<Botan::byte>(salt));
-    return std::make_pair(keySP, saltSP);
+    ostream.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    return cryptoKey;
 }
 
 /**
@@ -162,21 +547,28 @@ std::pair<KeySP, SaltSP> PBCStorage::decrypt(const std::string &password,
  */
 void PBCStorage::init(const std::string &fileName) {
     _currentPlaybookFileName = fileName;
-    _keySP.reset();
-    _saltSP.reset();
+    _cryptoKey = PBCCryptoKey();
+    _savedContentHashValid = false;
+    _lastBackupTime = 0;
 }
 
 /**
- * @brief Wrapper function which generates key and salt and sets the file name
- * first and the actual saving algorithm is implemented in writeToCurrentPlaybookFile()
- * @param password
- * @param fileName
+ * @brief Saves the active playbook to a (new) file with a new key and salt.
+ * The file name and the key become the current ones only after the file has
+ * been written, so a failed save keeps the automatic saves going to the
+ * previous file.
+ * @param password The password that the new key is derived from
+ * @param fileName The file
+ * @throws PBCSaveException if the playbook could not be written
  */
 void PBCStorage::savePlaybook(const std::string& password,
                               const std::string& fileName) {
-    generateAndSetKey(password);
+    PBCCryptoKey cryptoKey = deriveKey(password);
+    writeActivePlaybook(fileName, cryptoKey);
+    _cryptoKey = cryptoKey;
     _currentPlaybookFileName = fileName;
-    writeToCurrentPlaybookFile();
+    _lastBackupTime = 0;
+    backupSavedPlaybook();
 
     setLastPlaybookLocation(QFileInfo(QString::fromStdString(fileName)));
 }
@@ -184,44 +576,271 @@ void PBCStorage::savePlaybook(const std::string& password,
 /**
  * @brief Checks if key and salt are set before saving the playbook, so we don't
  * need to enter the password again.
+ *
+ * If the content hash of the playbook equals the hash of the last written
+ * state, nothing has changed and the file is not written again.
+ *
+ * The automatic saves happen inside of the changes to the playbook, which are
+ * mostly made from Qt slots, so a failed save is not thrown but passed to the
+ * save failure listener (see setSaveFailureListener()). The file keeps its
+ * previous version and the playbook keeps its unsaved changes.
+ * @throws PBCAutoSaveException if the playbook has not been saved manually yet
  */
 void PBCStorage::automaticSavePlaybook() {
-    if(_keySP != NULL && _saltSP != NULL) {
-        writeToCurrentPlaybookFile();
+    if(_cryptoKey.key != NULL && _cryptoKey.salt != NULL) {
+        if (hasUnsavedChanges()) {
+            try {
+                writeToCurrentPlaybookFile();
+            } catch (PBCSaveException& e) {
+                if (_saveFailureListener) {
+                    _saveFailureListener(e.what());
+                }
+            }
+        } else {
+            PBC_PERF_COUNT("storage.autosave.skipped", 1);
+        }
     } else {
         throw PBCAutoSaveException("Cryptographic key is missing.");  //NOLINT
     }
 }
 
 /**
- * @brief Writes the playbook to a string buffer using Boost serialization
- * framework.
- *
- * Encrypting and writing to file is done via PBCStorage::encrypt() function
+ * @brief Writes the active playbook to the current playbook file (see
+ * writeActivePlaybook()). Afterwards a snapshot is added to the backups, if it
+ * is due (see backupCurrentPlaybook()).
+ * @throws PBCSaveException if the playbook could not be written
  */
 void PBCStorage::writeToCurrentPlaybookFile() {
-    pbcAssert(_currentPlaybookFileName != "");
-    std::string extension = _currentPlaybookFileName.substr(_currentPlaybookFileName.size() - 4);  //NOLINT
+    writeActivePlaybook(_currentPlaybookFileName, _cryptoKey);
+    backupSavedPlaybook();
+}
+
+/**
+ * @brief Writes the active playbook to a file.
+ *
+ * Serializing and encrypting is done via PBCStorage::encrypt() function. The
+ * file is replaced atomically (see commitFile()), so a failed or interrupted
+ * save never destroys the previous version of the playbook.
+ * @param fileName The file
+ * @param cryptoKey The key, the salt and the key derivation
+ * @throws PBCSaveException if the playbook could not be written
+ */
+void PBCStorage::writeActivePlaybook(const std::string &fileName, const PBCCryptoKey &cryptoKey) {
+    PBC_PERF_SCOPE("storage.save");
+    pbcAssert(fileName != "");
+    std::string extension = fileName.substr(fileName.size() - 4);
     pbcAssert(extension == ".pbc");
+    const PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+
+    try {
+        std::ostringstream encryptedPlaybook;
+        encrypt(*playbook, encryptedPlaybook, cryptoKey);
+        const std::string bytes = encryptedPlaybook.str();
+        QSaveFile file;
+        openFile(file, fileName);
+        writeFile(file, fileName, bytes.data(), bytes.size());
+        commitFile(file, fileName);
+        PBC_PERF_COUNT("storage.savedBytes", bytes.size());
+    } catch (PBCSaveException& e) {
+        PBC_LOG_ERROR("storage", "saving failed: " << e.what());
+        _savedContentHashValid = false;
+        throw;
+    } catch (std::exception& e) {
+        PBC_LOG_ERROR("storage", "saving failed: " << e.what());
+        _savedContentHashValid = false;
+        throw PBCSaveException(e.what());
+    }
+    _savedContentHash = playbook->contentHash();
+    _savedContentHashValid = true;
+}
+
+/**
+ * @brief Backs up the current playbook file after it has been saved, if a
+ * snapshot is due. A failed backup is only logged, because the playbook
+ * itself has been saved.
+ */
+void PBCStorage::backupSavedPlaybook() {
+    try {
+        backupCurrentPlaybook(false);
+    } catch (std::exception& e) {
+        PBC_LOG_WARNING("storage", "backup failed: " << e.what());
+    }
+}
+
+/**
+ * @brief Adds a snapshot of the active playbook to the backups of the current
+ * playbook file (see PBCBackupStore) and removes the snapshots that the
+ * backup policy does not keep anymore.
+ * @param force If false, the snapshot is only taken if backups are enabled
+ * and the last snapshot is older than the interval of the backup policy
+ */
+void PBCStorage::backupCurrentPlaybook(bool force) {
+    if (!force && !_backupPolicy.enabled) {
+        return;
+    }
+    pbcAssert(_cryptoKey.key != NULL && _cryptoKey.salt != NULL);
+    const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    PBCBackupStore store(_currentPlaybookFileName);
+    if (!force) {
+        if (_lastBackupTime == 0) {
+            std::vector<PBCBackupStore::Snapshot> snapshots = store.snapshots();
+            _lastBackupTime = snapshots.empty() ? 0 : snapshots.front().time;
+        }
+        if (_lastBackupTime != 0 && now - _lastBackupTime < _backupPolicy.interval.count()) {
+            return;
+        }
+    }
+    PBC_PERF_SCOPE("storage.backup");
+    const PBCPlaybook& playbook = *PBCController::getInstance()->getPlaybook();
+    store.write(serializePlaybook(playbook), serializeMetadata(playbook),
+                *_cryptoKey.key, *_cryptoKey.salt, _cryptoKey.kdf, now);
+    _lastBackupTime = now;
+    store.prune(_backupPolicy, now);
+}
+
+/**
+ * @brief Sets when snapshots of the current playbook file are taken and how
+ * long they are kept. The policy applies from the next snapshot on.
+ */
+void PBCStorage::setBackupPolicy(const PBCBackupPolicy &policy) {
+    _backupPolicy = policy;
+}
+
+/**
+ * @brief Lists the snapshots of a playbook file
+ * @param fileName The playbook file
+ * @return The snapshots, the newest first
+ */
+std::vector<PBCBackupStore::Snapshot> PBCStorage::backups(const std::string &fileName) const {
+    return PBCBackupStore(fileName).snapshots();
+}
+
+/**
+ * @brief Decrypts the serialized playbook of a snapshot
+ * @param password The password of the playbook file when the snapshot has
+ * been taken
+ * @param fileName The playbook file
+ * @param snapshotId The snapshot
+ * @return The serialized playbook
+ * @throws PBCDeprecatedVersionException if the snapshot has been taken by a
+ * newer version of Playbook Creator
+ */
+std::string PBCStorage::readBackup(const std::string &password,
+                                   const std::string &fileName,
+                                   const std::string &snapshotId) {
+    PBCBackupStore store(fileName);
+    PBCBackupStore::Snapshot snapshot = store.snapshot(snapshotId);
+    checkVersion(snapshot.version);
+    KeySP key = deriveKey(password, snapshot.salt, snapshot.kdf);
+    return store.read(snapshot, *key);
+}
+
+/**
+ * @brief Loads the playbook of a snapshot without replacing the active
+ * playbook
+ * @param password The password of the playbook file when the snapshot has
+ * been taken
+ * @param fileName The playbook file
+ * @param snapshotId The snapshot
+ * @return The playbook
+ */
+PBCPlaybookSP PBCStorage::openBackup(const std::string &password,
+                                     const std::string &fileName,
+                                     const std::string &snapshotId) {
+    PBCPlaybookSP playbook(new PBCPlaybook());
+    deserializePlaybook(readBackup(password, fileName, snapshotId), playbook);
+    return playbook;
+}
+
+/**
+ * @brief Replaces the active playbook by a snapshot of the current playbook
+ * file and saves it. The replaced state is backed up first, so the restore
+ * can be reverted by restoring that snapshot.
+ * @param password The password of the playbook file when the snapshot has
+ * been taken
+ * @param snapshotId The snapshot
+ */
+void PBCStorage::restoreActivePlaybook(const std::string &password, const std::string &snapshotId) {
+    PBC_PERF_SCOPE("storage.restore");
+    pbcAssert(_currentPlaybookFileName != "");
+    // loaded completely first, so that a wrong password or a snapshot that
+    // cannot be read does not change anything
+    PBCPlaybookSP playbook = openBackup(password, _currentPlaybookFileName, snapshotId);
+    backupCurrentPlaybook(true);
+    PBCController::getInstance()->getPlaybook()->swap(*playbook);
+    writeToCurrentPlaybookFile();
+}
+
+/**
+ * @brief Serializes a playbook using Boost serialization framework
+ * @param playbook The playbook to serialize
+ * @return The serialized playbook
+ */
+std::string PBCStorage::serializePlaybook(const PBCPlaybook &playbook) {
+    PBC_PERF_SCOPE("storage.serialize");
     std::stringbuf buff;
     std::ostream ostream(&buff);
     boost::archive::text_oarchive archive(ostream);
-    archive << *PBCController::getInstance()->getPlaybook();
-
-    std::ofstream ofstream(_currentPlaybookFileName,
-                           std::ios_base::out | std::ios_base::binary);
+    archive << playbook;
+    return buff.str();
+}
 
-    ofstream << _PREAMBLE;
+/**
+ * @brief Writes a playbook that is not the active playbook (e.g. the result of
+ * a merge) to a new file. The active playbook's file and key are not changed.
+ * @param password The password the file is encrypted with
+ * @param fileName The path of the new file
+ * @param playbook The playbook to write
+ */
+void PBCStorage::writePlaybookToFile(const std::string &password,
+                                     const std::string &fileName,
+                                     PBCPlaybookSP playbook) {
+    PBC_PERF_SCOPE("storage.save");
+    pbcAssert(playbook != NULL);
+    pbcAssert(fileName.size() > 4 && fileName.substr(fileName.size() - 4) == ".pbc");
+    PBCCryptoKey cryptoKey = deriveKey(password);
 
+    std::ostringstream encryptedPlaybook;
     try {
-        encrypt(buff.str(), ofstream);
+        encrypt(*playbook, encryptedPlaybook, cryptoKey);
     } catch(std::exception& e) {
-        ofstream.close();
-        // std::remove(fileName.c_str());
-        std::cout << e.what() << std::endl;  // TODO(obr): message to user
+        throw PBCSaveException(e.what());
     }
+    const std::string bytes = encryptedPlaybook.str();
+    QSaveFile file;
+    openFile(file, fileName);
+    writeFile(file, fileName, bytes.data(), bytes.size());
+    commitFile(file, fileName);
+}
+
+/**
+ * @brief Writes the selected plays of the active playbook and everything they
+ * reference to a new file (see PBCPlaybook::extract()). The active playbook
+ * is neither changed nor saved.
+ * @param password The password the new file is encrypted with
+ * @param fileName The path of the new file
+ * @param selection The plays to export
+ * @return the exported playbook, which must not be edited
+ */
+PBCPlaybookSP PBCStorage::exportPlaybook(const std::string &password,
+                                         const std::string &fileName,
+                                         const PBCPlaySelection &selection) {
+    PBC_PERF_SCOPE("storage.export");
+    PBCPlaybookSP activePlaybook = PBCController::getInstance()->getPlaybook();
+    PBCPlaybookSP playbook = activePlaybook->extract(selection, activePlaybook->name());
+    writePlaybookToFile(password, fileName, playbook);
+    return playbook;
+}
 
-    ofstream.close();
+/**
+ * @brief Checks whether the active playbook differs from the state that has
+ * been written to (or loaded from) the current playbook file.
+ * @return true if the playbook has to be saved
+ */
+bool PBCStorage::hasUnsavedChanges() const {
+    return !_savedContentHashValid ||
+           _savedContentHash != PBCController::getInstance()->getPlaybook()->contentHash();
 }
 
 
@@ -232,50 +851,273 @@ void PBCStorage::writeToCurrentPlaybookFile() {
  * @param password The decryption password
  * @param fileName The path to the file where the playbook ist stored
  */
-std::pair<KeySP, SaltSP>  PBCStorage::loadPlaybook(const std::string &password, const std::string &fileName, PBCPlaybookSP targetPlaybook) {
+PBCCryptoKey PBCStorage::readPlaybook(const std::string &password, const std::string &fileName, PBCPlaybookSP targetPlaybook) {
+    PBC_PERF_SCOPE("storage.load");
     std::string extension = fileName.substr(fileName.size() - 4);
     pbcAssert(extension == ".pbc");
     std::stringbuf buff;
     std::ostream ostream(&buff);
     std::ifstream ifstream(fileName, std::ios_base::binary);
+    Preamble preamble = readPreamble(ifstream);
 
-    const size_t maxLen = _PREAMBLE.length();
-    char* preambleBuffer = new char[maxLen];
-    ifstream.getline(preambleBuffer, maxLen);
-    std::string pbcString(preambleBuffer);
-    pbcAssert(pbcString == "Playbook-Creator");
-
-    ifstream.getline(preambleBuffer, maxLen);
-    std::string version(preambleBuffer);
-    checkVersion(version);
-
-    ifstream.getline(preambleBuffer, maxLen);
-    std::string filetypeString(preambleBuffer);
-    pbcAssert(filetypeString == "playbook");
-
-    delete[] preambleBuffer;
-    preambleBuffer = NULL;
-
-    std::pair<KeySP, SaltSP> cryptoMaterial;
+    PBCCryptoKey cryptoKey;
     try {
-        cryptoMaterial = decrypt(password,
+        cryptoKey = decrypt(password,
                 ostream,
-                ifstream);
-    } catch (PBCDecryptionException& e) {
-        throw e;
+                ifstream,
+                preamble);
+    } catch (PBCStorageException&) {
+        throw;
     } catch(std::exception& e) {
         throw PBCStorageException(e.what());  // TODD(obr): message to user
     }
 
-    std::istream istream(&buff);
-    boost::archive::text_iarchive archive(istream);
-    archive >> *targetPlaybook;
+    {
+        PBC_PERF_SCOPE("storage.deserialize");
+        std::istream istream(&buff);
+        boost::archive::text_iarchive archive(istream);
+        archive >> *targetPlaybook;
+    }
+
+    return cryptoKey;
+}
 
+/**
+ * @brief Reads a playbook (see readPlaybook()) and remembers its location for
+ * the file dialogs
+ */
+PBCCryptoKey PBCStorage::loadPlaybook(const std::string &password, const std::string &fileName, PBCPlaybookSP targetPlaybook) {
+    PBCCryptoKey cryptoKey = readPlaybook(password, fileName, targetPlaybook);
     setLastPlaybookLocation(QFileInfo(QString::fromStdString(fileName)));
+    return cryptoKey;
+}
+
+/**
+ * @brief Reads the metadata of a playbook file. Only the small metadata
+ * header is decrypted, unless the file has been written by a version that did
+ * not write the header yet.
+ * @param password The decryption password
+ * @param fileName The path to the file where the playbook is stored
+ * @return The metadata
+ */
+PBCPlaybookMetadata PBCStorage::readMetadata(const std::string &password,
+                                             const std::string &fileName) {
+    PBC_PERF_SCOPE("storage.readMetadata");
+    std::ifstream ifstream(fileName, std::ios_base::binary);
+    if (!ifstream) {
+        throw PBCStorageException("Could not open " + fileName);
+    }
+    Preamble preamble = readPreamble(ifstream);
+
+    PBCPlaybookMetadata metadata;
+    if (preamble.format == 1) {
+        ifstream.close();
+        PBCPlaybookSP playbook(new PBCPlaybook());
+        readPlaybook(password, fileName, playbook);
+        metadata = metadataOf(*playbook);
+        metadata.lastModified = QFileInfo(QString::fromStdString(fileName)).lastModified().toSecsSinceEpoch();
+    } else {
+        Botan::SecureVector<Botan::byte> salt(_SALT_SIZE);
+        readBytes(ifstream, &salt[0], _SALT_SIZE);
+        KeySP keySP = deriveKey(password, salt, preamble.kdf);
+
+        Botan::SecureVector<Botan::byte> iv(_IV_SIZE);
+        readBytes(ifstream, &iv[0], _IV_SIZE);
+        Botan::byte sizeBytes[4];
+        readBytes(ifstream, sizeBytes, sizeof(sizeBytes));
+        uint32_t headerSize = decodeSize(sizeBytes);
+        if (headerSize > _MAX_METADATA_SIZE) {
+            throw PBCStorageException("The playbook file is corrupted.");
+        }
+        Botan::SecureVector<Botan::byte> header(headerSize);
+        readBytes(ifstream, header.data(), headerSize);
+
+        std::vector<Botan::byte> associatedData(preamble.text.begin(), preamble.text.end());
+        appendBytes(associatedData, salt.data(), salt.size());
+        try {
+            processAEAD(_CIPHER, Botan::Cipher_Dir::DECRYPTION, *keySP, iv, associatedData, header);
+        } catch (Botan::Integrity_Failure& e) {
+            throw PBCDecryptionException("Error while decrypting playbook. "
+                                         "Maybe you entered the wrong password to often "
+                                         "or someone tampered the playbook file.");
+        }
+        std::istringstream serializedMetadata(std::string(header.begin(), header.end()));
+        boost::archive::text_iarchive archive(serializedMetadata);
+        archive >> metadata;
+        metadata.fromHeader = true;
+    }
+    metadata.version = preamble.version;
+    return metadata;
+}
+
+
+/**
+ * @brief Re-encrypts a playbook file with a new key.
+ *
+ * The playbook is streamed through the decryption with the old key and the
+ * encryption with the new key in chunks, so it is neither deserialized nor
+ * held in memory completely. The new file replaces the old one only after
+ * the old authentication tag has been verified, so a wrong password or a
+ * tampered file leave the file unchanged. Files of format 1 have no metadata
+ * header yet; they are read completely and written in the newest format.
+ * The file gets the key derivation of the new key.
+ * @param oldPassword The current password of the file
+ * @param newKey The new key, the salt and the key derivation it has been
+ * derived with
+ * @param fileName The playbook file
+ */
+void PBCStorage::rekeyPlaybookFile(const std::string &oldPassword,
+                                   const PBCCryptoKey &newKey,
+                                   const std::string &fileName) {
+    PBC_PERF_SCOPE("storage.rekey");
+    std::ifstream inFile(fileName, std::ios_base::binary);
+    if (!inFile) {
+        throw PBCStorageException("Could not open " + fileName);
+    }
+    Preamble preamble = readPreamble(inFile);
+    QSaveFile outFile;
+    openFile(outFile, fileName);
+    auto write = [&outFile, &fileName](const void* data, size_t size) {
+        writeFile(outFile, fileName, data, size);
+    };
+
+    if (preamble.format == 1) {
+        inFile.close();
+        PBCPlaybookSP playbook(new PBCPlaybook());
+        readPlaybook(oldPassword, fileName, playbook);
+        std::ostringstream encryptedPlaybook;
+        encrypt(*playbook, encryptedPlaybook, newKey);
+        std::string bytes = encryptedPlaybook.str();
+        write(bytes.data(), bytes.size());
+    } else {
+        const SaltSP& newSalt = newKey.salt;
+        Botan::SecureVector<Botan::byte> salt(_SALT_SIZE);
+        readBytes(inFile, &salt[0], _SALT_SIZE);
+        KeySP oldKey = deriveKey(oldPassword, salt, preamble.kdf);
+
+        std::vector<Botan::byte> oldAssociatedData(preamble.text.begin(), preamble.text.end());
+        appendBytes(oldAssociatedData, salt.data(), salt.size());
+        const std::string newPreamble = newestPreamble(newKey.kdf);
+        std::vector<Botan::byte> newAssociatedData(newPreamble.begin(), newPreamble.end());
+        appendBytes(newAssociatedData, newSalt->data(), newSalt->size());
+
+        // the header is small, so it is re-encrypted at once
+        Botan::SecureVector<Botan::byte> headerIV(_IV_SIZE);
+        readBytes(inFile, &headerIV[0], _IV_SIZE);
+        Botan::byte headerSize[4];
+        readBytes(inFile, headerSize, sizeof(headerSize));
+        if (decodeSize(headerSize) > _MAX_METADATA_SIZE) {
+            throw PBCStorageException("The playbook file is corrupted.");
+        }
+        Botan::SecureVector<Botan::byte> header(decodeSize(headerSize));
+        readBytes(inFile, header.data(), header.size());
+        appendBytes(oldAssociatedData, headerIV.data(), headerIV.size());
+        appendBytes(oldAssociatedData, headerSize, sizeof(headerSize));
+        appendBytes(oldAssociatedData, header.data(), header.size());
+        try {
+            std::vector<Botan::byte> headerAssociatedData(
+                    oldAssociatedData.begin(),
+                    oldAssociatedData.begin() + preamble.text.size() + salt.size());
+            processAEAD(_CIPHER, Botan::Cipher_Dir::DECRYPTION, *oldKey, headerIV, headerAssociatedData, header);
+        } catch (Botan::Integrity_Failure& e) {
+            throw PBCDecryptionException("Error while decrypting playbook. "
+                                         "Maybe you entered the wrong password to often "
+                                         "or someone tampered the playbook file.");
+        }
+        Botan::AutoSeeded_RNG rng;
+        Botan::SecureVector<Botan::byte> newHeaderIV = rng.random_vec(_IV_SIZE);
+        processAEAD(_CIPHER, Botan::Cipher_Dir::ENCRYPTION, *newKey.key, newHeaderIV, newAssociatedData, header);
+        Botan::byte newHeaderSize[4];
+        encodeSize(header.size(), newHeaderSize);
+        write(newPreamble.data(), newPreamble.size());
+        write(newSalt->data(), newSalt->size());
+        write(newHeaderIV.data(), newHeaderIV.size());
+        write(newHeaderSize, sizeof(newHeaderSize));
+        write(header.data(), header.size());
+        appendBytes(newAssociatedData, newHeaderIV.data(), newHeaderIV.size());
+        appendBytes(newAssociatedData, newHeaderSize, sizeof(newHeaderSize));
+        appendBytes(newAssociatedData, header.data(), header.size());
+
+        Botan::SecureVector<Botan::byte> bodyIV(_IV_SIZE);
+        readBytes(inFile, &bodyIV[0], _IV_SIZE);
+        Botan::SecureVector<Botan::byte> newBodyIV = rng.random_vec(_IV_SIZE);
+        write(newBodyIV.data(), newBodyIV.size());
 
-    return cryptoMaterial;
+        std::unique_ptr<Botan::AEAD_Mode> decryption = Botan::AEAD_Mode::create(_CIPHER, Botan::Cipher_Dir::DECRYPTION);
+        std::unique_ptr<Botan::AEAD_Mode> encryption = Botan::AEAD_Mode::create(_CIPHER, Botan::Cipher_Dir::ENCRYPTION);
+        pbcAssert(decryption != NULL && encryption != NULL);
+        decryption->set_key(*oldKey);
+        decryption->set_associated_data(oldAssociatedData.data(), oldAssociatedData.size());
+        decryption->start(bodyIV.data(), bodyIV.size());
+        encryption->set_key(*newKey.key);
+        encryption->set_associated_data(newAssociatedData.data(), newAssociatedData.size());
+        encryption->start(newBodyIV.data(), newBodyIV.size());
+
+        std::streamoff bodyStart = inFile.tellg();
+        inFile.seekg(0, std::ios_base::end);
+        std::streamoff remaining = static_cast<std::streamoff>(inFile.tellg()) - bodyStart;
+        inFile.seekg(bodyStart);
+        if (remaining < static_cast<std::streamoff>(decryption->tag_size())) {
+            throw PBCStorageException("The playbook file is truncated.");
+        }
+
+        // The decrypted chunks are not authenticated before the tag has been
+        // verified, but they only end up in the new file, which is discarded
+        // in that case.
+        const size_t granularity = decryption->update_granularity();
+        const size_t chunkSize = std::max<size_t>(granularity, 65536 / granularity * granularity);
+        Botan::SecureVector<Botan::byte> chunk(chunkSize);
+        while (remaining >= static_cast<std::streamoff>(chunkSize + decryption->tag_size())) {
+            readBytes(inFile, chunk.data(), chunkSize);
+            decryption->update(chunk);
+            encryption->update(chunk);
+            write(chunk.data(), chunk.size());
+            remaining -= chunkSize;
+        }
+        chunk.resize(remaining);
+        readBytes(inFile, chunk.data(), chunk.size());
+        try {
+            decryption->finish(chunk);
+        } catch (Botan::Integrity_Failure& e) {
+            throw PBCDecryptionException("Error while decrypting playbook. "
+                                         "Maybe you entered the wrong password to often "
+                                         "or someone tampered the playbook file.");
+        }
+        encryption->finish(chunk);
+        write(chunk.data(), chunk.size());
+    }
+
+    inFile.close();
+    commitFile(outFile, fileName);
+    if (QFileInfo(QString::fromStdString(fileName)) == QFileInfo(QString::fromStdString(_currentPlaybookFileName))) {
+        _cryptoKey = newKey;
+    }
 }
 
+/**
+ * @brief Changes the password of playbook files (see rekeyPlaybookFile()).
+ * The new key is derived only once for all files.
+ * @param oldPassword The current password of the files
+ * @param newPassword The new password
+ * @param fileNames The playbook files. If the active playbook file is one of
+ * them, its automatic saves use the new password afterwards.
+ * @return The files that could not be changed and the reasons
+ */
+std::vector<std::pair<std::string, std::string>> PBCStorage::changePassword(
+        const std::string &oldPassword,
+        const std::string &newPassword,
+        const std::vector<std::string> &fileNames) {
+    PBCCryptoKey newKey = deriveKey(newPassword);
+    std::vector<std::pair<std::string, std::string>> failures;
+    for (const std::string& fileName : fileNames) {
+        try {
+            rekeyPlaybookFile(oldPassword, newKey, fileName);
+        } catch (std::exception& e) {
+            failures.push_back(std::make_pair(fileName, std::string(e.what())));
+        }
+    }
+    return failures;
+}
 
 /**
  * @brief Load the active playbook from a file
@@ -284,15 +1126,96 @@ std::pair<KeySP, SaltSP>  PBCStorage::loadPlaybook(const std::string &password,
  */
 void PBCStorage::loadActivePlaybook(const std::string &password,
                                     const std::string &fileName) {
-    std::pair<KeySP, SaltSP> cryptoMaterial = loadPlaybook(
-            password,
-            fileName,
-            PBCController::getInstance()->getPlaybook());
+    PBCPlaybookSP playbook(new PBCPlaybook());
+    PBCCryptoKey cryptoKey = loadPlaybook(password, fileName, playbook);
+    PBCController::getInstance()->getPlaybook()->swap(*playbook);
+    activateFile(fileName, cryptoKey);
+}
+
+/**
+ * @brief Replaces the active playbook by the playbook that a job has loaded.
+ * The active playbook is only changed here, so it stays untouched if the job
+ * has failed or has been cancelled.
+ * @param job The finished job
+ */
+void PBCStorage::activatePlaybook(const PBCLoadJob &job) {
+    pbcAssert(job.status() == PBCLoadJob::SUCCEEDED);
+    PBCController::getInstance()->getPlaybook()->swap(*job.playbook());
+    setLastPlaybookLocation(QFileInfo(QString::fromStdString(job.fileName())));
+    activateFile(job.fileName(), job.cryptoKey());
+}
+
+/**
+ * @brief Makes a file that has just been loaded the file of the active
+ * playbook
+ */
+void PBCStorage::activateFile(const std::string &fileName, const PBCCryptoKey &cryptoKey) {
+    _cryptoKey = cryptoKey;
     _currentPlaybookFileName = fileName;
-    _keySP = cryptoMaterial.first;
-    _saltSP = cryptoMaterial.second;
+    _lastBackupTime = 0;
+    _savedContentHash = PBCController::getInstance()->getPlaybook()->contentHash();
+    _savedContentHashValid = true;
+}
+
+/**
+ * @brief Loads a playbook from a file without replacing the active playbook,
+ * e.g. to compare or merge it
+ * @param password The decryption password
+ * @param fileName The path to the file where the playbook is stored
+ * @return The loaded playbook
+ */
+PBCPlaybookSP PBCStorage::openPlaybook(const std::string &password,
+                                       const std::string &fileName) {
+    PBCPlaybookSP playbook(new PBCPlaybook());
+    loadPlaybook(password, fileName, playbook);
+    return playbook;
 }
 
+/**
+ * @brief Replaces the routes of the players of the given plays
+ * @param plays The plays whose players should be relinked
+ * @param replacements Maps each route that should be replaced to its replacement
+ */
+static void relinkRoutes(const std::list<PBCPlaySP>& plays,
+                         const std::map<PBCRouteSP, PBCRouteSP>& replacements) {
+    if (replacements.empty()) {
+        return;
+    }
+    auto replacement = [&replacements](const PBCRouteSP& route) {
+        auto it = replacements.find(route);
+        return it != replacements.end() ? it->second : route;
+    };
+    for (const PBCPlaySP& play : plays) {
+        for (const PBCPlayerSP& player : *play->formation()) {
+            if (player->route() != NULL) {
+                player->setRoute(replacement(player->route()));
+            }
+            for (unsigned int nr = 1; nr <= 2; ++nr) {
+                if (player->alternativeRoute(nr) != NULL) {
+                    player->setAlternativeRoute(nr, replacement(player->alternativeRoute(nr)));
+                }
+            }
+            std::vector<PBCRouteSP> optionRoutes = player->optionRoutes();
+            if (!optionRoutes.empty()) {
+                player->resetOptionRoutes();
+                for (const PBCRouteSP& route : optionRoutes) {
+                    player->addOptionRoute(replacement(route));
+                }
+            }
+        }
+        PBCController::getInstance()->getPlaybook()->updateUsages(play);
+    }
+}
+
+/**
+ * @brief Imports the plays, categories, formations and routes of another
+ * playbook file into the active playbook.
+ *
+ * If an entry with the same name already exists, a PBCImportException is
+ * thrown, unless skipIdenticalDuplicates is set and the existing entry has the
+ * same content hash. Then the existing entry is kept and the imported entries
+ * are linked to it.
+ */
 void PBCStorage::importPlaybook(
         const std::string &password,
         const std::string &fileName,
@@ -301,10 +1224,29 @@ void PBCStorage::importPlaybook(
         bool importRoutes,
         bool importFormations,
         const std::string& prefix,
-        const std::string& suffix) {
+        const std::string& suffix,
+        bool skipIdenticalDuplicates) {
     PBCPlaybookSP importedPlaybook(new PBCPlaybook());
     loadPlaybook(password, fileName, importedPlaybook);
+    importPlaybook(importedPlaybook, importPlays, importCategories, importRoutes, importFormations,
+                   prefix, suffix, skipIdenticalDuplicates);
+}
 
+/**
+ * @brief Imports a playbook that has already been loaded (e.g. by a
+ * PBCLoadJob) into the active playbook (see above). The imported playbook is
+ * taken apart, so it cannot be used afterwards.
+ */
+void PBCStorage::importPlaybook(
+        PBCPlaybookSP importedPlaybook,
+        bool importPlays,
+        bool importCategories,
+        bool importRoutes,
+        bool importFormations,
+        const std::string& prefix,
+        const std::string& suffix,
+        bool skipIdenticalDuplicates) {
+    PBC_PERF_SCOPE("storage.import");
     unsigned int imported_numberOfPlayers = importedPlaybook->numberOfPlayers();
     unsigned int active_numberOfPlayers = PBCController::getInstance()->getPlaybook()->numberOfPlayers();
     if (importedPlaybook->numberOfPlayers() != PBCController::getInstance()->getPlaybook()->numberOfPlayers()) {
@@ -315,6 +1257,9 @@ void PBCStorage::importPlaybook(
                 + std::to_string(active_numberOfPlayers)
                 + ")");
     }
+    PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+    PBCUndoMacroScope macro(playbook->history(), "Import Playbook");
+    std::list<PBCPlaySP> addedPlays;
     // Only import categories if plays are imported. Remove categories from plays if categories should not be imported.
     // This prevents dangling references to non-existent plays/categories
     if (importPlays) {
@@ -322,8 +1267,17 @@ void PBCStorage::importPlaybook(
             for (const PBCCategorySP& category : importedPlaybook->categories()) {
                 const std::string name = category->name();
                 category->setName(prefix + name + suffix);
-                bool result = PBCController::getInstance()->getPlaybook()->addCategory(category, false, true);
+                bool result = playbook->addCategory(category, false, true);
                 if (result == false) {
+                    PBCCategorySP existingCategory = playbook->getCategory(category->name());
+                    if (skipIdenticalDuplicates &&
+                        existingCategory->contentHash() == category->contentHash()) {
+                        for (const PBCPlaySP& play : category->plays()) {
+                            play->removeCategory(category);
+                            play->addCategory(existingCategory);
+                        }
+                        continue;
+                    }
                     throw PBCImportException(
                             "this would overwrite an existing category named '" +
                             category->name() + "'");
@@ -340,13 +1294,22 @@ void PBCStorage::importPlaybook(
                     play->removeCategory(category);
                 }
             }
-            bool result = PBCController::getInstance()->getPlaybook()->addPlay(play, false, true);
-            std::cout << "imported play: " << play->name() << std::endl;
+            bool result = playbook->addPlay(play, false, true);
+            PBC_LOG_DEBUG("storage", "imported play: " << play->name());
             if (result == false) {
+                PBCPlaySP existingPlay = playbook->getPlay(play->name());
+                if (skipIdenticalDuplicates && existingPlay->contentHash() == play->contentHash()) {
+                    for (const PBCCategorySP& category : play->categories()) {
+                        category->removePlay(play);
+                        category->addPlay(existingPlay);
+                    }
+                    continue;
+                }
                 throw PBCImportException(
                         "this would overwrite an existing play named '" +
                         play->name() + "'");
             }
+            addedPlays.push_back(play);
         }
     }
 
@@ -354,8 +1317,12 @@ void PBCStorage::importPlaybook(
         for (const PBCFormationSP& formation : importedPlaybook->formations()) {
             const std::string name = formation->name();
             formation->setName(prefix + name + suffix);
-            bool result = PBCController::getInstance()->getPlaybook()->addFormation(formation, false, true);
+            bool result = playbook->addFormation(formation, false, true);
             if (result == false) {
+                if (skipIdenticalDuplicates &&
+                    playbook->getFormation(formation->name())->contentHash() == formation->contentHash()) {
+                    continue;
+                }
                 throw PBCImportException(
                         "this would overwrite an existing formation named '" +
                         formation->name() + "'");
@@ -364,16 +1331,23 @@ void PBCStorage::importPlaybook(
     }
 
     if (importRoutes) {
+        std::map<PBCRouteSP, PBCRouteSP> replacedRoutes;
         for (const PBCRouteSP& route : importedPlaybook->routes()) {
             const std::string name = route->name();
             route->setName(prefix + name + suffix);
-            bool result = PBCController::getInstance()->getPlaybook()->addRoute(route, false, true);
+            bool result = playbook->addRoute(route, false, true);
             if (result == false) {
+                PBCRouteSP existingRoute = playbook->getRoute(route->name());
+                if (skipIdenticalDuplicates && existingRoute->contentHash() == route->contentHash()) {
+                    replacedRoutes[route] = existingRoute;
+                    continue;
+                }
                 throw PBCImportException(
                         "this would overwrite an existing route named '" +
                         route->name() + "'");
             }
         }
+        relinkRoutes(addedPlays, replacedRoutes);
     }
 
     PBCStorage::getInstance()->automaticSavePlaybook();
@@ -383,10 +1357,10 @@ void PBCStorage::importPlaybook(
 /**
  * @brief Graphically exports the playbook in PDF file format.
  *
- * The plays are arranged in a grid.
+ * The plays are arranged in a grid. The export blocks until all pages have
+ * been rendered; use a PBCPDFExportJob directly to render page by page.
  * @param fileName The PDF file to which the playbook is exported
- * @param playViews A list of PBCPlayViews in which the exported plays are
- * graphically rendered using the Qt framework
+ * @param playListSP The names of the exported plays
  * @param paperWidth The width of one page
  * @param paperHeight The height of one page
  * @param columns The number of columns on one page
@@ -406,100 +1380,7 @@ void PBCStorage::exportAsPDF(const std::string& fileName,
                              const unsigned int marginRight,
                              const unsigned int marginTop,
                              const unsigned int marginBottom) {
-    std::string extension = fileName.substr(fileName.size() - 4);
-    pbcAssert(extension == ".pdf");
-    QPrinter printer(QPrinter::HighResolution);
-    printer.setOutputFileName(QString::fromStdString(fileName));
-    printer.setOutputFormat(QPrinter::PdfFormat);
-    unsigned int autoPaperWidth = paperWidth;
-    unsigned int autoPaperHeight = paperHeight;
-    if (paperWidth == 0 || paperHeight == 0) {
-        // is needed because play views are rendered to pixel graphics,
-        // which would result in huge files if not scaled down
-        float scaleFactor = 0.025;
-
-        autoPaperWidth = (PBCConfig::getInstance()->canvasWidth() * columns + marginLeft + marginRight) * scaleFactor;
-        autoPaperHeight = (PBCConfig::getInstance()->canvasHeight() * rows + marginTop + marginBottom) * scaleFactor;
-
-    }
-    std::cout << "paper width = " << autoPaperWidth << "; paper height = " << autoPaperHeight << std::endl;
-    printer.setPaperSize(QSizeF(autoPaperWidth, autoPaperHeight), QPrinter::Millimeter);
-
-    printer.setPageMargins(marginLeft,
-                           marginTop,
-                           marginRight,
-                           marginBottom,
-                           QPrinter::Millimeter);
-    pbcAssert(columns > 0);
-    pbcAssert(rows > 0);
-
-    boost::shared_ptr<qreal> pixelMarginLeftSP(new qreal());
-    boost::shared_ptr<qreal> pixelMarginRightSP(new qreal());
-    boost::shared_ptr<qreal> pixelMarginTopSP(new qreal());
-    boost::shared_ptr<qreal> pixelMarginBottomtSP(new qreal());
-    printer.getPageMargins(pixelMarginLeftSP.get(),
-                           pixelMarginTopSP.get(),
-                           pixelMarginRightSP.get(),
-                           pixelMarginBottomtSP.get(),
-                           QPrinter::DevicePixel);
-    QSize playSize = printer.pageRect().size();
-    playSize.setWidth(playSize.width() / columns);
-    playSize.setHeight(playSize.height() / rows);
-
-    printer.setPageMargins(0.0, 0.0, 0.0, 0.0, QPrinter::Millimeter);
-    QPainter painter(&printer);
-    bool paintBorder = true;
-    if(marginLeft == 0 &&
-       marginRight == 0 &&
-       marginTop == 0 &&
-       marginBottom == 0) {
-        paintBorder = false;
-    }
-    painter.setPen(QPen(QBrush(Qt::red), 20, Qt::DashLine));
-    QRectF borderRect(10,
-                      10,
-                      printer.paperRect().width() - 10,
-                      printer.paperRect().height() - 10);
-    if(paintBorder == true) {
-        painter.drawRect(printer.paperRect());
-    }
-
-
-
-    unsigned int x = 0;
-    unsigned int y = 0;
-    unsigned int columnCount = 1;
-    unsigned int rowCount = 1;
-
-    unsigned int old_width = PBCConfig::getInstance()->canvasWidth();
-    unsigned int old_height = PBCConfig::getInstance()->canvasHeight();
-    PBCConfig::getInstance()->setCanvasSize(playSize.width(), playSize.height());
-
-    for(QString playName : *playListSP) {
-        PBCPlaySP playSP = PBCController::getInstance()->getPlaybook()->getPlay(playName.toStdString()); //NOLINT
-        boost::shared_ptr<PBCPlayView> playViewSP(new PBCPlayView(playSP));  //NOLINT
-        playViewSP->render(&painter,
-                           QRectF(QPointF(x + *pixelMarginLeftSP, y + *pixelMarginTopSP), playSize),  //NOLINT
-                           QRectF(),
-                           Qt::IgnoreAspectRatio);
-        ++columnCount;
-        x = x + playSize.width();
-        if(columnCount > columns) {
-            x = 0;
-            y = y + playSize.height();
-            ++rowCount;
-            columnCount = 1;
-        }
-        if(rowCount > rows) {
-            bool successful = printer.newPage();
-            pbcAssert(successful == true);
-            if(paintBorder == true) {
-                painter.drawRect(borderRect);
-            }
-            rowCount = 1;
-            y = 0;
-        }
-    }
-
-    PBCConfig::getInstance()->setCanvasSize(old_width, old_height);
+    PBCPDFLayout layout{paperWidth, paperHeight, columns, rows, marginLeft, marginRight, marginTop, marginBottom};
+    PBCPDFExportJob job(fileName, *playListSP, layout);
+    job.run();
 }
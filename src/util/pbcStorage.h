@@ -24,63 +24,179 @@
 
 #include "pbcSingleton.h"
 #include "models/pbcPlay.h"
+#include "models/pbcPlaybook.h"
 #include "gui/pbcPlayView.h"
-#include <botan/pbkdf.h>
+#include "util/pbcBackupStore.h"
+#include "util/pbcKeyDerivation.h"
 #include <botan/secmem.h>
 #include <botan/data_src.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <list>
 
 typedef boost::shared_ptr<Botan::SecureVector<Botan::byte>> SaltSP;
 typedef boost::shared_ptr<Botan::OctetString> KeySP;
+
+/**
+ * @brief A key, the salt and the key derivation it has been derived with
+ */
+struct PBCCryptoKey {
+    KeySP key;
+    SaltSP salt;
+    PBCKdfSettings kdf;
+};
+
+/**
+ * @brief The summary of a playbook file, which is stored in a separately
+ * encrypted header, so it can be read without decrypting the playbook itself
+ * (see PBCStorage::readMetadata())
+ */
+struct PBCPlaybookMetadata {
+    std::string name;
+    std::string version;  // the version of Playbook Creator that has written the file
+    unsigned int numberOfPlayers = 0;
+    unsigned int plays = 0;
+    unsigned int categories = 0;
+    unsigned int formations = 0;
+    unsigned int routes = 0;
+    int64_t lastModified = 0;  // seconds since the epoch
+    // false if the file has no header (it has been written by an older version) and has been decrypted completely
+    bool fromHeader = false;
+
+    template<class Archive>
+    void serialize(Archive& ar, const unsigned int version) {  // NOLINT
+        ar & name;
+        ar & numberOfPlayers;
+        ar & plays;
+        ar & categories;
+        ar & formations;
+        ar & routes;
+        ar & lastModified;
+    }
+};
+
+class PBCLoadJob;
+
 class PBCStorage : public PBCSingleton<PBCStorage> {
     friend class PBCSingleton<PBCStorage>;
+    friend class PBCLoadJob;
 
 private:
     const std::string _CIPHER = "AES-256/GCM";
     const std::string _HASH = "SHA-256";
-    const std::string _PBKDF = "PBKDF2(SHA-256)";
-    const unsigned int _PBKDF_ITERATIONS = 10000;
     const unsigned int _SALT_SIZE = 16;  // in Bytes
     const unsigned int _IV_SIZE = 12;     // in Bytes = 96 Bits, recommended by BSI (https://www.bsi.bund.de/SharedDocs/Downloads/DE/BSI/Publikationen/TechnischeRichtlinien/TR02102/BSI-TR-02102.pdf?__blob=publicationFile&v=10)
     const unsigned int _KEY_SIZE = 32;  // in Bytes = 256 Bits
     const unsigned int _HASH_SIZE = 32;  // in Bytes = 256 Bits
-    const std::string _PREAMBLE = "Playbook-Creator\n"
-                           + PBCVersion::getVersionString() + "\n" \
-                           "playbook\n";
+    // Files of format 1 consist of the preamble, the salt, the IV and the
+    // encrypted playbook. Since format 2, the salt is followed by the IV, the
+    // size and the encrypted metadata header and then by the IV and the
+    // encrypted playbook. Both are authenticated separately; the preamble and
+    // the salt are authenticated with both, the header also with the playbook.
+    // Since format 3, the preamble names the key derivation and its
+    // parameters; older files use PBCKdfSettings::legacy().
+    const unsigned int _FORMAT = 3;
+    const unsigned int _MAX_METADATA_SIZE = 65536;  // in Bytes
+    const std::chrono::milliseconds _KDF_TARGET_TIME = std::chrono::milliseconds(250);
 
     std::string _currentPlaybookFileName;
-    SaltSP _saltSP;
-    KeySP _keySP;
+    PBCCryptoKey _cryptoKey;
+    PBCKdfSettings _keyDerivation;  // for new keys, empty until it is needed
+    PBCHash _savedContentHash = 0;
+    bool _savedContentHashValid = false;
+    PBCBackupPolicy _backupPolicy;
+    int64_t _lastBackupTime = 0;  // of the current playbook file, 0 if unknown
+    std::mutex _keyCacheMutex;
+    std::map<Botan::SecureVector<Botan::byte>, KeySP> _keyCache;  // key derivation, salt and password -> key
+    std::function<void(const std::string&)> _saveFailureListener;
+
+    struct Preamble {
+        std::string text;
+        std::string version;
+        unsigned int format;
+        PBCKdfSettings kdf;
+    };
 
     void checkVersion(const std::string &version);
-
-    void generateAndSetKey(const std::string &password);
-
-    void setCryptoKey(Botan::OctetString key,
-                      Botan::SecureVector<Botan::byte> salt);
-
-    void encrypt(const std::string &input, std::ofstream &outFile);  // NOLINT
-    std::pair<KeySP, SaltSP> decrypt(const std::string &password,
+    std::string newestPreamble(const PBCKdfSettings &kdf) const;
+    Preamble readPreamble(std::istream &inFile);  // NOLINT
+
+    PBCCryptoKey deriveKey(const std::string &password);
+    KeySP deriveKey(const std::string &password,
+                    const Botan::SecureVector<Botan::byte> &salt,
+                    const PBCKdfSettings &kdf);
+
+    void encrypt(const PBCPlaybook &playbook, std::ostream &outFile);  // NOLINT
+    void encrypt(const PBCPlaybook &playbook,
+                 std::ostream &outFile,  // NOLINT
+                 const PBCCryptoKey &cryptoKey);
+    std::string serializePlaybook(const PBCPlaybook& playbook);
+    PBCCryptoKey decrypt(const std::string &password,
                  std::ostream &ostream,  // NOLINT
-                 std::ifstream &inFile); // NOLINT
-
-    std::pair<KeySP, SaltSP> loadPlaybook(const std::string &password, const std::string &fileName, PBCPlaybookSP);
+                 std::istream &inFile,  // NOLINT
+                 const Preamble &preamble);
+
+    PBCCryptoKey readPlaybook(const std::string &password, const std::string &fileName, PBCPlaybookSP);
+    PBCCryptoKey loadPlaybook(const std::string &password, const std::string &fileName, PBCPlaybookSP);
+    void rekeyPlaybookFile(const std::string &oldPassword,
+                           const PBCCryptoKey &newKey,
+                           const std::string &fileName);
+    void activateFile(const std::string &fileName, const PBCCryptoKey &cryptoKey);
+    void writeActivePlaybook(const std::string &fileName, const PBCCryptoKey &cryptoKey);
+    void backupSavedPlaybook();
+    void backupCurrentPlaybook(bool force);
+    std::string readBackup(const std::string &password,
+                           const std::string &fileName,
+                           const std::string &snapshotId);
 
 protected:
     PBCStorage() {}
 
 public:
+    bool hasUnsavedChanges() const;
+
+    PBCKdfSettings keyDerivation();
+    void setKeyDerivation(const PBCKdfSettings &kdf);
+    PBCKdfSettings calibrateKeyDerivation(const std::string &algorithm, std::chrono::milliseconds targetTime);
+
     void init(const std::string &fileName);
 
     void savePlaybook(const std::string &password, const std::string &fileName);
 
     void automaticSavePlaybook();
+    void setSaveFailureListener(std::function<void(const std::string&)> listener) {
+        _saveFailureListener = listener;
+    }
 
     void writeToCurrentPlaybookFile();
+    const std::string& currentPlaybookFileName() const { return _currentPlaybookFileName; }
 
     void loadActivePlaybook(const std::string &password, const std::string &fileName);
+    void activatePlaybook(const PBCLoadJob &job);
+    PBCPlaybookSP openPlaybook(const std::string &password, const std::string &fileName);
+    PBCPlaybookMetadata readMetadata(const std::string &password, const std::string &fileName);
+    std::vector<std::pair<std::string, std::string>> changePassword(const std::string &oldPassword,
+                                                                    const std::string &newPassword,
+                                                                    const std::vector<std::string> &fileNames);
+    const PBCBackupPolicy& backupPolicy() const { return _backupPolicy; }
+    void setBackupPolicy(const PBCBackupPolicy &policy);
+    std::vector<PBCBackupStore::Snapshot> backups(const std::string &fileName) const;
+    PBCPlaybookSP openBackup(const std::string &password,
+                             const std::string &fileName,
+                             const std::string &snapshotId);
+    void restoreActivePlaybook(const std::string &password, const std::string &snapshotId);
+    void writePlaybookToFile(const std::string &password,
+                             const std::string &fileName,
+                             PBCPlaybookSP playbook);
+    PBCPlaybookSP exportPlaybook(const std::string &password,
+                                 const std::string &fileName,
+                                 const PBCPlaySelection &selection);
     void importPlaybook(
             const std::string &password,
             const std::string &fileName,
@@ -89,7 +205,17 @@ public:
             bool importRoutes,
             bool importFormations,
             const std::string& prefix = "",
-            const std::string& suffix = "");
+            const std::string& suffix = "",
+            bool skipIdenticalDuplicates = false);
+    void importPlaybook(
+            PBCPlaybookSP importedPlaybook,
+            bool importPlays,
+            bool importCategories,
+            bool importRoutes,
+            bool importFormations,
+            const std::string& prefix = "",
+            const std::string& suffix = "",
+            bool skipIdenticalDuplicates = false);
 
     void exportPlay(const std::string &fileName, PBCPlaySP play);
 
@@ -0,0 +1,215 @@
+/** @file pbcTrace.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcTrace.h"
+#include "util/pbcJson.h"
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+std::atomic<bool> PBCTrace::_enabled(false);
+
+/**
+ * @brief The recorded spans and the names of the threads. The buffer is
+ * never destroyed, so it can still be written at exit.
+ */
+struct TraceBuffer {
+    std::mutex mutex;
+    std::vector<PBCTraceEvent> events;
+    unsigned int capacity = 100000;
+    uint64_t recorded = 0;  // the next event is stored at recorded % capacity
+    PBCTrace::Clock::time_point epoch = PBCTrace::Clock::now();
+    std::map<uint32_t, std::string> threadNames;
+    std::string exitFileName;
+};
+
+static TraceBuffer& buffer() {
+    static TraceBuffer* traceBuffer = new TraceBuffer();
+    return *traceBuffer;
+}
+
+static std::atomic<uint32_t> nextThreadId(1);
+
+/**
+ * @brief Small consecutive thread ids are easier to read in the trace viewers
+ * than the ids of the operating system.
+ */
+static uint32_t currentThreadId() {
+    static thread_local uint32_t threadId = nextThreadId++;
+    return threadId;
+}
+
+/**
+ * @brief Enables or disables tracing. Enabling starts a new trace.
+ */
+void PBCTrace::setEnabled(bool enabled) {
+    if (enabled) {
+        clear();
+    }
+    _enabled.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Sets the number of spans that are kept. Recorded spans are dropped.
+ * @param capacity The number of spans
+ */
+void PBCTrace::setCapacity(unsigned int capacity) {
+    TraceBuffer& traceBuffer = buffer();
+    std::lock_guard<std::mutex> lock(traceBuffer.mutex);
+    traceBuffer.capacity = capacity > 0 ? capacity : 1;
+    traceBuffer.events.clear();
+    traceBuffer.recorded = 0;
+}
+
+/**
+ * @brief Names the calling thread in the trace
+ * @param name The name of the thread, e.g. "GUI"
+ */
+void PBCTrace::setThreadName(const std::string &name) {
+    TraceBuffer& traceBuffer = buffer();
+    std::lock_guard<std::mutex> lock(traceBuffer.mutex);
+    traceBuffer.threadNames[currentThreadId()] = name;
+}
+
+static void writeExitTrace() {
+    std::string fileName;
+    {
+        TraceBuffer& traceBuffer = buffer();
+        std::lock_guard<std::mutex> lock(traceBuffer.mutex);
+        fileName = traceBuffer.exitFileName;
+    }
+    PBCTrace::writeJson(fileName);
+}
+
+/**
+ * @brief Writes the trace to a file when the process exits normally
+ * @param fileName The trace file
+ */
+void PBCTrace::writeAtExit(const std::string &fileName) {
+    TraceBuffer& traceBuffer = buffer();
+    std::lock_guard<std::mutex> lock(traceBuffer.mutex);
+    if (traceBuffer.exitFileName.empty()) {
+        std::atexit(writeExitTrace);
+    }
+    traceBuffer.exitFileName = fileName;
+}
+
+/**
+ * @brief Stores a finished span of the calling thread
+ * @param name The name of the span. It must live as long as the process.
+ * @param start The start of the span
+ * @param end The end of the span
+ */
+void PBCTrace::record(const std::string *name, Clock::time_point start, Clock::time_point end) {
+    uint32_t threadId = currentThreadId();
+    TraceBuffer& traceBuffer = buffer();
+    std::lock_guard<std::mutex> lock(traceBuffer.mutex);
+    PBCTraceEvent event{
+        name,
+        threadId,
+        std::chrono::duration_cast<std::chrono::microseconds>(start - traceBuffer.epoch).count(),
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()};
+    if (traceBuffer.events.size() < traceBuffer.capacity) {
+        traceBuffer.events.push_back(event);
+    } else {
+        traceBuffer.events[traceBuffer.recorded % traceBuffer.capacity] = event;
+    }
+    ++traceBuffer.recorded;
+}
+
+/**
+ * @brief Gets the recorded spans
+ * @return The spans in the order in which they have finished (oldest first)
+ */
+std::vector<PBCTraceEvent> PBCTrace::events() {
+    TraceBuffer& traceBuffer = buffer();
+    std::lock_guard<std::mutex> lock(traceBuffer.mutex);
+    if (traceBuffer.events.size() < traceBuffer.capacity) {
+        return traceBuffer.events;
+    }
+    std::vector<PBCTraceEvent> result;
+    unsigned int oldest = traceBuffer.recorded % traceBuffer.capacity;
+    result.insert(result.end(), traceBuffer.events.begin() + oldest, traceBuffer.events.end());
+    result.insert(result.end(), traceBuffer.events.begin(), traceBuffer.events.begin() + oldest);
+    return result;
+}
+
+/**
+ * @brief Drops all recorded spans and restarts the time line
+ */
+void PBCTrace::clear() {
+    TraceBuffer& traceBuffer = buffer();
+    std::lock_guard<std::mutex> lock(traceBuffer.mutex);
+    traceBuffer.events.clear();
+    traceBuffer.recorded = 0;
+    traceBuffer.epoch = Clock::now();
+}
+
+/**
+ * @brief Converts the recorded spans to the Chrome trace-event format. The
+ * category of a span is the part of its name before the first dot.
+ * @return The JSON document
+ */
+std::string PBCTrace::toJson() {
+    std::map<uint32_t, std::string> threadNames;
+    {
+        TraceBuffer& traceBuffer = buffer();
+        std::lock_guard<std::mutex> lock(traceBuffer.mutex);
+        threadNames = traceBuffer.threadNames;
+    }
+    std::ostringstream json;
+    json << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    for (const auto& kv : threadNames) {
+        json << (first ? "\n" : ",\n")
+             << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << kv.first
+             << ", \"args\": {\"name\": " << PBCJson::string(kv.second) << "}}";
+        first = false;
+    }
+    for (const PBCTraceEvent& event : events()) {
+        std::string category = event.name->substr(0, event.name->find('.'));
+        json << (first ? "\n" : ",\n")
+             << "{\"name\": " << PBCJson::string(*event.name)
+             << ", \"cat\": " << PBCJson::string(category)
+             << ", \"ph\": \"X\", \"ts\": " << event.start
+             << ", \"dur\": " << event.duration
+             << ", \"pid\": 1, \"tid\": " << event.threadId << "}";
+        first = false;
+    }
+    json << "\n]}\n";
+    return json.str();
+}
+
+/**
+ * @brief Writes the recorded spans to a file (see toJson())
+ * @param fileName The trace file
+ * @return true if the file has been written
+ */
+bool PBCTrace::writeJson(const std::string &fileName) {
+    std::ofstream file(fileName, std::ios::trunc);
+    file << toJson();
+    file.close();
+    return file.good();
+}
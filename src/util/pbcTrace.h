@@ -0,0 +1,71 @@
+/** @file pbcTrace.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCTRACE_H
+#define PBCTRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A finished span
+ */
+struct PBCTraceEvent {
+    const std::string* name;  // owned by the metric the span has been recorded for
+    uint32_t threadId;
+    int64_t start;     // microseconds since the tracer has been enabled
+    int64_t duration;  // microseconds
+};
+
+/**
+ * @class PBCTrace
+ * @brief Records the spans of PBC_PERF_SCOPE (see pbcPerf.h) with their
+ * thread into a ring buffer and writes them as Chrome trace-event JSON, which
+ * can be opened in chrome://tracing or ui.perfetto.dev.
+ *
+ * Tracing is disabled by default. If the ring buffer is full, the oldest spans
+ * are overwritten.
+ */
+class PBCTrace {
+ public:
+    typedef std::chrono::steady_clock Clock;
+
+    static bool enabled() {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+    static void setEnabled(bool enabled);
+    static void setCapacity(unsigned int capacity);
+    static void setThreadName(const std::string& name);
+    static void writeAtExit(const std::string& fileName);
+    static void record(const std::string* name, Clock::time_point start, Clock::time_point end);
+    static std::vector<PBCTraceEvent> events();
+    static void clear();
+    static std::string toJson();
+    static bool writeJson(const std::string& fileName);
+
+ private:
+    static std::atomic<bool> _enabled;
+};
+
+#endif  // PBCTRACE_H
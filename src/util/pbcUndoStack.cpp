@@ -0,0 +1,276 @@
+/** @file pbcUndoStack.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcUndoStack.h"
+#include "util/pbcDeclarations.h"
+#include <string>
+
+/**
+ * @brief Appends a command to the macro
+ * @param command The command to append
+ */
+void PBCUndoMacro::append(PBCUndoCommandSP command) {
+    _commands.push_back(command);
+}
+
+/**
+ * @brief Checks whether any command has been recorded in this macro
+ * @return true if the macro is empty
+ */
+bool PBCUndoMacro::empty() const {
+    return _commands.empty();
+}
+
+/**
+ * @brief Undoes the recorded commands in reverse order
+ */
+void PBCUndoMacro::undo() {
+    for (auto it = _commands.rbegin(); it != _commands.rend(); ++it) {
+        (*it)->undo();
+    }
+}
+
+/**
+ * @brief Redoes the recorded commands in their original order
+ */
+void PBCUndoMacro::redo() {
+    for (const PBCUndoCommandSP& command : _commands) {
+        command->redo();
+    }
+}
+
+size_t PBCUndoMacro::byteSize() const {
+    size_t size = sizeof(*this) + _text.capacity();
+    for (const PBCUndoCommandSP& command : _commands) {
+        size += sizeof(command) + command->byteSize();
+    }
+    return size;
+}
+
+std::string PBCUndoMacro::text() const {
+    return _text;
+}
+
+/**
+ * @brief Returns the play that is affected by the most recent command of the
+ * macro that changes a play.
+ */
+PBCPlaySP PBCUndoMacro::affectedPlay() const {
+    for (auto it = _commands.rbegin(); it != _commands.rend(); ++it) {
+        PBCPlaySP play = (*it)->affectedPlay();
+        if (play != NULL) {
+            return play;
+        }
+    }
+    return PBCPlaySP();
+}
+
+
+/**
+ * @class PBCUndoStack
+ * @brief A linear undo/redo history of PBCUndoCommand instances.
+ *
+ * The history never copies the model. Each command only holds the changed
+ * parts (and shares the unchanged parts via smart pointers), so that every
+ * step costs memory proportional to the change. The memory of the whole
+ * history is bounded: if the estimated memory usage exceeds the budget, the
+ * oldest steps are dropped.
+ */
+
+/**
+ * @brief The constructor
+ * @param memoryBudget The maximum memory (in bytes) the history may retain
+ */
+PBCUndoStack::PBCUndoStack(size_t memoryBudget) :
+    _memoryBudget(memoryBudget),
+    _memoryUsage(0) {}
+
+/**
+ * @brief Records a command that has already been applied to the model.
+ *
+ * Pushing a command discards all redoable commands. If a macro is open, the
+ * command is appended to the innermost macro instead.
+ * @param command The command to record
+ */
+void PBCUndoStack::push(PBCUndoCommandSP command) {
+    pbcAssert(command != NULL);
+    if (!_openMacros.empty()) {
+        _openMacros.back()->append(command);
+        return;
+    }
+
+    for (const PBCUndoCommandSP& redoCommand : _redoCommands) {
+        _memoryUsage -= redoCommand->byteSize();
+    }
+    _redoCommands.clear();
+
+    if (!_undoCommands.empty()) {
+        PBCUndoCommandSP top = _undoCommands.back();
+        size_t oldSize = top->byteSize();
+        if (top->mergeWith(*command)) {
+            _memoryUsage = _memoryUsage - oldSize + top->byteSize();
+            enforceMemoryBudget();
+            notify();
+            return;
+        }
+    }
+
+    _undoCommands.push_back(command);
+    _memoryUsage += command->byteSize();
+    enforceMemoryBudget();
+    notify();
+}
+
+/**
+ * @brief Starts grouping all subsequently pushed commands into one step
+ * @param text The description of the grouped step
+ */
+void PBCUndoStack::beginMacro(const std::string &text) {
+    _openMacros.push_back(boost::shared_ptr<PBCUndoMacro>(new PBCUndoMacro(text)));
+}
+
+/**
+ * @brief Finishes the innermost macro and records it (if it is not empty)
+ */
+void PBCUndoStack::endMacro() {
+    if (_openMacros.empty()) {
+        return;  // the history has been cleared while the macro was open
+    }
+    boost::shared_ptr<PBCUndoMacro> macro = _openMacros.back();
+    _openMacros.pop_back();
+    if (!macro->empty()) {
+        push(macro);
+    }
+}
+
+bool PBCUndoStack::canUndo() const {
+    return !_undoCommands.empty();
+}
+
+bool PBCUndoStack::canRedo() const {
+    return !_redoCommands.empty();
+}
+
+/**
+ * @brief Undoes the most recent step
+ * @return The undone command or NULL if there is nothing to undo
+ */
+PBCUndoCommandSP PBCUndoStack::undo() {
+    if (_undoCommands.empty()) {
+        return PBCUndoCommandSP();
+    }
+    PBCUndoCommandSP command = _undoCommands.back();
+    _undoCommands.pop_back();
+    command->undo();
+    _redoCommands.push_back(command);
+    notify();
+    return command;
+}
+
+/**
+ * @brief Redoes the most recently undone step
+ * @return The redone command or NULL if there is nothing to redo
+ */
+PBCUndoCommandSP PBCUndoStack::redo() {
+    if (_redoCommands.empty()) {
+        return PBCUndoCommandSP();
+    }
+    PBCUndoCommandSP command = _redoCommands.back();
+    _redoCommands.pop_back();
+    command->redo();
+    _undoCommands.push_back(command);
+    notify();
+    return command;
+}
+
+std::string PBCUndoStack::undoText() const {
+    return _undoCommands.empty() ? "" : _undoCommands.back()->text();
+}
+
+std::string PBCUndoStack::redoText() const {
+    return _redoCommands.empty() ? "" : _redoCommands.back()->text();
+}
+
+/**
+ * @brief Drops the whole history, e.g. when another playbook is loaded
+ */
+void PBCUndoStack::clear() {
+    _undoCommands.clear();
+    _redoCommands.clear();
+    _openMacros.clear();
+    _memoryUsage = 0;
+    notify();
+}
+
+/**
+ * @brief The number of undoable steps
+ */
+size_t PBCUndoStack::count() const {
+    return _undoCommands.size();
+}
+
+/**
+ * @brief The estimated memory (in bytes) retained by undo and redo steps
+ */
+size_t PBCUndoStack::memoryUsage() const {
+    return _memoryUsage;
+}
+
+size_t PBCUndoStack::memoryBudget() const {
+    return _memoryBudget;
+}
+
+/**
+ * @brief Changes the memory budget and drops old steps if necessary
+ * @param bytes The new budget in bytes
+ */
+void PBCUndoStack::setMemoryBudget(size_t bytes) {
+    _memoryBudget = bytes;
+    enforceMemoryBudget();
+}
+
+/**
+ * @brief Drops the oldest undo steps until the history fits into the budget.
+ *
+ * The most recent step is always kept, so that a single large edit can still
+ * be undone.
+ */
+void PBCUndoStack::enforceMemoryBudget() {
+    while (_memoryUsage > _memoryBudget && _undoCommands.size() > 1) {
+        _memoryUsage -= _undoCommands.front()->byteSize();
+        _undoCommands.pop_front();
+    }
+}
+
+/**
+ * @brief Sets the function that is called whenever the undoable or redoable
+ * steps have changed (e.g. to update the undo / redo actions of the GUI)
+ * @param listener The function or an empty function to remove the listener
+ */
+void PBCUndoStack::setListener(Listener listener) {
+    _listener = listener;
+}
+
+void PBCUndoStack::notify() {
+    if (_listener) {
+        _listener();
+    }
+}
@@ -0,0 +1,147 @@
+/** @file pbcUndoStack.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCUNDOSTACK_H
+#define PBCUNDOSTACK_H
+
+#include <boost/shared_ptr.hpp>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+class PBCPlay;
+typedef boost::shared_ptr<PBCPlay> PBCPlaySP;
+
+class PBCUndoCommand;
+typedef boost::shared_ptr<PBCUndoCommand> PBCUndoCommandSP;
+
+/**
+ * @class PBCUndoCommand
+ * @brief The interface of a single reversible edit.
+ *
+ * A command only stores the parts of the model that have been changed by the
+ * edit. Everything else is shared with the live model via smart pointers.
+ */
+class PBCUndoCommand {
+ public:
+    virtual ~PBCUndoCommand() {}
+    virtual void undo() = 0;
+    virtual void redo() = 0;
+    /**
+     * @brief Estimates the heap memory retained by this command (in bytes)
+     */
+    virtual size_t byteSize() const = 0;
+    virtual std::string text() const = 0;
+    /**
+     * @brief Merges a subsequent command into this one (e.g. typing a name
+     * character by character)
+     * @return true if other has been merged and must not be pushed separately
+     */
+    virtual bool mergeWith(const PBCUndoCommand& other) { return false; }
+    /**
+     * @brief The (working copy of the) play that is changed by this command,
+     * or NULL if the command changes the playbook itself
+     */
+    virtual PBCPlaySP affectedPlay() const { return PBCPlaySP(); }
+};
+
+/**
+ * @class PBCUndoMacro
+ * @brief Groups several commands, so that they are undone and redone as a
+ * single step.
+ */
+class PBCUndoMacro : public PBCUndoCommand {
+ private:
+    std::string _text;
+    std::vector<PBCUndoCommandSP> _commands;
+
+ public:
+    explicit PBCUndoMacro(const std::string& text) : _text(text) {}
+    void append(PBCUndoCommandSP command);
+    bool empty() const;
+    void undo();
+    void redo();
+    size_t byteSize() const;
+    std::string text() const;
+    PBCPlaySP affectedPlay() const;
+};
+
+class PBCUndoStack {
+ public:
+    typedef std::function<void()> Listener;
+
+ private:
+    std::deque<PBCUndoCommandSP> _undoCommands;
+    std::deque<PBCUndoCommandSP> _redoCommands;
+    std::vector<boost::shared_ptr<PBCUndoMacro>> _openMacros;
+    size_t _memoryBudget;
+    size_t _memoryUsage;
+    Listener _listener;
+
+    void enforceMemoryBudget();
+    void notify();
+
+ public:
+    static const size_t DEFAULT_MEMORY_BUDGET = 8 * 1024 * 1024;  // in Bytes
+
+    explicit PBCUndoStack(size_t memoryBudget = DEFAULT_MEMORY_BUDGET);
+    void push(PBCUndoCommandSP command);
+    void beginMacro(const std::string& text);
+    void endMacro();
+    bool canUndo() const;
+    bool canRedo() const;
+    PBCUndoCommandSP undo();
+    PBCUndoCommandSP redo();
+    std::string undoText() const;
+    std::string redoText() const;
+    void clear();
+    size_t count() const;
+    size_t memoryUsage() const;
+    size_t memoryBudget() const;
+    void setMemoryBudget(size_t bytes);
+    void setListener(Listener listener);
+};
+
+/**
+ * @class PBCUndoMacroScope
+ * @brief Groups all commands pushed during its lifetime into one undo step.
+ *
+ * The macro is also closed if the edit is left by an exception (e.g. a
+ * PBCAutoSaveException), so that the history never keeps a dangling macro.
+ */
+class PBCUndoMacroScope {
+ private:
+    PBCUndoStack& _history;
+
+ public:
+    PBCUndoMacroScope(PBCUndoStack& history, const std::string& text) : _history(history) {  // NOLINT
+        _history.beginMacro(text);
+    }
+    ~PBCUndoMacroScope() {
+        _history.endMacro();
+    }
+    PBCUndoMacroScope(const PBCUndoMacroScope&) = delete;
+    PBCUndoMacroScope& operator=(const PBCUndoMacroScope&) = delete;
+};
+
+#endif  // PBCUNDOSTACK_H
@@ -0,0 +1,245 @@
+/** @file pbcUpdateChecker.cpp
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#include "pbcUpdateChecker.h"
+#include "util/pbcDeclarations.h"
+#include "../../updater/pbc_updater_bindings.h"
+#include <algorithm>
+#include <condition_variable>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief The state that is shared between the checker, its thread and the
+ * fetching thread. The fetching thread may outlive the checker (if the fetch
+ * has timed out or has been cancelled), so it must not touch anything else.
+ */
+struct PBCUpdateChecker::State {
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool started = false;
+    bool fetched = false;
+    bool cancelled = false;
+    PBCReleaseInfo result;
+};
+
+static PBCReleaseInfo releaseInfo(PBCReleaseInfo::Status status) {
+    PBCReleaseInfo info;
+    info.status = status;
+    info.major = 0;
+    info.minor = 0;
+    info.patch = 0;
+    info.fromCache = false;
+    return info;
+}
+
+/**
+ * @brief The constructor
+ * @param currentVersion The running version. Cached results of other versions
+ * are ignored.
+ * @param fetcher The function that fetches the release metadata. It is called
+ * on a separate thread.
+ * @param cacheFileName The file in which the last result is cached
+ * @param cacheTTL The time after which a cached result is fetched again
+ * @param timeout The time after which a running fetch is abandoned
+ * @param failureTTL The time after which a cached failure is fetched again
+ */
+PBCUpdateChecker::PBCUpdateChecker(const std::string &currentVersion,
+                                   Fetcher fetcher,
+                                   const std::string &cacheFileName,
+                                   std::chrono::seconds cacheTTL,
+                                   std::chrono::milliseconds timeout,
+                                   std::chrono::seconds failureTTL) :
+    _currentVersion(currentVersion),
+    _fetcher(fetcher),
+    _cacheFileName(cacheFileName),
+    _cacheTTL(cacheTTL),
+    _timeout(timeout),
+    _failureTTL(failureTTL),
+    _state(new State()) {}
+
+/**
+ * @brief The destructor. Cancels a running check.
+ */
+PBCUpdateChecker::~PBCUpdateChecker() {
+    cancel();
+}
+
+/**
+ * @brief Starts the check and returns immediately.
+ * @param callback Is called with the result on the checker's thread (unless
+ * the check is cancelled before). It must not call cancel() or destroy the
+ * checker.
+ */
+void PBCUpdateChecker::start(Callback callback) {
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        pbcAssert(_state->started == false);
+        _state->started = true;
+    }
+    _thread = std::thread(&PBCUpdateChecker::run, this, callback);
+}
+
+/**
+ * @brief Cancels the check. The callback will not be called afterwards.
+ * Blocks only until a callback that is already running has returned, never
+ * until the fetch has finished.
+ */
+void PBCUpdateChecker::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        _state->cancelled = true;
+    }
+    _state->condition.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+void PBCUpdateChecker::run(Callback callback) {
+    PBCReleaseInfo info;
+    if (readCache(info) == false) {
+        boost::shared_ptr<State> state = _state;
+        Fetcher fetcher = _fetcher;
+        std::thread([state, fetcher]() {
+            PBCReleaseInfo result;
+            try {
+                result = fetcher();
+            } catch (std::exception& e) {
+                result = releaseInfo(PBCReleaseInfo::CHECK_FAILED);
+                result.description = e.what();
+            }
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->result = result;
+                state->fetched = true;
+            }
+            state->condition.notify_all();
+        }).detach();
+
+        std::unique_lock<std::mutex> lock(_state->mutex);
+        bool finished = _state->condition.wait_for(lock, _timeout, [this]() {
+            return _state->fetched || _state->cancelled;
+        });
+        if (_state->cancelled) {
+            return;
+        }
+        if (finished) {
+            info = _state->result;
+            info.fromCache = false;
+        } else {
+            info = releaseInfo(PBCReleaseInfo::TIMED_OUT);
+        }
+        lock.unlock();
+
+        writeCache(info);
+    }
+
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    if (_state->cancelled == false) {
+        callback(info);
+    }
+}
+
+/**
+ * @brief Reads the cached result of the last check
+ * @param info Is set to the cached result
+ * @return true if there is a result for the current version that is younger
+ * than the cache's time to live (or the failure time to live if the check
+ * has failed or timed out)
+ */
+bool PBCUpdateChecker::readCache(PBCReleaseInfo &info) const {
+    std::ifstream file(_cacheFileName);
+    std::string version;
+    std::time_t fetchTime;
+    int status;
+    if (!std::getline(file, version) ||
+        !(file >> fetchTime >> status >> info.major >> info.minor >> info.patch)) {
+        return false;
+    }
+    file.ignore(1);  // the line break before the description
+    info.description.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    std::chrono::system_clock::time_point fetched = std::chrono::system_clock::from_time_t(fetchTime);
+    std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+    if (status < PBCReleaseInfo::UPDATE_AVAILABLE || status > PBCReleaseInfo::TIMED_OUT) {
+        return false;
+    }
+    const bool succeeded = status == PBCReleaseInfo::UPDATE_AVAILABLE || status == PBCReleaseInfo::UP_TO_DATE;
+    const std::chrono::seconds ttl = succeeded ? _cacheTTL : _failureTTL;
+    if (version != _currentVersion || fetched > now || now - fetched > ttl) {
+        return false;
+    }
+    info.status = static_cast<PBCReleaseInfo::Status>(status);
+    info.fromCache = true;
+    return true;
+}
+
+void PBCUpdateChecker::writeCache(const PBCReleaseInfo &info) const {
+    std::ofstream file(_cacheFileName, std::ios::trunc);
+    file << _currentVersion << "\n"
+         << std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()) << "\n"
+         << static_cast<int>(info.status) << "\n"
+         << info.major << " " << info.minor << " " << info.patch << "\n"
+         << info.description;
+    // a cache that cannot be written is not worth bothering the user
+}
+
+/**
+ * @brief Creates a fetcher that asks a GitHub-compatible API for the releases
+ * of Playbook Creator
+ * @param major The running major version
+ * @param minor The running minor version
+ * @param patch The running patch version
+ * @param apiUrl The url of the API (without trailing slash)
+ * @return The fetcher
+ */
+PBCUpdateChecker::Fetcher PBCUpdateChecker::releaseFetcher(unsigned int major,
+                                                           unsigned int minor,
+                                                           unsigned int patch,
+                                                           const std::string &apiUrl) {
+    return [major, minor, patch, apiUrl]() {
+        const uint32_t BUFF_LEN = 500;
+        uint8_t buffer[BUFF_LEN] = {0};
+        CBuffer descriptionBuffer = CBuffer{buffer, BUFF_LEN};
+        UpdateCheckingStatus ucs = updates_available_from(apiUrl.c_str(), major, minor, patch, &descriptionBuffer);
+        PBCReleaseInfo info = releaseInfo(PBCReleaseInfo::CHECK_FAILED);
+        switch (ucs.tag) {
+            case UpdateCheckingStatus::Tag::UpdatesAvailable:
+                info.status = PBCReleaseInfo::UPDATE_AVAILABLE;
+                info.major = ucs.updates_available._0;
+                info.minor = ucs.updates_available._1;
+                info.patch = ucs.updates_available._2;
+                info.description = std::string(reinterpret_cast<const char*>(buffer),
+                                               std::find(buffer, buffer + BUFF_LEN, 0) - buffer);
+                break;
+            case UpdateCheckingStatus::Tag::UpToDate:
+                info.status = PBCReleaseInfo::UP_TO_DATE;
+                break;
+            case UpdateCheckingStatus::Tag::Error:
+                break;
+        }
+        return info;
+    };
+}
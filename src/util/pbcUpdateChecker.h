@@ -0,0 +1,105 @@
+/** @file pbcUpdateChecker.h
+    This file is part of Playbook Creator.
+
+    Playbook Creator is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Playbook Creator is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Playbook Creator.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2026 Oliver Braunsdorf
+
+    @author Oliver Braunsdorf
+*/
+
+#ifndef PBCUPDATECHECKER_H
+#define PBCUPDATECHECKER_H
+
+#include <boost/shared_ptr.hpp>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+
+/**
+ * @brief The result of an update check
+ */
+struct PBCReleaseInfo {
+    enum Status {
+        UPDATE_AVAILABLE,
+        UP_TO_DATE,
+        CHECK_FAILED,
+        TIMED_OUT
+    };
+
+    Status status;
+    // the latest release (only valid if an update is available)
+    unsigned int major;
+    unsigned int minor;
+    unsigned int patch;
+    std::string description;
+    // true if the result has been read from the cache file
+    bool fromCache;
+};
+
+/**
+ * @class PBCUpdateChecker
+ * @brief Checks for a new release of Playbook Creator in the background.
+ *
+ * The release metadata is fetched on a separate thread, so startup does not
+ * wait for the network. If the fetch does not finish within the timeout,
+ * TIMED_OUT is reported and the fetch is abandoned. Successful results are
+ * written to a cache file and reused until they are older than the cache's
+ * time to live, so most starts do not send a request at all. Failed and
+ * timed out checks are cached as well, but only for the shorter failure time
+ * to live, so a missing connection is not retried on every start.
+ */
+class PBCUpdateChecker {
+ public:
+    typedef std::function<PBCReleaseInfo()> Fetcher;
+    typedef std::function<void(const PBCReleaseInfo&)> Callback;
+
+    PBCUpdateChecker(const std::string& currentVersion,
+                     Fetcher fetcher,
+                     const std::string& cacheFileName,
+                     std::chrono::seconds cacheTTL = std::chrono::hours(24),
+                     std::chrono::milliseconds timeout = std::chrono::seconds(10),
+                     std::chrono::seconds failureTTL = std::chrono::hours(1));
+    ~PBCUpdateChecker();
+
+    void start(Callback callback);
+    void cancel();
+
+    static Fetcher releaseFetcher(unsigned int major,
+                                  unsigned int minor,
+                                  unsigned int patch,
+                                  const std::string& apiUrl = "https://api.github.com");
+
+ private:
+    struct State;
+
+    std::string _currentVersion;
+    Fetcher _fetcher;
+    std::string _cacheFileName;
+    std::chrono::seconds _cacheTTL;
+    std::chrono::milliseconds _timeout;
+    std::chrono::seconds _failureTTL;
+    boost::shared_ptr<State> _state;
+    std::thread _thread;
+
+    PBCUpdateChecker(const PBCUpdateChecker& other) = delete;
+    PBCUpdateChecker& operator=(const PBCUpdateChecker& other) = delete;
+
+    void run(Callback callback);
+    bool readCache(PBCReleaseInfo& info) const;  // NOLINT
+    void writeCache(const PBCReleaseInfo& info) const;
+};
+
+#endif  // PBCUPDATECHECKER_H
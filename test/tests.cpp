@@ -1,10 +1,56 @@
 #define BOOST_TEST_MODULE PBCTests
 
+#include "dialogs/mainDialog.h"
 #include "util/pbcStorage.h"
+#include "util/pbcBackupStore.h"
 #include "util/pbcExceptions.h"
+#include "models/pbcUndoCommands.h"
+#include "models/pbcPlaybookCompaction.h"
+#include "models/pbcPlaybookMerge.h"
+#include "util/pbcConfig.h"
+#include "util/pbcContext.h"
+#include "util/pbcKeyDerivation.h"
+#include "util/pbcLoadJob.h"
+#include "gui/pbcPlayRenderer.h"
+#include "gui/pbcPlayView.h"
+#include "models/pbcMotion.h"
+#include "util/pbcBookletExport.h"
+#include "util/pbcImageExport.h"
+#include "util/pbcMultiLayoutExportJob.h"
+#include "util/pbcPDFExportJob.h"
+#include "util/pbcPDFOutline.h"
+#include "util/pbcUpdateChecker.h"
+#include "util/pbcLog.h"
+#include "util/pbcJson.h"
+#include "util/pbcPerf.h"
+#include "util/pbcTrace.h"
+#include <botan/hex.h>
+#include <botan/mac.h>
 #include <boost/test/unit_test.hpp>
+#include <QAction>
+#include <QApplication>
+#include <QImage>
+#include <QPainter>
+#include <QSettings>
 #include <boost/filesystem.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 
 using namespace boost::filesystem;
@@ -18,6 +64,12 @@ struct PBCTestConfig {
         BOOST_REQUIRE ( framework::master_test_suite().argc == 3 );
         BOOST_TEST( framework::master_test_suite().argv[1] == "--test-base-dir" );
         test_base_dir = path(framework::master_test_suite().argv[2]);
+
+        // the tests change settings (e.g. the key derivation), which must not
+        // end up in the settings of the user
+        QSettings::setDefaultFormat(QSettings::IniFormat);
+        QSettings::setPath(QSettings::IniFormat, QSettings::UserScope,
+                           QString::fromStdString((temp_directory_path() / unique_path()).string()));
         //std::cout << "test base directory: " << test_base_dir << std::endl;
     }
 
@@ -27,6 +79,23 @@ path PBCTestConfig::test_base_dir = "test";     //default directory. but has to
 
 BOOST_TEST_GLOBAL_FIXTURE(PBCTestConfig);
 
+/**
+ * @brief Creates the application object for the test suites that need widgets
+ * or fonts. It is created once on the offscreen platform, so no display is
+ * needed, and kept until the tests exit.
+ */
+struct PBCGuiFixture {
+    PBCGuiFixture() {
+        if (QApplication::instance() == NULL) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+            static int argc = 1;
+            static char name[] = "tests";
+            static char* argv[] = {name, NULL};
+            new QApplication(argc, argv);
+        }
+    }
+};
+
 
 
 BOOST_AUTO_TEST_SUITE(VersionTests)
@@ -470,4 +539,2272 @@ BOOST_AUTO_TEST_SUITE(StorageTests)
                 PBCImportException
         );
     }
-BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
+
+    BOOST_AUTO_TEST_CASE(import_identical_duplicates_test) {
+        PBCController::getInstance()->getPlaybook()->resetToNewEmptyPlaybook("dedup", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        PBCFormationSP formation = PBCController::getInstance()->getPlaybook()->formations().front();
+        PBCPlaySP play(new PBCPlay("testplay1", "testcode1", formation->name()));
+        PBCController::getInstance()->getPlaybook()->addPlay(play);  // playbook is automatically saved here;
+        PBCStorage::getInstance()->loadActivePlaybook("test", "test.pbc");
+        const PBCHash hash = PBCController::getInstance()->getPlaybook()->contentHash();
+
+        BOOST_CHECK_NO_THROW(
+                PBCStorage::getInstance()->importPlaybook("test", "test.pbc", true, true, true, true, "", "", true));
+        BOOST_CHECK_EQUAL(PBCController::getInstance()->getPlaybook()->contentHash(), hash);
+        BOOST_CHECK(!PBCStorage::getInstance()->hasUnsavedChanges());
+
+        PBCController::getInstance()->getPlaybook()->getPlay("testplay1")->setComment("changed");
+        BOOST_CHECK(PBCStorage::getInstance()->hasUnsavedChanges());
+        BOOST_CHECK_THROW(
+                PBCStorage::getInstance()->importPlaybook("test", "test.pbc", true, true, true, true, "", "", true),
+                PBCImportException
+        );
+    }
+
+    BOOST_AUTO_TEST_CASE(write_merged_playbook_test) {
+        PBCController::getInstance()->getPlaybook()->resetToNewEmptyPlaybook("merge", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        PBCPlaybookSP base = PBCStorage::getInstance()->openPlaybook("test", "test.pbc");
+        PBCFormationSP formation = PBCController::getInstance()->getPlaybook()->formations().front();
+        PBCController::getInstance()->getPlaybook()->addPlay(PBCPlaySP(new PBCPlay("ourplay", "", formation->name())));
+        PBCPlaybookSP theirs = PBCStorage::getInstance()->openPlaybook("test", "test.pbc");
+        theirs->addPlay(PBCPlaySP(new PBCPlay("theirplay", "", formation->name())), false, true);
+
+        PBCMergeResult result = PBCPlaybookMerge::merge(*base, *PBCController::getInstance()->getPlaybook(), *theirs);
+        BOOST_CHECK(result.conflicts.empty());
+        PBCStorage::getInstance()->writePlaybookToFile("merged", "merged.pbc", result.playbook);
+        PBCPlaybookSP merged = PBCStorage::getInstance()->openPlaybook("merged", "merged.pbc");
+        BOOST_CHECK_EQUAL(merged->getPlayNames().size(), 2);
+        BOOST_CHECK_EQUAL(merged->contentHash(), result.playbook->contentHash());
+    }
+
+    BOOST_AUTO_TEST_CASE(export_sub_playbook_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("export", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        const std::string formationName = playbook->formations().front()->name();
+        PBCRouteSP route = playbook->getRoute(playbook->getRouteNames().front());
+        PBCCategorySP category(new PBCCategory("exported"));
+        playbook->addCategory(category);
+        for (const std::string name : {"play1", "play2", "play3"}) {
+            PBCPlaySP play(new PBCPlay(name, "", formationName));
+            play->formation()->front()->setRoute(route);
+            playbook->addPlay(play);
+            if (name != "play3") {
+                play->addCategory(category);
+                category->addPlay(play);
+            }
+        }
+        const PBCHash hash = playbook->contentHash();
+
+        PBCPlaySelection selection;
+        selection.categories.insert("exported");
+        PBCPlaybookSP exported = PBCStorage::getInstance()->exportPlaybook("part", "part.pbc", selection);
+        BOOST_CHECK_EQUAL(playbook->contentHash(), hash);
+        BOOST_CHECK_EQUAL(PBCStorage::getInstance()->currentPlaybookFileName(), "test.pbc");
+
+        PBCPlaybookSP part = PBCStorage::getInstance()->openPlaybook("part", "part.pbc");
+        BOOST_CHECK_EQUAL(part->contentHash(), exported->contentHash());
+        BOOST_CHECK(part->getPlayNames() == std::vector<std::string>({"play1", "play2"}));
+        BOOST_CHECK(part->getRouteNames() == std::vector<std::string>({route->name()}));
+        BOOST_CHECK_EQUAL(part->playsInCategory("exported").size(), 2);
+        // the route is still shared between the plays and the route library
+        BOOST_CHECK(part->getPlay("play1")->formation()->front()->route() == part->getRoute(route->name()));
+        BOOST_CHECK(part->getPlay("play2")->formation()->front()->route() == part->getRoute(route->name()));
+    }
+
+    BOOST_AUTO_TEST_CASE(async_load_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("async", 5);
+        const std::string formationName = playbook->formations().front()->name();
+        PBCStorage::getInstance()->savePlaybook("test", "async.pbc");
+        playbook->addPlay(PBCPlaySP(new PBCPlay("play1", "", formationName)));
+        const PBCHash savedHash = playbook->contentHash();
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        playbook->addPlay(PBCPlaySP(new PBCPlay("play2", "", formationName)));
+        const PBCHash activeHash = playbook->contentHash();
+
+        std::vector<PBCLoadJob::Phase> phases;
+        std::atomic<int> finished(0);
+        PBCLoadJob job("test.pbc");
+        job.start("wrong",
+                  [&phases](PBCLoadJob::Phase phase, double) { phases.push_back(phase); },
+                  [&finished]() { ++finished; });
+        job.wait();
+        BOOST_CHECK_EQUAL(finished.load(), 1);
+        BOOST_CHECK_EQUAL(job.status(), PBCLoadJob::FAILED);
+        BOOST_CHECK_THROW(job.rethrow(), PBCDecryptionException);
+        BOOST_CHECK(job.playbook() == NULL);
+        BOOST_CHECK(std::find(phases.begin(), phases.end(), PBCLoadJob::READING) != phases.end());
+
+        // the retry does not read the file again
+        phases.clear();
+        job.start("test",
+                  [&phases](PBCLoadJob::Phase phase, double) { phases.push_back(phase); },
+                  [&finished]() { ++finished; });
+        job.wait();
+        BOOST_CHECK_EQUAL(finished.load(), 2);
+        BOOST_REQUIRE_EQUAL(job.status(), PBCLoadJob::SUCCEEDED);
+        BOOST_CHECK(std::find(phases.begin(), phases.end(), PBCLoadJob::READING) == phases.end());
+        BOOST_CHECK(std::find(phases.begin(), phases.end(), PBCLoadJob::DESERIALIZING) != phases.end());
+        BOOST_CHECK_EQUAL(job.playbook()->contentHash(), savedHash);
+
+        // the active playbook is replaced only when the job is activated
+        BOOST_CHECK_EQUAL(playbook->contentHash(), activeHash);
+        PBCStorage::getInstance()->loadActivePlaybook("test", "async.pbc");
+        BOOST_CHECK_EQUAL(PBCStorage::getInstance()->currentPlaybookFileName(), "async.pbc");
+        PBCStorage::getInstance()->activatePlaybook(job);
+        BOOST_CHECK(PBCController::getInstance()->getPlaybook() == playbook);
+        BOOST_CHECK_EQUAL(playbook->contentHash(), savedHash);
+        BOOST_CHECK_EQUAL(PBCStorage::getInstance()->currentPlaybookFileName(), "test.pbc");
+        BOOST_CHECK(playbook->getPlay("play1") != NULL);
+    }
+
+    BOOST_AUTO_TEST_CASE(async_load_cancel_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("cancel", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        const PBCHash hash = playbook->contentHash();
+
+        PBCLoadJob job("test.pbc");
+        job.start("test",
+                  [&job](PBCLoadJob::Phase phase, double) {
+                      if (phase == PBCLoadJob::DERIVING_KEY) {
+                          job.cancel();
+                      }
+                  },
+                  []() {});
+        job.wait();
+        BOOST_CHECK_EQUAL(job.status(), PBCLoadJob::CANCELLED);
+        BOOST_CHECK(job.playbook() == NULL);
+        BOOST_CHECK_EQUAL(playbook->contentHash(), hash);
+    }
+
+    BOOST_AUTO_TEST_CASE(metadata_test) {
+        PBCController::getInstance()->getPlaybook()->resetToNewEmptyPlaybook("metadata", 7);
+        PBCFormationSP formation = PBCController::getInstance()->getPlaybook()->formations().front();
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        PBCController::getInstance()->getPlaybook()->addPlay(PBCPlaySP(new PBCPlay("play1", "", formation->name())));
+        PBCController::getInstance()->getPlaybook()->addPlay(PBCPlaySP(new PBCPlay("play2", "", formation->name())));
+
+        PBCPlaybookMetadata metadata = PBCStorage::getInstance()->readMetadata("test", "test.pbc");
+        BOOST_CHECK(metadata.fromHeader);
+        BOOST_CHECK_EQUAL(metadata.name, "metadata");
+        BOOST_CHECK_EQUAL(metadata.version, PBCVersion::getVersionString());
+        BOOST_CHECK_EQUAL(metadata.numberOfPlayers, 7);
+        BOOST_CHECK_EQUAL(metadata.plays, 2);
+        BOOST_CHECK_EQUAL(metadata.formations, PBCController::getInstance()->getPlaybook()->formations().size());
+        BOOST_CHECK_EQUAL(metadata.routes, PBCController::getInstance()->getPlaybook()->routes().size());
+        BOOST_CHECK(std::abs(metadata.lastModified - std::time(NULL)) < 60);
+
+        BOOST_CHECK_THROW(PBCStorage::getInstance()->readMetadata("wrong", "test.pbc"), PBCDecryptionException);
+    }
+
+    BOOST_AUTO_TEST_CASE(metadata_of_old_format_test) {
+        path test_pb_path = PBCTestConfig::test_base_dir / "resources" / "StorageTests" /
+                            "VersionTestPlaybooks" / "v0_18_0.pbc";
+        PBCPlaybookMetadata metadata = PBCStorage::getInstance()->readMetadata("test", test_pb_path.string());
+        BOOST_CHECK(!metadata.fromHeader);
+        BOOST_CHECK_EQUAL(metadata.version, "0.17.1");  // the version that has written the file
+        BOOST_CHECK(metadata.plays >= 1);
+    }
+
+    BOOST_AUTO_TEST_CASE(tampered_header_test) {
+        PBCController::getInstance()->getPlaybook()->resetToNewEmptyPlaybook("tampered", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        std::fstream file("test.pbc", std::ios::in | std::ios::out | std::ios::binary);
+        std::string preamble;
+        for (int i = 0; i < 3; ++i) {
+            std::getline(file, preamble);
+        }
+        // flip a bit in the encrypted header (behind the salt, the IV and the size)
+        std::streamoff headerStart = static_cast<std::streamoff>(file.tellg()) + 16 + 12 + 4;
+        file.seekg(headerStart);
+        char byte = file.get();
+        file.seekp(headerStart);
+        file.put(byte ^ 1);
+        file.close();
+
+        BOOST_CHECK_THROW(PBCStorage::getInstance()->readMetadata("test", "test.pbc"), PBCDecryptionException);
+        BOOST_CHECK_THROW(PBCStorage::getInstance()->openPlaybook("test", "test.pbc"), PBCDecryptionException);
+    }
+
+    BOOST_AUTO_TEST_CASE(streamed_decrypt_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("streamed", 5);
+        PBCFormationSP formation = playbook->formations().front();
+        for (int i = 0; i < 500; ++i) {  // several chunks
+            playbook->addPlay(PBCPlaySP(new PBCPlay("play" + std::to_string(i), "", formation->name())), false, true);
+        }
+        PBCStorage::getInstance()->savePlaybook("test", "streamed.pbc");
+        const PBCHash hash = playbook->contentHash();
+        BOOST_CHECK_EQUAL(PBCStorage::getInstance()->openPlaybook("test", "streamed.pbc")->contentHash(), hash);
+
+        PBCLoadJob job("streamed.pbc");
+        job.start("test", [](PBCLoadJob::Phase, double) {}, []() {});
+        job.wait();
+        BOOST_REQUIRE_EQUAL(job.status(), PBCLoadJob::SUCCEEDED);
+        BOOST_CHECK_EQUAL(job.playbook()->contentHash(), hash);
+
+        // a file without its last bytes does not authenticate
+        std::ifstream file("streamed.pbc", std::ios_base::binary);
+        std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        file.close();
+        std::ofstream truncated("truncated.pbc", std::ios_base::binary);
+        truncated.write(content.data(), content.size() - 20);
+        truncated.close();
+        BOOST_CHECK_THROW(PBCStorage::getInstance()->openPlaybook("test", "truncated.pbc"), PBCDecryptionException);
+    }
+
+    BOOST_AUTO_TEST_CASE(change_password_test) {
+        PBCController::getInstance()->getPlaybook()->resetToNewEmptyPlaybook("rekey", 5);
+        PBCFormationSP formation = PBCController::getInstance()->getPlaybook()->formations().front();
+        for (int i = 0; i < 200; ++i) {  // larger than one chunk
+            PBCController::getInstance()->getPlaybook()->addPlay(
+                    PBCPlaySP(new PBCPlay("play" + std::to_string(i), "", formation->name())), false, true);
+        }
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        PBCStorage::getInstance()->writePlaybookToFile("test", "other.pbc",
+                                                       PBCController::getInstance()->getPlaybook());
+        const PBCHash hash = PBCController::getInstance()->getPlaybook()->contentHash();
+
+        std::vector<std::pair<std::string, std::string>> failures =
+                PBCStorage::getInstance()->changePassword("wrong", "new", {"test.pbc"});
+        BOOST_CHECK_EQUAL(failures.size(), 1);
+        BOOST_CHECK_EQUAL(PBCStorage::getInstance()->openPlaybook("test", "test.pbc")->contentHash(), hash);
+
+        failures = PBCStorage::getInstance()->changePassword("test", "new", {"test.pbc", "other.pbc"});
+        BOOST_CHECK(failures.empty());
+        BOOST_CHECK_THROW(PBCStorage::getInstance()->openPlaybook("test", "test.pbc"), PBCDecryptionException);
+        BOOST_CHECK_EQUAL(PBCStorage::getInstance()->openPlaybook("new", "test.pbc")->contentHash(), hash);
+        BOOST_CHECK_EQUAL(PBCStorage::getInstance()->openPlaybook("new", "other.pbc")->contentHash(), hash);
+        BOOST_CHECK_EQUAL(PBCStorage::getInstance()->readMetadata("new", "other.pbc").plays, 200);
+
+        // the active playbook is saved with the new password
+        PBCController::getInstance()->getPlaybook()->addPlay(PBCPlaySP(new PBCPlay("after", "", formation->name())));
+        BOOST_CHECK(PBCStorage::getInstance()->openPlaybook("new", "test.pbc")->hasPlay("after"));
+    }
+
+    BOOST_AUTO_TEST_CASE(change_password_of_old_format_test) {
+        path test_pb_path = PBCTestConfig::test_base_dir / "resources" / "StorageTests" /
+                            "VersionTestPlaybooks" / "v0_18_0.pbc";
+        copy_file(test_pb_path, "old.pbc", copy_option::overwrite_if_exists);
+        const PBCHash hash = PBCStorage::getInstance()->openPlaybook("test", "old.pbc")->contentHash();
+        BOOST_CHECK(PBCStorage::getInstance()->changePassword("test", "new", {"old.pbc"}).empty());
+        BOOST_CHECK_EQUAL(PBCStorage::getInstance()->openPlaybook("new", "old.pbc")->contentHash(), hash);
+        BOOST_CHECK(PBCStorage::getInstance()->readMetadata("new", "old.pbc").fromHeader);
+    }
+
+    BOOST_AUTO_TEST_CASE(kdf_settings_test) {
+        BOOST_CHECK_EQUAL(PBCKdfSettings::legacy().toString(), "PBKDF2(SHA-256) 10000");
+        PBCKdfSettings argon2 = PBCKdfSettings::fromString("Argon2id 65536 3 1");
+        BOOST_CHECK_EQUAL(argon2.algorithm, PBCKdfSettings::ARGON2ID);
+        BOOST_CHECK(argon2.parameters == std::vector<size_t>({65536, 3, 1}));
+        BOOST_CHECK(PBCKdfSettings::fromString(argon2.toString()) == argon2);
+        BOOST_CHECK_THROW(PBCKdfSettings::fromString("Argon2id 65536"), PBCStorageException);
+        BOOST_CHECK_THROW(PBCKdfSettings::fromString("PBKDF2(SHA-256) 0"), PBCStorageException);
+        BOOST_CHECK_THROW(PBCKdfSettings::fromString("MD5 1000"), PBCStorageException);
+        BOOST_CHECK_NO_THROW(PBCKdfSettings::fromString("PBKDF2(SHA-256) 100000000"));
+        BOOST_CHECK_THROW(PBCKdfSettings::fromString("PBKDF2(SHA-256) 100000001"), PBCStorageException);
+        BOOST_CHECK_THROW(PBCKdfSettings::fromString("PBKDF2(SHA-256) -1"), PBCStorageException);
+        BOOST_CHECK_THROW(PBCKdfSettings::fromString("Argon2id 8388608 3 1"), PBCStorageException);
+        BOOST_CHECK_THROW(PBCKdfSettings::fromString("Argon2id 65536 100000 1"), PBCStorageException);
+        BOOST_CHECK_THROW(PBCKdfSettings::fromString("Argon2id 65536 3 1000"), PBCStorageException);
+    }
+
+    BOOST_AUTO_TEST_CASE(key_derivation_per_file_test) {
+        const PBCKdfSettings previous = PBCStorage::getInstance()->keyDerivation();
+        const PBCKdfSettings argon2{PBCKdfSettings::ARGON2ID, {1024, 1, 1}};
+        PBCController::getInstance()->getPlaybook()->resetToNewEmptyPlaybook("kdf", 5);
+        PBCStorage::getInstance()->setKeyDerivation(argon2);
+        PBCStorage::getInstance()->savePlaybook("test", "argon2.pbc");
+        const PBCHash hash = PBCController::getInstance()->getPlaybook()->contentHash();
+
+        // the key derivation is recorded in the file, not taken from the settings
+        PBCStorage::getInstance()->setKeyDerivation(PBCKdfSettings::legacy());
+        std::ifstream file("argon2.pbc", std::ios_base::binary);
+        std::string line;
+        for (int i = 0; i < 4; ++i) {
+            std::getline(file, line);
+        }
+        BOOST_CHECK_EQUAL(line, "kdf " + argon2.toString());
+        file.close();
+        BOOST_CHECK_EQUAL(PBCStorage::getInstance()->openPlaybook("test", "argon2.pbc")->contentHash(), hash);
+
+        // automatic saves keep the key derivation of the active file
+        PBCFormationSP formation = PBCController::getInstance()->getPlaybook()->formations().front();
+        PBCController::getInstance()->getPlaybook()->addPlay(PBCPlaySP(new PBCPlay("after", "", formation->name())));
+        BOOST_CHECK(PBCStorage::getInstance()->openPlaybook("test", "argon2.pbc")->hasPlay("after"));
+
+        // a new password gets the new key derivation
+        BOOST_CHECK(PBCStorage::getInstance()->changePassword("test", "new", {"argon2.pbc"}).empty());
+        file.open("argon2.pbc", std::ios_base::binary);
+        for (int i = 0; i < 4; ++i) {
+            std::getline(file, line);
+        }
+        BOOST_CHECK_EQUAL(line, "kdf " + PBCKdfSettings::legacy().toString());
+        BOOST_CHECK(PBCStorage::getInstance()->openPlaybook("new", "argon2.pbc")->hasPlay("after"));
+
+        PBCStorage::getInstance()->setKeyDerivation(previous);
+    }
+
+    BOOST_AUTO_TEST_CASE(calibrate_key_derivation_test) {
+        PBCKdfSettings kdf = PBCKeyDerivation::calibrate(PBCKdfSettings::PBKDF2, std::chrono::milliseconds(10));
+        BOOST_CHECK_EQUAL(kdf.algorithm, PBCKdfSettings::PBKDF2);
+        BOOST_REQUIRE_EQUAL(kdf.parameters.size(), 1);
+        BOOST_CHECK_GE(kdf.parameters[0], PBCKdfSettings::legacy().parameters[0]);
+        BOOST_CHECK_NO_THROW(PBCKdfSettings::fromString(kdf.toString()));
+        BOOST_CHECK(PBCKeyDerivation::benchmark(kdf, 1).count() > 0);
+    }
+
+    BOOST_AUTO_TEST_CASE(atomic_save_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("atomic", 5);
+        PBCFormationSP formation = playbook->formations().front();
+        for (int i = 0; i < 2000; ++i) {
+            playbook->addPlay(PBCPlaySP(new PBCPlay("play" + std::to_string(i), "", formation->name())), false, true);
+        }
+        PBCPerf::setEnabled(true);
+        PBCPerf::reset();
+        PBCStorage::getInstance()->savePlaybook("test", "atomic.pbc");
+        for (int i = 0; i < 5; ++i) {
+            playbook->addPlay(PBCPlaySP(new PBCPlay("autosaved" + std::to_string(i), "", formation->name())));
+        }
+        for (const PBCPerfSnapshot& metric : PBCPerf::snapshot()) {
+            if (metric.name == "storage.save" || metric.name == "storage.commit") {
+                BOOST_CHECK_EQUAL(metric.count, 6);
+                BOOST_TEST_MESSAGE(metric.name << ": " << metric.mean() << " us");
+            }
+        }
+        PBCPerf::setEnabled(false);
+        BOOST_CHECK_EQUAL(PBCStorage::getInstance()->readMetadata("test", "atomic.pbc").plays, 2005);
+
+        // no temporary files are left behind
+        for (const directory_entry& entry : directory_iterator(current_path())) {
+            std::string name = entry.path().filename().string();
+            BOOST_CHECK(name == "atomic.pbc" || name == "atomic.pbc.backups" || name.compare(0, 10, "atomic.pbc") != 0);
+        }
+
+        // a failed save is reported and does not count as saved
+        BOOST_CHECK_THROW(PBCStorage::getInstance()->writePlaybookToFile("test", "missing/other.pbc", playbook),
+                          PBCSaveException);
+        BOOST_CHECK_THROW(PBCStorage::getInstance()->savePlaybook("other", "missing/atomic.pbc"), PBCSaveException);
+        BOOST_CHECK(PBCStorage::getInstance()->hasUnsavedChanges());
+        BOOST_CHECK(exists("missing") == false);
+        // the failed "Save As" keeps the file and the key of the previous save
+        BOOST_CHECK_EQUAL(PBCStorage::getInstance()->currentPlaybookFileName(), "atomic.pbc");
+        playbook->addPlay(PBCPlaySP(new PBCPlay("after failure", "", formation->name())));
+        BOOST_CHECK(PBCStorage::getInstance()->openPlaybook("test", "atomic.pbc")->hasPlay("after failure"));
+        PBCStorage::getInstance()->savePlaybook("test", "atomic.pbc");
+        BOOST_CHECK(PBCStorage::getInstance()->hasUnsavedChanges() == false);
+    }
+
+    BOOST_AUTO_TEST_CASE(failed_autosave_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("autosave", 5);
+        PBCFormationSP formation = playbook->formations().front();
+        create_directory("autosave");
+        PBCStorage::getInstance()->savePlaybook("test", "autosave/autosave.pbc");
+        remove_all("autosave");
+
+        // the failure is passed to the listener instead of being thrown out of the change
+        std::vector<std::string> failures;
+        PBCStorage::getInstance()->setSaveFailureListener([&failures](const std::string& message) {
+            failures.push_back(message);
+        });
+        BOOST_CHECK_NO_THROW(playbook->addPlay(PBCPlaySP(new PBCPlay("play1", "", formation->name()))));
+        PBCStorage::getInstance()->setSaveFailureListener(std::function<void(const std::string&)>());
+        BOOST_CHECK_EQUAL(failures.size(), 1);
+        BOOST_CHECK(playbook->hasPlay("play1"));
+        BOOST_CHECK(PBCStorage::getInstance()->hasUnsavedChanges());
+        BOOST_CHECK(exists("autosave") == false);
+    }
+
+    BOOST_AUTO_TEST_CASE(backup_test) {
+        const PBCBackupPolicy previousPolicy = PBCStorage::getInstance()->backupPolicy();
+        PBCBackupPolicy policy;
+        policy.interval = std::chrono::seconds(0);  // a snapshot of every save
+        PBCStorage::getInstance()->setBackupPolicy(policy);
+        remove_all("backup.pbc.backups");
+
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("backup", 5);
+        PBCFormationSP formation = playbook->formations().front();
+        for (int i = 0; i < 500; ++i) {
+            playbook->addPlay(PBCPlaySP(new PBCPlay("play" + std::to_string(i), "", formation->name())), false, true);
+        }
+        PBCStorage::getInstance()->savePlaybook("test", "backup.pbc");
+        // appended at the end of the serialized playbook
+        playbook->addPlay(PBCPlaySP(new PBCPlay("zz added", "", formation->name())));
+
+        std::vector<PBCBackupStore::Snapshot> snapshots = PBCStorage::getInstance()->backups("backup.pbc");
+        BOOST_REQUIRE_EQUAL(snapshots.size(), 2);
+        const PBCBackupStore::Snapshot& oldest = snapshots.back();
+
+        // the snapshots share most of their chunks
+        PBCBackupStore store("backup.pbc");
+        PBCBackupStore::Statistics statistics = store.statistics();
+        BOOST_CHECK_GT(oldest.chunks.size(), 4);
+        BOOST_CHECK_LT(statistics.chunks, oldest.chunks.size() + 4);
+        BOOST_CHECK_LT(statistics.storedBytes, statistics.snapshotBytes * 2 / 3);
+
+        PBCPlaybookSP backup = PBCStorage::getInstance()->openBackup("test", "backup.pbc", oldest.id);
+        BOOST_CHECK_EQUAL(backup->plays().size(), 500);
+        BOOST_CHECK(backup->hasPlay("zz added") == false);
+        BOOST_CHECK_THROW(PBCStorage::getInstance()->openBackup("wrong", "backup.pbc", oldest.id),
+                          PBCDecryptionException);
+
+        // restoring backs up the current state first
+        PBCStorage::getInstance()->restoreActivePlaybook("test", oldest.id);
+        BOOST_CHECK(playbook->hasPlay("zz added") == false);
+        BOOST_CHECK(PBCStorage::getInstance()->openPlaybook("test", "backup.pbc")->hasPlay("zz added") == false);
+        snapshots = PBCStorage::getInstance()->backups("backup.pbc");
+        BOOST_CHECK_GE(snapshots.size(), 3);
+        bool addedIsBackedUp = false;
+        for (const PBCBackupStore::Snapshot& snapshot : snapshots) {
+            addedIsBackedUp |= PBCStorage::getInstance()->openBackup("test", "backup.pbc", snapshot.id)
+                                       ->hasPlay("zz added");
+        }
+        BOOST_CHECK(addedIsBackedUp);
+
+        // two days later, only the newest snapshot of the day is kept
+        const int64_t later = snapshots.front().time + 2 * 24 * 3600;
+        BOOST_CHECK_EQUAL(store.prune(policy, later).size(), snapshots.size() - 1);
+        snapshots = store.snapshots();
+        BOOST_REQUIRE_EQUAL(snapshots.size(), 1);
+        BOOST_CHECK_LE(store.statistics().chunks, snapshots.front().chunks.size());
+        BOOST_CHECK(PBCStorage::getInstance()->openBackup("test", "backup.pbc", snapshots.front().id)->plays().size() > 0);
+
+        PBCStorage::getInstance()->setBackupPolicy(previousPolicy);
+    }
+
+    BOOST_AUTO_TEST_CASE(failed_restore_test) {
+        const PBCBackupPolicy previousPolicy = PBCStorage::getInstance()->backupPolicy();
+        PBCBackupPolicy policy;
+        policy.interval = std::chrono::seconds(0);
+        PBCStorage::getInstance()->setBackupPolicy(policy);
+        remove_all("restore.pbc.backups");
+
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("restore", 5);
+        PBCFormationSP formation = playbook->formations().front();
+        playbook->addPlay(PBCPlaySP(new PBCPlay("kept", "", formation->name())), false, true);
+        PBCStorage::getInstance()->savePlaybook("test", "restore.pbc");
+        std::vector<PBCBackupStore::Snapshot> snapshots = PBCStorage::getInstance()->backups("restore.pbc");
+        BOOST_REQUIRE_EQUAL(snapshots.size(), 1);
+        const PBCBackupStore::Snapshot snapshot = snapshots.front();
+        playbook->addPlay(PBCPlaySP(new PBCPlay("unsaved", "", formation->name())), false, true);
+        const PBCHash hash = playbook->contentHash();
+        auto readFile = [](const std::string& fileName) {
+            std::ifstream file(fileName, std::ios_base::binary);
+            return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        };
+        auto writeFile = [](const std::string& fileName, const std::string& content) {
+            std::ofstream file(fileName, std::ios_base::binary | std::ios_base::trunc);
+            file.write(content.data(), content.size());
+        };
+        const std::string savedFile = readFile("restore.pbc");
+        PBCBackupStore store("restore.pbc");
+
+        // a snapshot of a newer version is refused before anything is changed
+        const std::string snapshotFile = store.dirName() + "/snapshots/" + snapshot.id + ".snapshot";
+        const std::string snapshotContent = readFile(snapshotFile);
+        const std::string versionLine = "version " + snapshot.version + "\n";
+        BOOST_REQUIRE(snapshotContent.find(versionLine) != std::string::npos);
+        std::string newerContent = snapshotContent;
+        newerContent.replace(newerContent.find(versionLine), versionLine.size(), "version 999.0.0\n");
+        writeFile(snapshotFile, newerContent);
+        BOOST_CHECK_THROW(PBCStorage::getInstance()->restoreActivePlaybook("test", snapshot.id),
+                          PBCDeprecatedVersionException);
+        BOOST_CHECK_EQUAL(playbook->contentHash(), hash);
+        BOOST_CHECK(playbook->hasPlay("unsaved"));
+        BOOST_CHECK(readFile("restore.pbc") == savedFile);
+        BOOST_CHECK_EQUAL(store.snapshots().size(), 1);
+
+        // so is a snapshot whose chunks are corrupted
+        writeFile(snapshotFile, snapshotContent);
+        writeFile(store.dirName() + "/chunks/" + snapshot.chunks.front().id, "corrupt");
+        BOOST_CHECK_THROW(PBCStorage::getInstance()->restoreActivePlaybook("test", snapshot.id),
+                          PBCStorageException);
+        BOOST_CHECK_EQUAL(playbook->contentHash(), hash);
+        BOOST_CHECK(playbook->hasPlay("unsaved"));
+        BOOST_CHECK(readFile("restore.pbc") == savedFile);
+        BOOST_CHECK_EQUAL(store.snapshots().size(), 1);
+
+        remove_all("restore.pbc.backups");
+        PBCStorage::getInstance()->setBackupPolicy(previousPolicy);
+    }
+
+    BOOST_AUTO_TEST_CASE(backup_subkeys_test) {
+        remove_all("subkeys.pbc.backups");
+        PBCBackupStore store("subkeys.pbc");
+        const std::string data(100000, 'x');
+        const Botan::SecureVector<Botan::byte> salt(16, 1);
+        const Botan::OctetString key(Botan::SecureVector<Botan::byte>(32, 2));
+        PBCBackupStore::Snapshot snapshot = store.write(data, "metadata", key, salt, PBCKdfSettings::legacy(), 1);
+        std::string metadata;
+        BOOST_CHECK(store.read(snapshot, key, &metadata) == data);
+        BOOST_CHECK_EQUAL(metadata, "metadata");
+
+        // the chunks are not named by a hash under the encryption key
+        std::unique_ptr<Botan::MessageAuthenticationCode> mac = Botan::MessageAuthenticationCode::create("HMAC(SHA-256)");
+        mac->set_key(key);
+        mac->update(reinterpret_cast<const Botan::byte*>(data.data()), snapshot.chunks.front().size);
+        Botan::SecureVector<Botan::byte> hash = mac->final();
+        BOOST_CHECK(snapshot.chunks.front().id != Botan::hex_encode(hash.data(), 16, false));
+
+        // a new key does not share chunks with the snapshots of the old key
+        const Botan::OctetString otherKey(Botan::SecureVector<Botan::byte>(32, 3));
+        PBCBackupStore::Snapshot other = store.write(data, "metadata", otherKey, salt, PBCKdfSettings::legacy(), 2);
+        BOOST_CHECK(other.chunks.front().id != snapshot.chunks.front().id);
+        BOOST_CHECK_THROW(store.read(other, key), PBCDecryptionException);
+        remove_all("subkeys.pbc.backups");
+    }
+
+    BOOST_AUTO_TEST_CASE(chunk_boundaries_test) {
+        std::string data;
+        std::srand(42);
+        for (int i = 0; i < 200000; ++i) {
+            data += static_cast<char>('a' + std::rand() % 26);
+        }
+        std::vector<std::pair<size_t, size_t>> chunks = PBCBackupStore::chunkBoundaries(data);
+        std::set<std::string> contents;
+        size_t offset = 0;
+        for (const std::pair<size_t, size_t>& chunk : chunks) {
+            BOOST_CHECK_EQUAL(chunk.first, offset);
+            offset += chunk.second;
+            contents.insert(data.substr(chunk.first, chunk.second));
+        }
+        BOOST_CHECK_EQUAL(offset, data.size());
+
+        // an insertion only changes the chunk it falls into
+        data.insert(100000, "inserted");
+        std::vector<std::pair<size_t, size_t>> changedChunks = PBCBackupStore::chunkBoundaries(data);
+        unsigned int newChunks = 0;
+        for (const std::pair<size_t, size_t>& chunk : changedChunks) {
+            newChunks += contents.count(data.substr(chunk.first, chunk.second)) == 0;
+        }
+        BOOST_CHECK_LE(newChunks, 2);
+    }
+BOOST_AUTO_TEST_SUITE_END()
+
+
+
+BOOST_AUTO_TEST_SUITE(UndoTests)
+    BOOST_AUTO_TEST_CASE(undo_redo_add_play_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("undo", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        PBCFormationSP formation = playbook->formations().front();
+        PBCPlaySP play(new PBCPlay("undoplay", "undocode", formation->name()));
+        playbook->addPlay(play);
+        BOOST_CHECK_EQUAL(playbook->getPlayNames().size(), 1);
+
+        playbook->history().undo();
+        BOOST_CHECK_EQUAL(playbook->getPlayNames().size(), 0);
+        BOOST_CHECK(playbook->history().canRedo());
+
+        playbook->history().redo();
+        BOOST_CHECK(playbook->getPlay("undoplay") == play);
+    }
+
+    BOOST_AUTO_TEST_CASE(undo_delete_route_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("undo", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        const std::string routeName = playbook->getRouteNames().front();
+        PBCRouteSP route = playbook->getRoute(routeName);
+        playbook->deleteRoute(routeName);
+        BOOST_CHECK_THROW(playbook->getRoute(routeName), PBCUnexpectedError);
+
+        playbook->history().undo();
+        BOOST_CHECK(playbook->getRoute(routeName) == route);  // the very same route object is restored
+    }
+
+    BOOST_AUTO_TEST_CASE(undo_overwrite_route_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("undo", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        const std::string routeName = playbook->getRouteNames().front();
+        PBCRouteSP route = playbook->getRoute(routeName);
+        const std::string codeName = route->codeName();
+        const size_t pathCount = route->paths().size();
+
+        std::vector<PBCPathSP> newPaths;
+        newPaths.push_back(PBCPathSP(new PBCPath(PBCDPoint(0, 1))));
+        playbook->addRoute(PBCRouteSP(new PBCRoute(routeName, "changed", newPaths)), true);
+        BOOST_CHECK_EQUAL(route->codeName(), "changed");
+
+        playbook->history().undo();
+        BOOST_CHECK(playbook->getRoute(routeName) == route);
+        BOOST_CHECK_EQUAL(route->codeName(), codeName);
+        BOOST_CHECK_EQUAL(route->paths().size(), pathCount);
+    }
+
+    BOOST_AUTO_TEST_CASE(merge_player_edits_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("undo", 5);
+        PBCFormationSP formation = playbook->formations().front();
+        PBCPlaySP play(new PBCPlay("undoplay", "undocode", formation->name()));
+        PBCPlayerSP player = play->formation()->front();
+        const std::string originalName = player->name();
+
+        for (const std::string& name : {"A", "AB", "ABC"}) {
+            PBCPlayer before = *player;
+            player->setName(name);
+            playbook->history().push(PBCUndoCommandSP(
+                    new PBCPlayerEditCommand("Change Player Name", play, player, before)));
+        }
+        BOOST_CHECK_EQUAL(playbook->history().count(), 1);
+
+        playbook->history().undo();
+        BOOST_CHECK_EQUAL(player->name(), originalName);
+        playbook->history().redo();
+        BOOST_CHECK_EQUAL(player->name(), "ABC");
+    }
+
+    BOOST_AUTO_TEST_CASE(memory_budget_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("undo", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        PBCFormationSP formation = playbook->formations().front();
+        for (unsigned int i = 0; i < 10; ++i) {
+            PBCPlaySP play(new PBCPlay("play" + std::to_string(i), "", formation->name()));
+            playbook->addPlay(play, false, true);
+        }
+        BOOST_CHECK_EQUAL(playbook->history().count(), 10);
+
+        size_t stepSize = playbook->history().memoryUsage() / 10;
+        playbook->history().setMemoryBudget(3 * stepSize);
+        BOOST_CHECK_LE(playbook->history().memoryUsage(), 3 * stepSize);
+        BOOST_CHECK_GE(playbook->history().count(), 1);
+        BOOST_CHECK_LT(playbook->history().count(), 10);
+        playbook->history().setMemoryBudget(PBCUndoStack::DEFAULT_MEMORY_BUDGET);
+    }
+BOOST_AUTO_TEST_SUITE_END()
+
+
+
+BOOST_FIXTURE_TEST_SUITE(MainDialogTests, PBCGuiFixture)
+    BOOST_AUTO_TEST_CASE(undo_actions_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("undo", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        MainDialog dialog;
+        QAction* undo = dialog.findChild<QAction*>("actionUndo");
+        QAction* redo = dialog.findChild<QAction*>("actionRedo");
+        BOOST_REQUIRE(undo != NULL);
+        BOOST_REQUIRE(redo != NULL);
+        BOOST_CHECK(undo->isEnabled() == false);
+        BOOST_CHECK(redo->isEnabled() == false);
+
+        // the actions follow the history without opening the Edit menu
+        PBCFormationSP formation = playbook->formations().front();
+        playbook->addPlay(PBCPlaySP(new PBCPlay("undoplay", "undocode", formation->name())));
+        BOOST_CHECK(undo->isEnabled());
+        BOOST_CHECK(undo->text().startsWith("Undo "));
+        BOOST_CHECK(undo->shortcut() == QKeySequence(QKeySequence::Undo));
+
+        undo->trigger();
+        BOOST_CHECK_EQUAL(playbook->getPlayNames().size(), 0);
+        BOOST_CHECK(undo->isEnabled() == false);
+        BOOST_CHECK(redo->isEnabled());
+
+        redo->trigger();
+        BOOST_CHECK_EQUAL(playbook->getPlayNames().size(), 1);
+        BOOST_CHECK(undo->isEnabled());
+        BOOST_CHECK(redo->isEnabled() == false);
+    }
+BOOST_AUTO_TEST_SUITE_END()
+
+
+
+BOOST_AUTO_TEST_SUITE(ContentHashTests)
+    BOOST_AUTO_TEST_CASE(copy_hash_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("hash", 5);
+        PBCFormationSP formation = playbook->formations().front();
+        PBCPlaySP play(new PBCPlay("hashplay", "hashcode", formation->name()));
+        PBCPlay copy(*play);
+        BOOST_CHECK_EQUAL(copy.contentHash(), play->contentHash());
+
+        PBCPlaySP other(new PBCPlay("otherplay", "hashcode", formation->name()));
+        BOOST_CHECK_NE(other->contentHash(), play->contentHash());
+    }
+
+    BOOST_AUTO_TEST_CASE(dirty_player_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("hash", 5);
+        PBCFormationSP formation = playbook->formations().front();
+        PBCPlaySP play(new PBCPlay("hashplay", "hashcode", formation->name()));
+        const PBCHash hash = play->contentHash();
+        BOOST_CHECK_EQUAL(play->contentHash(), hash);
+
+        PBCPlayerSP player = play->formation()->back();
+        const std::string name = player->name();
+        player->setName("changed");
+        BOOST_CHECK_NE(play->contentHash(), hash);
+        player->setName(name);
+        BOOST_CHECK_EQUAL(play->contentHash(), hash);
+    }
+
+    BOOST_AUTO_TEST_CASE(shared_route_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("hash", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        PBCFormationSP formation = playbook->formations().front();
+        PBCPlaySP play(new PBCPlay("hashplay", "hashcode", formation->name()));
+        const std::string routeName = playbook->getRouteNames().front();
+        PBCRouteSP route = playbook->getRoute(routeName);
+        play->formation()->front()->setRoute(route);
+        const PBCHash playHash = play->contentHash();
+        const PBCHash playbookHash = playbook->contentHash();
+
+        std::vector<PBCPathSP> newPaths;
+        newPaths.push_back(PBCPathSP(new PBCPath(PBCDPoint(0, 1))));
+        playbook->addRoute(PBCRouteSP(new PBCRoute(routeName, "changed", newPaths)), true);
+        BOOST_CHECK_NE(play->contentHash(), playHash);
+        BOOST_CHECK_NE(playbook->contentHash(), playbookHash);
+
+        playbook->history().undo();
+        BOOST_CHECK_EQUAL(play->contentHash(), playHash);
+        BOOST_CHECK_EQUAL(playbook->contentHash(), playbookHash);
+    }
+
+    BOOST_AUTO_TEST_CASE(replaced_route_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("hash", 5);
+        PBCFormationSP formation = playbook->formations().front();
+        PBCPlaySP play(new PBCPlay("hashplay", "hashcode", formation->name()));
+        PBCPlayerSP player = play->formation()->front();
+        std::vector<PBCPathSP> paths;
+        paths.push_back(PBCPathSP(new PBCPath(PBCDPoint(0, 1))));
+        PBCRouteSP oldRoute(new PBCRoute("old", "", paths));
+        PBCRouteSP newRoute(new PBCRoute("new", "", paths));
+        player->setRoute(oldRoute);
+        play->contentHash();
+
+        // the play does not depend on a route that its player has dropped
+        player->setRoute(newRoute);
+        const PBCHash hash = play->contentHash();
+        oldRoute->setName("changed");
+        BOOST_CHECK_EQUAL(play->contentHash(), hash);
+        newRoute->setName("changed");
+        BOOST_CHECK_NE(play->contentHash(), hash);
+
+        // a copy links itself to the routes of its players
+        PBCPlay copy(*play);
+        const PBCHash copyHash = copy.contentHash();
+        BOOST_CHECK_EQUAL(copyHash, play->contentHash());
+        for (const PBCPlayerSP& copiedPlayer : *copy.formation()) {
+            if (copiedPlayer->route() != NULL) {
+                copiedPlayer->route()->setName("changed again");
+            }
+        }
+        BOOST_CHECK_NE(copy.contentHash(), copyHash);
+    }
+
+    BOOST_AUTO_TEST_CASE(undo_add_play_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("hash", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        const PBCHash hash = playbook->contentHash();
+        PBCFormationSP formation = playbook->formations().front();
+        playbook->addPlay(PBCPlaySP(new PBCPlay("hashplay", "hashcode", formation->name())));
+        BOOST_CHECK_NE(playbook->contentHash(), hash);
+
+        playbook->history().undo();
+        BOOST_CHECK_EQUAL(playbook->contentHash(), hash);
+    }
+BOOST_AUTO_TEST_SUITE_END()
+
+
+
+BOOST_AUTO_TEST_SUITE(UsageIndexTests)
+    BOOST_AUTO_TEST_CASE(route_usage_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("usage", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        const std::string routeName = playbook->getRouteNames().front();
+        PBCRouteSP route = playbook->getRoute(routeName);
+        PBCFormationSP formation = playbook->formations().front();
+        PBCPlaySP play(new PBCPlay("usageplay", "usagecode", formation->name()));
+        play->formation()->front()->setRoute(route);
+        play->formation()->back()->addOptionRoute(route);
+        BOOST_CHECK(playbook->routeUsages(routeName).empty());
+
+        playbook->addPlay(play);
+        BOOST_CHECK_EQUAL(playbook->routeUsages(routeName).size(), 2);
+        BOOST_CHECK_EQUAL(playbook->playsUsingRoute(routeName).size(), 1);
+        BOOST_CHECK(playbook->playsUsingFormation(formation->name()).count(play) == 1);
+
+        playbook->deletePlay("usageplay");
+        BOOST_CHECK(playbook->routeUsages(routeName).empty());
+        BOOST_CHECK(playbook->playsUsingFormation(formation->name()).empty());
+
+        playbook->history().undo();
+        BOOST_CHECK_EQUAL(playbook->routeUsages(routeName).size(), 2);
+    }
+
+    BOOST_AUTO_TEST_CASE(overwrite_play_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("usage", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        const std::string routeName = playbook->getRouteNames().front();
+        PBCFormationSP formation = playbook->formations().front();
+        PBCPlaySP play(new PBCPlay("usageplay", "usagecode", formation->name()));
+        play->formation()->front()->setRoute(playbook->getRoute(routeName));
+        playbook->addPlay(play);
+
+        PBCPlaySP copy(new PBCPlay(*play));
+        copy->formation()->front()->resetRoute();
+        playbook->addPlay(copy, true);
+        BOOST_CHECK(playbook->routeUsages(routeName).empty());
+
+        playbook->history().undo();
+        BOOST_CHECK_EQUAL(playbook->routeUsages(routeName).size(), 1);
+        BOOST_CHECK(playbook->routeUsages(routeName).front().play == play);
+    }
+
+    BOOST_AUTO_TEST_CASE(player_edit_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("usage", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        const std::string routeName = playbook->getRouteNames().front();
+        PBCFormationSP formation = playbook->formations().front();
+        PBCPlaySP play(new PBCPlay("usageplay", "usagecode", formation->name()));
+        playbook->addPlay(play);
+
+        PBCPlayerSP player = play->formation()->front();
+        PBCPlayer before = *player;
+        player->setAlternativeRoute(1, playbook->getRoute(routeName));
+        playbook->history().push(PBCUndoCommandSP(
+                new PBCPlayerEditCommand("Set Alternative Route", play, player, before)));
+        playbook->updateUsages(play);
+        BOOST_CHECK_EQUAL(playbook->routeUsages(routeName).size(), 1);
+        BOOST_CHECK(playbook->routeUsages(routeName).front().kind == PBCRouteUsage::ALTERNATIVE_ROUTE_1);
+
+        playbook->history().undo();
+        BOOST_CHECK(playbook->routeUsages(routeName).empty());
+    }
+BOOST_AUTO_TEST_SUITE_END()
+
+
+
+BOOST_AUTO_TEST_SUITE(MergeTests)
+    PBCPlaybookSP newPlaybook() {
+        PBCPlaybookSP playbook(new PBCPlaybook());
+        playbook->resetToNewEmptyPlaybook("merge", 5);
+        return playbook;
+    }
+
+    BOOST_AUTO_TEST_CASE(diff_test) {
+        PBCController::getInstance()->getPlaybook()->resetToNewEmptyPlaybook("merge", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        PBCPlaybookSP from = newPlaybook();
+        PBCPlaybookSP to = newPlaybook();
+        BOOST_CHECK(PBCPlaybookMerge::diff(*from, *to).empty());
+
+        const std::string formationName = from->formations().front()->name();
+        const std::string routeName = from->getRouteNames().front();
+        to->addPlay(PBCPlaySP(new PBCPlay("play1", "code1", formationName)), false, true);
+        to->deleteRoute(routeName);
+
+        std::vector<PBCDiffEntry> diff = PBCPlaybookMerge::diff(*from, *to);
+        BOOST_REQUIRE_EQUAL(diff.size(), 2);
+        BOOST_CHECK(diff[0].type == PBCDiffEntry::ROUTE);
+        BOOST_CHECK_EQUAL(diff[0].name, routeName);
+        BOOST_CHECK(diff[0].change == PBCDiffEntry::REMOVED);
+        BOOST_CHECK(diff[1].type == PBCDiffEntry::PLAY);
+        BOOST_CHECK(diff[1].change == PBCDiffEntry::ADDED);
+    }
+
+    BOOST_AUTO_TEST_CASE(three_way_merge_test) {
+        PBCController::getInstance()->getPlaybook()->resetToNewEmptyPlaybook("merge", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        PBCPlaybookSP base = newPlaybook();
+        PBCPlaybookSP ours = newPlaybook();
+        PBCPlaybookSP theirs = newPlaybook();
+        const std::string formationName = base->formations().front()->name();
+        const std::string routeName = base->getRouteNames().front();
+
+        PBCPlaySP ourPlay(new PBCPlay("ourplay", "code1", formationName));
+        ourPlay->formation()->front()->setRoute(ours->getRoute(routeName));
+        ours->addPlay(ourPlay, false, true);
+
+        std::vector<PBCPathSP> newPaths;
+        newPaths.push_back(PBCPathSP(new PBCPath(PBCDPoint(0, 1))));
+        theirs->addRoute(PBCRouteSP(new PBCRoute(routeName, "changed", newPaths)), true);
+        theirs->addPlay(PBCPlaySP(new PBCPlay("theirplay", "code2", formationName)), false, true);
+
+        PBCMergeResult result = PBCPlaybookMerge::merge(*base, *ours, *theirs);
+        BOOST_CHECK(result.conflicts.empty());
+        BOOST_CHECK_EQUAL(result.playbook->getPlayNames().size(), 2);
+        PBCRouteSP mergedRoute = result.playbook->getRoute(routeName);
+        BOOST_CHECK_EQUAL(mergedRoute->codeName(), "changed");
+        BOOST_CHECK(mergedRoute != theirs->getRoute(routeName));
+        BOOST_CHECK(result.playbook->getPlay("ourplay")->formation()->front()->route() == mergedRoute);
+        BOOST_CHECK(result.playbook->getPlay("ourplay") != ourPlay);
+        BOOST_CHECK_EQUAL(result.playbook->playsUsingRoute(routeName).size(), 1);
+    }
+
+    BOOST_AUTO_TEST_CASE(merged_motion_test) {
+        PBCController::getInstance()->getPlaybook()->resetToNewEmptyPlaybook("merge", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        PBCPlaybookSP base = newPlaybook();
+        PBCPlaybookSP ours = newPlaybook();
+        PBCPlaybookSP theirs = newPlaybook();
+        PBCPlaySP ourPlay(new PBCPlay("ourplay", "code1", base->formations().front()->name()));
+        PBCMotionSP motion(new PBCMotion());
+        motion->addPath(PBCPathSP(new PBCPath(PBCDPoint(1, 0))));
+        ourPlay->formation()->front()->setMotion(motion);
+        ours->addPlay(ourPlay, false, true);
+        const PBCHash ourHash = ourPlay->contentHash();
+
+        PBCMergeResult result = PBCPlaybookMerge::merge(*base, *ours, *theirs);
+        PBCMotionSP mergedMotion = result.playbook->getPlay("ourplay")->formation()->front()->motion();
+        BOOST_REQUIRE(mergedMotion != NULL);
+        BOOST_CHECK(mergedMotion != motion);
+        BOOST_CHECK_EQUAL(mergedMotion->contentHash(), motion->contentHash());
+
+        // editing the merged motion leaves the input playbook alone
+        mergedMotion->addPath(PBCPathSP(new PBCPath(PBCDPoint(2, 0))));
+        BOOST_CHECK_EQUAL(motion->paths().size(), 1);
+        BOOST_CHECK_EQUAL(ourPlay->contentHash(), ourHash);
+    }
+
+    BOOST_AUTO_TEST_CASE(conflict_test) {
+        PBCController::getInstance()->getPlaybook()->resetToNewEmptyPlaybook("merge", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        PBCPlaybookSP base = newPlaybook();
+        PBCPlaybookSP ours = newPlaybook();
+        PBCPlaybookSP theirs = newPlaybook();
+        const std::string formationName = base->formations().front()->name();
+        for (const PBCPlaybookSP& playbook : {base, ours, theirs}) {
+            playbook->addPlay(PBCPlaySP(new PBCPlay("play", "code", formationName)), false, true);
+            playbook->addCategory(PBCCategorySP(new PBCCategory("category")), false, true);
+        }
+        ours->getPlay("play")->setComment("ours");
+        theirs->getPlay("play")->setComment("theirs");
+        theirs->getCategory("category")->addPlay(theirs->getPlay("play"));
+        theirs->getPlay("play")->addCategory(theirs->getCategory("category"));
+
+        PBCMergeResult result = PBCPlaybookMerge::merge(*base, *ours, *theirs);
+        BOOST_REQUIRE_EQUAL(result.conflicts.size(), 1);
+        BOOST_CHECK(result.conflicts.front().type == PBCDiffEntry::PLAY);
+        BOOST_CHECK_EQUAL(result.conflicts.front().name, "play");
+        BOOST_CHECK(result.conflicts.front().ourChange == PBCDiffEntry::MODIFIED);
+        BOOST_CHECK(result.conflicts.front().theirChange == PBCDiffEntry::MODIFIED);
+        BOOST_CHECK_EQUAL(result.playbook->getPlay("play")->comment(), "ours");
+        // the category has only been changed by them, so the play is linked to it
+        BOOST_CHECK_EQUAL(result.playbook->playsInCategory("category").size(), 1);
+    }
+BOOST_AUTO_TEST_SUITE_END()
+
+
+
+BOOST_AUTO_TEST_SUITE(CompactionTests)
+    bool containsName(const std::vector<std::string>& names, const std::string& name) {
+        return std::find(names.begin(), names.end(), name) != names.end();
+    }
+
+    BOOST_AUTO_TEST_CASE(compaction_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("compact", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        const std::string formationName = playbook->formations().front()->name();
+        std::vector<PBCPathSP> paths{PBCPathSP(new PBCPath(0, 5))};
+        PBCRouteSP usedRoute(new PBCRoute("used", "", paths));
+        playbook->addRoute(usedRoute);
+        playbook->addRoute(PBCRouteSP(new PBCRoute("unused", "", paths)));
+        PBCFormationSP unusedFormation(new PBCFormation(*playbook->getFormation(formationName)));
+        unusedFormation->setName("unused formation");
+        playbook->addFormation(unusedFormation);
+
+        PBCPlaySP play(new PBCPlay("play", "code", formationName));
+        play->formation()->front()->setRoute(usedRoute);
+        play->formation()->back()->setMotion(PBCMotionSP(new PBCMotion()));
+        playbook->addPlay(play);
+        PBCCategorySP category(new PBCCategory("category"));
+        playbook->addCategory(category);
+        play->addCategory(category);
+        category->addPlay(play);
+        // older versions left deleted plays in their categories and deleted categories in the plays
+        PBCPlaySP deletedPlay(new PBCPlay("deleted", "code", formationName));
+        deletedPlay->addCategory(category);
+        category->addPlay(deletedPlay);
+        play->addCategory(PBCCategorySP(new PBCCategory("deleted category")));
+
+        const PBCHash hash = playbook->contentHash();
+        PBCCompactionReport dryRun = PBCPlaybookCompaction::compact(*playbook, false);
+        BOOST_CHECK(dryRun.applied == false);
+        BOOST_CHECK(playbook->contentHash() == hash);
+        BOOST_CHECK_EQUAL(dryRun.routes.size(), 1);
+        BOOST_CHECK(containsName(dryRun.routes, "unused"));
+        BOOST_CHECK_EQUAL(dryRun.formations.size(), 1);
+        BOOST_CHECK(containsName(dryRun.formations, "unused formation"));
+        BOOST_CHECK_EQUAL(dryRun.emptyMotions, 1);
+        BOOST_CHECK_EQUAL(dryRun.categoryLinks.size(), 2);
+        BOOST_CHECK_EQUAL(dryRun.staleCategoryPlays, 1);
+        BOOST_CHECK_LT(dryRun.bytesAfter, dryRun.bytesBefore);
+
+        PBCCompactionReport report = PBCPlaybookCompaction::compact(*playbook, true);
+        BOOST_CHECK(report.applied);
+        BOOST_CHECK_EQUAL(report.routes.size(), dryRun.routes.size());
+        BOOST_CHECK_EQUAL(report.formations.size(), dryRun.formations.size());
+        BOOST_CHECK_EQUAL(report.categoryLinks.size(), dryRun.categoryLinks.size());
+        BOOST_CHECK_EQUAL(report.bytesAfter, dryRun.bytesAfter);
+        BOOST_CHECK(containsName(playbook->getRouteNames(), "unused") == false);
+        BOOST_CHECK(containsName(playbook->getRouteNames(), "used"));
+        BOOST_CHECK(playbook->hasFormation("unused formation") == false);
+        BOOST_CHECK(playbook->playsInCategory("category") == std::set<PBCPlaySP>{play});
+        BOOST_CHECK(play->categories() == std::set<PBCCategorySP>{category});
+        BOOST_CHECK(play->formation()->back()->motion() == NULL);
+        BOOST_CHECK(PBCPlaybookCompaction::compact(*playbook, false).empty());
+
+        // the compaction is a single undo step
+        playbook->history().undo();
+        BOOST_CHECK(containsName(playbook->getRouteNames(), "unused"));
+        BOOST_CHECK(playbook->hasFormation("unused formation"));
+        BOOST_CHECK_EQUAL(playbook->playsInCategory("category").size(), 2);
+        BOOST_CHECK(play->formation()->back()->motion() != NULL);
+    }
+
+    BOOST_AUTO_TEST_CASE(delete_play_unlinks_categories_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("compact", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        PBCPlaySP play(new PBCPlay("play", "code", playbook->formations().front()->name()));
+        playbook->addPlay(play);
+        PBCCategorySP category(new PBCCategory("category"));
+        playbook->addCategory(category);
+        play->addCategory(category);
+        category->addPlay(play);
+
+        playbook->deletePlay("play");
+        BOOST_CHECK(playbook->playsInCategory("category").empty());
+        BOOST_CHECK(PBCPlaybookCompaction::compact(*playbook, false).empty());
+        playbook->history().undo();
+        BOOST_CHECK(playbook->playsInCategory("category").count(play) == 1);
+        BOOST_CHECK(play->categories().count(category) == 1);
+    }
+
+    BOOST_AUTO_TEST_CASE(compaction_defaults_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("compact", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        BOOST_CHECK(PBCPlaybookCompaction::compact(*playbook, false).empty());
+
+        PBCCompactionReport report = PBCPlaybookCompaction::compact(*playbook, false, false);
+        BOOST_CHECK_EQUAL(report.routes.size(), playbook->getRouteNames().size());
+        BOOST_CHECK_EQUAL(report.formations.size(), playbook->getFormationNames().size());
+        BOOST_CHECK(PBCPlaybook::isDefaultRoute(report.routes.front()));
+        BOOST_CHECK(PBCPlaybook::isDefaultFormation(report.formations.front()));
+    }
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(ExtractTests)
+    BOOST_AUTO_TEST_CASE(extract_test) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("extract", 5);
+        PBCStorage::getInstance()->savePlaybook("test", "test.pbc");
+        const std::string formationName = playbook->formations().front()->name();
+        std::vector<PBCPathSP> paths{PBCPathSP(new PBCPath(0, 5))};
+        PBCRouteSP shared(new PBCRoute("shared", "", paths));
+        PBCRouteSP option(new PBCRoute("option", "", paths));
+        playbook->addRoute(shared);
+        playbook->addRoute(option);
+        PBCCategorySP offense(new PBCCategory("offense"));
+        PBCCategorySP trick(new PBCCategory("trick"));
+        playbook->addCategory(offense);
+        playbook->addCategory(trick);
+
+        PBCPlaySP play1(new PBCPlay("play1", "Code-A", formationName));
+        PBCPlaySP play2(new PBCPlay("play2", "code-b", formationName));
+        PBCPlaySP play3(new PBCPlay("play3", "code-c", formationName, "Flea Flicker"));
+        play1->formation()->front()->setRoute(shared);
+        play2->formation()->front()->setRoute(shared);
+        play3->formation()->front()->addOptionRoute(option);
+        for (const PBCPlaySP& play : {play1, play2, play3}) {
+            playbook->addPlay(play);
+        }
+        for (const PBCPlaySP& play : {play1, play2}) {
+            play->addCategory(offense);
+            offense->addPlay(play);
+        }
+        play2->addCategory(trick);
+        trick->addPlay(play2);
+        const PBCHash hash = playbook->contentHash();
+
+        PBCPlaySelection selection;
+        selection.plays.insert("play1");
+        PBCPlaybookSP part = playbook->extract(selection, "part");
+        BOOST_CHECK(part->getPlayNames() == std::vector<std::string>({"play1"}));
+        BOOST_CHECK(part->getRouteNames() == std::vector<std::string>({"shared"}));
+        BOOST_CHECK(part->getFormationNames() == std::vector<std::string>({formationName}));
+        BOOST_CHECK(part->getCategoryNames() == std::vector<std::string>({"offense"}));
+        BOOST_CHECK(part->playsInCategory("offense") == std::set<PBCPlaySP>{part->getPlay("play1")});
+        BOOST_CHECK(part->getPlay("play1") != play1);
+        BOOST_CHECK(part->getPlay("play1")->formation()->front()->route() == shared);
+
+        selection.plays.clear();
+        selection.categories.insert("trick");
+        selection.terms.push_back("FLEA");
+        part = playbook->extract(selection, "part");
+        BOOST_CHECK(part->getPlayNames() == std::vector<std::string>({"play2", "play3"}));
+        BOOST_CHECK(part->getRouteNames() == std::vector<std::string>({"option", "shared"}));
+        BOOST_CHECK_EQUAL(part->playsInCategory("offense").size(), 1);
+        BOOST_CHECK_EQUAL(part->playsInCategory("trick").size(), 1);
+        BOOST_CHECK(part->playsUsingRoute("shared").count(part->getPlay("play2")) == 1);
+
+        // the active playbook has not been changed
+        BOOST_CHECK_EQUAL(playbook->contentHash(), hash);
+        BOOST_CHECK(playbook->playsInCategory("offense") == std::set<PBCPlaySP>({play1, play2}));
+        BOOST_CHECK(play2->categories() == std::set<PBCCategorySP>({offense, trick}));
+    }
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(ContextTests)
+    BOOST_AUTO_TEST_CASE(separate_context_test) {
+        PBCContext context;
+        PBCPlaybookSP playbook = context.get<PBCController>()->getPlaybook();
+        BOOST_CHECK(playbook != PBCController::getInstance()->getPlaybook());
+        {
+            PBCContextScope scope(context);
+            BOOST_CHECK(PBCController::getInstance()->getPlaybook() == playbook);
+            BOOST_CHECK(PBCStorage::getInstance() == context.get<PBCStorage>());
+        }
+        BOOST_CHECK(PBCController::getInstance() == PBCContext::global().get<PBCController>());
+    }
+
+    BOOST_AUTO_TEST_CASE(recreated_context_test) {
+        // the cached service of a destroyed context must not be returned, even
+        // if the next context is created at the same address
+        for (unsigned int i = 0; i < 3; ++i) {
+            std::unique_ptr<PBCContext> context(new PBCContext());
+            PBCContextScope scope(*context);
+            PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+            BOOST_CHECK(playbook == context->get<PBCController>()->getPlaybook());
+            BOOST_CHECK(playbook->name() != "recreated");
+            playbook->resetToNewEmptyPlaybook("recreated", 5);
+            BOOST_CHECK(PBCController::getInstance()->getPlaybook()->name() == "recreated");
+        }
+        BOOST_CHECK(PBCController::getInstance() == PBCContext::global().get<PBCController>());
+    }
+
+    BOOST_AUTO_TEST_CASE(concurrent_first_request_test) {
+        PBCContext context;
+        std::vector<PBCConfig*> configs(8);
+        std::vector<std::thread> threads;
+        for (unsigned int i = 0; i < configs.size(); ++i) {
+            threads.push_back(std::thread([&context, &configs, i]() {
+                configs[i] = context.get<PBCConfig>();
+            }));
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        for (PBCConfig* config : configs) {
+            BOOST_CHECK(config == configs.front());
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(concurrent_playbooks_test) {
+        const unsigned int threadCount = 4;
+        const unsigned int playCount = 20;
+        std::vector<std::vector<std::string>> playNames(threadCount);
+        std::vector<std::string> playbookNames(threadCount);
+        std::vector<std::thread> threads;
+        for (unsigned int i = 0; i < threadCount; ++i) {
+            threads.push_back(std::thread([&playNames, &playbookNames, i, playCount]() {
+                PBCContext context;
+                PBCContextScope scope(context);
+                PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+                playbook->resetToNewEmptyPlaybook("thread" + std::to_string(i), 5);
+                PBCStorage::getInstance()->savePlaybook("test", "thread" + std::to_string(i) + ".pbc");
+                const std::string formationName = playbook->formations().front()->name();
+                for (unsigned int p = 0; p < playCount; ++p) {
+                    playbook->addPlay(PBCPlaySP(new PBCPlay("play" + std::to_string(i) + "_" + std::to_string(p),
+                                                            "",
+                                                            formationName)));
+                }
+                playNames[i] = playbook->getPlayNames();
+                playbookNames[i] = PBCController::getInstance()->getPlaybook()->name();
+            }));
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        for (unsigned int i = 0; i < threadCount; ++i) {
+            BOOST_CHECK_EQUAL(playbookNames[i], "thread" + std::to_string(i));
+            BOOST_REQUIRE_EQUAL(playNames[i].size(), playCount);
+            const std::string prefix = "play" + std::to_string(i) + "_";
+            for (const std::string& name : playNames[i]) {
+                BOOST_CHECK_EQUAL(name.substr(0, prefix.size()), prefix);
+            }
+        }
+    }
+BOOST_AUTO_TEST_SUITE_END()
+
+
+
+BOOST_AUTO_TEST_SUITE(UpdateCheckerTests)
+    static PBCReleaseInfo releaseInfo(PBCReleaseInfo::Status status) {
+        return PBCReleaseInfo{status, 0, 0, 0, "", false};
+    }
+
+    static PBCReleaseInfo check(PBCUpdateChecker& checker) {  // NOLINT
+        std::promise<PBCReleaseInfo> result;
+        checker.start([&result](const PBCReleaseInfo& info) {
+            result.set_value(info);
+        });
+        std::future<PBCReleaseInfo> future = result.get_future();
+        BOOST_REQUIRE(future.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+        return future.get();
+    }
+
+    static std::string cacheFileName() {
+        path cacheFile = temp_directory_path() / unique_path("pbc-update-cache-%%%%-%%%%");
+        return cacheFile.string();
+    }
+
+    BOOST_AUTO_TEST_CASE(cache_test) {
+        std::string cacheFile = cacheFileName();
+        std::atomic<int> fetches(0);
+        PBCUpdateChecker::Fetcher fetcher = [&fetches]() {
+            ++fetches;
+            return PBCReleaseInfo{PBCReleaseInfo::UPDATE_AVAILABLE, 1, 2, 3, "new features\nand fixes", false};
+        };
+
+        PBCUpdateChecker first("0.19.0", fetcher, cacheFile);
+        PBCReleaseInfo info = check(first);
+        BOOST_CHECK_EQUAL(info.status, PBCReleaseInfo::UPDATE_AVAILABLE);
+        BOOST_CHECK(info.fromCache == false);
+        BOOST_CHECK_EQUAL(fetches, 1);
+
+        PBCUpdateChecker second("0.19.0", fetcher, cacheFile);
+        info = check(second);
+        BOOST_CHECK_EQUAL(fetches, 1);
+        BOOST_CHECK(info.fromCache == true);
+        BOOST_CHECK_EQUAL(info.status, PBCReleaseInfo::UPDATE_AVAILABLE);
+        BOOST_CHECK_EQUAL(info.major, 1);
+        BOOST_CHECK_EQUAL(info.minor, 2);
+        BOOST_CHECK_EQUAL(info.patch, 3);
+        BOOST_CHECK_EQUAL(info.description, "new features\nand fixes");
+
+        // a result of another version is not reused
+        PBCUpdateChecker third("0.20.0", fetcher, cacheFile);
+        info = check(third);
+        BOOST_CHECK_EQUAL(fetches, 2);
+        BOOST_CHECK(info.fromCache == false);
+        remove(cacheFile);
+    }
+
+    BOOST_AUTO_TEST_CASE(expired_cache_test) {
+        std::string cacheFile = cacheFileName();
+        std::time_t twoDaysAgo = std::chrono::system_clock::to_time_t(
+                    std::chrono::system_clock::now() - std::chrono::hours(48));
+        {
+            std::ofstream file(cacheFile);
+            file << "0.19.0\n" << twoDaysAgo << "\n" << PBCReleaseInfo::UP_TO_DATE << "\n0 0 0\n";
+        }
+        std::atomic<int> fetches(0);
+        PBCUpdateChecker::Fetcher fetcher = [&fetches]() {
+            ++fetches;
+            return releaseInfo(PBCReleaseInfo::UP_TO_DATE);
+        };
+
+        PBCUpdateChecker threeDays("0.19.0", fetcher, cacheFile, std::chrono::hours(72));
+        BOOST_CHECK(check(threeDays).fromCache == true);
+        BOOST_CHECK_EQUAL(fetches, 0);
+
+        PBCUpdateChecker oneDay("0.19.0", fetcher, cacheFile, std::chrono::hours(24));
+        BOOST_CHECK(check(oneDay).fromCache == false);
+        BOOST_CHECK_EQUAL(fetches, 1);
+        remove(cacheFile);
+    }
+
+    BOOST_AUTO_TEST_CASE(timeout_test) {
+        std::string cacheFile = cacheFileName();
+        PBCUpdateChecker::Fetcher fetcher = []() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            return releaseInfo(PBCReleaseInfo::UP_TO_DATE);
+        };
+        PBCUpdateChecker checker("0.19.0", fetcher, cacheFile, std::chrono::hours(24), std::chrono::milliseconds(20));
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        PBCReleaseInfo info = check(checker);
+        BOOST_CHECK_EQUAL(info.status, PBCReleaseInfo::TIMED_OUT);
+        BOOST_CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(400));
+
+        // the timeout is cached, so the next start does not wait again
+        PBCUpdateChecker next("0.19.0", fetcher, cacheFile, std::chrono::hours(24), std::chrono::milliseconds(20));
+        info = check(next);
+        BOOST_CHECK_EQUAL(info.status, PBCReleaseInfo::TIMED_OUT);
+        BOOST_CHECK(info.fromCache == true);
+        remove(cacheFile);
+    }
+
+    BOOST_AUTO_TEST_CASE(cancel_test) {
+        std::string cacheFile = cacheFileName();
+        PBCUpdateChecker::Fetcher fetcher = []() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            return releaseInfo(PBCReleaseInfo::UP_TO_DATE);
+        };
+        bool called = false;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        {
+            PBCUpdateChecker checker("0.19.0", fetcher, cacheFile);
+            checker.start([&called](const PBCReleaseInfo& info) {
+                called = true;
+            });
+            checker.cancel();
+        }
+        BOOST_CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(400));
+        BOOST_CHECK(called == false);
+        BOOST_CHECK(exists(cacheFile) == false);
+    }
+
+    BOOST_AUTO_TEST_CASE(failed_check_test) {
+        std::string cacheFile = cacheFileName();
+        std::atomic<int> fetches(0);
+        PBCUpdateChecker::Fetcher fetcher = [&fetches]() -> PBCReleaseInfo {
+            ++fetches;
+            throw std::runtime_error("no connection");
+        };
+        PBCUpdateChecker checker("0.19.0", fetcher, cacheFile);
+        PBCReleaseInfo info = check(checker);
+        BOOST_CHECK_EQUAL(info.status, PBCReleaseInfo::CHECK_FAILED);
+        BOOST_CHECK(info.fromCache == false);
+        BOOST_CHECK_EQUAL(fetches, 1);
+
+        PBCUpdateChecker next("0.19.0", fetcher, cacheFile);
+        info = check(next);
+        BOOST_CHECK_EQUAL(info.status, PBCReleaseInfo::CHECK_FAILED);
+        BOOST_CHECK(info.fromCache == true);
+        BOOST_CHECK_EQUAL(fetches, 1);
+        remove(cacheFile);
+    }
+
+    BOOST_AUTO_TEST_CASE(expired_failure_cache_test) {
+        std::string cacheFile = cacheFileName();
+        std::time_t twoHoursAgo = std::chrono::system_clock::to_time_t(
+                    std::chrono::system_clock::now() - std::chrono::hours(2));
+        {
+            std::ofstream file(cacheFile);
+            file << "0.19.0\n" << twoHoursAgo << "\n" << PBCReleaseInfo::CHECK_FAILED << "\n0 0 0\n";
+        }
+        std::atomic<int> fetches(0);
+        PBCUpdateChecker::Fetcher fetcher = [&fetches]() {
+            ++fetches;
+            return releaseInfo(PBCReleaseInfo::UP_TO_DATE);
+        };
+
+        // a failure expires much earlier than a successful result
+        PBCUpdateChecker threeHours("0.19.0", fetcher, cacheFile, std::chrono::hours(24),
+                                    std::chrono::seconds(5), std::chrono::hours(3));
+        BOOST_CHECK(check(threeHours).fromCache == true);
+        BOOST_CHECK_EQUAL(fetches, 0);
+
+        PBCUpdateChecker oneHour("0.19.0", fetcher, cacheFile, std::chrono::hours(24),
+                                 std::chrono::seconds(5), std::chrono::hours(1));
+        PBCReleaseInfo info = check(oneHour);
+        BOOST_CHECK(info.fromCache == false);
+        BOOST_CHECK_EQUAL(info.status, PBCReleaseInfo::UP_TO_DATE);
+        BOOST_CHECK_EQUAL(fetches, 1);
+        remove(cacheFile);
+    }
+BOOST_AUTO_TEST_SUITE_END()
+
+
+
+BOOST_AUTO_TEST_SUITE(DefaultPlaybookTests)
+    BOOST_AUTO_TEST_CASE(default_routes_test) {
+        PBCPlaybook playbook;
+        std::vector<std::string> routeNames = playbook.getRouteNames();
+        BOOST_CHECK_EQUAL(routeNames.size(), 14);
+        PBCRouteSP shallow = playbook.getRoute("Shallow");
+        BOOST_REQUIRE_EQUAL(shallow->paths().size(), 2);
+        BOOST_CHECK_EQUAL(shallow->paths()[0]->endpoint().get<0>(), 13);
+        BOOST_CHECK_EQUAL(shallow->paths()[0]->bezierControlPoint().get<0>(), 2);
+        BOOST_CHECK_EQUAL(shallow->paths()[1]->endpoint().get<0>(), 15);
+        BOOST_CHECK_EQUAL(shallow->paths()[1]->bezierControlPoint().get<0>(), DUMMY_POINT.get<0>());
+    }
+
+    BOOST_AUTO_TEST_CASE(default_formation_test) {
+        PBCPlaybook playbook;
+        BOOST_CHECK_EQUAL(playbook.getFormation("Spread Right")->size(), 5);
+        playbook.resetToNewEmptyPlaybook("eleven", 11);
+        PBCFormationSP formation = playbook.getFormation("Spread Right");
+        BOOST_REQUIRE_EQUAL(formation->size(), 11);
+        BOOST_CHECK_EQUAL(formation->back()->role().fullName, "Right Tackle");
+        BOOST_CHECK_EQUAL(std::string(formation->back()->role().shortName.data()), "RT");
+    }
+
+    BOOST_AUTO_TEST_CASE(lazy_defaults_test) {
+        PBCPlaybook lazy;
+        PBCPlaybook used;
+        used.getRouteNames();
+        // filling in the defaults on first use does not change the playbook's content
+        BOOST_CHECK_EQUAL(lazy.contentHash(), used.contentHash());
+        BOOST_CHECK(PBCPlaybookMerge::diff(lazy, used).empty());
+    }
+
+    BOOST_AUTO_TEST_CASE(concurrent_defaults_test) {
+        PBCPlaybook playbook;
+        playbook.resetToNewEmptyPlaybook("concurrent", 5);
+        std::vector<size_t> routeCounts(8);
+        std::vector<std::thread> threads;
+        for (unsigned int i = 0; i < routeCounts.size(); ++i) {
+            threads.push_back(std::thread([&playbook, &routeCounts, i]() {
+                routeCounts[i] = (i % 2 == 0) ? playbook.getRouteNames().size() : playbook.routes().size();
+            }));
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        for (size_t count : routeCounts) {
+            BOOST_CHECK_EQUAL(count, 14);
+        }
+    }
+BOOST_AUTO_TEST_SUITE_END()
+
+
+
+BOOST_AUTO_TEST_SUITE(PerfTests)
+    static PBCPerfSnapshot findMetric(const std::string& name) {
+        for (const PBCPerfSnapshot& metric : PBCPerf::snapshot()) {
+            if (metric.name == name) {
+                return metric;
+            }
+        }
+        BOOST_FAIL("metric " + name + " not found");
+        return PBCPerfSnapshot();
+    }
+
+    static void timedFunction() {
+        PBC_PERF_SCOPE("test.timer");
+        PBC_PERF_COUNT("test.counter", 3);
+    }
+
+    BOOST_AUTO_TEST_CASE(disabled_test) {
+        PBCPerf::setEnabled(false);
+        PBCPerf::reset();
+        timedFunction();
+        BOOST_CHECK_EQUAL(findMetric("test.timer").count, 0);
+    }
+
+    BOOST_AUTO_TEST_CASE(timer_and_counter_test) {
+        PBCPerf::setEnabled(true);
+        PBCPerf::reset();
+        for (int i = 0; i < 10; ++i) {
+            timedFunction();
+        }
+        PBCPerf::setEnabled(false);
+        PBCPerfSnapshot timer = findMetric("test.timer");
+        BOOST_CHECK_EQUAL(timer.kind, PBCPerfSnapshot::TIMER);
+        BOOST_CHECK_EQUAL(timer.count, 10);
+        BOOST_CHECK(timer.min <= timer.max);
+        PBCPerfSnapshot counter = findMetric("test.counter");
+        BOOST_CHECK_EQUAL(counter.kind, PBCPerfSnapshot::COUNTER);
+        BOOST_CHECK_EQUAL(counter.count, 10);
+        BOOST_CHECK_EQUAL(counter.sum, 30);
+    }
+
+    BOOST_AUTO_TEST_CASE(histogram_test) {
+        PBCPerfMetric* metric = PBCPerf::metric("test.histogram", PBCPerfSnapshot::TIMER);
+        metric->reset();
+        for (uint64_t value : {0, 1, 3, 3, 100, 5000}) {
+            metric->record(value);
+        }
+        PBCPerfSnapshot snapshot = metric->snapshot();
+        BOOST_CHECK_EQUAL(snapshot.buckets[0], 1);  // 0
+        BOOST_CHECK_EQUAL(snapshot.buckets[1], 1);  // 1
+        BOOST_CHECK_EQUAL(snapshot.buckets[2], 2);  // 2..3
+        BOOST_CHECK_EQUAL(snapshot.buckets[7], 1);  // 64..127
+        BOOST_CHECK_EQUAL(snapshot.buckets[13], 1);  // 4096..8191
+        BOOST_CHECK_EQUAL(snapshot.min, 0);
+        BOOST_CHECK_EQUAL(snapshot.max, 5000);
+        BOOST_CHECK_EQUAL(snapshot.percentile(0.5), 3);
+        BOOST_CHECK_EQUAL(snapshot.percentile(1.0), 5000);
+    }
+
+    BOOST_AUTO_TEST_CASE(concurrent_recording_test) {
+        PBCPerfMetric* metric = PBCPerf::metric("test.concurrent", PBCPerfSnapshot::COUNTER);
+        metric->reset();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.push_back(std::thread([metric]() {
+                for (int j = 0; j < 1000; ++j) {
+                    metric->record(2);
+                }
+            }));
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        BOOST_CHECK_EQUAL(metric->snapshot().count, 4000);
+        BOOST_CHECK_EQUAL(metric->snapshot().sum, 8000);
+    }
+
+    BOOST_AUTO_TEST_CASE(json_test) {
+        PBCPerfMetric* metric = PBCPerf::metric("test.json", PBCPerfSnapshot::TIMER);
+        metric->reset();
+        metric->record(1500);
+        std::string json = PBCPerf::toJson();
+        BOOST_CHECK(json.find("\"name\": \"test.json\", \"kind\": \"timer\", \"count\": 1, \"sum_us\": 1500")
+                    != std::string::npos);
+        BOOST_CHECK(json.find("{\"below_us\": 2048, \"count\": 1}") != std::string::npos);
+    }
+
+    BOOST_AUTO_TEST_CASE(json_escape_test) {
+        PBCPerf::metric("test.\"json\"\n\t\x01", PBCPerfSnapshot::COUNTER)->record(1);
+        std::string json = PBCPerf::toJson();
+        BOOST_CHECK(json.find("\"test.\\\"json\\\"\\n\\t\\u0001\"") != std::string::npos);
+        BOOST_CHECK_EQUAL(PBCJson::string("a\\b\r\x1f"), "\"a\\\\b\\r\\u001f\"");
+    }
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(TraceTests)
+    static void innerSpan() {
+        PBC_PERF_SCOPE("test.inner");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    static void outerSpan() {
+        PBC_PERF_SCOPE("test.outer");
+        innerSpan();
+    }
+
+    BOOST_AUTO_TEST_CASE(disabled_test) {
+        PBCTrace::setEnabled(false);
+        PBCTrace::clear();
+        outerSpan();
+        BOOST_CHECK(PBCTrace::events().empty());
+    }
+
+    BOOST_AUTO_TEST_CASE(nested_spans_test) {
+        PBCTrace::setEnabled(true);
+        outerSpan();
+        PBCTrace::setEnabled(false);
+        std::vector<PBCTraceEvent> events = PBCTrace::events();
+        BOOST_REQUIRE_EQUAL(events.size(), 2);
+        const PBCTraceEvent& inner = events[0];
+        const PBCTraceEvent& outer = events[1];
+        BOOST_CHECK_EQUAL(*inner.name, "test.inner");
+        BOOST_CHECK_EQUAL(*outer.name, "test.outer");
+        BOOST_CHECK_EQUAL(inner.threadId, outer.threadId);
+        BOOST_CHECK(inner.duration >= 1000);
+        BOOST_CHECK(outer.start <= inner.start);
+        BOOST_CHECK(inner.start + inner.duration <= outer.start + outer.duration);
+    }
+
+    BOOST_AUTO_TEST_CASE(threads_test) {
+        PBCTrace::setEnabled(true);
+        outerSpan();
+        std::thread(outerSpan).join();
+        PBCTrace::setEnabled(false);
+        std::vector<PBCTraceEvent> events = PBCTrace::events();
+        BOOST_REQUIRE_EQUAL(events.size(), 4);
+        BOOST_CHECK_EQUAL(events[0].threadId, events[1].threadId);
+        BOOST_CHECK_EQUAL(events[2].threadId, events[3].threadId);
+        BOOST_CHECK_NE(events[0].threadId, events[2].threadId);
+    }
+
+    BOOST_AUTO_TEST_CASE(ring_buffer_test) {
+        PBCTrace::setCapacity(3);
+        PBCTrace::setEnabled(true);
+        for (int i = 0; i < 5; ++i) {
+            outerSpan();
+        }
+        PBCTrace::setEnabled(false);
+        std::vector<PBCTraceEvent> events = PBCTrace::events();
+        PBCTrace::setCapacity(100000);
+        BOOST_REQUIRE_EQUAL(events.size(), 3);
+        // the oldest spans have been overwritten
+        BOOST_CHECK_EQUAL(*events[0].name, "test.outer");
+        BOOST_CHECK_EQUAL(*events[1].name, "test.inner");
+        BOOST_CHECK_EQUAL(*events[2].name, "test.outer");
+        BOOST_CHECK(events[0].start < events[1].start);
+    }
+
+    BOOST_AUTO_TEST_CASE(json_test) {
+        PBCTrace::setEnabled(true);
+        PBCTrace::setThreadName("test \"main\"");
+        innerSpan();
+        PBCTrace::setEnabled(false);
+        std::string json = PBCTrace::toJson();
+        BOOST_CHECK_EQUAL(json.find("{\"displayTimeUnit\": \"ms\", \"traceEvents\": ["), 0);
+        BOOST_CHECK(json.find("\"name\": \"test.inner\", \"cat\": \"test\", \"ph\": \"X\", \"ts\": ")
+                    != std::string::npos);
+        BOOST_CHECK(json.find("\"args\": {\"name\": \"test \\\"main\\\"\"}") != std::string::npos);
+
+        path fileName = temp_directory_path() / unique_path("pbc-trace-%%%%%%%%.json");
+        BOOST_CHECK(PBCTrace::writeJson(fileName.string()));
+        std::ifstream file(fileName.string());
+        std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        BOOST_CHECK_EQUAL(content, json);
+        remove(fileName);
+    }
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(LogTests)
+    class CollectingSink : public PBCLogSink {
+     public:
+        std::vector<PBCLogRecord> records;
+        unsigned int flushes = 0;
+
+        void write(const PBCLogRecord& record) override {
+            records.push_back(record);
+        }
+        void flush() override {
+            ++flushes;
+        }
+    };
+
+    struct LogFixture {
+        boost::shared_ptr<CollectingSink> sink;
+
+        LogFixture() : sink(new CollectingSink()) {
+            PBCLog::setLevel(PBCLogRecord::LEVEL_INFO);
+            PBCLog::addSink(sink);
+        }
+        ~LogFixture() {
+            PBCLog::flush();
+            PBCLog::removeSink(sink);
+        }
+    };
+
+    static int evaluations = 0;
+
+    static std::string evaluated(const std::string& message) {
+        ++evaluations;
+        return message;
+    }
+
+    BOOST_AUTO_TEST_CASE(no_sink_test) {
+        BOOST_CHECK(!PBCLog::enabled(PBCLogRecord::LEVEL_ERROR, "test"));
+    }
+
+    BOOST_FIXTURE_TEST_CASE(levels_test, LogFixture) {
+        evaluations = 0;
+        PBC_LOG_DEBUG("test", evaluated("debug"));
+        PBC_LOG_INFO("test", evaluated("info") << " " << 42);
+        PBC_LOG_ERROR("test", evaluated("error"));
+        PBCLog::flush();
+        BOOST_CHECK_EQUAL(evaluations, 2);  // the debug message is not even formatted
+        BOOST_REQUIRE_EQUAL(sink->records.size(), 2);
+        BOOST_CHECK_EQUAL(sink->records[0].level, PBCLogRecord::LEVEL_INFO);
+        BOOST_CHECK_EQUAL(sink->records[0].category, "test");
+        BOOST_CHECK_EQUAL(sink->records[0].message, "info 42");
+        BOOST_CHECK_EQUAL(sink->records[1].message, "error");
+        BOOST_CHECK(sink->flushes >= 1);
+    }
+
+    BOOST_FIXTURE_TEST_CASE(trace_elided_test, LogFixture) {
+        evaluations = 0;
+        PBCLog::setLevel(PBCLogRecord::LEVEL_TRACE);
+        PBC_LOG_TRACE("test", evaluated("trace"));
+        PBCLog::flush();
+        PBCLog::setLevel(PBCLogRecord::LEVEL_INFO);
+        // trace messages are removed at compile time by default
+        BOOST_CHECK_EQUAL(evaluations, PBC_LOG_MIN_LEVEL <= PBC_LOG_LEVEL_TRACE ? 1 : 0);
+    }
+
+    BOOST_FIXTURE_TEST_CASE(categories_test, LogFixture) {
+        PBCLog::setLevel("test.verbose", PBCLogRecord::LEVEL_DEBUG);
+        PBCLog::setLevel("test.quiet", PBCLogRecord::LEVEL_OFF);
+        PBC_LOG(PBCLogRecord::LEVEL_DEBUG, "test", "hidden");
+        PBC_LOG(PBCLogRecord::LEVEL_DEBUG, "test.verbose", "shown");
+        PBC_LOG(PBCLogRecord::LEVEL_DEBUG, "test.verbose.sub", "shown too");
+        PBC_LOG(PBCLogRecord::LEVEL_ERROR, "test.quiet", "hidden");
+        PBCLog::flush();
+        PBCLog::setLevel("test.verbose", PBCLogRecord::LEVEL_INFO);
+        PBCLog::setLevel("test.quiet", PBCLogRecord::LEVEL_INFO);
+        BOOST_REQUIRE_EQUAL(sink->records.size(), 2);
+        BOOST_CHECK_EQUAL(sink->records[0].message, "shown");
+        BOOST_CHECK_EQUAL(sink->records[1].message, "shown too");
+    }
+
+    BOOST_FIXTURE_TEST_CASE(configure_test, LogFixture) {
+        BOOST_CHECK(!PBCLog::configure("loud"));
+        BOOST_CHECK(!PBCLog::configure("info,=debug"));
+        BOOST_CHECK(PBCLog::configure("warning,test.configured=debug"));
+        PBC_LOG(PBCLogRecord::LEVEL_INFO, "test", "hidden");
+        PBC_LOG(PBCLogRecord::LEVEL_DEBUG, "test.configured", "shown");
+        PBCLog::flush();
+        BOOST_CHECK(PBCLog::configure("info,test.configured=info"));
+        BOOST_REQUIRE_EQUAL(sink->records.size(), 1);
+        BOOST_CHECK_EQUAL(sink->records[0].message, "shown");
+    }
+
+    BOOST_FIXTURE_TEST_CASE(threads_test, LogFixture) {
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.push_back(std::thread([i]() {
+                for (int j = 0; j < 100; ++j) {
+                    PBC_LOG_INFO("test", i << " " << j);
+                }
+            }));
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        PBCLog::flush();
+        BOOST_CHECK_EQUAL(sink->records.size(), 400);
+    }
+
+    BOOST_AUTO_TEST_CASE(format_test) {
+        PBCLogRecord record{std::chrono::system_clock::now(), PBCLogRecord::LEVEL_WARNING, "gui.mouse", "clicked"};
+        std::string line = record.format();
+        BOOST_CHECK_EQUAL(line.size(), std::string("2026-01-01 00:00:00.000 ").size() +
+                                       std::string("WARNING [gui.mouse] clicked").size());
+        BOOST_CHECK(line.find(" WARNING [gui.mouse] clicked") != std::string::npos);
+    }
+
+    BOOST_AUTO_TEST_CASE(file_sink_test) {
+        path fileName = temp_directory_path() / unique_path("pbc-log-%%%%%%%%.log");
+        PBCLogSinkSP sink(new PBCFileLogSink(fileName.string()));
+        PBCLog::addSink(sink);
+        PBC_LOG_WARNING("test", "written to file");
+        PBCLog::flush();
+        PBCLog::removeSink(sink);
+        sink.reset();
+        std::ifstream file(fileName.string());
+        std::string line;
+        BOOST_REQUIRE(std::getline(file, line));
+        BOOST_CHECK(line.find("WARNING [test] written to file") != std::string::npos);
+        file.close();
+        remove(fileName);
+    }
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(PDFOutlineTests)
+    // a document with two pages, as QPrinter writes it, with an optional
+    // comment in the second page
+    static std::string minimalPDF(const std::string& comment = "") {
+        std::vector<std::string> objects = {
+            "<<\n/Type /Catalog\n/Pages 2 0 R\n>>",
+            "<<\n/Type /Pages\n/Kids [3 0 R 4 0 R]\n/Count 2\n>>",
+            "<<\n/Type /Page\n/Parent 2 0 R\n/MediaBox [0 0 595 842]\n>>",
+            "<<\n/Type /Page\n/Parent 2 0 R\n/MediaBox [0 0 595 842]\n/Annots [(a \\) [b) <3E>]\n" +
+                (comment.empty() ? "" : "% " + comment + "\n") + ">>",
+            "<<\n/Producer (Test)\n>>"
+        };
+        std::string pdf = "%PDF-1.4\n";
+        std::vector<size_t> offsets;
+        for (unsigned int i = 0; i < objects.size(); ++i) {
+            offsets.push_back(pdf.size());
+            pdf += std::to_string(i + 1) + " 0 obj\n" + objects[i] + "\nendobj\n";
+        }
+        size_t xref = pdf.size();
+        pdf += "xref\n0 6\n0000000000 65535 f \n";
+        for (size_t offset : offsets) {
+            char entry[21];
+            std::snprintf(entry, sizeof(entry), "%010lu 00000 n \n", static_cast<unsigned long>(offset));
+            pdf += entry;
+        }
+        pdf += "trailer\n<<\n/Size 6\n/Info 5 0 R\n/Root 1 0 R\n>>\nstartxref\n" + std::to_string(xref) + "\n%%EOF\n";
+        return pdf;
+    }
+
+    static size_t startXref(const std::string& pdf) {
+        return std::stoul(pdf.substr(pdf.rfind("startxref") + std::string("startxref").size()));
+    }
+
+    // checks that every entry of the last cross-reference table points to its object
+    static void checkXref(const std::string& pdf) {
+        std::istringstream table(pdf.substr(startXref(pdf)));
+        std::string keyword;
+        table >> keyword;
+        BOOST_REQUIRE_EQUAL(keyword, "xref");
+        unsigned int first;
+        unsigned int count;
+        while (table >> first >> count) {
+            for (unsigned int i = 0; i < count; ++i) {
+                size_t offset;
+                unsigned int generation;
+                std::string type;
+                table >> offset >> generation >> type;
+                BOOST_CHECK_EQUAL(pdf.compare(offset, std::to_string(first + i).size() + 6,
+                                              std::to_string(first + i) + " 0 obj"), 0);
+            }
+        }
+    }
+
+    static std::vector<PBCPDFBookmark> bookmarks() {
+        PBCPDFBookmark play{"Play 1", 1, 10, 800};
+        PBCPDFBookmark category{"Pass \xC3\xBC\xF0\x9F\x8F\x88", 0, 0, 842};
+        category.children = {play, play};
+        return {play, category};
+    }
+
+    BOOST_AUTO_TEST_CASE(update_test) {
+        std::string pdf = minimalPDF();
+        std::string update = PBCPDFOutline::update(pdf, bookmarks());
+        std::string result = pdf + update;
+        checkXref(result);
+        BOOST_CHECK(update.find("1 0 obj\n<<\n/Type /Catalog\n/Pages 2 0 R\n/Outlines 6 0 R\n") == 0);
+        BOOST_CHECK(update.find("/Prev " + std::to_string(startXref(pdf)) + "\n") != std::string::npos);
+        BOOST_CHECK(update.find("/Size 11\n") != std::string::npos);
+        BOOST_CHECK(update.find("/Info 5 0 R\n") != std::string::npos);
+        BOOST_CHECK(update.find("/Type /Outlines\n/First 7 0 R\n/Last 8 0 R\n/Count 2\n") != std::string::npos);
+        BOOST_CHECK(update.find("/Dest [4 0 R /XYZ 10.00 800.00 null]") != std::string::npos);
+        BOOST_CHECK(update.find("/Title <FEFF0050006C0061007900200031>") != std::string::npos);
+        // a closed entry with two children, U+00FC and U+1F3C8
+        BOOST_CHECK(update.find("/Title <FEFF0050006100730073002000FCD83CDFC8>\n/Parent 6 0 R\n"
+                                "/Prev 7 0 R\n/First 9 0 R\n/Last 10 0 R\n/Count -2\n") != std::string::npos);
+
+        // a second outline replaces the first one
+        std::string second = PBCPDFOutline::update(result, {bookmarks()[0]});
+        result += second;
+        checkXref(result);
+        BOOST_CHECK(second.find("/Outlines 11 0 R\n") != std::string::npos);
+        BOOST_CHECK(second.find("/Outlines 6 0 R") == std::string::npos);
+        BOOST_CHECK(second.find("/Size 13\n") != std::string::npos);
+    }
+
+    BOOST_AUTO_TEST_CASE(file_test) {
+        path fileName = temp_directory_path() / unique_path("pbc-outline-%%%%%%%%.pdf");
+        std::string pdf = minimalPDF();
+        {
+            std::ofstream file(fileName.string(), std::ios::binary);
+            file << pdf;
+        }
+        PBCPDFOutline::addToFile(fileName.string(), bookmarks());
+        std::ifstream file(fileName.string(), std::ios::binary);
+        std::string result((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        file.close();
+        BOOST_CHECK_EQUAL(result, pdf + PBCPDFOutline::update(pdf, bookmarks()));
+        remove(fileName);
+    }
+
+    BOOST_AUTO_TEST_CASE(unsupported_test) {
+        BOOST_CHECK(PBCPDFOutline::update(minimalPDF(), {}).empty());
+        BOOST_CHECK_THROW(PBCPDFOutline::update("no pdf at all", bookmarks()), PBCStorageException);
+        std::string pdf = minimalPDF();
+        BOOST_CHECK_THROW(PBCPDFOutline::update(pdf.substr(0, pdf.size() / 2) + "startxref\n3\n%%EOF", bookmarks()),
+                          PBCStorageException);
+        std::string stream = "%PDF-1.5\n1 0 obj\n<< /Type /XRef >>\nendobj\nstartxref\n9\n%%EOF\n";
+        BOOST_CHECK_THROW(PBCPDFOutline::update(stream, bookmarks()), PBCStorageException);
+    }
+
+    BOOST_AUTO_TEST_CASE(large_object_test) {
+        // the page is larger than the part of the file that is read at first
+        std::string pdf = minimalPDF(std::string(20000, 'x'));
+        std::string update = PBCPDFOutline::update(pdf, bookmarks());
+        checkXref(pdf + update);
+        BOOST_CHECK(update.find("/Dest [4 0 R /XYZ 10.00 800.00 null]") != std::string::npos);
+    }
+
+    BOOST_AUTO_TEST_CASE(invalid_values_test) {
+        const std::string pdf = minimalPDF();
+        PBCPDFBookmark missingPage{"Play 3", 2, 0, 0};
+        BOOST_CHECK_THROW(PBCPDFOutline::update(pdf, {missingPage}), PBCStorageException);
+
+        // the trailer follows the cross-reference table, so it can be changed without moving the table
+        std::string largeSize = pdf;
+        largeSize.replace(largeSize.find("/Size 6"), 7, "/Size 99999999999999999999999");
+        BOOST_CHECK_THROW(PBCPDFOutline::update(largeSize, bookmarks()), PBCStorageException);
+        std::string largeRoot = pdf;
+        largeRoot.replace(largeRoot.find("/Root 1 0 R"), 11, "/Root 4294967297 0 R");
+        BOOST_CHECK_THROW(PBCPDFOutline::update(largeRoot, bookmarks()), PBCStorageException);
+        std::string unterminated = pdf;
+        unterminated.replace(unterminated.rfind(">>\nstartxref"), 2, "/Broken (");
+        BOOST_CHECK_THROW(PBCPDFOutline::update(unterminated, bookmarks()), PBCStorageException);
+    }
+
+    BOOST_AUTO_TEST_CASE(failed_file_test) {
+        path fileName = temp_directory_path() / unique_path("pbc-outline-%%%%%%%%.pdf");
+        std::string pdf = minimalPDF();
+        {
+            std::ofstream file(fileName.string(), std::ios::binary);
+            file << pdf;
+        }
+        PBCPDFBookmark missingPage{"Play 3", 2, 0, 0};
+        BOOST_CHECK_THROW(PBCPDFOutline::addToFile(fileName.string(), {missingPage}), PBCStorageException);
+        std::ifstream file(fileName.string(), std::ios::binary);
+        std::string result((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        file.close();
+        BOOST_CHECK_EQUAL(result, pdf);
+        remove(fileName);
+
+        // a missing file is not created
+        BOOST_CHECK_THROW(PBCPDFOutline::addToFile(fileName.string(), bookmarks()), PBCStorageException);
+        BOOST_CHECK(exists(fileName) == false);
+    }
+BOOST_AUTO_TEST_SUITE_END()
+
+
+
+BOOST_FIXTURE_TEST_SUITE(ExportTests, PBCGuiFixture)
+    // plays of the active playbook, which is reset to a new one
+    static std::vector<PBCPlaySP> testPlays(unsigned int count) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        playbook->resetToNewEmptyPlaybook("export", 5);
+        PBCFormationSP formation = playbook->formations().front();
+        std::vector<PBCPlaySP> plays;
+        for (unsigned int i = 0; i < count; ++i) {
+            PBCPlaySP play(new PBCPlay("play" + std::to_string(i), "", formation->name()));
+            playbook->addPlay(play, false, true);
+            plays.push_back(play);
+        }
+        return plays;
+    }
+
+    static std::string readFile(const std::string& fileName) {
+        std::ifstream file(fileName, std::ios_base::binary);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    // the number of page objects of a PDF file (not counting the page tree)
+    static unsigned int countPages(const std::string& fileName) {
+        const std::string pdf = readFile(fileName);
+        const std::string page = "/Type /Page";
+        unsigned int pages = 0;
+        for (size_t i = pdf.find(page); i != std::string::npos; i = pdf.find(page, i + 1)) {
+            pages += pdf.compare(i, page.size() + 1, page + "s") != 0;
+        }
+        return pages;
+    }
+
+    static const PBCPDFLayout GRID_LAYOUT{0, 0, 2, 2, 0, 0, 0, 0};
+
+    // a play with a code name, a center, a motion and a route with option and alternative routes
+    static PBCPlaySP fixturePlay() {
+        PBCPlaySP play = testPlays(1).front();
+        play->setCodeName("FIX");
+        PBCPlayerSP receiver;
+        bool hasCenter = false;
+        for (const PBCPlayerSP& player : *play->formation()) {
+            if (player->role().fullName == "Center") {
+                hasCenter = true;
+            } else if (receiver == NULL) {
+                receiver = player;
+            }
+        }
+        BOOST_REQUIRE(hasCenter);
+        BOOST_REQUIRE(receiver != NULL);
+        PBCMotionSP motion(new PBCMotion());
+        motion->addPath(PBCPathSP(new PBCPath(PBCDPoint(-3, 0))));
+        receiver->setMotion(motion);
+        receiver->setRoute(PBCRouteSP(new PBCRoute("slant", "s", {PBCPathSP(new PBCPath(0, 5)),
+                                                                    PBCPathSP(new PBCPath(6, 12, 2, 9))})));
+        receiver->addOptionRoute(PBCRouteSP(new PBCRoute("out", "o", {PBCPathSP(new PBCPath(5, 5))})));
+        receiver->setAlternativeRoute(1, PBCRouteSP(new PBCRoute("go", "g", {PBCPathSP(new PBCPath(0, 15))})));
+        receiver->setAlternativeRoute(2, PBCRouteSP(new PBCRoute("in", "i", {PBCPathSP(new PBCPath(-5, 5))})));
+        return play;
+    }
+
+    BOOST_AUTO_TEST_CASE(pdf_cancel_test) {
+        std::remove("cancel.pdf");
+        PBCPDFExportJob job("cancel.pdf", testPlays(9), GRID_LAYOUT);
+        BOOST_CHECK_EQUAL(job.pages(), 3);
+        BOOST_CHECK(job.step() == false);
+        BOOST_CHECK(exists("cancel.pdf"));
+        job.cancel();
+        BOOST_CHECK(job.cancelled());
+        BOOST_CHECK(job.step());
+        BOOST_CHECK(exists("cancel.pdf") == false);
+
+        // an unfinished job that is destroyed removes its file, too
+        {
+            PBCPDFExportJob destroyed("cancel.pdf", testPlays(9), GRID_LAYOUT);
+            destroyed.step();
+        }
+        BOOST_CHECK(exists("cancel.pdf") == false);
+    }
+
+    BOOST_AUTO_TEST_CASE(pdf_pages_test) {
+        // the last page is full, so no empty page follows it
+        PBCPDFExportJob full("full.pdf", testPlays(8), GRID_LAYOUT);
+        full.run();
+        BOOST_CHECK(full.finished());
+        BOOST_CHECK_EQUAL(full.pagesDone(), 2);
+        BOOST_CHECK_EQUAL(countPages("full.pdf"), 2);
+
+        PBCPDFExportJob partial("partial.pdf", testPlays(9), GRID_LAYOUT);
+        partial.run();
+        BOOST_CHECK_EQUAL(partial.pagesDone(), 3);
+        BOOST_CHECK_EQUAL(countPages("partial.pdf"), 3);
+    }
+
+    BOOST_AUTO_TEST_CASE(renderer_matches_view_test) {
+        PBCPlaySP play = fixturePlay();
+        PBCRenderStyle style = PBCRenderStyle::fromConfig();
+        QImage viewImage(style.canvasWidth, style.canvasHeight, QImage::Format_ARGB32_Premultiplied);
+        QImage rendererImage(viewImage.size(), viewImage.format());
+        viewImage.fill(Qt::white);
+        rendererImage.fill(Qt::white);
+        const QRectF target(viewImage.rect());
+        {
+            QPainter painter(&viewImage);
+            PBCPlayView view(play);
+            view.render(&painter, target, QRectF(), Qt::IgnoreAspectRatio);
+        }
+        {
+            QPainter painter(&rendererImage);
+            PBCPlayRenderer::render(&painter, *play, style, target);
+        }
+
+        // antialiased edges and text may differ slightly, the drawing must not
+        unsigned int differentPixels = 0;
+        unsigned int paintedPixels = 0;
+        for (int y = 0; y < viewImage.height(); ++y) {
+            for (int x = 0; x < viewImage.width(); ++x) {
+                QRgb view = viewImage.pixel(x, y);
+                QRgb renderer = rendererImage.pixel(x, y);
+                int difference = std::max({std::abs(qRed(view) - qRed(renderer)),
+                                           std::abs(qGreen(view) - qGreen(renderer)),
+                                           std::abs(qBlue(view) - qBlue(renderer))});
+                differentPixels += difference > 64;
+                paintedPixels += view != viewImage.pixel(0, 0);
+            }
+        }
+        const unsigned int pixels = viewImage.width() * viewImage.height();
+        BOOST_TEST_MESSAGE(differentPixels << " of " << pixels << " pixels differ");
+        BOOST_CHECK_GT(paintedPixels, pixels / 100);
+        BOOST_CHECK_LT(differentPixels, pixels / 200);
+    }
+
+    static std::vector<std::string> playNames(const std::vector<PBCPlaySP>& plays) {
+        std::vector<std::string> names;
+        for (const PBCPlaySP& play : plays) {
+            names.push_back(play->name());
+        }
+        return names;
+    }
+
+    BOOST_AUTO_TEST_CASE(images_manifest_test) {
+        remove_all("images");
+        std::vector<PBCPlaySP> plays = testPlays(3);
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        PBCImageExportOptions options;
+        options.dpi = PBCImageExportOptions::MIN_DPI;
+        PBCImageExportReport first = PBCImageExport::exportPlays(playbook, playNames(plays), "images", options);
+        BOOST_CHECK_EQUAL(first.written.size(), 3);
+        BOOST_CHECK(first.skipped.empty());
+        BOOST_CHECK(first.failures.empty());
+        BOOST_CHECK(exists("images/play0.png"));
+        BOOST_CHECK(exists(path("images") / PBCImageExport::MANIFEST_FILE));
+
+        // nothing has changed, so nothing is rewritten
+        last_write_time("images/play0.png", 0);
+        PBCImageExportReport second = PBCImageExport::exportPlays(playbook, playNames(plays), "images", options);
+        BOOST_CHECK(second.written.empty());
+        BOOST_CHECK_EQUAL(second.skipped.size(), 3);
+        BOOST_CHECK_EQUAL(last_write_time("images/play0.png"), 0);
+
+        // only the image of the changed play is rewritten
+        plays[1]->setCodeName("CHANGED");
+        PBCImageExportReport third = PBCImageExport::exportPlays(playbook, playNames(plays), "images", options);
+        BOOST_REQUIRE_EQUAL(third.written.size(), 1);
+        BOOST_CHECK(path(third.written.front()).filename() == "play1.png");
+        BOOST_CHECK_EQUAL(third.skipped.size(), 2);
+        BOOST_CHECK_EQUAL(last_write_time("images/play0.png"), 0);
+
+        // other settings rewrite all images
+        options.dpi = PBCImageExportOptions::MIN_DPI + 1;
+        PBCImageExportReport fourth = PBCImageExport::exportPlays(playbook, playNames(plays), "images", options);
+        BOOST_CHECK_EQUAL(fourth.written.size(), 3);
+        BOOST_CHECK(fourth.skipped.empty());
+
+        options.dpi = PBCImageExportOptions::MAX_DPI + 1;
+        BOOST_CHECK_THROW(PBCImageExport::exportPlays(playbook, playNames(plays), "images", options),
+                          PBCUnexpectedError);
+        remove_all("images");
+    }
+
+    BOOST_AUTO_TEST_CASE(image_name_collision_test) {
+        remove_all("images");
+        testPlays(0);
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        PBCFormationSP formation = playbook->formations().front();
+        const std::vector<std::string> names = {"a/b", "a?b", "A_B", "a_b"};
+        for (const std::string& name : names) {
+            playbook->addPlay(PBCPlaySP(new PBCPlay(name, "", formation->name())), false, true);
+        }
+        BOOST_CHECK_EQUAL(PBCImageExport::fileName("a/b"), "a_b");
+        BOOST_CHECK_EQUAL(PBCImageExport::fileName(""), "play");
+
+        PBCImageExportOptions options;
+        options.format = PBCImageExportOptions::SVG;
+        PBCImageExportReport first = PBCImageExport::exportPlays(playbook, names, "images", options);
+        BOOST_REQUIRE_EQUAL(first.written.size(), names.size());
+        std::set<std::string> files;
+        for (const std::string& file : first.written) {
+            files.insert(path(file).filename().string());
+        }
+        // names that only differ in case collide on case-insensitive file systems
+        BOOST_CHECK(files == std::set<std::string>({"a_b.svg", "a_b-2.svg", "A_B-3.svg", "a_b-4.svg"}));
+
+        // the plays keep their files, even if the first of them is not exported any more
+        PBCImageExportReport second = PBCImageExport::exportPlays(playbook, {"a_b", "a?b"}, "images", options);
+        BOOST_CHECK(second.written.empty());
+        BOOST_REQUIRE_EQUAL(second.skipped.size(), 2);
+        BOOST_CHECK(path(second.skipped[0]).filename() == "a_b-4.svg");
+        BOOST_CHECK(path(second.skipped[1]).filename() == "a_b-2.svg");
+        remove_all("images");
+    }
+
+    static PBCCategorySP addToCategory(const PBCPlaySP& play, const std::string& categoryName) {
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        PBCCategorySP category = playbook->getCategory(categoryName);
+        if (category == NULL) {
+            category.reset(new PBCCategory(categoryName));
+            playbook->addCategory(category);
+        }
+        play->addCategory(category);
+        category->addPlay(play);
+        return category;
+    }
+
+    static std::set<std::string> fileNames(const std::vector<std::string>& paths) {
+        std::set<std::string> names;
+        for (const std::string& file : paths) {
+            names.insert(path(file).filename().string());
+        }
+        return names;
+    }
+
+    BOOST_AUTO_TEST_CASE(booklet_manifest_test) {
+        remove_all("booklets");
+        std::vector<PBCPlaySP> plays = testPlays(3);
+        PBCPlaybookSP playbook = PBCController::getInstance()->getPlaybook();
+        addToCategory(plays[0], "runs");
+        addToCategory(plays[1], "runs");
+        PBCCategorySP passes = addToCategory(plays[2], "passes");
+        const path manifest = path("booklets") / PBCBookletExport::MANIFEST_FILE;
+
+        PBCBookletReport first = PBCBookletExport::exportBooklets(playbook, "booklets", GRID_LAYOUT);
+        BOOST_CHECK(fileNames(first.written) == std::set<std::string>({"runs.pdf", "passes.pdf"}));
+        BOOST_CHECK(first.failures.empty());
+        BOOST_REQUIRE(exists(manifest));
+
+        // a rebuild without changes writes nothing, not even the manifest
+        for (const path& file : {path("booklets/runs.pdf"), path("booklets/passes.pdf"), manifest}) {
+            last_write_time(file, 0);
+        }
+        PBCBookletReport second = PBCBookletExport::exportBooklets(playbook, "booklets", GRID_LAYOUT);
+        BOOST_CHECK(second.written.empty());
+        BOOST_CHECK(second.removed.empty());
+        BOOST_CHECK_EQUAL(second.skipped.size(), 2);
+        BOOST_CHECK_EQUAL(last_write_time("booklets/runs.pdf"), 0);
+        BOOST_CHECK_EQUAL(last_write_time("booklets/passes.pdf"), 0);
+        BOOST_CHECK_EQUAL(last_write_time(manifest), 0);
+
+        // editing a play only rebuilds the booklets that contain it
+        plays[2]->setCodeName("EDITED");
+        PBCBookletReport third = PBCBookletExport::exportBooklets(playbook, "booklets", GRID_LAYOUT);
+        BOOST_CHECK(fileNames(third.written) == std::set<std::string>({"passes.pdf"}));
+        BOOST_CHECK(fileNames(third.skipped) == std::set<std::string>({"runs.pdf"}));
+        BOOST_CHECK_EQUAL(last_write_time("booklets/runs.pdf"), 0);
+        BOOST_CHECK_NE(last_write_time("booklets/passes.pdf"), 0);
+
+        // the booklet of an emptied category is removed
+        plays[2]->removeCategory(passes);
+        passes->removePlay(plays[2]);
+        PBCBookletReport fourth = PBCBookletExport::exportBooklets(playbook, "booklets", GRID_LAYOUT);
+        BOOST_CHECK(fourth.written.empty());
+        BOOST_CHECK(fileNames(fourth.removed) == std::set<std::string>({"passes.pdf"}));
+        BOOST_CHECK(exists("booklets/passes.pdf") == false);
+        BOOST_CHECK(exists("booklets/runs.pdf"));
+
+        // the manifest no longer lists the removed booklet
+        PBCBookletReport fifth = PBCBookletExport::exportBooklets(playbook, "booklets", GRID_LAYOUT);
+        BOOST_CHECK(fifth.removed.empty());
+        BOOST_CHECK(fileNames(fifth.skipped) == std::set<std::string>({"runs.pdf"}));
+        remove_all("booklets");
+    }
+
+    static std::string roleName(const PBCPlayerSP& player) {
+        const std::array<char, 4> shortName = player->role().shortName;
+        return std::string(shortName.begin(), std::find(shortName.begin(), shortName.end(), '\0'));
+    }
+
+    BOOST_AUTO_TEST_CASE(role_booklets_test) {
+        remove_all("roles");
+        std::vector<PBCPlaySP> plays = testPlays(3);
+        // the second play lacks the players with the role of the last player of the formation
+        PBCFormationSP formation = plays[1]->formation();
+        const std::string role = roleName(formation->back());
+        formation->erase(std::remove_if(formation->begin(), formation->end(), [&](const PBCPlayerSP& player) {
+            return roleName(player) == role;
+        }), formation->end());
+        formation->invalidateContentHash();
+        BOOST_REQUIRE(formation->empty() == false);
+        const std::string otherRole = roleName(formation->front());
+
+        // one play per page, so the pages show which plays are in a booklet
+        const PBCPDFLayout singleLayout{0, 0, 1, 1, 0, 0, 0, 0};
+        PBCBookletReport report = PBCBookletExport::exportRoleBooklets(plays, {role, otherRole, "XYZ"},
+                                                                       "roles", singleLayout);
+        BOOST_CHECK(fileNames(report.written) == std::set<std::string>({"role-" + role + ".pdf",
+                                                                        "role-" + otherRole + ".pdf"}));
+        BOOST_CHECK_EQUAL(countPages("roles/role-" + role + ".pdf"), 2);
+        BOOST_CHECK_EQUAL(countPages("roles/role-" + otherRole + ".pdf"), 3);
+
+        // an unknown role is reported instead of producing an empty booklet
+        BOOST_REQUIRE_EQUAL(report.failures.size(), 1);
+        BOOST_CHECK(path(report.failures.front().first).filename() == "role-XYZ.pdf");
+        BOOST_CHECK(report.failures.front().second.find("'XYZ'") != std::string::npos);
+        BOOST_CHECK(exists("roles/role-XYZ.pdf") == false);
+        remove_all("roles");
+    }
+
+    BOOST_AUTO_TEST_CASE(parse_layout_test) {
+        PBCPDFLayout layout{210, 297, 1, 1, 5, 6, 7, 8};
+        BOOST_CHECK(PBCMultiLayoutExportJob::parseLayout("4x2", layout));
+        BOOST_CHECK_EQUAL(layout.columns, 4);
+        BOOST_CHECK_EQUAL(layout.rows, 2);
+        BOOST_CHECK_EQUAL(layout.paperWidth, 210);
+        BOOST_CHECK_EQUAL(layout.paperHeight, 297);
+        BOOST_CHECK_EQUAL(layout.marginLeft, 5);
+        BOOST_CHECK_EQUAL(layout.marginBottom, 8);
+
+        BOOST_CHECK(PBCMultiLayoutExportJob::parseLayout(" 3 x 1 @ 100 x 50 ", layout));
+        BOOST_CHECK_EQUAL(layout.columns, 3);
+        BOOST_CHECK_EQUAL(layout.rows, 1);
+        BOOST_CHECK_EQUAL(layout.paperWidth, 100);
+        BOOST_CHECK_EQUAL(layout.paperHeight, 50);
+
+        // invalid layouts leave the layout unchanged
+        for (const std::string spec : {"", "4", "4x", "x2", "0x2", "2x0", "-1x2", "4*2",
+                                       "4x2@100", "4x2@100x", "4x2 mm"}) {
+            BOOST_CHECK_MESSAGE(PBCMultiLayoutExportJob::parseLayout(spec, layout) == false, spec);
+        }
+        BOOST_CHECK_EQUAL(layout.columns, 3);
+        BOOST_CHECK_EQUAL(layout.paperWidth, 100);
+    }
+
+    BOOST_AUTO_TEST_CASE(layout_file_name_test) {
+        const PBCPDFLayout canvasSized{0, 0, 4, 2, 0, 0, 0, 0};
+        BOOST_CHECK_EQUAL(PBCMultiLayoutExportJob::fileName("Playbook", canvasSized), "Playbook-4x2.pdf");
+        const PBCPDFLayout wristband{100, 50, 3, 1, 0, 0, 0, 0};
+        BOOST_CHECK_EQUAL(PBCMultiLayoutExportJob::fileName("out/Playbook", wristband), "out/Playbook-3x1-100x50mm.pdf");
+        // only one dimension of the paper does not make a paper size
+        const PBCPDFLayout halfPaper{100, 0, 3, 1, 0, 0, 0, 0};
+        BOOST_CHECK_EQUAL(PBCMultiLayoutExportJob::fileName("Playbook", halfPaper), "Playbook-3x1.pdf");
+    }
+
+    BOOST_AUTO_TEST_CASE(multi_layout_test) {
+        const PBCPDFLayout single{0, 0, 1, 1, 0, 0, 0, 0};
+        std::vector<PBCPDFTarget> targets = {{"single.pdf", single}, {"grid.pdf", GRID_LAYOUT}};
+        PBCMultiLayoutExportJob job(testPlays(5), targets);
+        // one step per recorded play and per page
+        BOOST_CHECK_EQUAL(job.steps(), 5 + 5 + 2);
+        job.run();
+        BOOST_CHECK(job.finished());
+        BOOST_CHECK_EQUAL(job.stepsDone(), job.steps());
+        BOOST_CHECK_EQUAL(countPages("single.pdf"), 5);
+        BOOST_CHECK_EQUAL(countPages("grid.pdf"), 2);
+
+        PBCMultiLayoutExportJob cancelled(testPlays(5), targets);
+        cancelled.step();
+        cancelled.step();
+        cancelled.cancel();
+        BOOST_CHECK(cancelled.step());
+        BOOST_CHECK(exists("single.pdf") == false);
+        BOOST_CHECK(exists("grid.pdf") == false);
+    }
+BOOST_AUTO_TEST_SUITE_END()
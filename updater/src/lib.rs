@@ -1,4 +1,8 @@
 use core::slice;
+use std::ffi::CStr;
+use std::os::raw::c_char;
+
+const GITHUB_API_URL: &str = "https://api.github.com";
 
 #[derive(Debug, Clone)]
 enum MyError {
@@ -42,15 +46,55 @@ pub extern "C" fn updates_available(
     current_pbc_version_minor: u64,
     current_pbc_version_patch: u64,
     description_result_buffer: &CBuffer,
+) -> UpdateCheckingStatus {
+    check_for_updates(
+        GITHUB_API_URL,
+        (
+            current_pbc_version_major,
+            current_pbc_version_minor,
+            current_pbc_version_patch,
+        ),
+        description_result_buffer,
+    )
+}
+
+/// Same as `updates_available`, but asks the GitHub-compatible API at `api_url`
+/// (e.g. "http://127.0.0.1:8080") instead of api.github.com.
+#[unsafe(no_mangle)]
+pub extern "C" fn updates_available_from(
+    api_url: *const c_char,
+    current_pbc_version_major: u64,
+    current_pbc_version_minor: u64,
+    current_pbc_version_patch: u64,
+    description_result_buffer: &CBuffer,
+) -> UpdateCheckingStatus {
+    if api_url.is_null() {
+        return UpdateCheckingStatus::Error;
+    }
+    let api_url = match unsafe { CStr::from_ptr(api_url) }.to_str() {
+        Ok(url) => url,
+        Err(_) => return UpdateCheckingStatus::Error,
+    };
+    check_for_updates(
+        api_url,
+        (
+            current_pbc_version_major,
+            current_pbc_version_minor,
+            current_pbc_version_patch,
+        ),
+        description_result_buffer,
+    )
+}
+
+fn check_for_updates(
+    api_url: &str,
+    current_pbc_version: (u64, u64, u64),
+    description_result_buffer: &CBuffer,
 ) -> UpdateCheckingStatus {
     let description_result: &mut [u8] = unsafe {
         slice::from_raw_parts_mut(description_result_buffer.buf, description_result_buffer.len)
     };
-    if let Ok(versions) = fetch_parse_and_filter_releases((
-        current_pbc_version_major,
-        current_pbc_version_minor,
-        current_pbc_version_patch,
-    )) {
+    if let Ok(versions) = fetch_parse_and_filter_releases(api_url, current_pbc_version) {
         if let Some(latest_release) = versions.first() {
             let major = latest_release.version.major;
             let minor = latest_release.version.minor;
@@ -74,9 +118,11 @@ pub extern "C" fn updates_available(
 }
 
 fn fetch_parse_and_filter_releases(
+    api_url: &str,
     current_pbc_version: (u64, u64, u64),
 ) -> Result<Vec<ReleaseWithBody>, MyError> {
     let releases = self_update::backends::github::ReleaseList::configure()
+        .with_url(api_url)
         .repo_owner("obraunsdorf")
         .repo_name("playbook-creator")
         .build()?
@@ -103,39 +149,97 @@ fn fetch_parse_and_filter_releases(
 #[cfg(test)]
 mod tests {
     use crate::*;
+    use std::ffi::CString;
+    use std::io::{BufRead, BufReader, Write};
+    use std::net::TcpListener;
+    use std::thread;
 
-    #[test]
-    fn basic_test() {
-        let old_version = (0, 13, 0);
-        let versions = fetch_parse_and_filter_releases(old_version).unwrap();
-        let latest_version = versions.first().unwrap();
+    const RELEASES_JSON: &str = r#"[
+        {"tag_name": "v0.14.1", "created_at": "2021-02-01T00:00:00Z", "name": "v0.14.1",
+         "body": "bugfix release", "assets": []},
+        {"tag_name": "v0.14.0", "created_at": "2021-01-01T00:00:00Z", "name": "v0.14.0",
+         "body": "feature release", "assets": []},
+        {"tag_name": "v0.13.0", "created_at": "2020-12-01T00:00:00Z", "name": "v0.13.0",
+         "body": "old release", "assets": []}
+    ]"#;
 
-        let (major, minor, patch) = old_version;
+    /// Serves the canned releases list to `requests` clients, so the tests do
+    /// not depend on api.github.com. Returns the API url of the stand-in.
+    fn serve_releases(status_line: &'static str, requests: usize) -> String {
+        let listener = TcpListener::bind("127.0.0.1:0").unwrap();
+        let url = format!("http://{}", listener.local_addr().unwrap());
+        thread::spawn(move || {
+            for stream in listener.incoming().take(requests) {
+                let mut stream = stream.unwrap();
+                let mut reader = BufReader::new(stream.try_clone().unwrap());
+                let mut request_line = String::new();
+                reader.read_line(&mut request_line).unwrap();
+                assert!(request_line.starts_with("GET /repos/obraunsdorf/playbook-creator/releases"));
+                let mut header = String::new();
+                while reader.read_line(&mut header).unwrap() > 2 {
+                    header.clear();
+                }
+                let response = format!(
+                    "{}\r\nContent-Type: application/json\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{}",
+                    status_line,
+                    RELEASES_JSON.len(),
+                    RELEASES_JSON
+                );
+                stream.write_all(response.as_bytes()).unwrap();
+            }
+        });
+        url
+    }
+
+    fn check(url: &str, version: (u64, u64, u64), buffer: &mut [u8]) -> UpdateCheckingStatus {
+        let url = CString::new(url).unwrap();
         let buf = CBuffer {
-            buf: [0u8; 500].as_mut_ptr(),
-            len: 500,
+            buf: buffer.as_mut_ptr(),
+            len: buffer.len(),
         };
-        match updates_available(major, minor, patch, &buf) {
-            UpdateCheckingStatus::UpdatesAvailable(..) => {
-                let description: &[u8] = unsafe { slice::from_raw_parts(buf.buf, buf.len) };
-                let desc = String::from_utf8_lossy(description);
-                println!("description:\n{}", desc)
+        updates_available_from(url.as_ptr(), version.0, version.1, version.2, &buf)
+    }
+
+    #[test]
+    fn update_available_test() {
+        let url = serve_releases("HTTP/1.1 200 OK", 1);
+        let mut buffer = [0u8; 500];
+        match check(&url, (0, 13, 0), &mut buffer) {
+            UpdateCheckingStatus::UpdatesAvailable(major, minor, patch) => {
+                assert_eq!((major, minor, patch), (0, 14, 1));
+                assert!(buffer.starts_with(b"bugfix release"));
             }
-            UpdateCheckingStatus::UpToDate => assert!(false),
-            UpdateCheckingStatus::Error => assert!(false),
+            _ => panic!("expected an update"),
         }
+    }
 
-        let buf = CBuffer {
-            buf: [0u8; 500].as_mut_ptr(),
-            len: 500,
-        };
-        let major = latest_version.version.major;
-        let minor = latest_version.version.minor;
-        let patch = latest_version.version.patch;
-        match updates_available(major, minor, patch, &buf) {
-            UpdateCheckingStatus::UpdatesAvailable(..) => assert!(false),
+    #[test]
+    fn up_to_date_test() {
+        let url = serve_releases("HTTP/1.1 200 OK", 1);
+        let mut buffer = [0u8; 500];
+        match check(&url, (0, 14, 1), &mut buffer) {
             UpdateCheckingStatus::UpToDate => {}
-            UpdateCheckingStatus::Error => assert!(false),
+            _ => panic!("expected no update"),
+        }
+    }
+
+    #[test]
+    fn server_error_test() {
+        let url = serve_releases("HTTP/1.1 500 Internal Server Error", 1);
+        let mut buffer = [0u8; 500];
+        match check(&url, (0, 13, 0), &mut buffer) {
+            UpdateCheckingStatus::Error => {}
+            _ => panic!("expected an error"),
+        }
+    }
+
+    #[test]
+    fn description_is_truncated_test() {
+        let url = serve_releases("HTTP/1.1 200 OK", 1);
+        let mut buffer = [0u8; 6];
+        match check(&url, (0, 13, 0), &mut buffer) {
+            UpdateCheckingStatus::UpdatesAvailable(..) => assert_eq!(&buffer, b"bugfix"),
+            _ => panic!("expected an update"),
         }
     }
 }